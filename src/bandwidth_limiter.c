@@ -0,0 +1,86 @@
+/*
+* Copyright © xFusion Digital Technologies Co., Ltd. 2012-2018. All rights reserved.
+* Description: shared upload bandwidth limiter
+* Author:
+* Create: 2019-06-16
+* Notes:
+*/
+#include <time.h>
+#include "bandwidth_limiter.h"
+
+#define BANDWIDTH_LIMITER_MIN_CHUNK 1024
+#define BANDWIDTH_LIMITER_MAX_CHUNK 16384
+#define BANDWIDTH_LIMITER_CHUNKS_PER_SECOND 8
+
+static double UtoolBandwidthLimiterClock(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double) now.tv_sec + (double) now.tv_nsec / 1000000000;
+}
+
+void UtoolBandwidthLimiterInit(UtoolBandwidthLimiter *limiter, long bytesPerSecond)
+{
+    pthread_mutex_init(&(limiter->mutex), NULL);
+    limiter->rate = (double) bytesPerSecond;
+    limiter->tokens = 0;
+    limiter->updated = UtoolBandwidthLimiterClock();
+
+    // send several chunks per second, so that uploads sharing the limiter interleave smoothly
+    size_t chunk = (size_t) bytesPerSecond / BANDWIDTH_LIMITER_CHUNKS_PER_SECOND;
+    chunk = chunk < BANDWIDTH_LIMITER_MIN_CHUNK ? BANDWIDTH_LIMITER_MIN_CHUNK : chunk;
+    limiter->chunk = chunk > BANDWIDTH_LIMITER_MAX_CHUNK ? BANDWIDTH_LIMITER_MAX_CHUNK : chunk;
+
+    // at most one second of bandwidth could be saved by idle uploads
+    limiter->burst = limiter->rate > (double) limiter->chunk ? limiter->rate : (double) limiter->chunk;
+}
+
+void UtoolBandwidthLimiterDestroy(UtoolBandwidthLimiter *limiter)
+{
+    pthread_mutex_destroy(&(limiter->mutex));
+}
+
+void UtoolBandwidthLimiterAcquire(UtoolBandwidthLimiter *limiter, size_t bytes)
+{
+    pthread_mutex_lock(&(limiter->mutex));
+    double now = UtoolBandwidthLimiterClock();
+    limiter->tokens += (now - limiter->updated) * limiter->rate;
+    if (limiter->tokens > limiter->burst) {
+        limiter->tokens = limiter->burst;
+    }
+    limiter->updated = now;
+
+    // take tokens first, every upload waits until the debt made by all uploads is paid off
+    limiter->tokens -= (double) bytes;
+    double wait = limiter->tokens < 0 ? -limiter->tokens / limiter->rate : 0;
+    pthread_mutex_unlock(&(limiter->mutex));
+
+    if (wait > 0) {
+        struct timespec duration = {
+                .tv_sec = (time_t) wait,
+                .tv_nsec = (long) ((wait - (double) (time_t) wait) * 1000000000),
+        };
+        nanosleep(&duration, NULL);
+    }
+}
+
+size_t UtoolLimitedReadCallback(char *buffer, size_t size, size_t nitems, void *reader)
+{
+    UtoolLimitedReader *limited = (UtoolLimitedReader *) reader;
+    size_t len = size * nitems;
+    if (len > limited->limiter->chunk) {
+        len = limited->limiter->chunk;
+    }
+
+    size_t read = limited->read(buffer, 1, len, limited->data);
+    if (read > 0 && read != CURL_READFUNC_ABORT && read != CURL_READFUNC_PAUSE) {
+        UtoolBandwidthLimiterAcquire(limited->limiter, read);
+    }
+    return read;
+}
+
+int UtoolLimitedSeekCallback(void *reader, curl_off_t offset, int origin)
+{
+    UtoolLimitedReader *limited = (UtoolLimitedReader *) reader;
+    return limited->seek(limited->data, offset, origin);
+}
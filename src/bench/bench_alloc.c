@@ -0,0 +1,56 @@
+/*
+* Copyright © xFusion Digital Technologies Co., Ltd. 2012-2018. All rights reserved.
+* Description: allocation counter shared by benchmark executables
+* Author:
+* Create: 2019-06-16
+* Notes: glibc allows malloc to be interposed by executable, its own functions are still reachable through
+*        __libc_xxx.
+*/
+#include <stdlib.h>
+#include "bench_alloc.h"
+
+#if defined(__GLIBC__)
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t count, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+
+static unsigned long g_BenchAllocCount = 0;
+
+void *malloc(size_t size)
+{
+    __atomic_add_fetch(&g_BenchAllocCount, 1, __ATOMIC_RELAXED);
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size)
+{
+    __atomic_add_fetch(&g_BenchAllocCount, 1, __ATOMIC_RELAXED);
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *ptr, size_t size)
+{
+    __atomic_add_fetch(&g_BenchAllocCount, 1, __ATOMIC_RELAXED);
+    return __libc_realloc(ptr, size);
+}
+
+bool UtoolBenchAllocCounted(void)
+{
+    return true;
+}
+
+unsigned long UtoolBenchAllocCount(void)
+{
+    return __atomic_load_n(&g_BenchAllocCount, __ATOMIC_RELAXED);
+}
+#else
+bool UtoolBenchAllocCounted(void)
+{
+    return false;
+}
+
+unsigned long UtoolBenchAllocCount(void)
+{
+    return 0;
+}
+#endif
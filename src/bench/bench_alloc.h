@@ -0,0 +1,34 @@
+/*
+* Copyright © xFusion Digital Technologies Co., Ltd. 2012-2018. All rights reserved.
+* Description: allocation counter shared by benchmark executables
+* Author:
+* Create: 2019-06-16
+* Notes: malloc, calloc & realloc of the whole process are counted, libcurl & openssl included.
+*/
+#ifndef UTOOL_BENCH_ALLOC_H
+#define UTOOL_BENCH_ALLOC_H
+/* For c++ compatibility */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+
+/**
+ * whether allocations could be counted, glibc only
+ *
+ * @return
+ */
+bool UtoolBenchAllocCounted(void);
+
+/**
+ * count of malloc, calloc & realloc calls since process starts, always 0 if allocations are not counted
+ *
+ * @return
+ */
+unsigned long UtoolBenchAllocCount(void);
+
+#ifdef __cplusplus
+}
+#endif //UTOOL_BENCH_ALLOC_H
+#endif
@@ -0,0 +1,576 @@
+/*
+* Copyright © xFusion Digital Technologies Co., Ltd. 2012-2018. All rights reserved.
+* Description: benchmark every registered command against mock iBMC under several RTT profiles
+* Author:
+* Create: 2019-06-16
+* Notes: linux only, every command runs in a forked child so that peak RSS & malloc count are per command.
+*        utool runs ipmitool beside its own executable, the ipmitool stub of mock iBMC should be placed beside
+*        utool-bench.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+#include "curl/curl.h"
+#include "cJSON.h"
+#include "argparse.h"
+#include "securec.h"
+#include "utool.h"
+#include "commons.h"
+#include "json_stream.h"
+#include "bench_alloc.h"
+
+#ifndef UTOOL_BENCH_MOCK_SCRIPT
+#define UTOOL_BENCH_MOCK_SCRIPT "tools/mock-bmc/mock_bmc.py"
+#endif
+
+#define BENCH_DEFAULT_PORT 8443
+#define BENCH_DEFAULT_PROFILES "0,20,200"
+#define BENCH_MAX_PROFILES 16
+#define BENCH_MAX_ARGS 16
+#define BENCH_MAX_REPEAT 100
+#define BENCH_COMMAND_TIMEOUT_SECONDS 120
+#define BENCH_MOCK_READY_RETRIES 100
+#define BENCH_MOCK_RESPONSE_LEN 8192
+#define BENCH_MESSAGE_LEN 256
+
+/**
+ * Arguments of a command against mock iBMC fixtures, connect options are prepended by bench.
+ * Commands without case or with skip reason are reported as skipped.
+ */
+typedef struct _BenchCase
+{
+    const char *command;
+    const char *args[BENCH_MAX_ARGS];
+    const char *skipReason;
+} UtoolBenchCase;
+
+/**
+ * Measurement of a command run, written by child through pipe
+ */
+typedef struct _BenchRun
+{
+    int exited;                             /** whether child exits normally */
+    int ret;                                /** utool_main return code */
+    bool success;                           /** command succeeds, output state is not Failure */
+    double wallTimeMs;
+    unsigned long mallocs;
+    long peakRssKiB;
+    char message[BENCH_MESSAGE_LEN];        /** output if command fails */
+} UtoolBenchRun;
+
+typedef struct _BenchOption
+{
+    const char *mockScript;
+    const char *python;
+    const char *profiles;
+    const char *commands;
+    const char *output;
+    int port;
+    int repeat;
+} UtoolBenchOption;
+
+typedef struct _BenchMock
+{
+    pid_t pid;
+    int port;
+    CURL *curl;                             /** persistent control connection */
+} UtoolBenchMock;
+
+typedef struct _BenchMockResponse
+{
+    size_t size;
+    char content[BENCH_MOCK_RESPONSE_LEN];
+} UtoolBenchMockResponse;
+
+static const UtoolBenchCase g_UtoolBenchCases[] = {
+        {.command = "adduser", .args = {"-n", "benchuser", "-p", "Bench@12345", "-r", "Operator"}},
+        {.command = "setpwd", .args = {"-n", "operator", "-p", "Bench@12345"}},
+        {.command = "setpriv", .args = {"-n", "operator", "-r", "Commonuser"}},
+        {.command = "deluser", .args = {"-n", "commonuser"}},
+        {.command = "settimezone", .args = {"-z", "+08:00"}},
+        {.command = "powercontrol", .args = {"-t", "ForceRestart"}},
+        {.command = "setservice", .args = {"-s", "VNC", "-e", "Enabled", "-p", "5900"}},
+        {.command = "setip", .args = {"-v", "4", "-m", "Static", "-a", "127.0.0.1", "-g", "127.0.0.1", "-s",
+                                      "255.0.0.0"}},
+        {.command = "setvlan", .args = {"-e", "Disabled"}},
+        {.command = "settrapcom", .args = {"-e", "Enabled"}},
+        {.command = "settrapdest", .args = {"-d", "1", "-e", "Enabled", "-a", "127.0.0.1"}},
+        {.command = "locateserver", .args = {"-s", "On"}},
+        {.command = "setvnc", .args = {"-t", "480"}},
+        {.command = "setsysboot", .args = {"-d", "PXE", "-e", "Once", "-m", "UEFI"}},
+        {.command = "setbios", .args = {"-a", "QuickBoot", "-v", "Disabled"}},
+        {.command = "setfan", .args = {"-i", "255", "-m", "Manual", "-s", "50"}},
+        {.command = "locatedisk", .args = {"-i", "HDDPlaneDisk0", "-s", "On"}},
+        {.command = "setadaptiveport", .args = {"-p", "Dedicated,1;LOM,1"}},
+        {.command = "sendipmirawcmd", .args = {"-n", "0x06", "-c", "0x01"}},
+        {.command = "waittask", .args = {"-i", "1"}},
+        {.command = "mountvmm", .skipReason = "waits virtual media task"},
+        {.command = "geteventlog", .skipReason = "exports log through BMC task & file transfer"},
+        {.command = "restorebmc", .skipReason = "waits BMC to reboot"},
+        {.command = "resetbmc", .skipReason = "waits BMC to reboot"},
+        {.command = "fwupdate", .skipReason = "transfers firmware image & waits upgrade task"},
+        {.command = "fwrollout", .skipReason = "transfers firmware image & waits upgrade task"},
+        {.command = "collect", .skipReason = "transfers BMC dump files"},
+        {.command = "importbmccfg", .skipReason = "transfers configuration file & waits import task"},
+        {.command = "exportbmccfg", .skipReason = "transfers configuration file & waits export task"},
+        {.command = "exporter", .skipReason = "long running metrics service"},
+        {.command = "upload", .skipReason = "transfers file"},
+        {.command = "scp", .skipReason = "transfers file"},
+        {.command = "download", .skipReason = "transfers file"},
+        {0},
+};
+
+static const char *const usage[] = {
+        "utool-bench [-m mock-script] [-P port] [-r rtt-profiles] [-n repeat] [-c commands] [-o output]",
+        NULL,
+};
+
+static const UtoolBenchCase *BenchFindCase(const char *command)
+{
+    for (const UtoolBenchCase *benchCase = g_UtoolBenchCases; benchCase->command != NULL; benchCase++) {
+        if (strcmp(benchCase->command, command) == 0) {
+            return benchCase;
+        }
+    }
+    return NULL;
+}
+
+static bool BenchCommandSelected(const char *commands, const char *command)
+{
+    if (commands == NULL) {
+        return true;
+    }
+
+    size_t len = strlen(command);
+    for (const char *cursor = commands; (cursor = strstr(cursor, command)) != NULL; cursor += len) {
+        bool starts = cursor == commands || *(cursor - 1) == ',';
+        bool ends = cursor[len] == '\0' || cursor[len] == ',';
+        if (starts && ends) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static double BenchElapsedMs(const struct timespec *start, const struct timespec *end)
+{
+    return (double) (end->tv_sec - start->tv_sec) * 1000.0 + (double) (end->tv_nsec - start->tv_nsec) / 1000000.0;
+}
+
+static size_t BenchMockWriteCallback(void *content, size_t size, size_t count, void *userp)
+{
+    UtoolBenchMockResponse *response = (UtoolBenchMockResponse *) userp;
+    size_t len = size * count;
+    size_t room = BENCH_MOCK_RESPONSE_LEN - 1 - response->size;
+    size_t copied = len < room ? len : room;
+    if (copied > 0) {
+        memcpy_s(response->content + response->size, BENCH_MOCK_RESPONSE_LEN - response->size, content, copied);
+        response->size += copied;
+        response->content[response->size] = '\0';
+    }
+    return len;
+}
+
+/**
+ * Send control request to mock iBMC through the persistent control connection, control requests are not counted
+ * by mock iBMC, and reusing the connection keeps them out of connection & handshake counters too.
+ *
+ * @param mock
+ * @param method
+ * @param path
+ * @param output    parsed response, optional
+ * @return true if mock responses 200
+ */
+static bool BenchMockRequest(UtoolBenchMock *mock, const char *method, const char *path, cJSON **output)
+{
+    char url[256] = {0};
+    long httpStatusCode = 0;
+    bool ok = false;
+    CURL *curl = mock->curl;
+    UtoolBenchMockResponse *response = (UtoolBenchMockResponse *) calloc(1, sizeof(UtoolBenchMockResponse));
+    if (response == NULL) {
+        return false;
+    }
+
+    UtoolWrapSecFmt(url, sizeof(url), sizeof(url) - 1, "https://127.0.0.1:%d%s", mock->port, path);
+    curl_easy_setopt(curl, CURLOPT_URL, url);
+    curl_easy_setopt(curl, CURLOPT_HTTPGET, 1L);
+    if (strcmp(method, "POST") == 0) {
+        curl_easy_setopt(curl, CURLOPT_POSTFIELDS, "");
+    }
+    curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, method);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, response);
+
+    if (curl_easy_perform(curl) == CURLE_OK) {
+        curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &httpStatusCode);
+        ok = httpStatusCode == 200;
+    }
+    if (ok && output != NULL) {
+        *output = cJSON_Parse(response->content);
+        ok = *output != NULL;
+    }
+
+    FREE_OBJ(response)
+    return ok;
+}
+
+static void BenchStopMock(UtoolBenchMock *mock)
+{
+    if (mock->curl != NULL) {
+        curl_easy_cleanup(mock->curl);
+        mock->curl = NULL;
+    }
+    if (mock->pid > 0) {
+        kill(mock->pid, SIGTERM);
+        waitpid(mock->pid, NULL, 0);
+        mock->pid = -1;
+    }
+}
+
+/**
+ * Start mock iBMC with RTT profile, each request takes one RTT and each new connection takes two more for TCP &
+ * TLS handshake.
+ *
+ * @param option
+ * @param rttMs
+ * @param mock
+ * @return true if mock iBMC is ready
+ */
+static bool BenchStartMock(const UtoolBenchOption *option, int rttMs, UtoolBenchMock *mock)
+{
+    char port[16] = {0};
+    char latency[16] = {0};
+    char connectLatency[16] = {0};
+    char ipmiLatency[16] = {0};
+    UtoolWrapSecFmt(port, sizeof(port), sizeof(port) - 1, "%d", option->port);
+    UtoolWrapSecFmt(latency, sizeof(latency), sizeof(latency) - 1, "%d", rttMs);
+    UtoolWrapSecFmt(connectLatency, sizeof(connectLatency), sizeof(connectLatency) - 1, "%d", rttMs * 2);
+    UtoolWrapSecFmt(ipmiLatency, sizeof(ipmiLatency), sizeof(ipmiLatency) - 1, "%.3f", rttMs / 1000.0);
+
+    // ipmitool stub reports HTTPS port of mock & takes one RTT per IPMI command
+    setenv("UTOOL_MOCK_BMC_PORT", port, 1);
+    setenv("UTOOL_MOCK_IPMI_LATENCY", ipmiLatency, 1);
+
+    mock->port = option->port;
+    mock->curl = curl_easy_init();
+    if (mock->curl == NULL) {
+        return false;
+    }
+    curl_easy_setopt(mock->curl, CURLOPT_SSL_VERIFYPEER, 0L);
+    curl_easy_setopt(mock->curl, CURLOPT_SSL_VERIFYHOST, 0L);
+    curl_easy_setopt(mock->curl, CURLOPT_TIMEOUT, 10L);
+    curl_easy_setopt(mock->curl, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(mock->curl, CURLOPT_WRITEFUNCTION, BenchMockWriteCallback);
+
+    fflush(NULL);
+    mock->pid = fork();
+    if (mock->pid < 0) {
+        BenchStopMock(mock);
+        return false;
+    }
+
+    if (mock->pid == 0) {
+        FILE *ignored = freopen("/dev/null", "w", stdout);
+        (void) ignored;
+        execlp(option->python, option->python, option->mockScript, "--port", port, "--latency", latency,
+               "--connect-latency", connectLatency, NULL);
+        _exit(127);
+    }
+
+    for (int idx = 0; idx < BENCH_MOCK_READY_RETRIES; idx++) {
+        if (waitpid(mock->pid, NULL, WNOHANG) == mock->pid) {
+            fprintf(stderr, "Mock iBMC exits unexpectedly, please check %s.\n", option->mockScript);
+            mock->pid = -1;
+            BenchStopMock(mock);
+            return false;
+        }
+        if (BenchMockRequest(mock, "GET", "/mock/stats", NULL)) {
+            return true;
+        }
+        usleep(100000);
+    }
+
+    fprintf(stderr, "Mock iBMC is not ready in time.\n");
+    BenchStopMock(mock);
+    return false;
+}
+
+/**
+ * Run command in a forked child and collect measurement through pipe.
+ *
+ * @param argc
+ * @param argv
+ * @param run
+ */
+static void BenchRunCommand(int argc, char **argv, UtoolBenchRun *run)
+{
+    int fds[2] = {0};
+    memset_s(run, sizeof(UtoolBenchRun), 0, sizeof(UtoolBenchRun));
+    if (pipe(fds) != 0) {
+        UtoolWrapSecFmt(run->message, BENCH_MESSAGE_LEN, BENCH_MESSAGE_LEN - 1, "Failed to create pipe.");
+        return;
+    }
+
+    fflush(NULL);
+    pid_t pid = fork();
+    if (pid == 0) {
+        close(fds[0]);
+        alarm(BENCH_COMMAND_TIMEOUT_SECONDS);
+
+        // progress of commands goes to stdout, which is reserved for benchmark result
+        FILE *ignored = freopen("/dev/null", "w", stdout);
+        (void) ignored;
+
+        UtoolBenchRun *measured = &(UtoolBenchRun) {0};
+        char *result = NULL;
+        struct timespec start, end;
+        struct rusage usage;
+        unsigned long mallocs = UtoolBenchAllocCount();
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        measured->ret = utool_main(argc, argv, &result);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+
+        measured->mallocs = UtoolBenchAllocCount() - mallocs;
+        measured->wallTimeMs = BenchElapsedMs(&start, &end);
+        getrusage(RUSAGE_SELF, &usage);
+        measured->peakRssKiB = usage.ru_maxrss;
+        measured->exited = 1;
+
+        cJSON *output = result != NULL ? cJSON_Parse(result) : NULL;
+        cJSON *state = cJSON_GetObjectItem(output, "State");
+        measured->success = measured->ret == UTOOLE_OK &&
+                            !(cJSON_IsString(state) && strcmp(state->valuestring, STATE_FAILURE) == 0);
+        if (!measured->success && result != NULL) {
+            strncpy_s(measured->message, BENCH_MESSAGE_LEN, result, BENCH_MESSAGE_LEN - 1);
+        }
+
+        ssize_t written = write(fds[1], measured, sizeof(UtoolBenchRun));
+        _exit(written == (ssize_t) sizeof(UtoolBenchRun) ? 0 : 1);
+    }
+
+    close(fds[1]);
+    if (pid < 0) {
+        close(fds[0]);
+        UtoolWrapSecFmt(run->message, BENCH_MESSAGE_LEN, BENCH_MESSAGE_LEN - 1, "Failed to fork.");
+        return;
+    }
+
+    ssize_t received = read(fds[0], run, sizeof(UtoolBenchRun));
+    close(fds[0]);
+
+    int status = 0;
+    waitpid(pid, &status, 0);
+    if (received != (ssize_t) sizeof(UtoolBenchRun)) {
+        memset_s(run, sizeof(UtoolBenchRun), 0, sizeof(UtoolBenchRun));
+        UtoolWrapSecFmt(run->message, BENCH_MESSAGE_LEN, BENCH_MESSAGE_LEN - 1,
+                        WIFSIGNALED(status) ? "Command is killed by signal %d." : "Command exits with %d.",
+                        WIFSIGNALED(status) ? WTERMSIG(status) : WEXITSTATUS(status));
+    }
+}
+
+static int BenchCompareDouble(const void *left, const void *right)
+{
+    double l = *(const double *) left, r = *(const double *) right;
+    return l < r ? -1 : (l > r ? 1 : 0);
+}
+
+static void BenchAddNumber(cJSON *target, const char *key, cJSON *source, const char *sourceKey)
+{
+    cJSON *node = cJSON_GetObjectItem(source, sourceKey);
+    if (cJSON_IsNumber(node)) {
+        cJSON_AddNumberToObject(target, key, node->valuedouble);
+    } else {
+        cJSON_AddNullToObject(target, key);
+    }
+}
+
+/**
+ * Benchmark one command, mock resources are reloaded before every run so that SET commands do not affect others.
+ *
+ * @param option
+ * @param mock
+ * @param command
+ * @return measurement node
+ */
+static cJSON *BenchCommand(const UtoolBenchOption *option, UtoolBenchMock *mock, const UtoolCommand *command)
+{
+    cJSON *measurement = cJSON_CreateObject();
+    if (measurement == NULL) {
+        return NULL;
+    }
+    cJSON_AddStringToObject(measurement, "Command", command->name);
+
+    const UtoolBenchCase *benchCase = BenchFindCase(command->name);
+    if (benchCase != NULL && benchCase->skipReason != NULL) {
+        cJSON_AddStringToObject(measurement, "State", "Skipped");
+        cJSON_AddStringToObject(measurement, "Reason", benchCase->skipReason);
+        return measurement;
+    }
+
+    int argc = 0;
+    char *argv[BENCH_MAX_ARGS + 8] = {0};
+    argv[argc++] = "utool";
+    argv[argc++] = "-H";
+    argv[argc++] = "127.0.0.1";
+    argv[argc++] = "-U";
+    argv[argc++] = "Administrator";
+    argv[argc++] = "-P";
+    argv[argc++] = "Admin@9000";
+    argv[argc++] = (char *) command->name;
+    for (int idx = 0; benchCase != NULL && idx < BENCH_MAX_ARGS && benchCase->args[idx] != NULL; idx++) {
+        argv[argc++] = (char *) benchCase->args[idx];
+    }
+
+    double wallTimes[BENCH_MAX_REPEAT] = {0};
+    UtoolBenchRun *run = &(UtoolBenchRun) {0};
+    cJSON *stats = NULL;
+    for (int idx = 0; idx < option->repeat; idx++) {
+        FREE_CJSON(stats)
+        BenchMockRequest(mock, "POST", "/mock/reload", NULL);
+        BenchMockRequest(mock, "DELETE", "/mock/stats", NULL);
+        BenchRunCommand(argc, argv, run);
+        BenchMockRequest(mock, "GET", "/mock/stats", &stats);
+        wallTimes[idx] = run->wallTimeMs;
+        if (!run->exited) {
+            break;
+        }
+    }
+
+    if (!run->exited) {
+        cJSON_AddStringToObject(measurement, "State", "Crashed");
+        cJSON_AddStringToObject(measurement, "Message", run->message);
+        FREE_CJSON(stats)
+        return measurement;
+    }
+
+    qsort(wallTimes, (size_t) option->repeat, sizeof(double), BenchCompareDouble);
+    cJSON_AddStringToObject(measurement, "State", run->success ? "Success" : "Failure");
+    if (!run->success) {
+        cJSON_AddStringToObject(measurement, "Message", run->message);
+    }
+    cJSON_AddNumberToObject(measurement, "WallTimeMs", wallTimes[option->repeat / 2]);
+    cJSON_AddNumberToObject(measurement, "WallTimeMinMs", wallTimes[0]);
+    BenchAddNumber(measurement, "HttpRequests", stats, "Requests");
+    BenchAddNumber(measurement, "TlsHandshakes", stats, "Handshakes");
+    BenchAddNumber(measurement, "BytesSent", stats, "BytesReceived");
+    BenchAddNumber(measurement, "BytesReceived", stats, "BytesSent");
+    cJSON_AddNumberToObject(measurement, "PeakRssKiB", (double) run->peakRssKiB);
+    if (UtoolBenchAllocCounted()) {
+        cJSON_AddNumberToObject(measurement, "Mallocs", (double) run->mallocs);
+    } else {
+        cJSON_AddNullToObject(measurement, "Mallocs");
+    }
+    FREE_CJSON(stats)
+    return measurement;
+}
+
+/**
+ * Benchmark all selected commands under one RTT profile
+ *
+ * @param option
+ * @param rttMs
+ * @return profile node, NULL if mock iBMC could not start
+ */
+static cJSON *BenchProfile(const UtoolBenchOption *option, int rttMs)
+{
+    UtoolBenchMock *mock = &(UtoolBenchMock) {.pid = -1};
+    if (!BenchStartMock(option, rttMs, mock)) {
+        return NULL;
+    }
+
+    cJSON *profile = cJSON_CreateObject();
+    cJSON_AddNumberToObject(profile, "RttMs", rttMs);
+    cJSON *commands = cJSON_AddArrayToObject(profile, "Commands");
+    for (const UtoolCommand *command = g_UtoolCommands; command->name != NULL; command++) {
+        if (!BenchCommandSelected(option->commands, command->name)) {
+            continue;
+        }
+
+        fprintf(stderr, "[RTT %dms] %s\n", rttMs, command->name);
+        cJSON *measurement = BenchCommand(option, mock, command);
+        if (measurement != NULL) {
+            cJSON_AddItemToArray(commands, measurement);
+        }
+    }
+
+    BenchStopMock(mock);
+    return profile;
+}
+
+int main(int argc, char **argv)
+{
+    int ret = 0;
+    cJSON *output = NULL;
+    UtoolBenchOption *option = &(UtoolBenchOption) {
+            .mockScript = UTOOL_BENCH_MOCK_SCRIPT,
+            .python = "python3",
+            .profiles = BENCH_DEFAULT_PROFILES,
+            .port = BENCH_DEFAULT_PORT,
+            .repeat = 1,
+    };
+
+    struct argparse_option options[] = {
+            OPT_HELP(),
+            OPT_STRING('m', "mock", &(option->mockScript), "mock iBMC script", NULL, 0, 0),
+            OPT_STRING('y', "python", &(option->python), "python3 executable", NULL, 0, 0),
+            OPT_INTEGER('P', "port", &(option->port), "HTTPS port of mock iBMC, 8443 by default", NULL, 0, 0),
+            OPT_STRING('r', "rtt", &(option->profiles), "comma separated RTT profiles in ms, 0,20,200 by default",
+                       NULL, 0, 0),
+            OPT_INTEGER('n', "repeat", &(option->repeat), "runs per command, median wall time is reported", NULL, 0,
+                        0),
+            OPT_STRING('c', "commands", &(option->commands), "comma separated commands, all by default", NULL, 0, 0),
+            OPT_STRING('o', "output", &(option->output), "output JSON file, stdout by default", NULL, 0, 0),
+            OPT_END(),
+    };
+
+    struct argparse parser;
+    argparse_init(&parser, options, usage, 0);
+    argparse_parse(&parser, argc, (const char **) argv);
+    if (option->repeat < 1 || option->repeat > BENCH_MAX_REPEAT) {
+        fprintf(stderr, "Repeat should be in range [1, %d].\n", BENCH_MAX_REPEAT);
+        return 1;
+    }
+
+    // children inherit this, so every command skips global initialization of curl like a fresh process does
+    curl_global_init(CURL_GLOBAL_ALL);
+    output = cJSON_CreateObject();
+    cJSON *profiles = cJSON_AddArrayToObject(output, "Profiles");
+
+    char *nextp = NULL;
+    char profileList[256] = {0};
+    strncpy_s(profileList, sizeof(profileList), option->profiles, sizeof(profileList) - 1);
+    int count = 0;
+    for (char *token = strtok_r(profileList, ",", &nextp); token != NULL && count < BENCH_MAX_PROFILES;
+         token = strtok_r(NULL, ",", &nextp), count++) {
+        cJSON *profile = BenchProfile(option, atoi(token));
+        if (profile == NULL) {
+            ret = 1;
+            goto DONE;
+        }
+        cJSON_AddItemToArray(profiles, profile);
+    }
+
+    FILE *fp = option->output != NULL ? fopen(option->output, "w") : stdout;
+    if (fp == NULL || UtoolJsonPrintToFile(output, fp) != UTOOLE_OK) {
+        fprintf(stderr, "Failed to write benchmark result.\n");
+        ret = 1;
+    } else {
+        fputc('\n', fp);
+    }
+    if (fp != NULL && fp != stdout) {
+        fclose(fp);
+    }
+
+DONE:
+    FREE_CJSON(output)
+    curl_global_cleanup();
+    return ret;
+}
@@ -0,0 +1,567 @@
+/*
+* Copyright © xFusion Digital Technologies Co., Ltd. 2012-2018. All rights reserved.
+* Description: micro benchmark of mapping engine & string utilities on large payloads
+* Author:
+* Create: 2019-06-16
+* Notes: payloads are loaded from `--payloads` directory if present, otherwise they are synthesized with the same
+*        shape iBMC responses:
+*
+*        memory.json     array of /Systems/1/Memory/xxx resources
+*        sensors.json    /Chassis/1/ThresholdSensors resource
+*        bios.json       /Systems/1/Bios resource
+*        ipmi.txt        output of `ipmitool raw`
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <limits.h>
+#include <time.h>
+#include "cJSON.h"
+#include "cJSON_Utils.h"
+#include "argparse.h"
+#include "zf_log.h"
+#include "securec.h"
+#include "commons.h"
+#include "string_utils.h"
+#include "json_index.h"
+#include "json_stream.h"
+#include "mapped_file.h"
+#include "memory-mappings.h"
+#include "sensor-mappings.h"
+#include "ipmi.h"
+#include "bench_alloc.h"
+
+#define MICRO_BENCH_DEFAULT_DIMMS 64
+#define MICRO_BENCH_DEFAULT_SENSORS 500
+#define MICRO_BENCH_DEFAULT_BIOS_ATTRIBUTES 1000
+#define MICRO_BENCH_DEFAULT_IPMI_BYTES 256
+#define MICRO_BENCH_DEFAULT_MIN_TIME_MS 200
+#define MICRO_BENCH_MIN_ITERATIONS 3
+#define MICRO_BENCH_NAME_LEN 64
+
+typedef struct _MicroBenchOption
+{
+    const char *payloadDir;
+    const char *filter;
+    const char *output;
+    int dimms;
+    int sensors;
+    int biosAttributes;
+    int ipmiBytes;
+    int minTimeMs;
+} UtoolMicroBenchOption;
+
+/**
+ * Payloads shared by all cases, cases should not change them.
+ */
+typedef struct _MicroBenchPayloads
+{
+    UtoolRedfishServer *server;     /** only oemName is used by mapping engine */
+    cJSON *memories;                /** array of memory resources */
+    cJSON *sensors;                 /** ThresholdSensors resource */
+    cJSON *bios;                    /** Bios resource */
+    char **biosPointers;            /** JSON pointer of every BIOS attribute, NULL terminated */
+    char *ipmiOutput;               /** ipmitool raw output */
+    char *ipmiBuffer;               /** scratch copy of ipmiOutput, UtoolStringSplit changes its input */
+    size_t ipmiOutputLen;
+} UtoolMicroBenchPayloads;
+
+/**
+ * A micro benchmark case, `run` is one iteration over the whole payload, `nodes` is the payload node count the
+ * cost is divided by, so that results do not change with payload size.
+ */
+typedef struct _MicroBenchCase
+{
+    const char *name;
+    size_t (*nodes)(const UtoolMicroBenchPayloads *payloads);
+    int (*run)(UtoolMicroBenchPayloads *payloads);
+} UtoolMicroBenchCase;
+
+static const char *const usage[] = {
+        "utool-microbench [-d payload-dir] [-m dimms] [-s sensors] [-a bios-attributes] [-b ipmi-bytes] "
+        "[-t min-time-ms] [-f filter] [-o output]",
+        NULL,
+};
+
+static size_t CountNodes(const cJSON *node)
+{
+    size_t count = 0;
+    for (const cJSON *item = node; item != NULL; item = item->next) {
+        count += 1 + CountNodes(item->child);
+    }
+    return count;
+}
+
+static size_t MemoryNodes(const UtoolMicroBenchPayloads *payloads)
+{
+    return CountNodes(payloads->memories->child);
+}
+
+static size_t SensorNodes(const UtoolMicroBenchPayloads *payloads)
+{
+    return CountNodes(payloads->sensors->child);
+}
+
+static size_t BiosAttributeNodes(const UtoolMicroBenchPayloads *payloads)
+{
+    return (size_t) cJSON_GetArraySize(cJSON_GetObjectItem(payloads->bios, "Attributes"));
+}
+
+static size_t MemoryXpathNodes(const UtoolMicroBenchPayloads *payloads)
+{
+    size_t mappings = 0;
+    while (getMemoryMappings[mappings].sourceXpath != NULL) {
+        mappings++;
+    }
+    return mappings * (size_t) cJSON_GetArraySize(payloads->memories);
+}
+
+static size_t IpmiByteNodes(const UtoolMicroBenchPayloads *payloads)
+{
+    size_t count = 0;
+    for (const char *cursor = payloads->ipmiOutput; *cursor != '\0'; cursor++) {
+        if (*cursor != ' ' && (cursor == payloads->ipmiOutput || *(cursor - 1) == ' ')) {
+            count++;
+        }
+    }
+    return count;
+}
+
+/** `getmemory` maps every memory resource through getMemoryMappings */
+static int RunMapMemory(UtoolMicroBenchPayloads *payloads)
+{
+    int ret = UTOOLE_OK;
+    cJSON *memory = NULL;
+    cJSON_ArrayForEach(memory, payloads->memories) {
+        cJSON *mapped = cJSON_CreateObject();
+        ret = UtoolAssetCreatedJsonNotNull(mapped);
+        if (ret != UTOOLE_OK) {
+            return ret;
+        }
+        ret = UtoolMappingCJSONItems(payloads->server, memory, mapped, getMemoryMappings);
+        FREE_CJSON(mapped)
+        if (ret != UTOOLE_OK) {
+            return ret;
+        }
+    }
+    return ret;
+}
+
+/** `getsensor` maps ThresholdSensors through getThresholdSensorMappings */
+static int RunMapSensors(UtoolMicroBenchPayloads *payloads)
+{
+    cJSON *mapped = cJSON_CreateObject();
+    int ret = UtoolAssetCreatedJsonNotNull(mapped);
+    if (ret != UTOOLE_OK) {
+        return ret;
+    }
+    ret = UtoolMappingCJSONItems(payloads->server, payloads->sensors, mapped, getThresholdSensorMappings);
+    FREE_CJSON(mapped)
+    return ret;
+}
+
+/** xpath of every BIOS attribute resolved the way mapping engine resolves sourceXpath */
+static int RunPointerBios(UtoolMicroBenchPayloads *payloads)
+{
+    for (char **pointer = payloads->biosPointers; *pointer != NULL; pointer++) {
+        if (cJSONUtils_GetPointer(payloads->bios, *pointer) == NULL) {
+            return UTOOLE_INTERNAL;
+        }
+    }
+    return UTOOLE_OK;
+}
+
+/** every BIOS attribute looked up through json index the way `setbios --diff` does */
+static int RunIndexBios(UtoolMicroBenchPayloads *payloads)
+{
+    UtoolJsonIndex *index = &(UtoolJsonIndex) {0};
+    cJSON *attributes = cJSON_GetObjectItem(payloads->bios, "Attributes");
+    int ret = UtoolJsonIndexBuild(index, attributes);
+    if (ret != UTOOLE_OK) {
+        return ret;
+    }
+
+    cJSON *attribute = NULL;
+    cJSON_ArrayForEach(attribute, attributes) {
+        if (UtoolJsonIndexGet(index, attribute->string) == NULL) {
+            ret = UTOOLE_INTERNAL;
+            break;
+        }
+    }
+    UtoolJsonIndexFree(index);
+    return ret;
+}
+
+/** ${Oem} of every getMemoryMappings xpath replaced per memory resource the way mapping engine does */
+static int RunReplaceMemoryXpaths(UtoolMicroBenchPayloads *payloads)
+{
+    for (int idx = 0; idx < cJSON_GetArraySize(payloads->memories); idx++) {
+        for (const UtoolOutputMapping *mapping = getMemoryMappings; mapping->sourceXpath != NULL; mapping++) {
+            char *path = UtoolStringReplace(mapping->sourceXpath, VAR_OEM, payloads->server->oemName);
+            if (path == NULL) {
+                return UTOOLE_INTERNAL;
+            }
+            FREE_OBJ(path)
+        }
+    }
+    return UTOOLE_OK;
+}
+
+/** ipmitool output split into bytes the way `getipmiwhitelist` & firmware upgrade do */
+static int RunSplitIpmiOutput(UtoolMicroBenchPayloads *payloads)
+{
+    memcpy_s(payloads->ipmiBuffer, payloads->ipmiOutputLen + 1, payloads->ipmiOutput, payloads->ipmiOutputLen + 1);
+    char **segments = UtoolStringSplit(payloads->ipmiBuffer, ' ');
+    if (segments == NULL) {
+        return UTOOLE_INTERNAL;
+    }
+    UtoolStringFreeArrays(segments);
+    return UTOOLE_OK;
+}
+
+/** ipmitool output decoded into bytes the way IPMI commands read their response */
+static int RunDecodeIpmiOutput(UtoolMicroBenchPayloads *payloads)
+{
+    UtoolIPMIResponse response;
+    return UtoolIPMIDecodeResponse(payloads->ipmiOutput, &response);
+}
+
+static const UtoolMicroBenchCase g_UtoolMicroBenchCases[] = {
+        {.name = "UtoolMappingCJSONItems/getmemory", .nodes = MemoryNodes, .run = RunMapMemory},
+        {.name = "UtoolMappingCJSONItems/getsensor", .nodes = SensorNodes, .run = RunMapSensors},
+        {.name = "cJSONUtils_GetPointer/bios-attributes", .nodes = BiosAttributeNodes, .run = RunPointerBios},
+        {.name = "UtoolJsonIndexGet/bios-attributes", .nodes = BiosAttributeNodes, .run = RunIndexBios},
+        {.name = "UtoolStringReplace/getmemory-xpaths", .nodes = MemoryXpathNodes, .run = RunReplaceMemoryXpaths},
+        {.name = "UtoolStringSplit/ipmi-output", .nodes = IpmiByteNodes, .run = RunSplitIpmiOutput},
+        {.name = "UtoolIPMIDecodeResponse/ipmi-output", .nodes = IpmiByteNodes, .run = RunDecodeIpmiOutput},
+        {0},
+};
+
+/**
+ * Load payload file, NULL if payload directory is not specified or file does not exist
+ *
+ * @param option
+ * @param name
+ * @return mapped file
+ */
+static UtoolMappedFile *OpenPayloadFile(const UtoolMicroBenchOption *option, const char *name)
+{
+    char path[PATH_MAX] = {0};
+    char realPath[PATH_MAX] = {0};
+    if (option->payloadDir == NULL) {
+        return NULL;
+    }
+
+    UtoolWrapSecFmt(path, sizeof(path), sizeof(path) - 1, "%s/%s", option->payloadDir, name);
+    if (realpath(path, realPath) == NULL) {
+        return NULL;
+    }
+    return UtoolMappedFileOpen(realPath);
+}
+
+static cJSON *LoadJsonPayload(const UtoolMicroBenchOption *option, const char *name)
+{
+    UtoolMappedFile *file = OpenPayloadFile(option, name);
+    if (file == NULL) {
+        return NULL;
+    }
+
+    cJSON *payload = cJSON_ParseWithLength((const char *) file->data, file->size);
+    if (payload == NULL) {
+        fprintf(stderr, "Payload %s/%s is not valid JSON, synthesized one is used.\n", option->payloadDir, name);
+    }
+    UtoolMappedFileRelease(file);
+    return payload;
+}
+
+static cJSON *SynthesizeMemories(int count)
+{
+    cJSON *memories = cJSON_CreateArray();
+    for (int idx = 0; memories != NULL && idx < count; idx++) {
+        char memory[1024] = {0};
+        UtoolWrapSecFmt(memory, sizeof(memory), sizeof(memory) - 1,
+                        "{\"@odata.id\":\"/redfish/v1/Systems/1/Memory/mainboardDIMM%03d\","
+                        "\"Id\":\"mainboardDIMM%03d\",\"Name\":\"DIMM%03d\",\"DeviceLocator\":\"DIMM%03d\","
+                        "\"CapacityMiB\":32768,\"Manufacturer\":\"Samsung\",\"OperatingSpeedMhz\":2666,"
+                        "\"SerialNumber\":\"3A5B%04X\",\"MemoryDeviceType\":\"DDR4\",\"DataWidthBits\":72,"
+                        "\"RankCount\":2,\"PartNumber\":\"M393A4K40CB2-CTD\","
+                        "\"Status\":{\"State\":\"Enabled\",\"Health\":\"OK\"},"
+                        "\"Oem\":{\"Huawei\":{\"Position\":\"mainboard\","
+                        "\"Technology\":\"Synchronous| Registered (Buffered)\",\"MinVoltageMillivolt\":1200}}}",
+                        idx, idx, idx, idx, idx);
+        cJSON_AddItemToArray(memories, cJSON_Parse(memory));
+    }
+    return memories;
+}
+
+static cJSON *SynthesizeSensors(int count)
+{
+    cJSON *resource = cJSON_CreateObject();
+    cJSON *sensors = cJSON_AddArrayToObject(resource, "Sensors");
+    for (int idx = 0; sensors != NULL && idx < count; idx++) {
+        char sensor[512] = {0};
+        UtoolWrapSecFmt(sensor, sizeof(sensor), sizeof(sensor) - 1,
+                        "{\"SensorNumber\":%d,\"Name\":\"Sensor%d Temp\",\"ReadingValue\":%d,"
+                        "\"Unit\":\"degrees C\",\"Status\":\"ok\",\"UpperThresholdNonCritical\":null,"
+                        "\"UpperThresholdCritical\":%d,\"UpperThresholdFatal\":null,"
+                        "\"LowerThresholdNonCritical\":null,\"LowerThresholdCritical\":null,"
+                        "\"LowerThresholdFatal\":null}",
+                        idx + 1, idx + 1, 20 + idx % 40, 80 + idx % 20);
+        cJSON_AddItemToArray(sensors, cJSON_Parse(sensor));
+    }
+    cJSON_AddStringToObject(resource, "@odata.id", "/redfish/v1/Chassis/1/ThresholdSensors");
+    return resource;
+}
+
+static cJSON *SynthesizeBios(int count)
+{
+    cJSON *resource = cJSON_CreateObject();
+    cJSON_AddStringToObject(resource, "@odata.id", "/redfish/v1/Systems/1/Bios");
+    cJSON *attributes = cJSON_AddObjectToObject(resource, "Attributes");
+    for (int idx = 0; attributes != NULL && idx < count; idx++) {
+        char name[MICRO_BENCH_NAME_LEN] = {0};
+        UtoolWrapSecFmt(name, sizeof(name), sizeof(name) - 1, "BiosAttribute%04d", idx);
+        if (idx % 2 == 0) {
+            cJSON_AddStringToObject(attributes, name, idx % 4 == 0 ? "Enabled" : "Disabled");
+        } else {
+            cJSON_AddNumberToObject(attributes, name, idx);
+        }
+    }
+    return resource;
+}
+
+static char *SynthesizeIpmiOutput(int count)
+{
+    // " xx" per byte, 16 bytes per line
+    size_t len = (size_t) count * 3 + (size_t) count / 16 + 2;
+    char *output = (char *) calloc(len, sizeof(char));
+    size_t offset = 0;
+    for (int idx = 0; output != NULL && idx < count; idx++) {
+        UtoolWrapSecFmt(output + offset, len - offset, 3, " %02x", idx & 0xFF);
+        offset += 3;
+        if ((idx + 1) % 16 == 0 || idx + 1 == count) {
+            output[offset++] = '\n';
+        }
+    }
+    return output;
+}
+
+static char **BuildBiosPointers(cJSON *bios)
+{
+    cJSON *attributes = cJSON_GetObjectItem(bios, "Attributes");
+    int count = cJSON_GetArraySize(attributes);
+    char **pointers = (char **) calloc((size_t) count + 1, sizeof(char *));
+    int idx = 0;
+    cJSON *attribute = NULL;
+    cJSON_ArrayForEach(attribute, attributes) {
+        if (pointers == NULL) {
+            break;
+        }
+        // attribute names are plain identifiers, no JSON pointer escaping is needed
+        size_t len = strlen("/Attributes/") + strlen(attribute->string) + 1;
+        pointers[idx] = (char *) malloc(len);
+        if (pointers[idx] == NULL) {
+            UtoolStringFreeArrays(pointers);
+            return NULL;
+        }
+        UtoolWrapSecFmt(pointers[idx], len, len - 1, "/Attributes/%s", attribute->string);
+        idx++;
+    }
+    return pointers;
+}
+
+/**
+ * Load or synthesize all payloads
+ *
+ * @param option
+ * @param payloads
+ * @return UTOOLE_OK if succeed
+ */
+static int PreparePayloads(const UtoolMicroBenchOption *option, UtoolMicroBenchPayloads *payloads)
+{
+    payloads->memories = LoadJsonPayload(option, "memory.json");
+    if (!cJSON_IsArray(payloads->memories)) {
+        FREE_CJSON(payloads->memories)
+        payloads->memories = SynthesizeMemories(option->dimms);
+    }
+
+    payloads->sensors = LoadJsonPayload(option, "sensors.json");
+    if (!cJSON_IsArray(cJSON_GetObjectItem(payloads->sensors, "Sensors"))) {
+        FREE_CJSON(payloads->sensors)
+        payloads->sensors = SynthesizeSensors(option->sensors);
+    }
+
+    payloads->bios = LoadJsonPayload(option, "bios.json");
+    if (!cJSON_IsObject(cJSON_GetObjectItem(payloads->bios, "Attributes"))) {
+        FREE_CJSON(payloads->bios)
+        payloads->bios = SynthesizeBios(option->biosAttributes);
+    }
+
+    UtoolMappedFile *ipmi = OpenPayloadFile(option, "ipmi.txt");
+    if (ipmi != NULL) {
+        payloads->ipmiOutput = UtoolStringNDup((const char *) ipmi->data, ipmi->size);
+        UtoolMappedFileRelease(ipmi);
+    } else {
+        payloads->ipmiOutput = SynthesizeIpmiOutput(option->ipmiBytes);
+    }
+
+    if (payloads->memories == NULL || payloads->sensors == NULL || payloads->bios == NULL ||
+        payloads->ipmiOutput == NULL) {
+        return UTOOLE_INTERNAL;
+    }
+
+    payloads->ipmiOutputLen = strlen(payloads->ipmiOutput);
+    payloads->ipmiBuffer = (char *) malloc(payloads->ipmiOutputLen + 1);
+    payloads->biosPointers = BuildBiosPointers(payloads->bios);
+    return payloads->ipmiBuffer != NULL && payloads->biosPointers != NULL ? UTOOLE_OK : UTOOLE_INTERNAL;
+}
+
+static void FreePayloads(UtoolMicroBenchPayloads *payloads)
+{
+    FREE_CJSON(payloads->memories)
+    FREE_CJSON(payloads->sensors)
+    FREE_CJSON(payloads->bios)
+    FREE_OBJ(payloads->ipmiOutput)
+    FREE_OBJ(payloads->ipmiBuffer)
+    UtoolStringFreeArrays(payloads->biosPointers);
+    payloads->biosPointers = NULL;
+}
+
+static double ElapsedNs(const struct timespec *start, const struct timespec *end)
+{
+    return (double) (end->tv_sec - start->tv_sec) * 1e9 + (double) (end->tv_nsec - start->tv_nsec);
+}
+
+/**
+ * Run a case repeatedly for at least min time, one warm up iteration is not measured.
+ *
+ * @param option
+ * @param benchCase
+ * @param payloads
+ * @return measurement node, NULL if case fails
+ */
+static cJSON *RunCase(const UtoolMicroBenchOption *option, const UtoolMicroBenchCase *benchCase,
+                      UtoolMicroBenchPayloads *payloads)
+{
+    size_t nodes = benchCase->nodes(payloads);
+    if (nodes == 0 || benchCase->run(payloads) != UTOOLE_OK) {
+        fprintf(stderr, "Micro benchmark %s fails on its payload.\n", benchCase->name);
+        return NULL;
+    }
+
+    struct timespec start, now;
+    double elapsed = 0;
+    long iterations = 0;
+    unsigned long allocs = UtoolBenchAllocCount();
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    do {
+        if (benchCase->run(payloads) != UTOOLE_OK) {
+            return NULL;
+        }
+        iterations++;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        elapsed = ElapsedNs(&start, &now);
+    } while (iterations < MICRO_BENCH_MIN_ITERATIONS || elapsed < option->minTimeMs * 1e6);
+    allocs = UtoolBenchAllocCount() - allocs;
+
+    double total = (double) iterations * (double) nodes;
+    cJSON *measurement = cJSON_CreateObject();
+    cJSON_AddStringToObject(measurement, "Name", benchCase->name);
+    cJSON_AddNumberToObject(measurement, "Nodes", (double) nodes);
+    cJSON_AddNumberToObject(measurement, "Iterations", (double) iterations);
+    cJSON_AddNumberToObject(measurement, "NsPerNode", elapsed / total);
+    if (UtoolBenchAllocCounted()) {
+        cJSON_AddNumberToObject(measurement, "AllocsPerNode", (double) allocs / total);
+    } else {
+        cJSON_AddNullToObject(measurement, "AllocsPerNode");
+    }
+    return measurement;
+}
+
+int main(int argc, char **argv)
+{
+    int ret = 1;
+    cJSON *output = NULL;
+    UtoolMicroBenchPayloads *payloads = &(UtoolMicroBenchPayloads) {
+            .server = &(UtoolRedfishServer) {.oemName = DEFAULT_OEM},
+    };
+    UtoolMicroBenchOption *option = &(UtoolMicroBenchOption) {
+            .dimms = MICRO_BENCH_DEFAULT_DIMMS,
+            .sensors = MICRO_BENCH_DEFAULT_SENSORS,
+            .biosAttributes = MICRO_BENCH_DEFAULT_BIOS_ATTRIBUTES,
+            .ipmiBytes = MICRO_BENCH_DEFAULT_IPMI_BYTES,
+            .minTimeMs = MICRO_BENCH_DEFAULT_MIN_TIME_MS,
+    };
+
+    struct argparse_option options[] = {
+            OPT_HELP(),
+            OPT_STRING('d', "payloads", &(option->payloadDir), "directory of recorded payloads", NULL, 0, 0),
+            OPT_INTEGER('m', "dimms", &(option->dimms), "synthesized memory count, 64 by default", NULL, 0, 0),
+            OPT_INTEGER('s', "sensors", &(option->sensors), "synthesized threshold sensor count, 500 by default",
+                        NULL, 0, 0),
+            OPT_INTEGER('a', "bios-attributes", &(option->biosAttributes),
+                        "synthesized BIOS attribute count, 1000 by default", NULL, 0, 0),
+            OPT_INTEGER('b', "ipmi-bytes", &(option->ipmiBytes), "synthesized ipmitool output bytes, 256 by default",
+                        NULL, 0, 0),
+            OPT_INTEGER('t', "min-time", &(option->minTimeMs), "min measured time per case in ms, 200 by default",
+                        NULL, 0, 0),
+            OPT_STRING('f', "filter", &(option->filter), "only run cases whose name contains filter", NULL, 0, 0),
+            OPT_STRING('o', "output", &(option->output), "output JSON file, stdout by default", NULL, 0, 0),
+            OPT_END(),
+    };
+
+    struct argparse parser;
+    argparse_init(&parser, options, usage, 0);
+    argparse_parse(&parser, argc, (const char **) argv);
+    if (option->dimms < 1 || option->sensors < 1 || option->biosAttributes < 1 || option->ipmiBytes < 1 ||
+        option->minTimeMs < 0) {
+        fprintf(stderr, "Payload sizes should be positive.\n");
+        return 1;
+    }
+
+    // informational logs of mapped files go to stderr otherwise
+    zf_log_set_output_level(ZF_LOG_WARN);
+    if (PreparePayloads(option, payloads) != UTOOLE_OK) {
+        fprintf(stderr, "Failed to prepare payloads.\n");
+        goto DONE;
+    }
+
+    output = cJSON_CreateObject();
+    cJSON *sizes = cJSON_AddObjectToObject(output, "Payloads");
+    cJSON_AddNumberToObject(sizes, "Memories", cJSON_GetArraySize(payloads->memories));
+    cJSON_AddNumberToObject(sizes, "ThresholdSensors",
+                            cJSON_GetArraySize(cJSON_GetObjectItem(payloads->sensors, "Sensors")));
+    cJSON_AddNumberToObject(sizes, "BiosAttributes", (double) BiosAttributeNodes(payloads));
+    cJSON_AddNumberToObject(sizes, "IpmiBytes", (double) IpmiByteNodes(payloads));
+
+    cJSON *benchmarks = cJSON_AddArrayToObject(output, "Benchmarks");
+    for (const UtoolMicroBenchCase *benchCase = g_UtoolMicroBenchCases; benchCase->name != NULL; benchCase++) {
+        if (option->filter != NULL && strstr(benchCase->name, option->filter) == NULL) {
+            continue;
+        }
+
+        fprintf(stderr, "%s\n", benchCase->name);
+        cJSON *measurement = RunCase(option, benchCase, payloads);
+        if (measurement == NULL) {
+            goto DONE;
+        }
+        cJSON_AddItemToArray(benchmarks, measurement);
+    }
+
+    FILE *fp = option->output != NULL ? fopen(option->output, "w") : stdout;
+    if (fp == NULL || UtoolJsonPrintToFile(output, fp) != UTOOLE_OK) {
+        fprintf(stderr, "Failed to write micro benchmark result.\n");
+    } else {
+        fputc('\n', fp);
+        ret = 0;
+    }
+    if (fp != NULL && fp != stdout) {
+        fclose(fp);
+    }
+
+DONE:
+    FREE_CJSON(output)
+    FreePayloads(payloads);
+    return ret;
+}
@@ -42,13 +42,8 @@ int UtoolCmdDeleteUser(UtoolCommandOption *commandOption, char **result)
     char *username = NULL;
 
     UtoolRedfishServer *server = &(UtoolRedfishServer) {0};
-    UtoolCurlResponse *getUserResponse = &(UtoolCurlResponse) {0};
+    UtoolResult *findAccountResult = &(UtoolResult) {0};
     UtoolCurlResponse *deleteUserResponse = &(UtoolCurlResponse) {0};
-    UtoolCurlResponse *getUserMemberResponse = &(UtoolCurlResponse) {0};
-
-    // initialize output objects
-    cJSON *userMembersJson = NULL,        // curl response user member as json
-            *userJson = NULL;              // curl response user as json
 
     struct argparse_option options[] = {
             OPT_BOOLEAN('h', "help", &(commandOption->flag), HELP_SUB_COMMAND_DESC, UtoolGetHelpOptionCallback, 0, 0),
@@ -78,84 +73,29 @@ int UtoolCmdDeleteUser(UtoolCommandOption *commandOption, char **result)
         goto FAILURE;
     }
 
-    ret = UtoolMakeCurlRequest(server, "/AccountService/Accounts", HTTP_GET, NULL, NULL, getUserMemberResponse);
-    if (ret != UTOOLE_OK) {
-        goto FAILURE;
-    }
-
-    // process get chassis response
-    if (getUserMemberResponse->httpStatusCode >= 400) {
-        ret = UtoolResolveFailureResponse(getUserMemberResponse, result);
-        goto DONE;
-    }
-
-    userMembersJson = cJSON_Parse(getUserMemberResponse->content);
-    ret = UtoolAssetParseJsonNotNull(userMembersJson);
-    if (ret != UTOOLE_OK) {
+    const cJSON *account = UtoolRedfishFindAccount(server, username, findAccountResult);
+    if (findAccountResult->broken) {
+        ret = findAccountResult->code;
+        *result = findAccountResult->desc;
         goto FAILURE;
     }
 
-    bool foundUserWithName = false;
-    char *userAccountUrl = NULL;
-    cJSON *members = cJSON_GetObjectItem(userMembersJson, "Members");
-    int memberCount = cJSON_GetArraySize(members);
-    for (int idx = 0; idx < memberCount && !foundUserWithName; idx++) {
-        cJSON *userLinkObject = cJSON_GetArrayItem(members, idx);
-        cJSON *link = cJSON_GetObjectItem(userLinkObject, "@odata.id");
-        ret = UtoolAssetJsonNodeNotNull(link, "/Members/*/@odata.id");
-        if (ret != UTOOLE_OK) {
-            goto FAILURE;
-        }
-
-        userAccountUrl = link->valuestring;
-        ret = UtoolMakeCurlRequest(server, userAccountUrl, HTTP_GET, NULL, NULL, getUserResponse);
-        if (ret != UTOOLE_OK) {
-            goto FAILURE;
-        }
-
-        if (getUserResponse->httpStatusCode >= 400) {
-            ret = UtoolResolveFailureResponse(getUserResponse, result);
-            goto FAILURE;
-        }
-
-        userJson = cJSON_Parse(getUserResponse->content);
-        ret = UtoolAssetParseJsonNotNull(userJson);
-        if (ret != UTOOLE_OK) {
-            goto FAILURE;
-        }
-
-        cJSON *userNameNode = cJSON_GetObjectItem(userJson, "UserName");
-        ret = UtoolAssetJsonNodeNotNull(userNameNode, "UserName");
-        char *currentUsername = userNameNode->valuestring;
-        if (ret != UTOOLE_OK || username == NULL) {
-            goto FAILURE;
-        }
-
-        if (UtoolStringEquals(username, currentUsername)) {
-            foundUserWithName = true;
-            ZF_LOGI("Current username is %s, matched.", username);
-            break;
-        } else {
-            ZF_LOGI("Current username is %s, does not matched.", currentUsername);
-        }
-
-        FREE_CJSON(userJson)
-        UtoolFreeCurlResponse(getUserResponse);
-    }
-
-    if (!foundUserWithName) {
+    if (account == NULL) {
         char buffer[MAX_FAILURE_MSG_LEN];
         UtoolWrapSecFmt(buffer, MAX_FAILURE_MSG_LEN, MAX_FAILURE_MSG_LEN - 1,
                         "Failure: No user with name `%s` exists", username);
         ret = UtoolBuildStringOutputResult(STATE_FAILURE, buffer, result);
     } else {
-        // delete user
+        // delete user, ETag in account index is used directly
+        char *userAccountUrl = cJSON_GetObjectItem(account, "@odata.id")->valuestring;
+        const cJSON *etag = cJSON_GetObjectItem(account, "@odata.etag");
         const UtoolCurlHeader ifMatchHeader[] = {
-                {.name = HEADER_IF_MATCH, .value=getUserResponse->etag},
+                {.name = HEADER_IF_MATCH, .value=etag != NULL ? etag->valuestring : NULL},
                 NULL,
         };
 
-        ret = UtoolMakeCurlRequest(server, userAccountUrl, HTTP_DELETE, NULL, NULL, deleteUserResponse);
+        ret = UtoolMakeCurlRequest(server, userAccountUrl, HTTP_DELETE, NULL, etag != NULL ? ifMatchHeader : NULL,
+                                   deleteUserResponse);
         if (ret != UTOOLE_OK) {
             goto FAILURE;
         }
@@ -165,6 +105,7 @@ int UtoolCmdDeleteUser(UtoolCommandOption *commandOption, char **result)
             goto FAILURE;
         }
 
+        UtoolRedfishForgetAccount(server, username);
         UtoolBuildDefaultSuccessResult(result);
     }
 
@@ -174,11 +115,7 @@ FAILURE:
     goto DONE;
 
 DONE:
-    FREE_CJSON(userJson)
-    FREE_CJSON(userMembersJson)
-    UtoolFreeCurlResponse(getUserResponse);
     UtoolFreeCurlResponse(deleteUserResponse);
-    UtoolFreeCurlResponse(getUserMemberResponse);
     UtoolFreeRedfishServer(server);
     return ret;
 }
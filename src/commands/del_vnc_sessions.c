@@ -22,6 +22,7 @@
 
 static const char *VNCSessionUserTag = "VNC";
 static const UtoolOutputMapping getSessionsMapping[] = {
+        {.sourceXpath = "/Id", .targetKeyValue="Id"},
         {.sourceXpath = "/@odata.id", .targetKeyValue="Url"},
         {.sourceXpath = "/Oem/${Oem}/UserTag", .targetKeyValue="UserTag"},
         NULL
@@ -33,6 +34,13 @@ static const char *const usage[] = {
         NULL,
 };
 
+static const char *SESSION_DELETED = "Deleted";
+static const char *SESSION_EXPIRED = "Expired";
+static const char *SESSION_DELETE_FAILED = "Failed";
+
+static void DeleteSessionCallback(UtoolRedfishAsyncGroup *group, UtoolRedfishAsyncRequest *request,
+                                  UtoolResult *result);
+
 
 /**
 * delete all VNC sessions, command handler for `delvncsession`
@@ -46,7 +54,7 @@ int UtoolCmdDeleteVNCSession(UtoolCommandOption *commandOption, char **outputStr
     UtoolResult *result = &(UtoolResult) {0};
     UtoolRedfishServer *server = &(UtoolRedfishServer) {0};
 
-    cJSON *sessionMembersResJson = NULL, *sessions = NULL;
+    cJSON *sessionMembersResJson = NULL, *sessions = NULL, *statuses = NULL;
 
 
     struct argparse_option options[] = {
@@ -72,7 +80,7 @@ int UtoolCmdDeleteVNCSession(UtoolCommandOption *commandOption, char **outputStr
     }
 
     /** get all session members */
-    UtoolRedfishGet(server, "/SessionService/Sessions", NULL, NULL, result);
+    UtoolRedfishGetCollection(server, "/SessionService/Sessions", getSessionsMapping, result);
     if (result->broken) {
         goto FAILURE;
     }
@@ -89,38 +97,86 @@ int UtoolCmdDeleteVNCSession(UtoolCommandOption *commandOption, char **outputStr
         goto FAILURE;
     }
 
+    statuses = cJSON_CreateArray();
+    result->code = UtoolAssetCreatedJsonNotNull(statuses);
+    if (result->code != UTOOLE_OK) {
+        goto FAILURE;
+    }
+
+    // delete VNC sessions concurrently, at most REDFISH_ASYNC_MAX_IN_FLIGHT requests are in flight.
+    // group is marked broken if any session is invalid, then no session is deleted
+    UtoolRedfishAsyncGroup *group = &(UtoolRedfishAsyncGroup) {0};
+    UtoolRedfishAsyncGroupInit(group, server, 0);
+
     cJSON *session = NULL;
     cJSON_ArrayForEach(session, sessions) {
         cJSON *tag = cJSON_GetObjectItem(session, "UserTag");
         result->code = UtoolAssetJsonNodeNotNull(tag, "/Oem/${Oem}/UserTag");
         if (result->code != UTOOLE_OK) {
-            goto FAILURE;
+            group->broken = true;
+            break;
         }
 
         if (UtoolStringEquals(VNCSessionUserTag, tag->valuestring)) {
             cJSON *url = cJSON_GetObjectItem(session, "Url");
             result->code = UtoolAssetJsonNodeNotNull(url, "/@odata.id");
             if (result->code != UTOOLE_OK) {
-                goto FAILURE;
+                group->broken = true;
+                break;
             }
 
-            UtoolRedfishDelete(server, url->valuestring, NULL, NULL, result);
-            if (result->broken) {
-                goto FAILURE;
+            cJSON *status = cJSON_CreateObject();
+            result->code = UtoolAssetCreatedJsonNotNull(status);
+            if (result->code != UTOOLE_OK) {
+                group->broken = true;
+                break;
             }
+            cJSON_AddItemToArray(statuses, status);
 
-            FREE_CJSON(result->data);
+            cJSON *id = cJSON_GetObjectItem(session, "Id");
+            const char *sessionId = cJSON_IsString(id) ? id->valuestring : url->valuestring;
+            cJSON *node = cJSON_AddStringToObject(status, "Id", sessionId);
+            result->code = UtoolAssetCreatedJsonNotNull(node);
+            if (result->code != UTOOLE_OK) {
+                group->broken = true;
+                break;
+            }
+
+            UtoolRedfishAsyncSubmit(group, url->valuestring, HTTP_DELETE, NULL, NULL, NULL, NULL,
+                                    DeleteSessionCallback, status);
         }
     }
 
+    UtoolRedfishAsyncGroupRun(group, result);
+    if (result->broken || result->code != UTOOLE_OK) {
+        goto FAILURE;
+    }
+
     // output to outputStr
-    UtoolBuildDefaultSuccessResult(&(result->desc));
+    if (cJSON_GetArraySize(statuses) == 0) {
+        UtoolBuildDefaultSuccessResult(&(result->desc));
+        goto DONE;
+    }
+
+    const char *state = STATE_SUCCESS;
+    cJSON *item = NULL;
+    cJSON_ArrayForEach(item, statuses) {
+        cJSON *statusNode = cJSON_GetObjectItem(item, "Status");
+        if (cJSON_IsString(statusNode) && UtoolStringEquals(statusNode->valuestring, SESSION_DELETE_FAILED)) {
+            state = STATE_FAILURE;
+            break;
+        }
+    }
+
+    result->code = UtoolBuildOutputResult(state, statuses, &(result->desc));
+    statuses = NULL;
     goto DONE;
 
 FAILURE:
     goto DONE;
 
 DONE:
+    FREE_CJSON(statuses)
     FREE_CJSON(sessions)
     FREE_CJSON(sessionMembersResJson)
     UtoolFreeRedfishServer(server);
@@ -128,3 +184,55 @@ DONE:
     *outputStr = result->desc;
     return result->code;
 }
+
+/**
+* Record delete status of a VNC session into its status node.
+*
+* A session which is not found (404) has been expired since sessions were listed, it is treated as done. Other
+* failures are recorded in status node too, so that the rest sessions are still deleted.
+*
+* @param group
+* @param request
+* @param result
+*/
+static void DeleteSessionCallback(UtoolRedfishAsyncGroup *group, UtoolRedfishAsyncRequest *request,
+                                  UtoolResult *result)
+{
+    (void) group;
+    cJSON *status = (cJSON *) request->context;
+    cJSON *messages = NULL;
+    FREE_CJSON(result->data)
+
+    // session is deleted even if response has no content
+    long httpStatusCode = request->response.httpStatusCode;
+    if (!result->broken || (httpStatusCode >= 200 && httpStatusCode < 300)) {
+        cJSON_AddStringToObject(status, "Status", SESSION_DELETED);
+        goto DONE;
+    }
+
+    if (httpStatusCode == 404) {
+        ZF_LOGI("VNC session %s has been expired.", request->url);
+        cJSON_AddStringToObject(status, "Status", SESSION_EXPIRED);
+        goto DONE;
+    }
+
+    ZF_LOGE("Failed to delete VNC session %s.", request->url);
+    cJSON_AddStringToObject(status, "Status", SESSION_DELETE_FAILED);
+
+    // failure output is {"State": "Failure", "Message": [...]}, only its messages are kept
+    cJSON *failure = result->desc != NULL ? cJSON_Parse(result->desc) : NULL;
+    messages = cJSON_DetachItemFromObject(failure, "Message");
+    FREE_CJSON(failure)
+    if (messages == NULL) {
+        int code = result->code;
+        messages = cJSON_CreateString((code > UTOOLE_OK && code < ((int) CURL_LAST)) ?
+                                      curl_easy_strerror((CURLcode) code) : UtoolGetStringError((UtoolCode) code));
+    }
+    if (messages != NULL) {
+        cJSON_AddItemToObject(status, "Message", messages);
+    }
+
+DONE:
+    result->broken = 0;
+    result->code = UTOOLE_OK;
+}
@@ -0,0 +1,1047 @@
+/*
+* Copyright © xFusion Digital Technologies Co., Ltd. 2018-2019. All rights reserved.
+* Description: command handler for `exporter`, exposes sensor data as Prometheus metrics
+* Author:
+* Create: 2019-06-14
+* Notes:
+*/
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#include <signal.h>
+#include <pthread.h>
+#include <time.h>
+#include <errno.h>
+#include <ctype.h>
+#if defined(__MINGW32__)
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#endif
+#include "cJSON_Utils.h"
+#include "commons.h"
+#include "curl/curl.h"
+#include "zf_log.h"
+#include "constants.h"
+#include "command-helps.h"
+#include "command-interfaces.h"
+#include "argparse.h"
+#include "redfish.h"
+#include "string_utils.h"
+#include "sensor-mappings.h"
+#include "resource_cache.h"
+
+#if defined(__MINGW32__)
+typedef SOCKET ExporterSocket;
+#define EXPORTER_INVALID_SOCKET INVALID_SOCKET
+#define EXPORTER_CLOSE_SOCKET closesocket
+#define EXPORTER_SEND_FLAGS 0
+#else
+typedef int ExporterSocket;
+#define EXPORTER_INVALID_SOCKET (-1)
+#define EXPORTER_CLOSE_SOCKET close
+#define EXPORTER_SEND_FLAGS MSG_NOSIGNAL
+#endif
+
+#define EXPORTER_DEFAULT_ADDRESS "127.0.0.1"
+#define EXPORTER_DEFAULT_PORT 9798
+#define EXPORTER_DEFAULT_INTERVAL 30
+#define EXPORTER_MIN_INTERVAL 5
+#define EXPORTER_MAX_INTERVAL 3600
+#define EXPORTER_MAX_TARGETS 64
+#define EXPORTER_MAX_REQUEST_LEN 4096
+#define EXPORTER_CLIENT_TIMEOUT 5
+#define EXPORTER_BUFFER_INIT_SIZE 8192
+#define EXPORTER_METRICS_PATH "/metrics"
+#define EXPORTER_CONTENT_TYPE "text/plain; version=0.0.4; charset=utf-8"
+
+static const char *OPTION_LISTEN_PORT_ILLEGAL = "Error: option `listen-port` is illegal, range: 1-65535.";
+static const char *OPTION_SCRAPE_INTERVAL_ILLEGAL = "Error: option `scrape-interval` is illegal, range: 5-3600.";
+static const char *OPTION_TARGETS_ILLEGAL = "Error: option `targets` is illegal, at most 64 hosts split by comma.";
+static const char *EXPORTER_LISTEN_FAILED = "Error: failed to listen on %s:%d.";
+static const char *EXPORTER_STOPPED = "Exporter stopped.";
+
+static const char *const usage[] = {
+        "exporter [-a listen-address] [-l listen-port] [-i scrape-interval] [-t targets]",
+        NULL,
+};
+
+/**
+ * A group of metrics, all properties of one sensor command output are exported as gauges of the group.
+ */
+typedef struct _ExporterMetricGroup {
+    const char *name;               /* metric name prefix, utool_<name>_<property> */
+    const char *command;            /* sensor command whose output the group follows */
+    const char *labels[3];          /* member properties exported as labels instead of gauges */
+} ExporterMetricGroup;
+
+/**
+ * A redfish resource mapped into a metric group with the mapping tables of sensor commands.
+ */
+typedef struct _ExporterSource {
+    const char *url;
+    const ExporterMetricGroup *group;
+    const UtoolOutputMapping *mapping;          /* mapping of resource itself, could be NULL */
+    const char *membersKey;                     /* members array of resource, could be NULL */
+    const UtoolOutputMapping *memberMapping;    /* mapping of each member */
+} ExporterSource;
+
+static const ExporterMetricGroup g_ExporterTemperature = {"temperature", "gettemp", {"Name", "SensorNumber", NULL}};
+static const ExporterMetricGroup g_ExporterFan = {"fan", "getfan", {"Id", "CommonName", "Location"}};
+static const ExporterMetricGroup g_ExporterVoltage = {"voltage", "getvolt", {"Name", "SensorNumber", NULL}};
+static const ExporterMetricGroup g_ExporterPsu = {"psu", "getpsu", {"Id", "CommonName", "Location"}};
+static const ExporterMetricGroup g_ExporterSensor = {"sensor", "getsensor", {"SensorName", "SensorNumber", "Unit"}};
+
+static const ExporterSource g_ExporterSources[] = {
+        {"/Chassis/%s/Thermal", &g_ExporterTemperature, NULL, "Temperatures", getTemperatureMappings},
+        {"/Chassis/%s/Thermal", &g_ExporterFan, getFanSummaryMapping, "Fans", getFanMappings},
+        {"/Chassis/%s/Power", &g_ExporterVoltage, NULL, "Voltages", getVoltageMappings},
+        {"/Chassis/%s/Power", &g_ExporterPsu, NULL, "PowerSupplies", getPowerSupplyMapping},
+        {"/Chassis/%s", &g_ExporterPsu, getPowerSummaryMapping, NULL, NULL},
+        {"/Chassis/%s/ThresholdSensors", &g_ExporterSensor, getThresholdSensorMappings, NULL, NULL},
+};
+
+#define EXPORTER_SOURCE_COUNT ((int) (sizeof(g_ExporterSources) / sizeof(g_ExporterSources[0])))
+
+/**
+ * A growable text buffer
+ */
+typedef struct _ExporterBuffer {
+    char *data;
+    size_t len;
+    size_t cap;
+    bool failed;                    /* memory could not be allocated, content is incomplete */
+} ExporterBuffer;
+
+/**
+ * A BMC scraped by exporter, its session & connections are kept between refreshes.
+ */
+typedef struct _ExporterTarget {
+    struct _ExporterContext *context;
+    char *host;
+    UtoolCommandOption commandOption;
+    UtoolRedfishServer server;      /* discovered once, discovered again after a refresh fails */
+    bool discovered;
+    CURLM *multi;                   /* connections kept alive between refreshes */
+    pthread_t refresher;
+    bool started;
+
+    pthread_mutex_t mutex;          /* protects metrics */
+    char *metrics;                  /* response cache, rendered by last refresh */
+    size_t metricsLen;
+} ExporterTarget;
+
+typedef struct _ExporterContext {
+    ExporterTarget *targets;
+    int total;
+    int interval;
+    bool stopping;
+    pthread_mutex_t mutex;          /* protects stopping */
+    pthread_cond_t stop;
+} ExporterContext;
+
+/**
+ * snapshot of one resource request in a refresh
+ */
+typedef struct _ExporterFetch {
+    const char *url;
+    cJSON *snapshot;
+} ExporterFetch;
+
+static volatile sig_atomic_t g_ExporterInterrupted = 0;
+
+static void ExporterInterruptHandler(int signo)
+{
+    (void) signo;
+    g_ExporterInterrupted = 1;
+}
+
+static bool ExporterReserve(ExporterBuffer *buffer, size_t size)
+{
+    if (buffer->failed) {
+        return false;
+    }
+    if (buffer->len + size + 1 <= buffer->cap) {
+        return true;
+    }
+
+    size_t capacity = buffer->cap > 0 ? buffer->cap : EXPORTER_BUFFER_INIT_SIZE;
+    while (capacity < buffer->len + size + 1) {
+        capacity *= 2;
+    }
+
+    char *data = (char *) realloc(buffer->data, capacity);
+    if (data == NULL) {
+        buffer->failed = true;
+        return false;
+    }
+    buffer->data = data;
+    buffer->cap = capacity;
+    return true;
+}
+
+static void ExporterAppend(ExporterBuffer *buffer, const char *format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    int size = vsnprintf(NULL, 0, format, args);
+    va_end(args);
+    if (size < 0 || !ExporterReserve(buffer, (size_t) size)) {
+        return;
+    }
+
+    va_start(args, format);
+    vsnprintf(buffer->data + buffer->len, (size_t) size + 1, format, args);
+    va_end(args);
+    buffer->len += (size_t) size;
+}
+
+/**
+ * append label value, backslash, double-quote and line feed are escaped.
+ *
+ * @param buffer
+ * @param value
+ */
+static void ExporterAppendLabelValue(ExporterBuffer *buffer, const char *value)
+{
+    size_t len = strlen(value);
+    if (!ExporterReserve(buffer, len * 2)) {
+        return;
+    }
+
+    char *cursor = buffer->data + buffer->len;
+    for (size_t idx = 0; idx < len; idx++) {
+        if (value[idx] == '\\' || value[idx] == '"') {
+            *cursor++ = '\\';
+            *cursor++ = value[idx];
+        } else if (value[idx] == '\n') {
+            *cursor++ = '\\';
+            *cursor++ = 'n';
+        } else {
+            *cursor++ = value[idx];
+        }
+    }
+    *cursor = '\0';
+    buffer->len = (size_t) (cursor - buffer->data);
+}
+
+/**
+ * build metric name from group name and property name, e.g. fan + SpeedRPM -> utool_fan_speed_rpm
+ *
+ * @param group
+ * @param property
+ * @param name
+ * @param size
+ */
+static void ExporterMetricName(const ExporterMetricGroup *group, const char *property, char *name, size_t size)
+{
+    UtoolWrapSecFmt(name, size, size - 1, "utool_%s_", group->name);
+    size_t len = strnlen(name, size);
+    size_t propertyLen = strlen(property);
+    for (size_t idx = 0; idx < propertyLen && len + 2 < size; idx++) {
+        char ch = property[idx];
+        if (isupper((unsigned char) ch)) {
+            bool afterLower = idx > 0 && (islower((unsigned char) property[idx - 1]) ||
+                                          isdigit((unsigned char) property[idx - 1]));
+            bool acronymEnd = idx > 0 && isupper((unsigned char) property[idx - 1]) &&
+                              islower((unsigned char) property[idx + 1]);
+            if (afterLower || acronymEnd) {
+                name[len++] = '_';
+            }
+            name[len++] = (char) tolower((unsigned char) ch);
+        } else if (isalnum((unsigned char) ch)) {
+            name[len++] = ch;
+        } else {
+            name[len++] = '_';
+        }
+    }
+    name[len] = '\0';
+}
+
+static bool ExporterIsLabel(const ExporterMetricGroup *group, const char *property)
+{
+    for (int idx = 0; idx < 3 && group->labels[idx] != NULL; idx++) {
+        if (UtoolStringEquals(group->labels[idx], property)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * get gauge value of property, numbers are exported as is, health is exported as OK=0, Warning=1, Critical=2.
+ *
+ * @param group
+ * @param property
+ * @param value
+ * @return whether property is a gauge
+ */
+static bool ExporterGetGaugeValue(const ExporterMetricGroup *group, const cJSON *property, double *value)
+{
+    if (property == NULL || property->string == NULL || ExporterIsLabel(group, property->string)) {
+        return false;
+    }
+
+    if (cJSON_IsNumber(property)) {
+        *value = property->valuedouble;
+        return true;
+    }
+
+    if (cJSON_IsString(property) && UtoolStringEndsWith(property->string, "Health")) {
+        static const char *const healthStates[] = {"OK", "Warning", "Critical"};
+        for (int idx = 0; idx < 3; idx++) {
+            if (UtoolStringEquals(property->valuestring, healthStates[idx])) {
+                *value = idx;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+static void ExporterAppendFamilyHeader(ExporterBuffer *buffer, const ExporterMetricGroup *group,
+                                       const char *property, const char *name)
+{
+    ExporterAppend(buffer, "# HELP %s Property %s of `%s` output.\n", name, property, group->command);
+    ExporterAppend(buffer, "# TYPE %s gauge\n", name);
+}
+
+static void ExporterAppendSample(ExporterBuffer *buffer, const char *name, const char *host,
+                                 const ExporterMetricGroup *group, const cJSON *member, double value)
+{
+    ExporterAppend(buffer, "%s{host=\"", name);
+    ExporterAppendLabelValue(buffer, host);
+    ExporterAppend(buffer, "\"");
+
+    for (int idx = 0; member != NULL && idx < 3 && group->labels[idx] != NULL; idx++) {
+        const cJSON *label = cJSON_GetObjectItem(member, group->labels[idx]);
+        char labelName[MAX_URL_LEN] = {0};
+        ExporterMetricName(group, group->labels[idx], labelName, sizeof(labelName));
+        // label name drops the metric prefix, utool_<group>_
+        const char *shortName = labelName + strlen("utool__") + strlen(group->name);
+        if (cJSON_IsString(label)) {
+            ExporterAppend(buffer, ",%s=\"", shortName);
+            ExporterAppendLabelValue(buffer, label->valuestring);
+            ExporterAppend(buffer, "\"");
+        } else if (cJSON_IsNumber(label)) {
+            ExporterAppend(buffer, ",%s=\"%.15g\"", shortName, label->valuedouble);
+        }
+    }
+    ExporterAppend(buffer, "} %.15g\n", value);
+}
+
+/**
+ * whether a gauge family is rendered already by a member before current one
+ *
+ * @param group
+ * @param members
+ * @param current
+ * @param property
+ * @return
+ */
+static bool ExporterIsFamilyRendered(const ExporterMetricGroup *group, const cJSON *members, const cJSON *current,
+                                     const char *property)
+{
+    for (const cJSON *member = members->child; member != NULL && member != current; member = member->next) {
+        double value = 0;
+        if (ExporterGetGaugeValue(group, cJSON_GetObjectItem(member, property), &value)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * render members array, samples of the same family are rendered together as exposition format requires.
+ *
+ * @param buffer
+ * @param host
+ * @param group
+ * @param members
+ */
+static void ExporterRenderMembers(ExporterBuffer *buffer, const char *host, const ExporterMetricGroup *group,
+                                  const cJSON *members)
+{
+    const cJSON *member = NULL;
+    cJSON_ArrayForEach(member, members) {
+        const cJSON *property = NULL;
+        cJSON_ArrayForEach(property, member) {
+            double value = 0;
+            if (!ExporterGetGaugeValue(group, property, &value) ||
+                ExporterIsFamilyRendered(group, members, member, property->string)) {
+                continue;
+            }
+
+            char name[MAX_URL_LEN] = {0};
+            ExporterMetricName(group, property->string, name, sizeof(name));
+            ExporterAppendFamilyHeader(buffer, group, property->string, name);
+            for (const cJSON *sample = member; sample != NULL; sample = sample->next) {
+                if (ExporterGetGaugeValue(group, cJSON_GetObjectItem(sample, property->string), &value)) {
+                    ExporterAppendSample(buffer, name, host, group, sample, value);
+                }
+            }
+        }
+    }
+}
+
+static void ExporterRenderGroup(ExporterBuffer *buffer, const char *host, const ExporterMetricGroup *group,
+                                const cJSON *output)
+{
+    const cJSON *property = NULL;
+    cJSON_ArrayForEach(property, output) {
+        double value = 0;
+        if (cJSON_IsArray(property)) {
+            ExporterRenderMembers(buffer, host, group, property);
+        } else if (ExporterGetGaugeValue(group, property, &value)) {
+            char name[MAX_URL_LEN] = {0};
+            ExporterMetricName(group, property->string, name, sizeof(name));
+            ExporterAppendFamilyHeader(buffer, group, property->string, name);
+            ExporterAppendSample(buffer, name, host, group, NULL, value);
+        }
+    }
+}
+
+static void ExporterAppendTargetGauge(ExporterBuffer *buffer, const char *name, const char *help, const char *host,
+                                      double value)
+{
+    ExporterAppend(buffer, "# HELP %s %s\n# TYPE %s gauge\n%s{host=\"", name, help, name, name);
+    ExporterAppendLabelValue(buffer, host);
+    ExporterAppend(buffer, "\"} %.15g\n", value);
+}
+
+/**
+ * map a finished resource into snapshot with the mapping tables of sensor commands.
+ *
+ * @param group
+ * @param request
+ * @param result
+ */
+static void ExporterFetchCallback(UtoolRedfishAsyncGroup *group, UtoolRedfishAsyncRequest *request,
+                                  UtoolResult *result)
+{
+    ExporterFetch *fetch = (ExporterFetch *) request->context;
+    if (result->broken) {
+        // resource is not supported by this BMC, e.g. ThresholdSensors of old BMC
+        if (request->response.httpStatusCode == 404) {
+            ZF_LOGW("Resource %s is not found, its metrics are skipped.", request->url);
+            result->broken = 0;
+            FREE_OBJ(result->desc)
+        }
+        return;
+    }
+
+    for (int idx = 0; idx < EXPORTER_SOURCE_COUNT; idx++) {
+        const ExporterSource *source = g_ExporterSources + idx;
+        if (!UtoolStringEquals(source->url, fetch->url)) {
+            continue;
+        }
+
+        cJSON *output = cJSON_GetObjectItem(fetch->snapshot, source->group->name);
+        if (output == NULL) {
+            output = cJSON_AddObjectToObject(fetch->snapshot, source->group->name);
+        }
+        result->code = UtoolAssetCreatedJsonNotNull(output);
+        if (result->code != UTOOLE_OK) {
+            goto FAILURE;
+        }
+
+        if (source->mapping != NULL) {
+            result->code = UtoolMappingCJSONItems(group->server, result->data, output, source->mapping);
+            if (result->code != UTOOLE_OK) {
+                goto FAILURE;
+            }
+        }
+
+        if (source->membersKey != NULL) {
+            cJSON *outputMembers = cJSON_AddArrayToObject(output, "Members");
+            result->code = UtoolAssetCreatedJsonNotNull(outputMembers);
+            if (result->code != UTOOLE_OK) {
+                goto FAILURE;
+            }
+
+            cJSON *member = NULL;
+            cJSON *members = cJSON_GetObjectItem(result->data, source->membersKey);
+            cJSON_ArrayForEach(member, members) {
+                cJSON *outputMember = cJSON_CreateObject();
+                result->code = UtoolAssetCreatedJsonNotNull(outputMember);
+                if (result->code != UTOOLE_OK) {
+                    goto FAILURE;
+                }
+                cJSON_AddItemToArray(outputMembers, outputMember);
+                result->code = UtoolMappingCJSONItems(group->server, member, outputMember, source->memberMapping);
+                if (result->code != UTOOLE_OK) {
+                    goto FAILURE;
+                }
+            }
+        }
+    }
+    return;
+
+FAILURE:
+    result->broken = 1;
+}
+
+/**
+ * refresh all sensor resources of target concurrently and render its response cache.
+ *
+ *  - redfish session (system id, oem name) is discovered at the first time and again after a refresh fails.
+ *  - only `utool_up 0` is exported if refresh fails, stale readings are not exported.
+ *
+ * @param target
+ */
+static void ExporterRefreshTarget(ExporterTarget *target)
+{
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    UtoolResult *result = &(UtoolResult) {0};
+    ExporterBuffer *buffer = &(ExporterBuffer) {0};
+    ExporterFetch fetches[EXPORTER_SOURCE_COUNT];
+    int fetchCount = 0;
+    cJSON *snapshot = NULL;
+
+    if (!target->discovered) {
+        UtoolFreeRedfishServer(&(target->server));
+        UtoolGetRedfishServer2(&(target->commandOption), &(target->server), result);
+        if (result->broken || target->server.systemId == NULL) {
+            goto FAILURE;
+        }
+        target->discovered = true;
+    }
+
+    snapshot = cJSON_CreateObject();
+    result->code = UtoolAssetCreatedJsonNotNull(snapshot);
+    if (result->code != UTOOLE_OK) {
+        goto FAILURE;
+    }
+
+    UtoolRedfishAsyncGroup *group = &(UtoolRedfishAsyncGroup) {0};
+    UtoolRedfishAsyncGroupInit(group, &(target->server), 0);
+    group->multi = target->multi;
+
+    // sources sharing the same resource are served by one request
+    for (int idx = 0; idx < EXPORTER_SOURCE_COUNT; idx++) {
+        bool requested = false;
+        for (int fetched = 0; fetched < fetchCount; fetched++) {
+            requested = requested || UtoolStringEquals(fetches[fetched].url, g_ExporterSources[idx].url);
+        }
+        if (!requested) {
+            ExporterFetch *fetch = fetches + fetchCount++;
+            fetch->url = g_ExporterSources[idx].url;
+            fetch->snapshot = snapshot;
+            UtoolRedfishAsyncGet(group, fetch->url, NULL, NULL, ExporterFetchCallback, fetch);
+        }
+    }
+
+    UtoolRedfishAsyncGroupRun(group, result);
+    if (result->broken) {
+        goto FAILURE;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    ExporterAppendTargetGauge(buffer, "utool_up", "Whether last refresh of BMC succeed.", target->host, 1);
+    const cJSON *output = NULL;
+    cJSON_ArrayForEach(output, snapshot) {
+        for (int idx = 0; idx < EXPORTER_SOURCE_COUNT; idx++) {
+            if (UtoolStringEquals(g_ExporterSources[idx].group->name, output->string)) {
+                ExporterRenderGroup(buffer, target->host, g_ExporterSources[idx].group, output);
+                break;
+            }
+        }
+    }
+    goto DONE;
+
+FAILURE:
+    ZF_LOGE("Failed to refresh metrics of %s, code is %d.", target->host, result->code);
+    target->discovered = false;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    buffer->len = 0;
+    ExporterAppendTargetGauge(buffer, "utool_up", "Whether last refresh of BMC succeed.", target->host, 0);
+    goto DONE;
+
+DONE:
+    ExporterAppendTargetGauge(buffer, "utool_refresh_duration_seconds", "Duration of last refresh of BMC.",
+                              target->host, (double) (end.tv_sec - start.tv_sec) +
+                                            (double) (end.tv_nsec - start.tv_nsec) / 1000000000);
+    ExporterAppendTargetGauge(buffer, "utool_refresh_timestamp_seconds", "Unix time of last refresh of BMC.",
+                              target->host, (double) time(NULL));
+
+    if (buffer->failed) {
+        ZF_LOGE("Failed to allocate memory for metrics of %s, previous metrics are kept.", target->host);
+        FREE_OBJ(buffer->data)
+    } else {
+        pthread_mutex_lock(&(target->mutex));
+        FREE_OBJ(target->metrics)
+        target->metrics = buffer->data;
+        target->metricsLen = buffer->len;
+        pthread_mutex_unlock(&(target->mutex));
+    }
+
+    FREE_CJSON(snapshot)
+    FREE_CJSON(result->data)
+    FREE_OBJ(result->desc)
+}
+
+/**
+ * refresher thread of a target, refreshes target every scrape interval until exporter stops.
+ *
+ * @param arg   exporter target
+ * @return
+ */
+static void *ExporterRefresher(void *arg)
+{
+    ExporterTarget *target = (ExporterTarget *) arg;
+    ExporterContext *context = target->context;
+
+    pthread_mutex_lock(&(context->mutex));
+    while (!context->stopping) {
+        pthread_mutex_unlock(&(context->mutex));
+        ExporterRefreshTarget(target);
+        pthread_mutex_lock(&(context->mutex));
+
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += context->interval;
+        while (!context->stopping) {
+            if (pthread_cond_timedwait(&(context->stop), &(context->mutex), &deadline) == ETIMEDOUT) {
+                break;
+            }
+        }
+    }
+    pthread_mutex_unlock(&(context->mutex));
+    return NULL;
+}
+
+static void ExporterSendAll(ExporterSocket client, const char *data, size_t len)
+{
+    while (len > 0) {
+        int sent = send(client, data, (int) len, EXPORTER_SEND_FLAGS);
+        if (sent <= 0) {
+            ZF_LOGW("Failed to send metrics response, client may be gone.");
+            return;
+        }
+        data += sent;
+        len -= (size_t) sent;
+    }
+}
+
+static void ExporterRespond(ExporterSocket client, const char *status, const char *body, size_t bodyLen)
+{
+    char header[MAX_HEADER_LEN] = {0};
+    UtoolWrapSecFmt(header, MAX_HEADER_LEN, MAX_HEADER_LEN - 1,
+                    "HTTP/1.1 %s\r\nContent-Type: %s\r\nContent-Length: %zu\r\nConnection: close\r\n\r\n",
+                    status, EXPORTER_CONTENT_TYPE, bodyLen);
+    ExporterSendAll(client, header, strlen(header));
+    ExporterSendAll(client, body, bodyLen);
+}
+
+/**
+ * decode percent-encoded query value in place
+ *
+ * @param value
+ */
+static void ExporterDecodeQueryValue(char *value)
+{
+    char *out = value;
+    for (char *in = value; *in != '\0'; in++) {
+        if (*in == '%' && isxdigit((unsigned char) in[1]) && isxdigit((unsigned char) in[2])) {
+            char hex[3] = {in[1], in[2], '\0'};
+            *out++ = (char) strtol(hex, NULL, 16);
+            in += 2;
+        } else {
+            *out++ = *in == '+' ? ' ' : *in;
+        }
+    }
+    *out = '\0';
+}
+
+/**
+ * find the target requested by path, `/metrics` serves the first target, `/metrics?target=host` serves the host.
+ *
+ * @param context
+ * @param path
+ * @return target, NULL if path is not a metrics path or target is unknown
+ */
+static ExporterTarget *ExporterFindTarget(ExporterContext *context, char *path)
+{
+    char *query = strchr(path, '?');
+    if (query != NULL) {
+        *query++ = '\0';
+    }
+    if (!UtoolStringEquals(path, EXPORTER_METRICS_PATH)) {
+        return NULL;
+    }
+
+    for (char *param = query; param != NULL && *param != '\0';) {
+        char *next = strchr(param, '&');
+        if (next != NULL) {
+            *next++ = '\0';
+        }
+        if (UtoolStringStartsWith(param, "target=")) {
+            char *host = param + strlen("target=");
+            ExporterDecodeQueryValue(host);
+            for (int idx = 0; idx < context->total; idx++) {
+                if (UtoolStringEquals(context->targets[idx].host, host)) {
+                    return context->targets + idx;
+                }
+            }
+            return NULL;
+        }
+        param = next;
+    }
+    return context->targets;
+}
+
+/**
+ * serve one scrape from response cache, scrapes never touch BMC.
+ *
+ * @param context
+ * @param client
+ */
+static void ExporterServeClient(ExporterContext *context, ExporterSocket client)
+{
+    char request[EXPORTER_MAX_REQUEST_LEN] = {0};
+    size_t len = 0;
+
+    // request line is all we need, read until end of headers
+    while (len < sizeof(request) - 1 && strstr(request, "\r\n\r\n") == NULL) {
+        int received = recv(client, request + len, (int) (sizeof(request) - 1 - len), 0);
+        if (received <= 0) {
+            break;
+        }
+        len += (size_t) received;
+        request[len] = '\0';
+    }
+
+    char method[16] = {0};
+    char path[MAX_URL_LEN] = {0};
+    // MAX_URL_LEN is 256
+    if (sscanf(request, "%15s %255s", method, path) != 2) {
+        const char *body = "Bad Request\n";
+        ExporterRespond(client, "400 Bad Request", body, strlen(body));
+        return;
+    }
+
+    if (!UtoolStringEquals(method, HTTP_GET)) {
+        const char *body = "Method Not Allowed\n";
+        ExporterRespond(client, "405 Method Not Allowed", body, strlen(body));
+        return;
+    }
+
+    ExporterTarget *target = ExporterFindTarget(context, path);
+    if (target == NULL) {
+        const char *body = "Not Found\n";
+        ExporterRespond(client, "404 Not Found", body, strlen(body));
+        return;
+    }
+
+    // copy metrics out, a slow client must not block refresh of target while its response is sent
+    char *metrics = NULL;
+    size_t metricsLen = 0;
+    bool ready = false;
+    pthread_mutex_lock(&(target->mutex));
+    if (target->metrics != NULL) {
+        ready = true;
+        metrics = (char *) malloc(target->metricsLen + 1);
+        if (metrics != NULL) {
+            memcpy(metrics, target->metrics, target->metricsLen);
+            metrics[target->metricsLen] = '\0';
+            metricsLen = target->metricsLen;
+        }
+    }
+    pthread_mutex_unlock(&(target->mutex));
+
+    if (metrics != NULL) {
+        ExporterRespond(client, "200 OK", metrics, metricsLen);
+        FREE_OBJ(metrics)
+    } else if (ready) {
+        ZF_LOGE("Failed to allocate memory for metrics response of %s.", target->host);
+        const char *body = "Internal Server Error\n";
+        ExporterRespond(client, "500 Internal Server Error", body, strlen(body));
+    } else {
+        const char *body = "Metrics are not ready\n";
+        ExporterRespond(client, "503 Service Unavailable", body, strlen(body));
+    }
+}
+
+static ExporterSocket ExporterListen(const char *address, int port)
+{
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((unsigned short) port);
+    if (inet_pton(AF_INET, address, &(addr.sin_addr)) != 1) {
+        ZF_LOGE("Listen address %s is illegal.", address);
+        return EXPORTER_INVALID_SOCKET;
+    }
+
+    ExporterSocket listener = socket(AF_INET, SOCK_STREAM, 0);
+    if (listener == EXPORTER_INVALID_SOCKET) {
+        return EXPORTER_INVALID_SOCKET;
+    }
+
+    int reuse = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, (const char *) &reuse, sizeof(reuse));
+    if (bind(listener, (struct sockaddr *) &addr, sizeof(addr)) != 0 || listen(listener, SOMAXCONN) != 0) {
+        ZF_LOGE("Failed to listen on %s:%d, error is %s.", address, port, strerror(errno));
+        EXPORTER_CLOSE_SOCKET(listener);
+        return EXPORTER_INVALID_SOCKET;
+    }
+    return listener;
+}
+
+/**
+ * accept and serve scrapes until SIGINT or SIGTERM is received.
+ *
+ * @param context
+ * @param listener
+ */
+static void ExporterServe(ExporterContext *context, ExporterSocket listener)
+{
+    while (!g_ExporterInterrupted) {
+        fd_set readable;
+        FD_ZERO(&readable);
+        FD_SET(listener, &readable);
+        struct timeval timeout = {.tv_sec = 1, .tv_usec = 0};
+        int ready = select((int) listener + 1, &readable, NULL, NULL, &timeout);
+        if (ready <= 0) {
+            continue;
+        }
+
+        ExporterSocket client = accept(listener, NULL, NULL);
+        if (client == EXPORTER_INVALID_SOCKET) {
+            continue;
+        }
+
+#if defined(__MINGW32__)
+        DWORD clientTimeout = EXPORTER_CLIENT_TIMEOUT * 1000;
+#else
+        struct timeval clientTimeout = {.tv_sec = EXPORTER_CLIENT_TIMEOUT, .tv_usec = 0};
+#endif
+        setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, (const char *) &clientTimeout, sizeof(clientTimeout));
+        setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, (const char *) &clientTimeout, sizeof(clientTimeout));
+        ExporterServeClient(context, client);
+        EXPORTER_CLOSE_SOCKET(client);
+    }
+}
+
+/**
+ * create targets from `targets` option, all targets share global connect options.
+ *
+ * @param commandOption
+ * @param targets   hosts split by comma, global host is used if NULL
+ * @param context
+ * @param result
+ */
+static void ExporterCreateTargets(UtoolCommandOption *commandOption, const char *targets, ExporterContext *context,
+                                  UtoolResult *result)
+{
+    char *hosts = UtoolStringNDup(targets != NULL ? targets : (commandOption->host ? commandOption->host : ""),
+                                  MAX_PAYLOAD_LEN);
+    result->code = UtoolAssetMallocNotNull(hosts);
+    if (result->code != UTOOLE_OK) {
+        goto FAILURE;
+    }
+
+    context->targets = (ExporterTarget *) calloc(EXPORTER_MAX_TARGETS, sizeof(ExporterTarget));
+    result->code = UtoolAssetMallocNotNull(context->targets);
+    if (result->code != UTOOLE_OK) {
+        goto FAILURE;
+    }
+
+    char *savePtr = NULL;
+    for (char *host = strtok_r(hosts, ",", &savePtr); host != NULL; host = strtok_r(NULL, ",", &savePtr)) {
+        if (context->total == EXPORTER_MAX_TARGETS) {
+            result->code = UtoolBuildOutputResult(STATE_FAILURE, cJSON_CreateString(OPTION_TARGETS_ILLEGAL),
+                                                  &(result->desc));
+            goto FAILURE;
+        }
+
+        ExporterTarget *target = context->targets + context->total++;
+        target->context = context;
+        pthread_mutex_init(&(target->mutex), NULL);
+        target->host = UtoolStringNDup(host, MAX_URL_LEN);
+        result->code = UtoolAssetMallocNotNull(target->host);
+        if (result->code != UTOOLE_OK) {
+            goto FAILURE;
+        }
+
+        target->commandOption = *commandOption;
+        target->commandOption.host = target->host;
+        target->commandOption.quiet = 1;
+        result->code = UtoolValidateConnectOptions(&(target->commandOption), &(result->desc));
+        if (result->code != UTOOLE_OK || target->commandOption.flag != EXECUTABLE) {
+            goto FAILURE;
+        }
+
+        target->multi = curl_multi_init();
+        result->code = UtoolAssetMallocNotNull(target->multi);
+        if (result->code != UTOOLE_OK) {
+            goto FAILURE;
+        }
+    }
+
+    // validate global connect options if there is no target, so usual `host is required` error is reported
+    if (context->total == 0) {
+        result->code = UtoolValidateConnectOptions(commandOption, &(result->desc));
+        if (result->code == UTOOLE_OK && result->desc == NULL) {
+            result->code = UtoolBuildOutputResult(STATE_FAILURE, cJSON_CreateString(OPTION_TARGETS_ILLEGAL),
+                                                  &(result->desc));
+        }
+        goto FAILURE;
+    }
+    goto DONE;
+
+FAILURE:
+    result->broken = 1;
+    goto DONE;
+
+DONE:
+    FREE_OBJ(hosts)
+}
+
+static void ExporterFreeTargets(ExporterContext *context)
+{
+    for (int idx = 0; context->targets != NULL && idx < context->total; idx++) {
+        ExporterTarget *target = context->targets + idx;
+        if (target->multi != NULL) {
+            curl_multi_cleanup(target->multi);
+        }
+        UtoolFreeRedfishServer(&(target->server));
+        pthread_mutex_destroy(&(target->mutex));
+        FREE_OBJ(target->metrics)
+        FREE_OBJ(target->host)
+    }
+    FREE_OBJ(context->targets)
+}
+
+/**
+ * Prometheus exporter, command handler of `exporter`
+ *
+ * Thermal, Power, Chassis & ThresholdSensors resources of each target are refreshed concurrently every scrape
+ * interval by its refresher thread, and mapped with the same mapping tables as `gettemp`, `getfan`, `getvolt`,
+ * `getpsu` and `getsensor`. Scrapes of `/metrics` are served from the response cache of last refresh.
+ *
+ * @param commandOption
+ * @param outputStr
+ * @return
+ */
+int UtoolCmdExporter(UtoolCommandOption *commandOption, char **outputStr)
+{
+    char *address = EXPORTER_DEFAULT_ADDRESS;
+    int port = EXPORTER_DEFAULT_PORT;
+    int interval = EXPORTER_DEFAULT_INTERVAL;
+    char *targets = NULL;
+    ExporterSocket listener = EXPORTER_INVALID_SOCKET;
+    bool socketStarted = false;
+
+    UtoolResult *result = &(UtoolResult) {0};
+    ExporterContext *context = &(ExporterContext) {0};
+    pthread_mutex_init(&(context->mutex), NULL);
+    pthread_cond_init(&(context->stop), NULL);
+
+    struct argparse_option options[] = {
+            OPT_BOOLEAN('h', "help", &(commandOption->flag), HELP_SUB_COMMAND_DESC, UtoolGetHelpOptionCallback, 0, 0),
+            OPT_STRING ('a', "listen-address", &address, "IPv4 address to listen on, 127.0.0.1 by default",
+                        NULL, 0, 0),
+            OPT_INTEGER('l', "listen-port", &port, "port to expose /metrics on, 9798 by default", NULL, 0, 0),
+            OPT_INTEGER('i', "scrape-interval", &interval, "seconds between two refreshes of BMC, 30 by default",
+                        NULL, 0, 0),
+            OPT_STRING ('t', "targets", &targets,
+                        "BMC hosts split by comma, scraped by /metrics?target=host, global host by default",
+                        NULL, 0, 0),
+            OPT_END(),
+    };
+
+    result->code = UtoolValidateSubCommandBasicOptions(commandOption, options, usage, &(result->desc));
+    if (commandOption->flag != EXECUTABLE) {
+        goto DONE;
+    }
+
+    if (port < 1 || port > 65535) {
+        result->code = UtoolBuildOutputResult(STATE_FAILURE, cJSON_CreateString(OPTION_LISTEN_PORT_ILLEGAL),
+                                              &(result->desc));
+        goto DONE;
+    }
+
+    if (interval < EXPORTER_MIN_INTERVAL || interval > EXPORTER_MAX_INTERVAL) {
+        result->code = UtoolBuildOutputResult(STATE_FAILURE, cJSON_CreateString(OPTION_SCRAPE_INTERVAL_ILLEGAL),
+                                              &(result->desc));
+        goto DONE;
+    }
+
+    context->interval = interval;
+
+    // every refresh should reflect current readings
+    UtoolResourceCacheEnable(false);
+
+    ExporterCreateTargets(commandOption, targets, context, result);
+    if (result->broken) {
+        goto DONE;
+    }
+
+#if defined(__MINGW32__)
+    WSADATA wsaData;
+    socketStarted = WSAStartup(MAKEWORD(2, 2), &wsaData) == 0;
+#endif
+    listener = ExporterListen(address, port);
+    if (listener == EXPORTER_INVALID_SOCKET) {
+        char message[MAX_FAILURE_MSG_LEN] = {0};
+        UtoolWrapSecFmt(message, MAX_FAILURE_MSG_LEN, MAX_FAILURE_MSG_LEN - 1, EXPORTER_LISTEN_FAILED, address, port);
+        result->code = UtoolBuildOutputResult(STATE_FAILURE, cJSON_CreateString(message), &(result->desc));
+        goto DONE;
+    }
+
+    g_ExporterInterrupted = 0;
+    void (*previousInt)(int) = signal(SIGINT, ExporterInterruptHandler);
+    void (*previousTerm)(int) = signal(SIGTERM, ExporterInterruptHandler);
+
+    for (int idx = 0; idx < context->total; idx++) {
+        ExporterTarget *target = context->targets + idx;
+        target->started = pthread_create(&(target->refresher), NULL, ExporterRefresher, target) == 0;
+        if (!target->started) {
+            ZF_LOGE("Failed to start refresher thread of %s.", target->host);
+        }
+    }
+
+    ZF_LOGI("Exporter is listening on %s:%d, scrape interval is %ds.", address, port, interval);
+    ExporterServe(context, listener);
+
+    pthread_mutex_lock(&(context->mutex));
+    context->stopping = true;
+    pthread_cond_broadcast(&(context->stop));
+    pthread_mutex_unlock(&(context->mutex));
+    for (int idx = 0; idx < context->total; idx++) {
+        if (context->targets[idx].started) {
+            pthread_join(context->targets[idx].refresher, NULL);
+        }
+    }
+
+    signal(SIGINT, previousInt);
+    signal(SIGTERM, previousTerm);
+    result->code = UtoolBuildStringOutputResult(STATE_SUCCESS, EXPORTER_STOPPED, &(result->desc));
+    goto DONE;
+
+DONE:
+    if (listener != EXPORTER_INVALID_SOCKET) {
+        EXPORTER_CLOSE_SOCKET(listener);
+    }
+#if defined(__MINGW32__)
+    if (socketStarted) {
+        WSACleanup();
+    }
+#endif
+    (void) socketStarted;
+    ExporterFreeTargets(context);
+    pthread_cond_destroy(&(context->stop));
+    pthread_mutex_destroy(&(context->mutex));
+    *outputStr = result->desc;
+    return result->code;
+}
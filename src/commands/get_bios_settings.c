@@ -20,6 +20,7 @@
 #include "command-interfaces.h"
 #include "argparse.h"
 #include "redfish.h"
+#include "json_stream.h"
 
 static const char *OPT_FILE_URL_ILLEGAL = "Error: option `file-uri` is illegal, Please make sure the path exists.";
 
@@ -48,7 +49,6 @@ int UtoolCmdGetBiosSettings(UtoolCommandOption *commandOption, char **outputStr)
 {
     cJSON *getBiosJson = NULL;
     FILE *outputFileFP = NULL;
-    char *prettyJson = NULL;
 
     UtoolResult *result = &(UtoolResult) {0};
     UtoolRedfishServer *server = &(UtoolRedfishServer) {0};
@@ -96,6 +96,7 @@ int UtoolCmdGetBiosSettings(UtoolCommandOption *commandOption, char **outputStr)
 
 
     getBiosJson = cJSON_Parse(getBiosSettingResp->content);
+    UtoolFreeCurlResponse(getBiosSettingResp);
     result->code = UtoolAssetParseJsonNotNull(getBiosJson);
     if (result->code != UTOOLE_OK) {
         goto FAILURE;
@@ -108,14 +109,8 @@ int UtoolCmdGetBiosSettings(UtoolCommandOption *commandOption, char **outputStr)
     }
 
     // if file-uri is specified, output to local file.
+    // attributes are streamed into file directly, a pretty printed copy of them is not built in memory.
     if (!UtoolStringIsEmpty(option->fileURI)) {
-        prettyJson = cJSON_Print(attributes);
-        result->code = UtoolAssetPrintJsonNotNull(prettyJson);
-        if (result->code != UTOOLE_OK) {
-            goto FAILURE;
-        }
-        FREE_CJSON(attributes)
-
         char realFilePath[PATH_MAX] = {0};
         UtoolFileRealpath(option->fileURI, realFilePath, PATH_MAX);
         outputFileFP = fopen(realFilePath, "wb");
@@ -125,11 +120,12 @@ int UtoolCmdGetBiosSettings(UtoolCommandOption *commandOption, char **outputStr)
             goto FAILURE;
         }
 
-        if (fputs(prettyJson, outputFileFP) == EOF) {
+        result->code = UtoolJsonPrintToFile(attributes, outputFileFP);
+        if (result->code != UTOOLE_OK) {
             result->broken = 1;
-            result->code = UTOOLE_FAILED_TO_WRITE_FILE;
             goto FAILURE;
         }
+        FREE_CJSON(attributes)
 
         // mapping result to output json
         UtoolBuildDefaultSuccessResult(&(result->desc));
@@ -138,6 +134,7 @@ int UtoolCmdGetBiosSettings(UtoolCommandOption *commandOption, char **outputStr)
     } else {
         // mapping result to output json
         result->code = UtoolBuildOutputResult(STATE_SUCCESS, attributes, &(result->desc));
+        attributes = NULL;
         goto DONE;
     }
 
@@ -150,10 +147,7 @@ DONE:
         fclose(outputFileFP);
     }
 
-    if (prettyJson != NULL) {
-        free(prettyJson);
-    }
-
+    FREE_CJSON(attributes)
     FREE_CJSON(getBiosJson)
     UtoolFreeRedfishServer(server);
     UtoolFreeCurlResponse(getBiosSettingResp);
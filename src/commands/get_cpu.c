@@ -126,7 +126,7 @@ int UtoolCmdGetProcessor(UtoolCommandOption *commandOption, char **outputStr)
         goto FAILURE;
     }
 
-    UtoolRedfishGet(server, "/Systems/%s/Processors", NULL, NULL, result);
+    UtoolRedfishGetCollection(server, "/Systems/%s/Processors", getProcessorMappings, result);
     if (result->broken) {
         goto FAILURE;
     }
@@ -83,7 +83,7 @@ int UtoolCmdGetEventSubscriptions(UtoolCommandOption *commandOption, char **outp
         goto FAILURE;
     }
 
-    UtoolRedfishGet(server, "/EventService/Subscriptions", NULL, NULL, result);
+    UtoolRedfishGetCollection(server, "/EventService/Subscriptions", getSubscriptionMappings, result);
     if (result->broken) {
         goto FAILURE;
     }
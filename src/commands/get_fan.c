@@ -17,13 +17,14 @@
 #include "command-interfaces.h"
 #include "argparse.h"
 #include "redfish.h"
+#include "sensor-mappings.h"
 
 static const char *const usage[] = {
         "getfan",
         NULL,
 };
 
-static const UtoolOutputMapping getFanSummaryMapping[] = {
+const UtoolOutputMapping getFanSummaryMapping[] = {
         {.sourceXpath = "/Oem/${Oem}/FanSummary/Status/HealthRollup", .targetKeyValue="OverallHealth"},
         {.sourceXpath = "/Oem/${Oem}/FanSummary/Count", .targetKeyValue="Maximum"},
         {.sourceXpath = "/Null", .targetKeyValue="Model"},
@@ -34,7 +35,7 @@ static const UtoolOutputMapping getFanSummaryMapping[] = {
         NULL
 };
 
-static const UtoolOutputMapping getFanMappings[] = {
+const UtoolOutputMapping getFanMappings[] = {
         {.sourceXpath = "/MemberId", .targetKeyValue="Id"},
         {.sourceXpath = "/Name", .targetKeyValue="CommonName"},
         {.sourceXpath = "/Oem/${Oem}/Position", .targetKeyValue="Location"},
@@ -142,6 +142,62 @@ static const UtoolOutputMapping getLocationMapping[] = {
 };
 
 
+/**
+ * rename disk backplane CPLD firmware when its board location is returned.
+ */
+static void GetFirmwareLocationCallback(UtoolRedfishAsyncGroup *group, UtoolRedfishAsyncRequest *request,
+                                        UtoolResult *result)
+{
+    (void) group;
+    if (result->broken) {
+        return;
+    }
+
+    // update Name
+    cJSON *firmware = request->output;
+    cJSON *name = cJSONUtils_GetPointer(firmware, "/Name");
+    cJSON *location = cJSONUtils_GetPointer(firmware, "/Location");
+    cJSON *deviceLocator = cJSONUtils_GetPointer(firmware, "/DeviceLocator");
+    if (cJSON_IsString(name) && cJSON_IsString(location) && cJSON_IsString(deviceLocator) &&
+        location->valuestring != NULL && deviceLocator->valuestring != NULL) {
+        char mapping[256] = {0};
+        UtoolWrapSecFmt(mapping, sizeof(mapping), sizeof(mapping) - 1, "%s%s_CPLD",
+                        location->valuestring == LOCATION_REAR ? "Rear" : "",
+                        deviceLocator->valuestring);
+        cJSON_SetValuestring(name, mapping);
+    }
+}
+
+/**
+ * chain board location request for disk backplane CPLD firmware as soon as the firmware is returned.
+ */
+static void GetFirmwareCallback(UtoolRedfishAsyncGroup *group, UtoolRedfishAsyncRequest *request,
+                                UtoolResult *result)
+{
+    if (result->broken) {
+        return;
+    }
+
+    /**
+        硬盘背板，
+            需要在升级资源查询/redfish/v1/Chassis/1/Boards/chassisDiskBP5链接，查看Location属性，
+            来明确是前置（chassisFront）还是后置（chassisRear），然后做重命名
+        chassisDiskBP5CPLD -> DiskBP5_CPLD
+        chassisDiskBP1CPLD -> RearDiskBP1_CPLD
+     */
+    cJSON *firmware = request->output;
+    cJSON *name = cJSONUtils_GetPointer(firmware, "/Name");
+    cJSON *relatedItem = cJSONUtils_GetPointer(firmware, "/RelatedItem");
+    if (cJSON_IsString(name) && cJSON_IsString(relatedItem)
+        && name->valuestring != NULL && relatedItem->valuestring != NULL) {
+        if (UtoolStringStartsWith(name->valuestring, "chassisDiskBP")
+            && UtoolStringEndsWith(name->valuestring, "CPLD")) {
+            UtoolRedfishAsyncGet(group, relatedItem->valuestring, firmware, getLocationMapping,
+                                 GetFirmwareLocationCallback, NULL);
+        }
+    }
+}
+
 /**
  * Get outband firmware information, command handler of `getfw`
  *
@@ -208,6 +264,10 @@ int UtoolCmdGetFirmware(UtoolCommandOption *commandOption, char **outputStr)
         goto FAILURE;
     }
 
+    // get all firmware inventories concurrently, output order follows members order
+    UtoolRedfishAsyncGroup *group = &(UtoolRedfishAsyncGroup) {0};
+    UtoolRedfishAsyncGroupInit(group, server, 0);
+
     cJSON *members = cJSON_GetObjectItem(firmwareMembersJson, "Members");
     int memberCount = cJSON_GetArraySize(members);
     for (int idx = 0; idx < memberCount; idx++) {
@@ -218,51 +278,21 @@ int UtoolCmdGetFirmware(UtoolCommandOption *commandOption, char **outputStr)
             firmware = cJSON_CreateObject();
             result->code = UtoolAssetCreatedJsonNotNull(firmware);
             if (result->code != UTOOLE_OK) {
-                goto FAILURE;
+                // submitted requests will be dropped by broken group
+                group->broken = true;
+                break;
             }
             cJSON_AddItemToArray(firmwares, firmware);
 
-            UtoolRedfishGet(server, url, firmware, getFwMappings, result);
-            if (result->broken) {
-                goto FAILURE;
-            }
-            FREE_CJSON(result->data)
-
-            /**
-                硬盘背板，
-                    需要在升级资源查询/redfish/v1/Chassis/1/Boards/chassisDiskBP5链接，查看Location属性，
-                    来明确是前置（chassisFront）还是后置（chassisRear），然后做重命名
-                chassisDiskBP5CPLD -> DiskBP5_CPLD
-                chassisDiskBP1CPLD -> RearDiskBP1_CPLD
-             */
-            cJSON *name = cJSONUtils_GetPointer(firmware, "/Name");
-            cJSON *relatedItem = cJSONUtils_GetPointer(firmware, "/RelatedItem");
-            if (cJSON_IsString(name) && cJSON_IsString(relatedItem)
-                && name->valuestring != NULL && relatedItem->valuestring != NULL) {
-                if (UtoolStringStartsWith(name->valuestring, "chassisDiskBP")
-                    && UtoolStringEndsWith(name->valuestring, "CPLD")) {
-                    UtoolRedfishGet(server, relatedItem->valuestring, firmware, getLocationMapping, result);
-                    if (result->broken) {
-                        goto FAILURE;
-                    }
-                    FREE_CJSON(result->data)
-
-                    // update Name
-                    cJSON *location = cJSONUtils_GetPointer(firmware, "/Location");
-                    cJSON *deviceLocator = cJSONUtils_GetPointer(firmware, "/DeviceLocator");
-                    if (cJSON_IsString(location) && cJSON_IsString(deviceLocator) && location->valuestring != NULL &&
-                        deviceLocator->valuestring != NULL) {
-                        char mapping[256] = {0};
-                        UtoolWrapSecFmt(mapping, sizeof(mapping), sizeof(mapping) - 1, "%s%s_CPLD",
-                                        location->valuestring == LOCATION_REAR ? "Rear" : "",
-                                        deviceLocator->valuestring);
-                        cJSON_SetValuestring(name, mapping);
-                    }
-                }
-            }
+            UtoolRedfishAsyncGet(group, url, firmware, getFwMappings, GetFirmwareCallback, NULL);
         }
     }
 
+    UtoolRedfishAsyncGroupRun(group, result);
+    if (result->broken) {
+        goto FAILURE;
+    }
+
     cJSON *item = NULL;
     cJSON_ArrayForEach(item, firmwares) {
         cJSON_DeleteItemFromObject(item, "RelatedItem");
@@ -0,0 +1,416 @@
+/*
+* Copyright © xFusion Digital Technologies Co., Ltd. 2018-2019. All rights reserved.
+* Description: command handler of `getinventory`
+* Author:
+* Create: 2019-06-14
+* Notes:
+*/
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "cJSON_Utils.h"
+#include "commons.h"
+#include "curl/curl.h"
+#include "zf_log.h"
+#include "constants.h"
+#include "command-helps.h"
+#include "command-interfaces.h"
+#include "argparse.h"
+#include "redfish.h"
+#include "resource_cache.h"
+#include "string_utils.h"
+
+static const char *const usage[] = {
+        "getinventory",
+        NULL,
+};
+
+/**
+ * A resource of inventory graph.
+ *
+ * Root resources are located by url, others are linked from their owner resource: links are read from linkXpath of
+ * owner (an array of links, a link object or a link string), or owner itself is used when linkXpath is NULL. Suffix
+ * is appended to the links when present.
+ */
+typedef struct _InventoryResource
+{
+    const char *url;
+    const char *linkXpath;
+    const char *suffix;
+
+    bool (*accept)(const char *ownerUrl, const char *link);     /** optional, whether the link should be followed */
+
+    const struct _InventoryResource *const *follows;            /** NULL terminated resources linked from this one */
+} InventoryResource;
+
+/**
+ * Prefetch state of inventory graph, async group must be the first member so it could be found in callbacks.
+ */
+typedef struct _InventoryPrefetch
+{
+    UtoolRedfishAsyncGroup group;
+    cJSON *visited;                     /** resolved URLs of submitted resources */
+} InventoryPrefetch;
+
+/**
+ * A section of inventory, output of an existing get command.
+ */
+typedef struct _InventorySection
+{
+    const char *name;
+    const char *command;
+
+    int (*pFuncExecute)(UtoolCommandOption *, char **);
+} InventorySection;
+
+/**
+ * `getfw` only reports BMC, BIOS and CPLD firmware.
+ */
+static bool AcceptFirmware(const char *ownerUrl, const char *link)
+{
+    (void) ownerUrl;
+    return UtoolStringEndsWith(link, "BMC") || UtoolStringEndsWith(link, "Bios") || UtoolStringEndsWith(link, "CPLD");
+}
+
+/**
+ * `getfw` loads board location of disk backplane CPLD firmware only.
+ */
+static bool AcceptDiskBackplaneCPLD(const char *ownerUrl, const char *link)
+{
+    (void) link;
+    const char *name = strrchr(ownerUrl, '/');
+    return name != NULL && UtoolStringStartsWith(name + 1, "chassisDiskBP") && UtoolStringEndsWith(name, "CPLD");
+}
+
+static const InventoryResource memberResource = {.linkXpath = "/Members"};
+
+/** getfw */
+static const InventoryResource firmwareBoardResource = {.linkXpath = "/RelatedItem/0",
+        .accept = AcceptDiskBackplaneCPLD};
+static const InventoryResource firmwareResource = {.linkXpath = "/Members", .accept = AcceptFirmware,
+        .follows = (const InventoryResource *const[]) {&firmwareBoardResource, NULL}};
+
+/** getldisk */
+static const InventoryResource volumesResource = {.suffix = "/Volumes",
+        .follows = (const InventoryResource *const[]) {&memberResource, NULL}};
+static const InventoryResource storageResource = {.linkXpath = "/Members",
+        .follows = (const InventoryResource *const[]) {&volumesResource, NULL}};
+
+/** getpcie */
+static const InventoryResource pcieFunctionResource = {.linkXpath = "/Links/PCIeFunctions/0"};
+static const InventoryResource pcieDeviceResource = {.linkXpath = "/PCIeDevices",
+        .follows = (const InventoryResource *const[]) {&pcieFunctionResource, NULL}};
+
+/** getpdisk */
+static const InventoryResource driveResource = {.linkXpath = "/Links/Drives"};
+
+/** getnic */
+static const InventoryResource networkPortResource = {.linkXpath = "/Controllers/0/Link/NetworkPorts"};
+static const InventoryResource networkAdapterResource = {.linkXpath = "/Members",
+        .follows = (const InventoryResource *const[]) {&networkPortResource, NULL}};
+
+/**
+ * union of resources required by inventory sections
+ */
+static const InventoryResource inventoryResources[] = {
+        {.url = "/Systems/%s", .follows = (const InventoryResource *const[]) {&pcieDeviceResource, NULL}},
+        {.url = "/Systems/%s/Processors", .follows = (const InventoryResource *const[]) {&memberResource, NULL}},
+        {.url = "/Systems/%s/Memory", .follows = (const InventoryResource *const[]) {&memberResource, NULL}},
+        {.url = "/Systems/%s/Storages", .follows = (const InventoryResource *const[]) {&storageResource, NULL}},
+        {.url = "/Chassis/%s", .follows = (const InventoryResource *const[]) {&driveResource, NULL}},
+        {.url = "/Chassis/%s/Power"},
+        {.url = "/Chassis/%s/Thermal"},
+        {.url = "/Chassis/%s/NetworkAdapters",
+                .follows = (const InventoryResource *const[]) {&networkAdapterResource, NULL}},
+        {.url = "/UpdateService/FirmwareInventory",
+                .follows = (const InventoryResource *const[]) {&firmwareResource, NULL}},
+        {0}
+};
+
+static const InventorySection inventorySections[] = {
+        {.name = "Product", .command = "getproduct", .pFuncExecute = UtoolCmdGetProduct},
+        {.name = "Firmware", .command = "getfw", .pFuncExecute = UtoolCmdGetFirmware},
+        {.name = "CPU", .command = "getcpu", .pFuncExecute = UtoolCmdGetProcessor},
+        {.name = "Memory", .command = "getmemory", .pFuncExecute = UtoolCmdGetMemory},
+        {.name = "PhysicalDisk", .command = "getpdisk", .pFuncExecute = UtoolCmdGetPhysicalDisks},
+        {.name = "LogicalDisk", .command = "getldisk", .pFuncExecute = UtoolCmdGetLogicalDisks},
+        {.name = "RAID", .command = "getraid", .pFuncExecute = UtoolCmdGetRAID},
+        {.name = "NIC", .command = "getnic", .pFuncExecute = UtoolCmdGetNIC},
+        {.name = "PCIe", .command = "getpcie", .pFuncExecute = UtoolCmdGetPCIe},
+        {.name = "PSU", .command = "getpsu", .pFuncExecute = UtoolCmdGetPowerSupply},
+        {.name = "Fan", .command = "getfan", .pFuncExecute = UtoolCmdGetFan},
+        {.name = "Temperature", .command = "gettemp", .pFuncExecute = UtoolCmdGetTemperature},
+        {0}
+};
+
+static void InventoryPrefetchCallback(UtoolRedfishAsyncGroup *group, UtoolRedfishAsyncRequest *request,
+                                      UtoolResult *result);
+
+/**
+ * submit a resource of inventory graph unless it is submitted already.
+ *
+ * @param prefetch
+ * @param resource
+ * @param url
+ */
+static void InventoryPrefetchSubmit(InventoryPrefetch *prefetch, const InventoryResource *resource, const char *url)
+{
+    char fullURL[MAX_URL_LEN] = {0};
+    UtoolResolveResourceURL(prefetch->group.server, url, fullURL);
+    if (cJSON_GetObjectItemCaseSensitive(prefetch->visited, fullURL) != NULL) {
+        return;
+    }
+
+    if (cJSON_AddNullToObject(prefetch->visited, fullURL) == NULL) {
+        prefetch->group.broken = true;
+        return;
+    }
+    UtoolRedfishAsyncGet(&(prefetch->group), url, NULL, NULL, InventoryPrefetchCallback, (void *) resource);
+}
+
+/**
+ * submit resources linked from owner resource.
+ *
+ * @param prefetch
+ * @param resource  linked resource
+ * @param ownerUrl
+ * @param owner
+ */
+static void InventoryPrefetchFollow(InventoryPrefetch *prefetch, const InventoryResource *resource,
+                                    const char *ownerUrl, cJSON *owner)
+{
+    cJSON *links = resource->linkXpath == NULL ? NULL : cJSONUtils_GetPointer(owner, resource->linkXpath);
+    if (resource->linkXpath != NULL && links == NULL) {
+        return;
+    }
+
+    int count = cJSON_IsArray(links) ? cJSON_GetArraySize(links) : 1;
+    for (int idx = 0; idx < count; idx++) {
+        const char *link = ownerUrl;
+        cJSON *linkNode = cJSON_IsArray(links) ? cJSON_GetArrayItem(links, idx) : links;
+        if (linkNode != NULL) {
+            cJSON *odataIdNode = cJSON_IsObject(linkNode) ? cJSON_GetObjectItem(linkNode, "@odata.id") : linkNode;
+            if (!cJSON_IsString(odataIdNode) || odataIdNode->valuestring == NULL) {
+                continue;
+            }
+            link = odataIdNode->valuestring;
+        }
+
+        if (resource->accept != NULL && !resource->accept(ownerUrl, link)) {
+            continue;
+        }
+
+        char url[MAX_URL_LEN] = {0};
+        UtoolWrapSecFmt(url, MAX_URL_LEN, MAX_URL_LEN - 1, "%s%s", link,
+                        resource->suffix != NULL ? resource->suffix : "");
+        InventoryPrefetchSubmit(prefetch, resource, url);
+    }
+}
+
+/**
+ * follow links of returned resource. Prefetch is best effort, resources missing on this server are left to the
+ * sections which report them as they always do.
+ */
+static void InventoryPrefetchCallback(UtoolRedfishAsyncGroup *group, UtoolRedfishAsyncRequest *request,
+                                      UtoolResult *result)
+{
+    if (result->broken) {
+        ZF_LOGW("Failed to prefetch inventory resource %s, status code is %ld.", request->url,
+                request->response.httpStatusCode);
+        result->broken = 0;
+        return;
+    }
+
+    InventoryPrefetch *prefetch = (InventoryPrefetch *) group;
+    const InventoryResource *resource = (const InventoryResource *) request->context;
+    for (int idx = 0; resource->follows != NULL && resource->follows[idx] != NULL; idx++) {
+        InventoryPrefetchFollow(prefetch, resource->follows[idx], request->url, result->data);
+    }
+}
+
+/**
+ * Fetch the whole inventory graph concurrently, each resource is fetched once and kept in resource cache, which is
+ * held by caller, so the sections are built from cache afterwards.
+ *
+ * @param server
+ * @param result
+ */
+static void InventoryPrefetchGraph(UtoolRedfishServer *server, UtoolResult *result)
+{
+    InventoryPrefetch *prefetch = &(InventoryPrefetch) {0};
+    UtoolRedfishAsyncGroupInit(&(prefetch->group), server, 0);
+
+    prefetch->visited = cJSON_CreateObject();
+    result->code = UtoolAssetCreatedJsonNotNull(prefetch->visited);
+    if (result->code != UTOOLE_OK) {
+        result->broken = 1;
+        return;
+    }
+
+    for (int idx = 0; inventoryResources[idx].url != NULL; idx++) {
+        InventoryPrefetchSubmit(prefetch, inventoryResources + idx, inventoryResources[idx].url);
+    }
+
+    UtoolRedfishAsyncGroupRun(&(prefetch->group), result);
+    ZF_LOGI("%d inventory resources are prefetched.", cJSON_GetArraySize(prefetch->visited));
+    FREE_CJSON(prefetch->visited)
+}
+
+/**
+ * Record failure of a section in inventory document as `"<section>": {"Error": "<reason>"}`.
+ *
+ * @param section
+ * @param output
+ * @param reason
+ * @return UTOOLE_OK unless memory could not be allocated
+ */
+static int InventoryAddSectionError(const InventorySection *section, cJSON *output, const char *reason)
+{
+    ZF_LOGW("Failed to build inventory section %s, reason: %s", section->name, reason);
+    cJSON *error = cJSON_AddObjectToObject(output, section->name);
+    int ret = UtoolAssetCreatedJsonNotNull(error);
+    if (ret != UTOOLE_OK) {
+        return ret;
+    }
+    return UtoolAssetCreatedJsonNotNull(cJSON_AddStringToObject(error, "Error", reason));
+}
+
+/**
+ * Run the get command of a section and take its output. A failed section is recorded in output and does not fail
+ * the inventory, so other sections are still reported.
+ *
+ * @param commandOption
+ * @param section
+ * @param output        section output or failure is added to it
+ * @return UTOOLE_OK unless memory could not be allocated
+ */
+static int InventoryBuildSection(UtoolCommandOption *commandOption, const InventorySection *section, cJSON *output)
+{
+    int ret;
+    char *sectionOutputStr = NULL;
+    cJSON *sectionOutput = NULL;
+
+    UtoolCommandOption *sectionOption = &(UtoolCommandOption) {0};
+    *sectionOption = *commandOption;
+    sectionOption->flag = EXECUTABLE;
+    sectionOption->commandArgc = 1;
+    sectionOption->commandArgv = (const char *[]) {section->command, NULL};
+
+    ZF_LOGI("Building inventory section %s from `%s`.", section->name, section->command);
+    ret = section->pFuncExecute(sectionOption, &sectionOutputStr);
+    if (ret != UTOOLE_OK) {
+        const char *reason = (ret > UTOOLE_OK && ret < ((int) CURL_LAST)) ?
+                             curl_easy_strerror((CURLcode) ret) : UtoolGetStringError((UtoolCode) ret);
+        ret = InventoryAddSectionError(section, output, reason);
+        goto DONE;
+    }
+
+    sectionOutput = cJSON_Parse(sectionOutputStr);
+    if (sectionOutput == NULL) {
+        ret = InventoryAddSectionError(section, output, UtoolGetStringError(UTOOLE_PARSE_JSON_FAILED));
+        goto DONE;
+    }
+
+    cJSON *state = cJSON_GetObjectItem(sectionOutput, RESULT_KEY_STATE);
+    cJSON *messages = cJSON_GetObjectItem(sectionOutput, RESULT_KEY_MESSAGES);
+    if (!cJSON_IsString(state) || !UtoolStringEquals(state->valuestring, STATE_SUCCESS)) {
+        cJSON *reason = cJSON_GetArrayItem(messages, 0);
+        ret = InventoryAddSectionError(section, output, cJSON_IsString(reason) ? reason->valuestring :
+                                                        UtoolGetStringError(UTOOLE_UNKNOWN_JSON_FORMAT));
+        goto DONE;
+    }
+
+    cJSON *message = cJSON_DetachItemFromArray(messages, 0);
+    if (message == NULL) {
+        ret = InventoryAddSectionError(section, output, UtoolGetStringError(UTOOLE_UNKNOWN_JSON_FORMAT));
+        goto DONE;
+    }
+    cJSON_AddItemToObject(output, section->name, message);
+    goto DONE;
+
+DONE:
+    FREE_CJSON(sectionOutput)
+    FREE_OBJ(sectionOutputStr)
+    return ret;
+}
+
+/**
+ * Get whole server inventory in one document, command handler of `getinventory`
+ *
+ * Output of getproduct, getfw, getcpu, getmemory, getpdisk, getldisk, getraid, getnic, getpcie, getpsu, getfan and
+ * gettemp is combined, each as a section. Resources required by all of them are prefetched concurrently and only once
+ * before sections are built. A section which fails is reported as `{"Error": "<reason>"}` instead of failing the whole
+ * inventory.
+ *
+ * @param commandOption
+ * @param outputStr
+ * @return
+ */
+int UtoolCmdGetInventory(UtoolCommandOption *commandOption, char **outputStr)
+{
+    struct argparse_option options[] = {
+            OPT_BOOLEAN('h', "help", &(commandOption->flag), HELP_SUB_COMMAND_DESC, UtoolGetHelpOptionCallback, 0, 0),
+            OPT_END(),
+    };
+
+    UtoolResult *result = &(UtoolResult) {0};
+    UtoolRedfishServer *server = &(UtoolRedfishServer) {0};
+    bool cacheHeld = false;
+
+    // initialize output objects
+    cJSON *output = NULL;
+
+    result->code = UtoolValidateSubCommandBasicOptions(commandOption, options, usage, &(result->desc));
+    if (commandOption->flag != EXECUTABLE) {
+        goto DONE;
+    }
+
+    result->code = UtoolValidateConnectOptions(commandOption, &(result->desc));
+    if (commandOption->flag != EXECUTABLE) {
+        goto DONE;
+    }
+
+    // fetched resources must outlive their freshness and cache capacity until all sections are built
+    UtoolResourceCacheHold(true);
+    cacheHeld = true;
+
+    result->code = UtoolGetRedfishServer(commandOption, server, &(result->desc));
+    if (result->code != UTOOLE_OK || server->systemId == NULL) {
+        goto DONE;
+    }
+
+    InventoryPrefetchGraph(server, result);
+    if (result->broken) {
+        goto DONE;
+    }
+
+    output = cJSON_CreateObject();
+    result->code = UtoolAssetCreatedJsonNotNull(output);
+    if (result->code != UTOOLE_OK) {
+        goto FAILURE;
+    }
+
+    for (int idx = 0; inventorySections[idx].name != NULL; idx++) {
+        result->code = InventoryBuildSection(commandOption, inventorySections + idx, output);
+        if (result->code != UTOOLE_OK) {
+            goto FAILURE;
+        }
+    }
+
+    // output to outputStr
+    result->code = UtoolBuildOutputResult(STATE_SUCCESS, output, &(result->desc));
+    goto DONE;
+
+FAILURE:
+    FREE_CJSON(output)
+    goto DONE;
+
+DONE:
+    if (cacheHeld) {
+        UtoolResourceCacheHold(false);
+    }
+    UtoolFreeRedfishServer(server);
+
+    *outputStr = result->desc;
+    return result->code;
+}
@@ -20,11 +20,11 @@
 #include "argparse.h"
 #include "string_utils.h"
 
-#define WHITELIST_ENABLED "01 01"
+#define WHITELIST_ENABLED ((const uint8_t *) "\x01\x01")
+#define WHITELIST_ENABLED_LEN 2
 
-#define DFT_SUB_FUNC "ff"
-#define OEM_NETFUNC "30"
-#define OEM_SUB_FUNC_PREFIX "db 07 00"
+#define DFT_SUB_FUNC 0xFF
+#define OEM_NETFUNC 0x30
 
 static const char *const usage[] = {
         "getipmiwhitelist",
@@ -33,8 +33,11 @@ static const char *const usage[] = {
 
 static const char *const GET_IPMI_WHITELIST_CONF = "0x30 0x93 0xdb 0x07 0x00 0x4c";
 static const char *const GET_IPMI_WHITELIST_CONF_XFUSION = "0x30 0x93 0x14 0xe3 0x00 0x4c";
-static const int SINGLE_BYTE_LEN = 3;
-static const int DATA_PART_POS = 9;
+static const int TOTAL_POS = 3;
+static const int LENGTH_POS = 4;
+static const int NETFUN_POS = 5;
+static const int COMMAND_POS = 6;
+static const int DATA_PART_POS = 8;
 
 // %x stands for the index of white list ipmi command to query
 static const char *const GET_IPMI_WHITELIST = "0x30 0x93 0xdb 0x07 0x00 0x4b 0x01 0x%02x";
@@ -48,8 +51,6 @@ void FreeIpmiCommand(UtoolIPMICommand *command);
 void FreeIpmiCommand(UtoolIPMICommand *command)
 {
     if (command != NULL) {
-        FREE_OBJ(command->netfun)
-        FREE_OBJ(command->command)
         FREE_OBJ(command->data)
         FREE_OBJ(command)
     }
@@ -66,7 +67,7 @@ void FreeIpmiCommand(UtoolIPMICommand *command)
 UtoolIPMICommand *getIpmiWhitelistCommand(UtoolCommandOption *commandOption, int index, UtoolResult *result)
 {
     char *ipmiCmdOutput = NULL;
-    char **segments = NULL;
+    UtoolIPMIResponse *response = &(UtoolIPMIResponse) {0};
     UtoolIPMIRawCmdOption *sendIpmiCommandOption = &(UtoolIPMIRawCmdOption) {0};
 
     UtoolIPMICommand *command = malloc(sizeof(UtoolIPMICommand));
@@ -75,11 +76,12 @@ UtoolIPMICommand *getIpmiWhitelistCommand(UtoolCommandOption *commandOption, int
         goto FAILURE;
     }
 
-    command->length = NULL;
-    command->total = NULL;
-    command->netfun = NULL;
-    command->command = NULL;
+    command->length = 0;
+    command->total = 0;
+    command->netfun = -1;
+    command->command = -1;
     command->data = NULL;
+    command->dataLength = 0;
 
     char getIpmiWhitelistCmd[MAX_IPMI_CMD_LEN] = {0};
     UtoolWrapSecFmt(getIpmiWhitelistCmd, MAX_IPMI_CMD_LEN, MAX_IPMI_CMD_LEN - 1,
@@ -102,53 +104,40 @@ UtoolIPMICommand *getIpmiWhitelistCommand(UtoolCommandOption *commandOption, int
         goto FAILURE;
     }
 
+    result->code = UtoolIPMIDecodeResponse(ipmiCmdOutput, response);
+    if (result->code != UTOOLE_OK) {
+        goto FAILURE;
+    }
+
     // update command data part
-    size_t ipmiCmdOutputLen = strnlen(ipmiCmdOutput, MAX_IPMI_CMD_LEN);
-    int dataPartStartAt = SINGLE_BYTE_LEN * (DATA_PART_POS - 1) + 1;
-    if (ipmiCmdOutputLen > dataPartStartAt) {
-        int size = ipmiCmdOutputLen - dataPartStartAt;
-        command->data = (char *) malloc(sizeof(char) * (size + 1));
+    if (response->length > DATA_PART_POS) {
+        command->dataLength = response->length - DATA_PART_POS;
+        command->data = (uint8_t *) malloc(command->dataLength);
         result->code = UtoolAssetMallocNotNull(command->data);
         if (result->code != UTOOLE_OK) {
             goto FAILURE;
         }
-        errno_t ok = strncpy_s(command->data, size + 1, ipmiCmdOutput + dataPartStartAt, size);
+        errno_t ok = memcpy_s(command->data, command->dataLength, response->bytes + DATA_PART_POS,
+                              command->dataLength);
         if (ok != EOK) {
-            perror("Failed to `strncpy`.");
+            perror("Failed to `memcpy`.");
             exit(EXIT_SECURITY_ERROR);
         }
     }
 
-    // split function will update orignal string
-    segments = UtoolStringSplit(ipmiCmdOutput, ' ');
-    if (segments == NULL) {
-        result->code = UTOOLE_INTERNAL;
-        goto FAILURE;
+    if (response->length > TOTAL_POS) {
+        command->total = response->bytes[TOTAL_POS];
     }
 
-    if (segments[3] != NULL) {
-        command->total = (int) strtol(segments[3], NULL, 16);
-    }
-
-    if (segments[4] != NULL) {
-        command->length = (int) strtol(segments[4], NULL, 16);
+    if (response->length > LENGTH_POS) {
+        command->length = response->bytes[LENGTH_POS];
 
-        if (command->length > 1) {
-            char *netfun = segments[5];
-            command->netfun = UtoolStringNDup(netfun, strnlen(netfun, MAX_COMMAND_NAME_LEN));
-            result->code = UtoolAssetMallocNotNull(command->netfun);
-            if (result->code != UTOOLE_OK) {
-                goto FAILURE;
-            }
+        if (command->length > 1 && response->length > NETFUN_POS) {
+            command->netfun = response->bytes[NETFUN_POS];
         }
 
-        if (command->length > 2) {
-            char *cmd = segments[6];
-            command->command = UtoolStringNDup(cmd, strnlen(cmd, MAX_COMMAND_NAME_LEN));
-            result->code = UtoolAssetMallocNotNull(command->command);
-            if (result->code != UTOOLE_OK) {
-                goto FAILURE;
-            }
+        if (command->length > 2 && response->length > COMMAND_POS) {
+            command->command = response->bytes[COMMAND_POS];
         }
     }
 
@@ -160,7 +149,6 @@ FAILURE:
 
 DONE:
     FREE_OBJ(ipmiCmdOutput)
-    UtoolStringFreeArrays(segments);
     return command;
 }
 
@@ -227,7 +215,15 @@ int UtoolCmdGetIpmiWhitelist(UtoolCommandOption *commandOption, char **outputStr
         goto FAILURE;
     }
 
-    whitelistEnabled = UtoolStringEndsWith(ipmiCmdOutput, WHITELIST_ENABLED);
+    UtoolIPMIResponse *response = &(UtoolIPMIResponse) {0};
+    result->code = UtoolIPMIDecodeResponse(ipmiCmdOutput, response);
+    if (result->code != UTOOLE_OK) {
+        goto FAILURE;
+    }
+
+    whitelistEnabled = response->length >= WHITELIST_ENABLED_LEN &&
+                       UtoolIPMIResponseMatches(response, response->length - WHITELIST_ENABLED_LEN,
+                                                WHITELIST_ENABLED, WHITELIST_ENABLED_LEN);
     ZF_LOGI("IPMI whitelist status: %s", whitelistEnabled ? ENABLED : DISABLED);
     FREE_OBJ(ipmiCmdOutput)
 
@@ -290,9 +286,9 @@ int UtoolCmdGetIpmiWhitelist(UtoolCommandOption *commandOption, char **outputStr
             }
 
             UtoolIPMICommand *command = whitelists[index];
-            if (command->netfun != NULL) {
+            if (command->netfun >= 0) {
                 char netFunc[MAX_IPMI_CMD_LEN] = {0};
-                UtoolWrapSecFmt(netFunc, MAX_IPMI_CMD_LEN, MAX_IPMI_CMD_LEN - 1, "0x%s", command->netfun);
+                UtoolWrapSecFmt(netFunc, MAX_IPMI_CMD_LEN, MAX_IPMI_CMD_LEN - 1, "0x%02x", command->netfun);
                 cJSON *netfun = cJSON_AddStringToObject(item, "NetFunction", netFunc);
                 result->code = UtoolAssetCreatedJsonNotNull(netfun);
                 if (result->code != UTOOLE_OK) {
@@ -300,7 +296,7 @@ int UtoolCmdGetIpmiWhitelist(UtoolCommandOption *commandOption, char **outputStr
                 }
             }
 
-            if (command->command != NULL) {
+            if (command->command >= 0) {
                 cJSON *cmdList = cJSON_AddArrayToObject(item, "CmdList");
                 result->code = UtoolAssetCreatedJsonNotNull(cmdList);
                 if (result->code != UTOOLE_OK) {
@@ -308,7 +304,7 @@ int UtoolCmdGetIpmiWhitelist(UtoolCommandOption *commandOption, char **outputStr
                 }
 
                 char commandName[MAX_IPMI_CMD_LEN] = {0};
-                UtoolWrapSecFmt(commandName, MAX_IPMI_CMD_LEN, MAX_IPMI_CMD_LEN - 1, "0x%s", command->command);
+                UtoolWrapSecFmt(commandName, MAX_IPMI_CMD_LEN, MAX_IPMI_CMD_LEN - 1, "0x%02x", command->command);
                 cJSON *cmd = cJSON_CreateString(commandName);
                 result->code = UtoolAssetCreatedJsonNotNull(cmd);
                 if (result->code != UTOOLE_OK) {
@@ -323,18 +319,21 @@ int UtoolCmdGetIpmiWhitelist(UtoolCommandOption *commandOption, char **outputStr
 
             // validate whether null.
             if (command->data != NULL) {
-                char *data = command->data;
-                // if netfun is 0x30
-                if (UtoolStringCaseEquals(command->netfun, OEM_NETFUNC)) {
-                    // if data starts with db 07 00, we should remove it.
-                    if (UtoolStringCaseStartsWith(data, OEM_SUB_FUNC_PREFIX)) {
-                        data = command->data + 9;
-                    }
+                const uint8_t *data = command->data;
+                size_t dataLength = command->dataLength;
+                // if netfun is 0x30 and data starts with manufacturer id db 07 00, we should remove it.
+                if (command->netfun == OEM_NETFUNC && dataLength >= IPMI_MANUFACTURER_ID_LEN &&
+                    memcmp(data, IPMI_MANUFACTURER_ID_HUAWEI, IPMI_MANUFACTURER_ID_LEN) == 0) {
+                    data += IPMI_MANUFACTURER_ID_LEN;
+                    dataLength -= IPMI_MANUFACTURER_ID_LEN;
                 }
 
-                if (!UtoolStringCaseEquals(data, "ff")) {
-                    char prefixedData[MAX_IPMI_CMD_LEN] = {0};
-                    UtoolWrapSecFmt(prefixedData, MAX_IPMI_CMD_LEN, MAX_IPMI_CMD_LEN - 1, "0x%s", data);
+                if (dataLength > 0 && !(dataLength == 1 && data[0] == DFT_SUB_FUNC)) {
+                    char prefixedData[MAX_IPMI_CMD_LEN] = "0x";
+                    result->code = UtoolIPMIFormatBytes(data, dataLength, prefixedData + 2, MAX_IPMI_CMD_LEN - 2);
+                    if (result->code != UTOOLE_OK) {
+                        goto FAILURE;
+                    }
 
                     cJSON *dataNode = cJSON_CreateString(prefixedData);
                     result->code = UtoolAssetCreatedJsonNotNull(dataNode);
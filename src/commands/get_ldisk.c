@@ -132,17 +132,15 @@ int UtoolCmdGetLogicalDisks(UtoolCommandOption *commandOption, char **result)
     };
 
     UtoolRedfishServer *server = &(UtoolRedfishServer) {0};
-    UtoolCurlResponse *getStorageMembersResponse = &(UtoolCurlResponse) {0},
-            *getVolumesResponse = &(UtoolCurlResponse) {0},
-            *getVolumeResponse = &(UtoolCurlResponse) {0};
+    UtoolCurlResponse *getStorageMembersResponse = &(UtoolCurlResponse) {0};
+    UtoolResult *getVolumesResult = &(UtoolResult) {0};
 
     // initialize output objects
     cJSON *output = NULL,               // output result json
             *volumes = NULL,             // output volume array
             *volume = NULL,              // output volume item
             *storageMembersJson = NULL, // curl response storage members as json
-            *volumeMembersJson = NULL,  // curl response volume members as json
-            *volumeJson = NULL;         // curl response volume as json
+            *volumeMembersJson = NULL;  // volume collection with members loaded
 
     ret = UtoolValidateSubCommandBasicOptions(commandOption, options, usage, result);
     if (commandOption->flag != EXECUTABLE) {
@@ -202,50 +200,18 @@ int UtoolCmdGetLogicalDisks(UtoolCommandOption *commandOption, char **result)
         char volumesUrl[MAX_URL_LEN];
         char *url = storageLinkNode->valuestring;
         UtoolWrapSecFmt(volumesUrl, MAX_URL_LEN, MAX_URL_LEN - 1, "%s/Volumes", url);
-        ret = UtoolMakeCurlRequest(server, volumesUrl, HTTP_GET, NULL, NULL, getVolumesResponse);
-        if (ret != UTOOLE_OK) {
-            goto DONE;
-        }
-
-        if (getVolumesResponse->httpStatusCode >= 400) {
-            ret = UtoolResolveFailureResponse(getVolumesResponse, result);
-            goto DONE;
-        }
-
-        // process get storage members response
-        volumeMembersJson = cJSON_Parse(getVolumesResponse->content);
-        ret = UtoolAssetParseJsonNotNull(volumeMembersJson);
-        if (ret != UTOOLE_OK) {
+        UtoolRedfishGetCollection(server, volumesUrl, getVolumeMappings, getVolumesResult);
+        if (getVolumesResult->broken) {
+            ret = getVolumesResult->code;
+            *result = getVolumesResult->desc;
             goto FAILURE;
         }
+        volumeMembersJson = getVolumesResult->data;
+        getVolumesResult->data = NULL;
 
         cJSON *volumeMember = NULL;
         cJSON *volumeMembers = cJSON_GetObjectItem(volumeMembersJson, "Members");
         cJSON_ArrayForEach(volumeMember, volumeMembers) {
-            cJSON *volumeUrl = cJSON_GetObjectItem(volumeMember, "@odata.id");
-            ret = UtoolAssetJsonNodeNotNull(volumeUrl, "/Members/*/@odata.id");
-            if (ret != UTOOLE_OK) {
-                goto FAILURE;
-            }
-
-            ret = UtoolMakeCurlRequest(server, volumeUrl->valuestring, HTTP_GET, NULL, NULL, getVolumeResponse);
-            if (ret != UTOOLE_OK) {
-                goto DONE;
-            }
-
-            if (getVolumeResponse->httpStatusCode >= 400) {
-                ret = UtoolResolveFailureResponse(getVolumeResponse, result);
-                goto DONE;
-            }
-
-
-            // process get storage members response
-            volumeJson = cJSON_Parse(getVolumeResponse->content);
-            ret = UtoolAssetParseJsonNotNull(volumeJson);
-            if (ret != UTOOLE_OK) {
-                goto FAILURE;
-            }
-
             volume = cJSON_CreateObject();
             ret = UtoolAssetCreatedJsonNotNull(volume);
             if (ret != UTOOLE_OK) {
@@ -253,20 +219,14 @@ int UtoolCmdGetLogicalDisks(UtoolCommandOption *commandOption, char **result)
             }
 
             // create volume item and add it to array
-            ret = UtoolMappingCJSONItems(server, volumeJson, volume, getVolumeMappings);
+            ret = UtoolMappingCJSONItems(server, volumeMember, volume, getVolumeMappings);
             if (ret != UTOOLE_OK) {
                 goto FAILURE;
             }
             cJSON_AddItemToArray(volumes, volume);
-
-            // free memory
-            FREE_CJSON(volumeJson)
-            UtoolFreeCurlResponse(getVolumeResponse);
         }
 
-
         FREE_CJSON(volumeMembersJson)
-        UtoolFreeCurlResponse(getVolumesResponse);
     }
 
     // calculate maximum count
@@ -292,17 +252,12 @@ FAILURE:
     FREE_CJSON(volume)
     FREE_CJSON(volumes)
     FREE_CJSON(output)
-    FREE_CJSON(volumeJson)
     FREE_CJSON(volumeMembersJson)
-    UtoolFreeCurlResponse(getVolumeResponse);
-    UtoolFreeCurlResponse(getVolumesResponse);
     goto DONE;
 
 DONE:
     FREE_CJSON(storageMembersJson)
-    FREE_CJSON(volumeJson)
     UtoolFreeCurlResponse(getStorageMembersResponse);
-    UtoolFreeCurlResponse(getVolumeResponse);
     UtoolFreeRedfishServer(server);
     return ret;
 }
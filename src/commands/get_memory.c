@@ -18,6 +18,7 @@
 #include "command-interfaces.h"
 #include "argparse.h"
 #include "redfish.h"
+#include "memory-mappings.h"
 
 static const char *const usage[] = {
         "getmemory",
@@ -36,7 +37,7 @@ static const UtoolOutputMapping getMemorySummaryMapping[] = {
         NULL
 };
 
-static const UtoolOutputMapping getMemoryMappings[] = {
+const UtoolOutputMapping getMemoryMappings[] = {
         {.sourceXpath = "/DeviceLocator", .targetKeyValue="CommonName"},
         {.sourceXpath = "/Oem/${Oem}/Position", .targetKeyValue="Location"},
         {.sourceXpath = "/Manufacturer", .targetKeyValue="Manufacturer"},
@@ -121,7 +122,7 @@ int UtoolCmdGetMemory(UtoolCommandOption *commandOption, char **outputStr)
     }
     FREE_CJSON(result->data)
 
-    UtoolRedfishGet(server, "/Systems/%s/Memory", NULL, NULL, result);
+    UtoolRedfishGetCollection(server, "/Systems/%s/Memory", getMemoryMappings, result);
     if (result->broken) {
         goto FAILURE;
     }
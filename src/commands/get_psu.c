@@ -17,19 +17,20 @@
 #include "command-interfaces.h"
 #include "argparse.h"
 #include "redfish.h"
+#include "sensor-mappings.h"
 
 static const char *const usage[] = {
         "getpsu",
         NULL,
 };
 
-static const UtoolOutputMapping getPowerSummaryMapping[] = {
+const UtoolOutputMapping getPowerSummaryMapping[] = {
         {.sourceXpath = "/Oem/${Oem}/PowerSupplySummary/Status/HealthRollup", .targetKeyValue="OverallHealth"},
         {.sourceXpath = "/Oem/${Oem}/PowerSupplySummary/Count", .targetKeyValue="Maximum"},
         NULL
 };
 
-static const UtoolOutputMapping getPowerSupplyMapping[] = {
+const UtoolOutputMapping getPowerSupplyMapping[] = {
         {.sourceXpath = "/MemberId", .targetKeyValue="Id"},
         {.sourceXpath = "/Name", .targetKeyValue="CommonName"},
         {.sourceXpath = "/Oem/${Oem}/Position", .targetKeyValue="Location"},
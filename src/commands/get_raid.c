@@ -138,7 +138,7 @@ int UtoolCmdGetRAID(UtoolCommandOption *commandOption, char **outputStr)
     }
     FREE_CJSON(result->data)
 
-    UtoolRedfishGet(server, "/Systems/%s/Storages", NULL, NULL, result);
+    UtoolRedfishGetCollection(server, "/Systems/%s/Storages", getRAIDMappings, result);
     if (result->broken) {
         goto FAILURE;
     }
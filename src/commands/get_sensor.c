@@ -17,13 +17,14 @@
 #include "command-interfaces.h"
 #include "argparse.h"
 #include "redfish.h"
+#include "sensor-mappings.h"
 
 static const char *const usage[] = {
         "getsensor",
         NULL,
 };
 
-static const UtoolOutputMapping getThresholdSensorNestMappings[] = {
+const UtoolOutputMapping getThresholdSensorNestMappings[] = {
         {.sourceXpath = "/SensorNumber", .targetKeyValue="SensorNumber"},
         {.sourceXpath = "/Name", .targetKeyValue="SensorName"},
         {.sourceXpath = "/ReadingValue", .targetKeyValue="Reading"},
@@ -40,7 +41,7 @@ static const UtoolOutputMapping getThresholdSensorNestMappings[] = {
 };
 
 
-static const UtoolOutputMapping getThresholdSensorMappings[] = {
+const UtoolOutputMapping getThresholdSensorMappings[] = {
         {.sourceXpath = "/Sensors", .targetKeyValue="Sensors", .nestMapping=getThresholdSensorNestMappings},
         NULL
 };
@@ -40,11 +40,10 @@ int UtoolCmdGetTasks(UtoolCommandOption *commandOption, char **result)
     };
 
     UtoolRedfishServer *server = &(UtoolRedfishServer) {0};
-    UtoolCurlResponse *getTasksResp = &(UtoolCurlResponse) {0};
-    UtoolCurlResponse *getTaskResp = &(UtoolCurlResponse) {0};
+    UtoolResult *getTasksResult = &(UtoolResult) {0};
 
     // initialize output objects
-    cJSON *taskJson = NULL, *taskMembersJson = NULL;
+    cJSON *taskMembersJson = NULL;
     cJSON *output = NULL, *tasks = NULL, *task = NULL;
 
     ret = UtoolValidateSubCommandBasicOptions(commandOption, options, usage, result);
@@ -62,14 +61,13 @@ int UtoolCmdGetTasks(UtoolCommandOption *commandOption, char **result)
         goto DONE;
     }
 
-    ret = UtoolMakeCurlRequest(server, "/TaskService/Tasks", HTTP_GET, NULL, NULL, getTasksResp);
-    if (ret != UTOOLE_OK) {
-        goto DONE;
-    }
-    if (getTasksResp->httpStatusCode >= 400) {
-        ret = UtoolResolveFailureResponse(getTasksResp, result);
+    UtoolRedfishGetCollection(server, "/TaskService/Tasks", g_UtoolGetTaskMappings, getTasksResult);
+    if (getTasksResult->broken) {
+        ret = getTasksResult->code;
+        *result = getTasksResult->desc;
         goto DONE;
     }
+    taskMembersJson = getTasksResult->data;
 
     output = cJSON_CreateObject();
     ret = UtoolAssetCreatedJsonNotNull(output);
@@ -83,35 +81,10 @@ int UtoolCmdGetTasks(UtoolCommandOption *commandOption, char **result)
         goto FAILURE;
     }
 
-    // process response
-    taskMembersJson = cJSON_Parse(getTasksResp->content);
-    ret = UtoolAssetParseJsonNotNull(taskMembersJson);
-    if (ret != UTOOLE_OK) {
-        goto FAILURE;
-    }
-
+    // task members are loaded already
     cJSON *member = NULL;
     cJSON *members = cJSON_GetObjectItem(taskMembersJson, "Members");
     cJSON_ArrayForEach(member, members) {
-        cJSON *odataIdNode = cJSON_GetObjectItem(member, "@odata.id");
-        char *url = odataIdNode->valuestring;
-
-        ret = UtoolMakeCurlRequest(server, url, HTTP_GET, NULL, NULL, getTaskResp);
-        if (ret != UTOOLE_OK) {
-            goto FAILURE;
-        }
-
-        if (getTaskResp->httpStatusCode >= 400) {
-            ret = UtoolResolveFailureResponse(getTaskResp, result);
-            goto FAILURE;
-        }
-
-        taskJson = cJSON_Parse(getTaskResp->content);
-        ret = UtoolAssetParseJsonNotNull(taskJson);
-        if (ret != UTOOLE_OK) {
-            goto FAILURE;
-        }
-
         task = cJSON_CreateObject();
         ret = UtoolAssetCreatedJsonNotNull(task);
         if (ret != UTOOLE_OK) {
@@ -119,15 +92,11 @@ int UtoolCmdGetTasks(UtoolCommandOption *commandOption, char **result)
         }
 
         // create task item and add it to array
-        ret = UtoolMappingCJSONItems(server, taskJson, task, g_UtoolGetTaskMappings);
+        ret = UtoolMappingCJSONItems(server, member, task, g_UtoolGetTaskMappings);
         if (ret != UTOOLE_OK) {
             goto FAILURE;
         }
         cJSON_AddItemToArray(tasks, task);
-
-        // free memory
-        FREE_CJSON(taskJson)
-        UtoolFreeCurlResponse(getTaskResp);
     }
 
     // output to result
@@ -141,9 +110,6 @@ FAILURE:
 
 DONE:
     FREE_CJSON(taskMembersJson)
-    FREE_CJSON(taskJson)
-    UtoolFreeCurlResponse(getTasksResp);
-    UtoolFreeCurlResponse(getTaskResp);
     UtoolFreeRedfishServer(server);
     return ret;
 }
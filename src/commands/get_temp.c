@@ -17,13 +17,14 @@
 #include "command-interfaces.h"
 #include "argparse.h"
 #include "redfish.h"
+#include "sensor-mappings.h"
 
 static const char *const usage[] = {
         "gettemp",
         NULL,
 };
 
-static const UtoolOutputMapping getTemperatureMappings[] = {
+const UtoolOutputMapping getTemperatureMappings[] = {
         {.sourceXpath = "/Name", .targetKeyValue="Name"},
         {.sourceXpath = "/SensorNumber", .targetKeyValue="SensorNumber"},
         {.sourceXpath = "/UpperThresholdFatal", .targetKeyValue="UpperThresholdFatal"},
@@ -106,7 +106,7 @@ int UtoolCmdGetUsers(UtoolCommandOption *commandOption, char **outputStr)
         goto FAILURE;
     }
 
-    UtoolRedfishGet(server, "/AccountService/Accounts", NULL, NULL, result);
+    UtoolRedfishGetCollection(server, "/AccountService/Accounts", getUserMappings, result);
     if (result->broken) {
         goto FAILURE;
     }
@@ -161,12 +161,22 @@ int BuildOutputResult(const char *ipmiCmdOutput, char **result)
 {
     int ret = UTOOLE_CREATE_JSON_NULL;
 
+    // response bytes are printed on one line like " db 07 00 1a", output is kept as it is if it is not hex bytes
+    const char *ipmiRsp = ipmiCmdOutput;
+    char formatted[MAX_IPMI_CMD_OUTPUT_LEN] = " ";
+    UtoolIPMIResponse *ipmiResponse = &(UtoolIPMIResponse) {0};
+    if (UtoolIPMIDecodeResponse(ipmiCmdOutput, ipmiResponse) == UTOOLE_OK && ipmiResponse->length > 0 &&
+        UtoolIPMIFormatBytes(ipmiResponse->bytes, ipmiResponse->length, formatted + 1,
+                             sizeof(formatted) - 1) == UTOOLE_OK) {
+        ipmiRsp = formatted;
+    }
+
     cJSON *response = cJSON_CreateObject();
     if (response == NULL) {
         goto DONE;
     }
 
-    if (cJSON_AddStringToObject(response, RESULT_KEY_IPMI_RSP, ipmiCmdOutput) == NULL) {
+    if (cJSON_AddStringToObject(response, RESULT_KEY_IPMI_RSP, ipmiRsp) == NULL) {
         goto DONE;
     }
 
@@ -20,6 +20,7 @@
 #include "argparse.h"
 #include "redfish.h"
 #include "string_utils.h"
+#include "json_index.h"
 
 #define MB (1024 * 1024)
 
@@ -29,7 +30,7 @@ static const char *OPT_FILE_TOO_LARGE = "Error: input JSON file should not large
 static const char *OPT_JSON_FILE_ILLEGAL = "Error: input JSON file is not well formed.";
 
 static const char *const usage[] = {
-        "setbios [-a attribute] [-v value] [-f file-uri]",
+        "setbios [-a attribute] [-v value] [-f file-uri] [-d]",
         NULL,
 };
 
@@ -38,10 +39,13 @@ typedef struct _SetBiosAttrOption
     char *attr;
     char *value;
     char *fileURI;
+    int diff;
 } UtoolSetBiosAttrOption;
 
 static cJSON *BuildPayload(UtoolSetBiosAttrOption *option, UtoolResult *result);
 
+static cJSON *DiffPayload(UtoolRedfishServer *server, cJSON *payload, UtoolResult *result);
+
 static void ValidateSubcommandOptions(UtoolSetBiosAttrOption *option, UtoolResult *result);
 
 /**
@@ -54,6 +58,7 @@ static void ValidateSubcommandOptions(UtoolSetBiosAttrOption *option, UtoolResul
 int UtoolCmdSetBIOS(UtoolCommandOption *commandOption, char **outputStr)
 {
     cJSON *payload = NULL;
+    cJSON *summary = NULL;
 
     UtoolResult *result = &(UtoolResult) {0};
     UtoolRedfishServer *server = &(UtoolRedfishServer) {0};
@@ -68,6 +73,9 @@ int UtoolCmdSetBIOS(UtoolCommandOption *commandOption, char **outputStr)
             OPT_STRING ('f', "file-uri", &(option->fileURI),
                         "specifies JSON file URI which indicates BIOS attribute and value pairs to update.", NULL, 0,
                         0),
+            OPT_BOOLEAN('d', "diff", &(option->diff),
+                        "only update attributes whose current or pending value differs from the given one.", NULL, 0,
+                        0),
             OPT_END()
     };
 
@@ -98,14 +106,29 @@ int UtoolCmdSetBIOS(UtoolCommandOption *commandOption, char **outputStr)
         goto DONE;
     }
 
-    UtoolRedfishPatch(server, "/Systems/%s/Bios/Settings", payload, NULL, NULL, NULL, result);
-    if (result->broken) {
-        goto FAILURE;
+    if (option->diff) {
+        summary = DiffPayload(server, payload, result);
+        if (result->broken) {
+            goto FAILURE;
+        }
+    }
+
+    // nothing is patched if all attributes already take the given value
+    if (summary == NULL || cJSON_GetArraySize(cJSON_GetObjectItem(payload, "Attributes")) > 0) {
+        UtoolRedfishPatch(server, "/Systems/%s/Bios/Settings", payload, NULL, NULL, NULL, result);
+        if (result->broken) {
+            goto FAILURE;
+        }
+        FREE_CJSON(result->data)
     }
-    FREE_CJSON(result->data)
 
     // output to outputStr
-    UtoolBuildDefaultSuccessResult(&(result->desc));
+    if (summary != NULL) {
+        result->code = UtoolBuildOutputResult(STATE_SUCCESS, summary, &(result->desc));
+        summary = NULL;
+    } else {
+        UtoolBuildDefaultSuccessResult(&(result->desc));
+    }
     goto DONE;
 
 FAILURE:
@@ -113,6 +136,7 @@ FAILURE:
 
 DONE:
     FREE_CJSON(payload)
+    FREE_CJSON(summary)
     UtoolFreeRedfishServer(server);
 
     *outputStr = result->desc;
@@ -299,4 +323,137 @@ DONE:
         fclose(infile);
     }
     return attributes;
-}
\ No newline at end of file
+}
+
+/**
+* Async request callback, take the response JSON away into request context.
+*
+* @param group
+* @param request
+* @param result
+*/
+static void TakeResponseCallback(UtoolRedfishAsyncGroup *group, UtoolRedfishAsyncRequest *request,
+                                 UtoolResult *result)
+{
+    (void) group;
+    if (!result->broken) {
+        *((cJSON **) request->context) = result->data;
+        result->data = NULL;
+    }
+}
+
+/**
+* whether requested value equals to current value. `-a -v` always gives string value, so string value is compared
+* with number value literally.
+*
+* @param current
+* @param requested
+* @return
+*/
+static bool IsSameAttributeValue(const cJSON *current, const cJSON *requested)
+{
+    if (cJSON_Compare(current, requested, true)) {
+        return true;
+    }
+
+    if (cJSON_IsNumber(current) && cJSON_IsString(requested) && !UtoolStringIsEmpty(requested->valuestring)) {
+        char *end = NULL;
+        double number = strtod(requested->valuestring, &end);
+        return *end == '\0' && number == current->valuedouble;
+    }
+    return false;
+}
+
+/**
+* Get current & pending BIOS attributes concurrently, then drop the requested attributes which already take the
+* given value from payload. Pending value takes precedence over current value since it is applied on next boot.
+*
+* @param server
+* @param payload
+* @param result
+* @return summary of changed & skipped attribute names, NULL if failed
+*/
+static cJSON *DiffPayload(UtoolRedfishServer *server, cJSON *payload, UtoolResult *result)
+{
+    cJSON *current = NULL;
+    cJSON *pending = NULL;
+    cJSON *summary = NULL;
+    UtoolJsonIndex *currentIndex = &(UtoolJsonIndex) {0};
+    UtoolJsonIndex *pendingIndex = &(UtoolJsonIndex) {0};
+
+    UtoolRedfishAsyncGroup *group = &(UtoolRedfishAsyncGroup) {0};
+    UtoolRedfishAsyncGroupInit(group, server, 0);
+    UtoolRedfishAsyncGet(group, "/Systems/%s/Bios", NULL, NULL, TakeResponseCallback, &current);
+    UtoolRedfishAsyncGet(group, "/Systems/%s/Bios/Settings", NULL, NULL, TakeResponseCallback, &pending);
+    UtoolRedfishAsyncGroupRun(group, result);
+    if (result->broken) {
+        goto FAILURE;
+    }
+
+    result->code = UtoolJsonIndexBuild(currentIndex, cJSON_GetObjectItem(current, "Attributes"));
+    if (result->code != UTOOLE_OK) {
+        goto FAILURE;
+    }
+
+    result->code = UtoolJsonIndexBuild(pendingIndex, cJSON_GetObjectItem(pending, "Attributes"));
+    if (result->code != UTOOLE_OK) {
+        goto FAILURE;
+    }
+
+    summary = cJSON_CreateObject();
+    result->code = UtoolAssetCreatedJsonNotNull(summary);
+    if (result->code != UTOOLE_OK) {
+        goto FAILURE;
+    }
+
+    cJSON *changed = cJSON_AddArrayToObject(summary, "Changed");
+    result->code = UtoolAssetCreatedJsonNotNull(changed);
+    if (result->code != UTOOLE_OK) {
+        goto FAILURE;
+    }
+
+    cJSON *skipped = cJSON_AddArrayToObject(summary, "Skipped");
+    result->code = UtoolAssetCreatedJsonNotNull(skipped);
+    if (result->code != UTOOLE_OK) {
+        goto FAILURE;
+    }
+
+    cJSON *attributes = cJSON_GetObjectItem(payload, "Attributes");
+    cJSON *attribute = attributes == NULL ? NULL : attributes->child;
+    while (attribute != NULL) {
+        cJSON *next = attribute->next;
+        cJSON *value = UtoolJsonIndexGet(pendingIndex, attribute->string);
+        if (value == NULL) {
+            value = UtoolJsonIndexGet(currentIndex, attribute->string);
+        }
+
+        bool same = value != NULL && IsSameAttributeValue(value, attribute);
+        cJSON *name = cJSON_CreateString(attribute->string);
+        result->code = UtoolAssetCreatedJsonNotNull(name);
+        if (result->code != UTOOLE_OK) {
+            goto FAILURE;
+        }
+        cJSON_AddItemToArray(same ? skipped : changed, name);
+
+        if (same) {
+            cJSON_Delete(cJSON_DetachItemViaPointer(attributes, attribute));
+        }
+        attribute = next;
+    }
+
+    ZF_LOGI("BIOS attributes diff: %d changed, %d skipped.", cJSON_GetArraySize(changed),
+            cJSON_GetArraySize(skipped));
+    goto DONE;
+
+FAILURE:
+    result->broken = 1;
+    FREE_CJSON(summary)
+    goto DONE;
+
+DONE:
+    UtoolJsonIndexFree(currentIndex);
+    UtoolJsonIndexFree(pendingIndex);
+    FREE_CJSON(current)
+    FREE_CJSON(pending)
+    return summary;
+}
@@ -53,13 +53,8 @@ int UtoolCmdSetUserPriv(UtoolCommandOption *commandOption, char **outputStr)
 
     UtoolResult *result = &(UtoolResult) {0};
     UtoolRedfishServer *server = &(UtoolRedfishServer) {0};
-    UtoolCurlResponse *getUserResponse = &(UtoolCurlResponse) {0};
     UtoolSetUserOption *setPasswordOption = &(UtoolSetUserOption) {0};
 
-    // initialize output objects
-    cJSON *userMembersJson = NULL,        // curl response user member as json
-    *userJson = NULL;              // curl response user as json
-
     struct argparse_option options[] = {
             OPT_BOOLEAN('h', "help", &(commandOption->flag), HELP_SUB_COMMAND_DESC, UtoolGetHelpOptionCallback, 0, 0),
             OPT_STRING ('n', "username", &(setPasswordOption->username), "specifies the user to be modified", NULL, 0,
@@ -96,78 +91,32 @@ int UtoolCmdSetUserPriv(UtoolCommandOption *commandOption, char **outputStr)
         goto FAILURE;
     }
 
-    UtoolRedfishGet(server, "/AccountService/Accounts", NULL, NULL, result);
+    const cJSON *account = UtoolRedfishFindAccount(server, setPasswordOption->username, result);
     if (result->broken) {
         goto FAILURE;
     }
-    userMembersJson = result->data;
-
-    bool foundUserWithName = false;
-    char *userAccountUrl = NULL;
-    cJSON *members = cJSON_GetObjectItem(userMembersJson, "Members");
-    int memberCount = cJSON_GetArraySize(members);
-    for (int idx = 0; idx < memberCount && !foundUserWithName; idx++) {
-        cJSON *userLinkObject = cJSON_GetArrayItem(members, idx);
-        cJSON *link = cJSON_GetObjectItem(userLinkObject, "@odata.id");
-        result->code = UtoolAssetJsonNodeNotNull(link, "/Members/*/@odata.id");
-        if (result->code != UTOOLE_OK) {
-            goto FAILURE;
-        }
-
-        userAccountUrl = link->valuestring;
-        result->code = UtoolMakeCurlRequest(server, userAccountUrl, HTTP_GET, NULL, NULL, getUserResponse);
-        if (result->code != UTOOLE_OK) {
-            goto FAILURE;
-        }
-
-        if (getUserResponse->httpStatusCode >= 400) {
-            result->code = UtoolResolveFailureResponse(getUserResponse, outputStr);
-            goto FAILURE;
-        }
-
-        userJson = cJSON_Parse(getUserResponse->content);
-        result->code = UtoolAssetParseJsonNotNull(userJson);
-        if (result->code != UTOOLE_OK) {
-            goto FAILURE;
-        }
-
-        cJSON *userNameNode = cJSON_GetObjectItem(userJson, "UserName");
-        result->code = UtoolAssetJsonNodeNotNull(userNameNode, "UserName");
-        char *username = userNameNode->valuestring;
-        if (result->code != UTOOLE_OK || username == NULL) {
-            goto FAILURE;
-        }
-
-        if (UtoolStringEquals(setPasswordOption->username, username)) {
-            foundUserWithName = true;
-            ZF_LOGI("Current username is %s, matched.", username);
-            break;
-        } else {
-            ZF_LOGI("Current username is %s, does not matched.", username);
-        }
-
-        FREE_CJSON(userJson)
-        UtoolFreeCurlResponse(getUserResponse);
-    }
 
-    if (!foundUserWithName) {
+    if (account == NULL) {
         char buffer[MAX_FAILURE_MSG_LEN];
         UtoolWrapSecFmt(buffer, MAX_FAILURE_MSG_LEN, MAX_FAILURE_MSG_LEN - 1,
                         "Failure: No user with name `%s` exists",
                         setPasswordOption->username);
         result->code = UtoolBuildStringOutputResult(STATE_FAILURE, buffer, &(result->desc));
     } else {
-        // update user
+        // update user, ETag in account index is used directly
+        char *userAccountUrl = cJSON_GetObjectItem(account, "@odata.id")->valuestring;
+        const cJSON *etag = cJSON_GetObjectItem(account, "@odata.etag");
         const UtoolCurlHeader ifMatchHeader[] = {
-                {.name = HEADER_IF_MATCH, .value=getUserResponse->etag},
+                {.name = HEADER_IF_MATCH, .value=etag != NULL ? etag->valuestring : NULL},
                 NULL,
         };
 
-        UtoolRedfishPatch(server, userAccountUrl, payload, ifMatchHeader, NULL, NULL, result);
+        UtoolRedfishPatch(server, userAccountUrl, payload, etag != NULL ? ifMatchHeader : NULL, NULL, NULL, result);
         if (result->broken) {
             goto FAILURE;
         }
         FREE_CJSON(result->data)
+        UtoolRedfishForgetAccount(server, setPasswordOption->username);
 
         UtoolBuildDefaultSuccessResult(&(result->desc));
     }
@@ -179,9 +128,6 @@ FAILURE:
 
 DONE:
     FREE_CJSON(payload)
-    FREE_CJSON(userJson)
-    FREE_CJSON(userMembersJson)
-    UtoolFreeCurlResponse(getUserResponse);
     UtoolFreeRedfishServer(server);
 
     *outputStr = result->desc;
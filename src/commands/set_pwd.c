@@ -54,15 +54,10 @@ int UtoolCmdSetPassword(UtoolCommandOption *commandOption, char **result)
     cJSON *payload = NULL;
 
     UtoolRedfishServer *server = &(UtoolRedfishServer) {0};
-    UtoolCurlResponse *getUserResponse = &(UtoolCurlResponse) {0};
+    UtoolResult *findAccountResult = &(UtoolResult) {0};
     UtoolCurlResponse *updateUserResponse = &(UtoolCurlResponse) {0};
-    UtoolCurlResponse *getUserMemberResponse = &(UtoolCurlResponse) {0};
     UtoolSetPasswordOption *setPasswordOption = &(UtoolSetPasswordOption) {.flag = EXECUTABLE};
 
-    // initialize output objects
-    cJSON *userMembersJson = NULL,        // curl response user member as json
-    *userJson = NULL;              // curl response user as json
-
     struct argparse_option options[] = {
             OPT_BOOLEAN('h', "help", &(commandOption->flag), HELP_SUB_COMMAND_DESC, UtoolGetHelpOptionCallback, 0, 0),
             OPT_STRING ('n', "username", &(setPasswordOption->username), "specifies the user to be modified", NULL, 0,
@@ -99,85 +94,30 @@ int UtoolCmdSetPassword(UtoolCommandOption *commandOption, char **result)
         goto FAILURE;
     }
 
-    ret = UtoolMakeCurlRequest(server, "/AccountService/Accounts", HTTP_GET, NULL, NULL, getUserMemberResponse);
-    if (ret != UTOOLE_OK) {
-        goto FAILURE;
-    }
-
-    // process get chassis response
-    if (getUserMemberResponse->httpStatusCode >= 400) {
-        ret = UtoolResolveFailureResponse(getUserMemberResponse, result);
-        goto DONE;
-    }
-
-    userMembersJson = cJSON_Parse(getUserMemberResponse->content);
-    ret = UtoolAssetParseJsonNotNull(userMembersJson);
-    if (ret != UTOOLE_OK) {
+    const cJSON *account = UtoolRedfishFindAccount(server, setPasswordOption->username, findAccountResult);
+    if (findAccountResult->broken) {
+        ret = findAccountResult->code;
+        *result = findAccountResult->desc;
         goto FAILURE;
     }
 
-    bool foundUserWithName = false;
-    char *userAccountUrl = NULL;
-    cJSON *members = cJSON_GetObjectItem(userMembersJson, "Members");
-    int memberCount = cJSON_GetArraySize(members);
-    for (int idx = 0; idx < memberCount && !foundUserWithName; idx++) {
-        cJSON *userLinkObject = cJSON_GetArrayItem(members, idx);
-        cJSON *link = cJSON_GetObjectItem(userLinkObject, "@odata.id");
-        ret = UtoolAssetJsonNodeNotNull(link, "/Members/*/@odata.id");
-        if (ret != UTOOLE_OK) {
-            goto FAILURE;
-        }
-
-        userAccountUrl = link->valuestring;
-        ret = UtoolMakeCurlRequest(server, userAccountUrl, HTTP_GET, NULL, NULL, getUserResponse);
-        if (ret != UTOOLE_OK) {
-            goto FAILURE;
-        }
-
-        if (getUserResponse->httpStatusCode >= 400) {
-            ret = UtoolResolveFailureResponse(getUserResponse, result);
-            goto FAILURE;
-        }
-
-        userJson = cJSON_Parse(getUserResponse->content);
-        ret = UtoolAssetParseJsonNotNull(userJson);
-        if (ret != UTOOLE_OK) {
-            goto FAILURE;
-        }
-
-        cJSON *userNameNode = cJSON_GetObjectItem(userJson, "UserName");
-        ret = UtoolAssetJsonNodeNotNull(userNameNode, "UserName");
-        char *username = userNameNode->valuestring;
-        if (ret != UTOOLE_OK || username == NULL) {
-            goto FAILURE;
-        }
-
-        if (UtoolStringEquals(setPasswordOption->username, username)) {
-            foundUserWithName = true;
-            ZF_LOGI("Current username is %s, matched.", username);
-            break;
-        } else {
-            ZF_LOGI("Current username is %s, does not matched.", username);
-        }
-
-        FREE_CJSON(userJson)
-        UtoolFreeCurlResponse(getUserResponse);
-    }
-
-    if (!foundUserWithName) {
+    if (account == NULL) {
         char buffer[MAX_FAILURE_MSG_LEN];
         UtoolWrapSecFmt(buffer, MAX_FAILURE_MSG_LEN, MAX_FAILURE_MSG_LEN - 1,
                         "Failure: No user with name `%s` exists",
                         setPasswordOption->username);
         ret = UtoolBuildStringOutputResult(STATE_FAILURE, buffer, result);
     } else {
-        // update user
+        // update user, ETag in account index is used directly
+        char *userAccountUrl = cJSON_GetObjectItem(account, "@odata.id")->valuestring;
+        const cJSON *etag = cJSON_GetObjectItem(account, "@odata.etag");
         const UtoolCurlHeader ifMatchHeader[] = {
-                {.name = HEADER_IF_MATCH, .value=getUserResponse->etag},
+                {.name = HEADER_IF_MATCH, .value=etag != NULL ? etag->valuestring : NULL},
                 NULL,
         };
 
-        ret = UtoolMakeCurlRequest(server, userAccountUrl, HTTP_PATCH, payload, ifMatchHeader, updateUserResponse);
+        ret = UtoolMakeCurlRequest(server, userAccountUrl, HTTP_PATCH, payload, etag != NULL ? ifMatchHeader : NULL,
+                                   updateUserResponse);
         if (ret != UTOOLE_OK) {
             goto FAILURE;
         }
@@ -187,6 +127,7 @@ int UtoolCmdSetPassword(UtoolCommandOption *commandOption, char **result)
             goto FAILURE;
         }
 
+        UtoolRedfishForgetAccount(server, setPasswordOption->username);
         UtoolBuildDefaultSuccessResult(result);
     }
 
@@ -197,11 +138,7 @@ FAILURE:
 
 DONE:
     FREE_CJSON(payload)
-    FREE_CJSON(userJson)
-    FREE_CJSON(userMembersJson)
-    UtoolFreeCurlResponse(getUserResponse);
     UtoolFreeCurlResponse(updateUserResponse);
-    UtoolFreeCurlResponse(getUserMemberResponse);
     UtoolFreeRedfishServer(server);
     return ret;
 }
@@ -8,12 +8,15 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <ctype.h>
+#include <errno.h>
 #include <stdbool.h>
 #include <sys/stat.h>
 #include <time.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include <libgen.h>
+#include <pthread.h>
 #include <ipmi.h>
 #include "cJSON_Utils.h"
 #include "commons.h"
@@ -26,9 +29,15 @@
 #include "redfish.h"
 #include "string_utils.h"
 #include "url_parser.h"
+#include "mapped_file.h"
+#include "update_log.h"
+#include "bandwidth_limiter.h"
 
 #define IPMI_PROGRESS_NOT_START -1
 #define IPMI_PROGRESS_NOT_RETURNED -2
+#define IPMI_PROGRESS_POS 3             /* progress byte follows manufacturer id in query progress response */
+#define IPMI_PROGRESS_IDLE 0xE4         /* upgrade not started or finished */
+#define UPDATE_LOG_FOLDER_MAX_SEQ 100   /* max sequence appended to update log folder of the same host */
 
 #define BMC_USE_IPMI_VERSION "2.58"
 #define BMC_USE_IPMI_MAJOR_VERSION 2
@@ -39,11 +48,9 @@
 #define BMC_TRANSITION_MINOR_VERSION 39
 #define TIME_LIMIT_SHUTDOWN 120
 #define TIME_LIMIT_POWER_ON 420
-#define REBOOT_CHECK_INTERVAL 3
-#define LOG_HEAD "{\"log\":[   \n"
-#define LOG_TAIL "\n]}"
+#define ROLLOUT_DEFAULT_CONCURRENCY 8
+#define ROLLOUT_MAX_CONCURRENCY 64
 #define MAX_LOG_ENTRY_LEN 512
-#define LOG_ENTRY_FORMAT "\t{\n\t\t\"Time\": \"%s\",\n\t\t\"Stage\": \"%s\",\n\t\t\"State\": \"%s\",\n\t\t\"Note\": \"%s\"\n\t}, \n"
 
 #define UPGRADE_TRANSITION_FIRMWARE_PAYLOAD "{\"ImageURI\": \"/tmp/web/%s\"}"
 
@@ -150,6 +157,8 @@
 #define FW_BIOS "BIOS"
 #define FW_CPLD "CPLD"
 
+#define FW_ACTIVE_BMC_URL "/UpdateService/FirmwareInventory/ActiveBMC"
+
 #define MAX_FIRMWARE_NAME_LEN 64
 
 #define MSG_FAILED_TO_GET_CURRENT_VERSION "Failed to get current firmware version"
@@ -182,12 +191,38 @@ typedef struct _UpdateFirmwareOption {
     bool disableLogEntry;
     bool isLocalFile;
     bool isRemoteFile;
-    FILE *logFileFP;
+    bool logFolderWithHost;         /* append host to update log folder name, set by rollout */
+    UtoolMappedFile *imageFile;     /* local image mapping kept alive across stage retries */
+    UtoolUpdateLog *updateLog;      /* JSON-lines update log, written by background writer thread */
     cJSON *payload;
+    cJSON *firmwareSnapshot;        /* firmware inventory url -> version, captured by the latest inventory sweep */
     time_t startTime;
     UtoolCommandOption *commandOption;
 } UpdateFirmwareOption;
 
+/**
+ * Stages of updating firmware for one BMC, the workflow advances stage by stage until done or broken.
+ */
+typedef enum _UpdateFirmwareStage {
+    UPDATE_STAGE_PREPARE = 0,           /* create session, get SN & BMC version, upgrade transition firmware */
+    UPDATE_STAGE_TRANSFER,              /* upload local file or let BMC download remote file */
+    UPDATE_STAGE_UPGRADE,               /* run upgrade task */
+    UPDATE_STAGE_BACKUP_PLANE,          /* reboot BMC and upgrade backup plane when dual image is required */
+    UPDATE_STAGE_ACTIVATE,              /* activate firmware and print new version */
+    UPDATE_STAGE_DONE
+} UpdateFirmwareStage;
+
+static const char *UPDATE_STAGE_NAMES[] = {"Prepare", "Transfer", "Upgrade", "Upgrade backup plane", "Activate",
+                                           "Done"};
+
+/**
+ * context of BMC reboot probe callback
+ */
+typedef struct _RebootProbeContext {
+    char *stage;
+    UpdateFirmwareOption *updateFirmwareOption;
+} RebootProbeContext;
+
 typedef struct _FirmwareMapping {
     char *firmwareName;
     char *firmwareURL;
@@ -200,7 +235,7 @@ typedef struct _IpmiUpgradeErrorMapping {
 
 
 static const FirmwareMapping firmwareMapping[] = {
-        {.firmwareName = FW_BMC, .firmwareURL="/UpdateService/FirmwareInventory/ActiveBMC"},
+        {.firmwareName = FW_BMC, .firmwareURL=FW_ACTIVE_BMC_URL},
         {.firmwareName = "Backplane CPLD", .firmwareURL="/UpdateService/FirmwareInventory/MainBoardCPLD"},
         {.firmwareName = "Motherboard CPLD", .firmwareURL="/UpdateService/FirmwareInventory/MainBoardCPLD"},
         {.firmwareName = "PS Firmware", .firmwareURL="/UpdateService/FirmwareInventory/chassisPS1"},
@@ -246,6 +281,11 @@ static const char *OPTION_TYPE_ILLEGAL = "Error: option `firmware-type` is illeg
                                          "available choices: BMC, BIOS, CPLD, PSUFW.";
 static const char *OPTION_DUAL_ILLEGAL = "Error: option `dual-image` is illegal, "
                                          "available choices: Single, Dual.";
+static const char *OPTION_HOST_FILE_REQUIRED = "Error: option `host-file` is required.";
+static const char *OPTION_HOST_FILE_ILLEGAL = "Error: host file is illegal, it should be a JSON array of "
+                                              "{\"Host\", \"Port\", \"Username\", \"Password\"} objects.";
+static const char *OPTION_CONCURRENCY_ILLEGAL = "Error: option `concurrency` is illegal, range: 1-64.";
+static const char *OPTION_BANDWIDTH_ILLEGAL = "Error: option `subnet-bandwidth` is illegal, should not be negative.";
 static const char *OPTION_TYPE_258_REQUIRED = "Current active BMC version is 2.58, option `firmware-type` is required "
                                               "for this version, available choices: BMC, BIOS, CPLD.";
 static const char *OPTION_TYPE_258_ILLEGAL = "Current active BMC version is 2.58, available choices for option "
@@ -274,6 +314,13 @@ static void UpdateFirmware2(UtoolRedfishServer *server, UpdateFirmwareOption *up
 
 static void WriteLogEntry(UpdateFirmwareOption *option, const char *stage, const char *state, const char *note);
 
+/**
+ * durability point of update log, pending entries are synced to disk, only called at stage boundaries.
+ *
+ * @param option
+ */
+static void SyncLogEntries(UpdateFirmwareOption *option);
+
 static void
 WriteFailedLogEntry(UpdateFirmwareOption *option, const char *stage, const char *state, UtoolResult *result);
 
@@ -328,7 +375,7 @@ CreateLogFile(UtoolRedfishServer *server, UtoolCommandOption *commandOption, Upd
  * @param result
  * @return
  */
-static int
+static void
 GetBmcVersion(UtoolRedfishServer *server, UtoolCommandOption *commandOption, UpdateFirmwareOption *updateFirmwareOption,
               UtoolResult *result);
 
@@ -405,6 +452,30 @@ static void
 StartUpgradeTransitionFirmwareWorkflow(UtoolRedfishServer *server, UtoolCommandOption *commandOption,
                                        UpdateFirmwareOption *updateFirmwareOption, UtoolResult *result);
 
+/**
+ * transfer firmware file to BMC, upload local file or let BMC download remote file.
+ *
+ * @param server
+ * @param updateFirmwareOption
+ * @param result
+ */
+static void TransferFirmwareFile(UtoolRedfishServer *server, UtoolCommandOption *commandOption,
+                                 UpdateFirmwareOption *updateFirmwareOption, UtoolResult *result);
+
+/**
+ * run one stage of update firmware workflow.
+ *
+ * @param stage     stage to run
+ * @param server
+ * @param commandOption
+ * @param updateFirmwareOption
+ * @param result
+ * @return next stage to run, result->broken is marked if stage fails.
+ */
+static UpdateFirmwareStage RunUpdateFirmwareStage(UpdateFirmwareStage stage, UtoolRedfishServer *server,
+                                                  UtoolCommandOption *commandOption,
+                                                  UpdateFirmwareOption *updateFirmwareOption, UtoolResult *result);
+
 static void DisplayRunningProgress(int quiet, const char *progress);
 
 static void DisplayProgress(int quiet, const char *progress);
@@ -445,7 +516,7 @@ const IpmiUpgradeErrorMapping *GetIpmiError(const char *ipmiCmdOutput);
 void WaitUtilIpmiUpgradeTaskFinish(UtoolRedfishServer *server, UtoolCommandOption *commandOption,
                                    UpdateFirmwareOption *updateFirmwareOption, UtoolResult *result);
 
-int ParseProgressFromIpmiOutputStr(char *queryCmdOutput, time_t upgradeStartTime, UtoolResult *result);
+int ParseProgressFromIpmiResponse(const UtoolIPMIResponse *response, time_t upgradeStartTime);
 
 void ExecIpmiUpgradeFinishedCmdIfRequired(UtoolCommandOption *commandOption,
                                           const UpdateFirmwareOption *updateFirmwareOption, UtoolResult *result);
@@ -455,9 +526,9 @@ static void DisplayRunningProgress(int quiet, const char *progress)
     if (!quiet) {
         char nowStr[100] = {0};
         time_t now = time(NULL);
-        struct tm *tm_now = localtime(&now);
-        if (tm_now != NULL) {
-            strftime(nowStr, sizeof(nowStr), "%Y-%m-%d %H:%M:%S", tm_now);
+        struct tm tm_now;
+        if (UtoolLocalTime(now, &tm_now)) {
+            strftime(nowStr, sizeof(nowStr), "%Y-%m-%d %H:%M:%S", &tm_now);
         }
 
         fprintf(stdout, "%s %s", nowStr, progress);
@@ -625,82 +696,239 @@ DONE:
 }
 
 /**
- * result->data has been freed in func
+ * inventory sweep callback, record version of the firmware into snapshot.
+ * only active BMC is required, any other firmware which could not be loaded is skipped, e.g. PSU is not installed or
+ * its inventory fails transiently.
+ *
+ * @param group
+ * @param request
+ * @param result
+ */
+static void FirmwareSnapshotCallback(UtoolRedfishAsyncGroup *group, UtoolRedfishAsyncRequest *request,
+                                     UtoolResult *result)
+{
+    (void) group;
+    cJSON *snapshot = (cJSON *) request->context;
+    if (result->broken) {
+        if (!UtoolStringEquals(request->url, FW_ACTIVE_BMC_URL)) {
+            ZF_LOGW("Failed to load firmware inventory %s, HTTP status is %ld, code is %d, skip it.", request->url,
+                    request->response.httpStatusCode, result->code);
+            FREE_OBJ(result->desc)
+            result->broken = 0;
+            result->code = UTOOLE_OK;
+        }
+        return;
+    }
+
+    cJSON *version = cJSON_GetObjectItem(result->data, "Version");
+    if (cJSON_IsString(version) && cJSON_AddStringToObject(snapshot, request->url, version->valuestring) == NULL) {
+        result->code = UTOOLE_INTERNAL;
+        result->broken = 1;
+    }
+}
+
+/**
+ * capture firmware version snapshot with a single concurrent sweep of all firmware inventories this command cares,
+ * the previous snapshot is replaced only when the sweep succeeds.
  *
  * @param server
  * @param updateFirmwareOption
  * @param result
- * @return
  */
-static int
-GetBmcVersion(UtoolRedfishServer *server, UtoolCommandOption *commandOption, UpdateFirmwareOption *updateFirmwareOption,
-              UtoolResult *result)
+static void CaptureFirmwareSnapshot(UtoolRedfishServer *server, UpdateFirmwareOption *updateFirmwareOption,
+                                    UtoolResult *result)
 {
-    UtoolRedfishGet(server, "/redfish/v1/UpdateService/FirmwareInventory/ActiveBMC", NULL, NULL, result);
+    UtoolRedfishAsyncGroup *group = &(UtoolRedfishAsyncGroup) {0};
+    cJSON *snapshot = cJSON_CreateObject();
+    result->code = UtoolAssetCreatedJsonNotNull(snapshot);
+    if (result->code != UTOOLE_OK) {
+        goto FAILURE;
+    }
+
+    UtoolRedfishAsyncGroupInit(group, server, 0);
+    for (int idx = 0; firmwareMapping[idx].firmwareName != NULL; idx++) {
+        // several firmware share the same inventory, e.g. CPLD
+        bool swept = false;
+        for (int prev = 0; prev < idx && !swept; prev++) {
+            swept = UtoolStringEquals(firmwareMapping[prev].firmwareURL, firmwareMapping[idx].firmwareURL);
+        }
+
+        if (!swept && UtoolRedfishAsyncGet(group, firmwareMapping[idx].firmwareURL, NULL, NULL,
+                                           FirmwareSnapshotCallback, snapshot) == NULL) {
+            break;
+        }
+    }
+
+    UtoolRedfishAsyncGroupRun(group, result);
     if (result->broken) {
-        ZF_LOGE(DISPLAY_GET_FIRMWARE_INVENTORY_FAILED);
-        DisplayProgress(server->quiet, DISPLAY_GET_FIRMWARE_INVENTORY_FAILED);
         goto FAILURE;
     }
 
-    cJSON *version = cJSON_GetObjectItem(result->data, "Version");
-    if (!cJSON_IsString(version)) {
+    if (cJSON_GetObjectItem(snapshot, FW_ACTIVE_BMC_URL) == NULL) {
+        ZF_LOGE("Version of active BMC is not found in firmware inventory.");
         goto FAILURE;
     }
 
-    FREE_OBJ(updateFirmwareOption->activeBmcVersion);
-    ZF_LOGI("Current active bmc version is: %s.", version->valuestring);
-    updateFirmwareOption->activeBmcVersion = UtoolStringNDup(version->valuestring,
-                                                             strnlen(version->valuestring, MAX_FM_VERSION_LEN));
-    goto DONE;
+    FREE_CJSON(updateFirmwareOption->firmwareSnapshot)
+    updateFirmwareOption->firmwareSnapshot = snapshot;
+    return;
 
 FAILURE:
+    FREE_CJSON(snapshot)
     result->broken = 1;
-    goto DONE;
+}
 
-DONE:
-    FREE_CJSON(result->data)
+/**
+ * capture firmware version snapshot after BMC reboot.
+ * even BMC is alive, not all services may be ready, keep polling until snapshot is captured or deadline exceeds.
+ *
+ * @param server
+ * @param updateFirmwareOption
+ * @param result
+ */
+static void CaptureFirmwareSnapshotUntilReady(UtoolRedfishServer *server, UpdateFirmwareOption *updateFirmwareOption,
+                                              UtoolResult *result)
+{
+    time_t deadline = time(NULL) + FIRMWARE_READY_TIME_LIMIT;
+    while (true) {
+        CaptureFirmwareSnapshot(server, updateFirmwareOption, result);
+        if (!result->broken || time(NULL) + REBOOT_PROBE_INTERVAL > deadline) {
+            return;
+        }
+
+        ZF_LOGI("Firmware inventory is not ready yet, retry in %d seconds.", REBOOT_PROBE_INTERVAL);
+        FREE_OBJ(result->desc)
+        result->broken = 0;
+        result->code = UTOOLE_OK;
+        sleep(REBOOT_PROBE_INTERVAL);
+    }
+}
+
+/**
+ * get firmware version from the latest snapshot
+ *
+ * @param updateFirmwareOption
+ * @param firmwareURL
+ * @return version, NULL if firmware is not present in snapshot
+ */
+static const char *GetSnapshotFirmwareVersion(UpdateFirmwareOption *updateFirmwareOption, const char *firmwareURL)
+{
+    cJSON *version = cJSON_GetObjectItem(updateFirmwareOption->firmwareSnapshot, firmwareURL);
+    return cJSON_IsString(version) ? version->valuestring : NULL;
 }
 
+/**
+ * refresh firmware snapshot and read active BMC version from it.
+ *
+ * @param server
+ * @param updateFirmwareOption
+ * @param result
+ * @return
+ */
 static void
-CreateLogFile(UtoolRedfishServer *server, UtoolCommandOption *commandOption, UpdateFirmwareOption *updateFirmwareOption,
+GetBmcVersion(UtoolRedfishServer *server, UtoolCommandOption *commandOption, UpdateFirmwareOption *updateFirmwareOption,
               UtoolResult *result)
 {
-    char folderName[PATH_MAX];
-    struct tm *tm_now = localtime(&updateFirmwareOption->startTime);
-    if (tm_now == NULL) {
-        result->code = UTOOLE_INTERNAL;
-        goto FAILURE;
+    CaptureFirmwareSnapshot(server, updateFirmwareOption, result);
+    if (result->broken) {
+        ZF_LOGE(DISPLAY_GET_FIRMWARE_INVENTORY_FAILED);
+        DisplayProgress(server->quiet, DISPLAY_GET_FIRMWARE_INVENTORY_FAILED);
+        return;
     }
 
-    if (updateFirmwareOption->psn == NULL) {
-        UtoolWrapSecFmt(folderName, PATH_MAX, PATH_MAX - 1, "%d%02d%02d%02d%02d%02d",
-                        tm_now->tm_year + 1900,
-                        tm_now->tm_mon + 1,
-                        tm_now->tm_mday,
-                        tm_now->tm_hour,
-                        tm_now->tm_min,
-                        tm_now->tm_sec);
-    } else {
-        UtoolWrapSecFmt(folderName, PATH_MAX, PATH_MAX - 1, "%d%02d%02d%02d%02d%02d_%s",
-                        tm_now->tm_year + 1900,
-                        tm_now->tm_mon + 1,
-                        tm_now->tm_mday,
-                        tm_now->tm_hour,
-                        tm_now->tm_min,
-                        tm_now->tm_sec,
-                        updateFirmwareOption->psn);
+    const char *version = GetSnapshotFirmwareVersion(updateFirmwareOption, FW_ACTIVE_BMC_URL);
+    FREE_OBJ(updateFirmwareOption->activeBmcVersion);
+    ZF_LOGI("Current active bmc version is: %s.", version);
+    updateFirmwareOption->activeBmcVersion = UtoolStringNDup(version, strnlen(version, MAX_FM_VERSION_LEN));
+}
+
+/**
+ * build update log folder name: start time and product SN. Rollout appends host too, so that hosts updated in
+ * parallel which start in the same second never share a folder, even if their SN is absent or duplicated.
+ *
+ * @param server
+ * @param updateFirmwareOption
+ * @param folderName
+ * @param size
+ * @return false if start time could not be converted to local time
+ */
+static bool BuildUpdateLogFolderName(const UtoolRedfishServer *server, const UpdateFirmwareOption *updateFirmwareOption,
+                                     char *folderName, size_t size)
+{
+    struct tm tm_now;
+    if (!UtoolLocalTime(updateFirmwareOption->startTime, &tm_now)) {
+        return false;
     }
 
+    UtoolWrapSecFmt(folderName, size, size - 1, "%d%02d%02d%02d%02d%02d",
+                    tm_now.tm_year + 1900,
+                    tm_now.tm_mon + 1,
+                    tm_now.tm_mday,
+                    tm_now.tm_hour,
+                    tm_now.tm_min,
+                    tm_now.tm_sec);
+    if (updateFirmwareOption->psn != NULL && *updateFirmwareOption->psn != '\0') {
+        UtoolWrapStringAppend(folderName, size, "_");
+        UtoolWrapStringAppend(folderName, size, updateFirmwareOption->psn);
+    }
+
+    if (updateFirmwareOption->logFolderWithHost && server->host != NULL) {
+        UtoolWrapStringAppend(folderName, size, "_");
+        size_t offset = strnlen(folderName, size);
+        UtoolWrapStringAppend(folderName, size, server->host);
+        // IPv6 address & port separators are not allowed in folder name on every platform
+        for (char *cursor = folderName + offset; *cursor != '\0'; cursor++) {
+            if (!isalnum((unsigned char) *cursor) && *cursor != '.' && *cursor != '-') {
+                *cursor = '_';
+            }
+        }
+    }
+    return true;
+}
 
-    ZF_LOGE("Try to create folder for current updating, folder: %s.", folderName);
+/**
+ * create update log folder, accessible by owner & group only.
+ *
+ * process umask set at startup drops owner execute permission, folder mode is set explicitly afterwards instead
+ * of changing umask, which is shared by all rollout threads.
+ *
+ * @param folderName
+ * @return 0 if succeed
+ */
+static int CreateUpdateLogFolder(const char *folderName)
+{
 #if defined(__MINGW32__)
-    int ret = mkdir(folderName);
+    return mkdir(folderName);
 #else
-    int old = umask(S_IWGRP | S_IXGRP | S_IROTH | S_IWOTH | S_IXOTH);
     int ret = mkdir(folderName, 0750);
-    umask(old);
+    if (ret == 0) {
+        ret = chmod(folderName, 0750);
+    }
+    return ret;
 #endif
+}
+
+static void
+CreateLogFile(UtoolRedfishServer *server, UtoolCommandOption *commandOption, UpdateFirmwareOption *updateFirmwareOption,
+              UtoolResult *result)
+{
+    char folderName[PATH_MAX];
+    if (!BuildUpdateLogFolderName(server, updateFirmwareOption, folderName, PATH_MAX)) {
+        result->code = UTOOLE_INTERNAL;
+        goto FAILURE;
+    }
+
+    ZF_LOGE("Try to create folder for current updating, folder: %s.", folderName);
+    int ret = CreateUpdateLogFolder(folderName);
+    // the same host may be listed more than once in a rollout, a sequence is appended to tell them apart
+    size_t baseLen = strnlen(folderName, PATH_MAX);
+    for (int seq = 1; ret != 0 && errno == EEXIST && seq < UPDATE_LOG_FOLDER_MAX_SEQ; seq++) {
+        folderName[baseLen] = '\0';
+        char suffix[16] = {0};
+        UtoolWrapSecFmt(suffix, sizeof(suffix), sizeof(suffix) - 1, "_%d", seq);
+        UtoolWrapStringAppend(folderName, PATH_MAX, suffix);
+        ret = CreateUpdateLogFolder(folderName);
+    }
     if (ret != 0) {
         cJSON *reason = cJSON_CreateString(FAILED_TO_CREATE_FOLDER);
         result->data = reason;
@@ -714,17 +942,14 @@ CreateLogFile(UtoolRedfishServer *server, UtoolCommandOption *commandOption, Upd
     UtoolWrapSecFmt(filepath, PATH_MAX, PATH_MAX - 1, "%s/update-firmware.log", folderName);
 
     UtoolFileRealpath(filepath, realFilepath, PATH_MAX);
-    updateFirmwareOption->logFileFP = fopen(realFilepath, "a");
-    if (!updateFirmwareOption->logFileFP) {
+    updateFirmwareOption->updateLog = UtoolUpdateLogOpen(realFilepath);
+    if (updateFirmwareOption->updateLog == NULL) {
         ZF_LOGW("Failed to create log file %s.", filepath);
         cJSON *reason = cJSON_CreateString(FAILED_TO_CREATE_FOLDER);
         result->data = reason;
         result->code = UtoolAssetCreatedJsonNotNull(reason);
         goto FAILURE;
     }
-
-    /* write log file head content*/
-    fprintf(updateFirmwareOption->logFileFP, LOG_HEAD);
     goto DONE;
 
 FAILURE:
@@ -943,6 +1168,7 @@ void WaitUtilIpmiUpgradeTaskFinish(UtoolRedfishServer *server, UtoolCommandOptio
     int progress = 0;
     bool finished = false;
     char *queryCmdOutput = NULL;
+    UtoolIPMIResponse *response = &(UtoolIPMIResponse) {0};
 
     int queryTimes = 0;
     int maxQueryTimes = 360;
@@ -979,18 +1205,21 @@ void WaitUtilIpmiUpgradeTaskFinish(UtoolRedfishServer *server, UtoolCommandOptio
         queryTimes++;
 
         UtoolIPMIRawCmdOption *queryProgressCmd = &(UtoolIPMIRawCmdOption) {.data = IPMI_UPGRADE_QUERY_PROGRESS};
+        response->length = 0;
         queryCmdOutput = UtoolIPMIExecRawCommand(commandOption, queryProgressCmd, result);
         ZF_LOGI("Query IPMI upgrading firmware progress returns: %s", queryCmdOutput);
         const IpmiUpgradeErrorMapping *errorMapping = GetIpmiError(queryCmdOutput); // we find error from command output
 
         time_t now = time(NULL);
-        struct tm *localtime_now = localtime(&now);
-        if (localtime_now != NULL) {
-            strftime(formattedLocalTimeNow, sizeof(formattedLocalTimeNow), "%Y-%m-%d %H:%M:%S", localtime_now);
+        struct tm localtime_now;
+        if (UtoolLocalTime(now, &localtime_now)) {
+            strftime(formattedLocalTimeNow, sizeof(formattedLocalTimeNow), "%Y-%m-%d %H:%M:%S", &localtime_now);
         }
 
-        // if cmd output does not contains "db 07 00", treat it as fail
-        if (queryCmdOutput != NULL && strstr(queryCmdOutput, "db 07 00") == NULL) {
+        // if cmd output does not start with manufacturer id "db 07 00", treat it as fail
+        if (queryCmdOutput != NULL &&
+            (UtoolIPMIDecodeResponse(queryCmdOutput, response) != UTOOLE_OK ||
+             !UtoolIPMIResponseMatches(response, 0, IPMI_MANUFACTURER_ID_HUAWEI, IPMI_MANUFACTURER_ID_LEN))) {
             ZF_LOGE("Query IPMI upgrading firmware progress returns illegal result: %s, could not find db 07 00 "
                     "in it", queryCmdOutput);
             result->broken = 1;
@@ -1021,11 +1250,8 @@ void WaitUtilIpmiUpgradeTaskFinish(UtoolRedfishServer *server, UtoolCommandOptio
         } else { // run query command succeed.
             lastSuccessfulQueryTime = time(NULL); // reset last successful query time
 
-            int parsedProgress = ParseProgressFromIpmiOutputStr(queryCmdOutput, upgradeStartTime, result);
+            int parsedProgress = ParseProgressFromIpmiResponse(response, upgradeStartTime);
             ZF_LOGE("Parse progress from ipmi output: %d", parsedProgress);
-            if (result->broken) {
-                goto FAILURE;
-            }
             if (parsedProgress == 100) { // upgrade finished.
                 ExecIpmiUpgradeFinishedCmdIfRequired(commandOption, updateFirmwareOption, result);
                 if (result->broken) {
@@ -1105,42 +1331,24 @@ void ExecIpmiUpgradeFinishedCmdIfRequired(UtoolCommandOption *commandOption,
     }
 }
 
-int ParseProgressFromIpmiOutputStr(char *queryCmdOutput, time_t upgradeStartTime, UtoolResult *result)
+int ParseProgressFromIpmiResponse(const UtoolIPMIResponse *response, time_t upgradeStartTime)
 {
-    int progress = 0;
-
-    char **segments = UtoolStringSplit(queryCmdOutput, ' ');
-    if (segments == NULL) {
-        result->code = UTOOLE_INTERNAL;
-        goto FAILURE;
-    }
-
-    char *progressStr = segments[3];
-    if (progressStr == NULL) { // should not happen?
-        progress = IPMI_PROGRESS_NOT_RETURNED;
-        goto DONE;
+    if (response->length <= IPMI_PROGRESS_POS) { // should not happen?
+        return IPMI_PROGRESS_NOT_RETURNED;
     }
 
-    if ("e4" == progressStr) { //  e4 means upgrade not started or finished
+    int progress = 0;
+    int value = response->bytes[IPMI_PROGRESS_POS];
+    if (value == IPMI_PROGRESS_IDLE) { //  e4 means upgrade not started or finished
         time_t now = time(NULL);
         double spentTimeLong = difftime(now, upgradeStartTime);
         // 除CPLD和白牌包外的升级，15s内无法完成，此时认为没有开始升级，设置进度为0
         progress = spentTimeLong <= 15 ? IPMI_PROGRESS_NOT_START : 100;
     } else {
-        int value = (int) strtol(progressStr, NULL, 16);
         // BMC bug, if value is ge than 128, substract 128 as progress
         progress = value >= 128 ? value - 128 : value;
     }
 
-    goto DONE;
-
-FAILURE:
-    result->broken = 1;
-    FREE_OBJ(queryCmdOutput);
-    goto DONE;
-
-DONE:
-    UtoolStringFreeArrays(segments);
     return progress;
 }
 
@@ -1277,9 +1485,8 @@ DONE:
  * @param updateFirmwareOption
  * @param result
  */
-static void StartUpgradeTargetFirmwareWorkflow(UtoolRedfishServer *server, UtoolCommandOption *commandOption,
-                                               UpdateFirmwareOption *updateFirmwareOption,
-                                               UtoolResult *result)
+static void TransferFirmwareFile(UtoolRedfishServer *server, UtoolCommandOption *commandOption,
+                                 UpdateFirmwareOption *updateFirmwareOption, UtoolResult *result)
 {
     // clean
     if (updateFirmwareOption->isLocalFile) {
@@ -1297,6 +1504,32 @@ static void StartUpgradeTargetFirmwareWorkflow(UtoolRedfishServer *server, Utool
         }
     }
 
+    goto DONE;
+
+FAILURE:
+    result->broken = 1;
+    goto DONE;
+
+DONE:
+    return;
+}
+
+/**
+ * be caution that result->data will carry last task cJSON object if whole progress success.
+ *
+ * @param server
+ * @param updateFirmwareOption
+ * @param result
+ */
+static void StartUpgradeTargetFirmwareWorkflow(UtoolRedfishServer *server, UtoolCommandOption *commandOption,
+                                               UpdateFirmwareOption *updateFirmwareOption,
+                                               UtoolResult *result)
+{
+    TransferFirmwareFile(server, commandOption, updateFirmwareOption, result);
+    if (result->broken) {
+        goto FAILURE;
+    }
+
     // upgrade firmware
     RetryFunc(STAGE_UPGRADE_FIRMWARE, UpgradeFirmware, server, commandOption, updateFirmwareOption, result, true);
     if (result->broken) {
@@ -1349,59 +1582,222 @@ DONE:
     return;
 }
 
-/**
- * 要求：升级失败要求能重试，最多3次。
- *
- * 如果升级BMC带了-e Auto参数，且出现BMC的HTTP不通或空间不足等情况时要求utool能直接先将BMC重启后再试。
- * 升级过程详细记录到升级日志文件，内容及格式详见sheet "升级日志文件"。
- *
- * @param self
- * @param option
- * @return
- */
-int UtoolCmdUpdateOutbandFirmware(UtoolCommandOption *commandOption, char **outputStr)
+static UpdateFirmwareStage RunUpdateFirmwareStage(UpdateFirmwareStage stage, UtoolRedfishServer *server,
+                                                  UtoolCommandOption *commandOption,
+                                                  UpdateFirmwareOption *updateFirmwareOption, UtoolResult *result)
 {
-    cJSON *output = NULL;                   /** output result json*/
-    cJSON *payload = NULL;                  /** payload json */
+    ZF_LOGI("Run update firmware stage: %s.", UPDATE_STAGE_NAMES[stage]);
 
-    UtoolResult *result = &(UtoolResult) {0};
-    UtoolRedfishServer *server = &(UtoolRedfishServer) {0};
-    UtoolCurlResponse *response = &(UtoolCurlResponse) {0};
-    UpdateFirmwareOption *updateFirmwareOption = &(UpdateFirmwareOption) {0};
+    switch (stage) {
+        case UPDATE_STAGE_PREPARE:
+            // clean
+            RetryFunc(STAGE_CREATE_SESSION, CreateSession, server, commandOption, updateFirmwareOption, result, false);
+            if (result->broken) {
+                goto FAILURE;
+            }
 
-    struct argparse_option options[] = {
-            OPT_BOOLEAN('h', "help", &(commandOption->flag), HELP_SUB_COMMAND_DESC, UtoolGetHelpOptionCallback,
-                        0, 0),
-            OPT_STRING ('u', "image-uri", &(updateFirmwareOption->imageURI), "firmware image file URI", NULL, 0,
-                        0),
-            OPT_STRING ('e', "activate-mode", &(updateFirmwareOption->activateMode),
-                        "firmware active mode, choices: {Auto, Manual}", NULL, 0, 0),
-            OPT_STRING ('t', "firmware-type", &(updateFirmwareOption->firmwareType),
-                        "firmware type, available choices: {BMC, BIOS, CPLD, PSUFW}",
-                        NULL, 0, 0),
-            OPT_STRING ('d', "dual-image", &(updateFirmwareOption->dualImage),
-                        "indicates whether should update firmware for both plane, "
-                        "available choices: {Single, Dual}",
-                        NULL, 0, 0),
-            OPT_END(),
-    };
+            // clean
+            RetryFunc(STAGE_GET_PRODUCT_SN, GetProductSn, server, commandOption, updateFirmwareOption, result, false);
+            if (result->broken && updateFirmwareOption->productName == NULL) {
+                goto FAILURE;
+            } else {
+                // even we can not get product SN, we just create log file without sn, the upgrade progress should
+                // continue.
+                result->broken = 0;
+                result->code = UTOOLE_OK;
+            }
 
-    updateFirmwareOption->disableLogEntry = false;
+            // clean
+            RetryFunc(STAGE_CREATE_LOG_FILE, CreateLogFile, server, commandOption, updateFirmwareOption, result, false);
+            if (result->broken) {
+                // failure reason is freed with output
+                result->code = UtoolBuildOutputResult(STATE_FAILURE, result->data, &(result->desc));
+                result->data = NULL;
+                goto FAILURE;
+            }
 
-    // validation sub command options
-    result->code = UtoolValidateSubCommandBasicOptions(commandOption, options, usage, &(result->desc));
-    if (commandOption->flag != EXECUTABLE) {
-        goto DONE;
-    }
+            // parse current BMC version.
+            ParseActiveBmcVersion(updateFirmwareOption, server, result);
+            if (result->broken) {
+                goto FAILURE;
+            }
 
-    // validation connection options
-    result->code = UtoolValidateConnectOptions(commandOption, &(result->desc));
-    if (commandOption->flag != EXECUTABLE) {
-        goto DONE;
-    }
+            ValidateUpdateFirmwareOptionFor258(server, updateFirmwareOption, result);
+            if (result->broken) {
+                goto FAILURE;
+            }
 
-    /* validation update firmware options */
-    ValidateUpdateFirmwareOptions(updateFirmwareOption, result);
+            // BMC 2.58 will be filter out in transition firmware upgrade condition check.
+            // because only 6.32, 6.38 is allowed to upgraded to version after 6.39
+            // upgrade transition firmware if necessary.
+            UpgradeTransitionFirmwareIfNecessary(server, commandOption, updateFirmwareOption, result);
+            if (result->broken) {
+                FREE_CJSON(result->data)
+                goto FAILURE;
+            }
+            return UPDATE_STAGE_TRANSFER;
+
+        case UPDATE_STAGE_TRANSFER:
+            TransferFirmwareFile(server, commandOption, updateFirmwareOption, result);
+            if (result->broken) {
+                FREE_CJSON(result->data)
+                goto FAILURE;
+            }
+            SyncLogEntries(updateFirmwareOption);
+            return UPDATE_STAGE_UPGRADE;
+
+        case UPDATE_STAGE_UPGRADE:
+            // upgrade firmware workflow starts,
+            // if workflow runs normally, result->data will carry the latest task instance.
+            RetryFunc(STAGE_UPGRADE_FIRMWARE, UpgradeFirmware, server, commandOption, updateFirmwareOption, result,
+                      true);
+
+            // if it still fails when reaching the maximum retries
+            if (result->broken) {
+                FREE_CJSON(result->data)
+                goto FAILURE;
+            }
+            SyncLogEntries(updateFirmwareOption);
+
+            // if dual image update required
+            if (updateFirmwareOption->dualImage != NULL && UtoolStringEquals(updateFirmwareOption->dualImage, "Dual")) {
+                return UPDATE_STAGE_BACKUP_PLANE;
+            }
+            return UPDATE_STAGE_ACTIVATE;
+
+        case UPDATE_STAGE_BACKUP_PLANE:
+            FREE_CJSON(result->data)
+
+            ZF_LOGI("Dual plane update is required, start now.");
+
+            DisplayProgress(server->quiet, DISPLAY_UPGRADE_CURRENT_PLANE_DONE);
+            WriteLogEntry(updateFirmwareOption, STAGE_UPGRADE_FIRMWARE, PROGRESS_RUN,
+                          DISPLAY_UPGRADE_CURRENT_PLANE_DONE);
+            ZF_LOGI(DISPLAY_UPGRADE_CURRENT_PLANE_DONE);
+
+            DisplayProgress(server->quiet, DISPLAY_UPGRADE_BACKUP_PLANE_START);
+            WriteLogEntry(updateFirmwareOption, STAGE_UPGRADE_FIRMWARE, PROGRESS_RUN,
+                          DISPLAY_UPGRADE_BACKUP_PLANE_START);
+            ZF_LOGI(DISPLAY_UPGRADE_BACKUP_PLANE_START);
+
+            // we need to reboot BMC to update another plane
+            RebootBMC(STAGE_UPGRADE_BACKUP_PLANE, server, updateFirmwareOption, result);
+            if (result->broken) {
+                goto FAILURE;
+            }
+
+            // parse current BMC version.
+            ParseActiveBmcVersion(updateFirmwareOption, server, result);
+            if (result->broken) {
+                goto FAILURE;
+            }
+
+            // update bakup plane now
+            StartUpgradeTargetFirmwareWorkflow(server, commandOption, updateFirmwareOption, result);
+
+            if (result->broken) {
+                FREE_CJSON(result->data)
+                DisplayProgress(server->quiet, DISPLAY_UPGRADE_BACKUP_PLANE_FAILED);
+                WriteLogEntry(updateFirmwareOption, STAGE_UPGRADE_FIRMWARE, PROGRESS_FAILED,
+                              DISPLAY_UPGRADE_BACKUP_PLANE_FAILED);
+                ZF_LOGI(DISPLAY_UPGRADE_BACKUP_PLANE_FAILED);
+                goto FAILURE;
+            }
+
+            DisplayProgress(server->quiet, DISPLAY_UPGRADE_BACKUP_PLANE_DONE);
+            WriteLogEntry(updateFirmwareOption, STAGE_UPGRADE_FIRMWARE, PROGRESS_RUN,
+                          DISPLAY_UPGRADE_BACKUP_PLANE_DONE);
+            ZF_LOGI(DISPLAY_UPGRADE_BACKUP_PLANE_DONE);
+            return UPDATE_STAGE_ACTIVATE;
+
+        case UPDATE_STAGE_ACTIVATE: {
+            /* step4: wait util firmware updating effect */
+            cJSON *firmwareType = NULL;
+            if (updateFirmwareOption->activeBmcVersionEq258) {
+                firmwareType = cJSON_CreateString(updateFirmwareOption->firmwareType);
+                result->code = UtoolAssetCreatedJsonNotNull(firmwareType);
+                if (result->code != UTOOLE_OK) {
+                    goto FAILURE;
+                }
+            } else {
+                firmwareType = cJSON_Duplicate(cJSONUtils_GetPointer(result->data, "/Messages/MessageArgs/0"),
+                                               false);
+                ZF_LOGI("Detected firmware type from `/Messages/MessageArgs/0`, value is: %s",
+                        cJSON_IsString(firmwareType) ? firmwareType->valuestring : NULL);
+                // Free task cJSON object carried by result->data;
+                FREE_CJSON(result->data)
+            }
+
+            if (cJSON_IsString(firmwareType)) {
+                PrintFirmwareVersion(server, updateFirmwareOption, firmwareType, result);
+                FREE_CJSON(result->data)
+            }
+            FREE_CJSON(firmwareType)
+            return UPDATE_STAGE_DONE;
+        }
+
+        default:
+            return UPDATE_STAGE_DONE;
+    }
+
+FAILURE:
+    result->broken = 1;
+    return stage;
+}
+
+/**
+ * 要求：升级失败要求能重试，最多3次。
+ *
+ * 如果升级BMC带了-e Auto参数，且出现BMC的HTTP不通或空间不足等情况时要求utool能直接先将BMC重启后再试。
+ * 升级过程详细记录到升级日志文件，内容及格式详见sheet "升级日志文件"。
+ *
+ * @param self
+ * @param option
+ * @return
+ */
+int UtoolCmdUpdateOutbandFirmware(UtoolCommandOption *commandOption, char **outputStr)
+{
+    cJSON *output = NULL;                   /** output result json*/
+    cJSON *payload = NULL;                  /** payload json */
+
+    UtoolResult *result = &(UtoolResult) {0};
+    UtoolRedfishServer *server = &(UtoolRedfishServer) {0};
+    UtoolCurlResponse *response = &(UtoolCurlResponse) {0};
+    UpdateFirmwareOption *updateFirmwareOption = &(UpdateFirmwareOption) {0};
+
+    struct argparse_option options[] = {
+            OPT_BOOLEAN('h', "help", &(commandOption->flag), HELP_SUB_COMMAND_DESC, UtoolGetHelpOptionCallback,
+                        0, 0),
+            OPT_STRING ('u', "image-uri", &(updateFirmwareOption->imageURI), "firmware image file URI", NULL, 0,
+                        0),
+            OPT_STRING ('e', "activate-mode", &(updateFirmwareOption->activateMode),
+                        "firmware active mode, choices: {Auto, Manual}", NULL, 0, 0),
+            OPT_STRING ('t', "firmware-type", &(updateFirmwareOption->firmwareType),
+                        "firmware type, available choices: {BMC, BIOS, CPLD, PSUFW}",
+                        NULL, 0, 0),
+            OPT_STRING ('d', "dual-image", &(updateFirmwareOption->dualImage),
+                        "indicates whether should update firmware for both plane, "
+                        "available choices: {Single, Dual}",
+                        NULL, 0, 0),
+            OPT_END(),
+    };
+
+    updateFirmwareOption->disableLogEntry = false;
+
+    // validation sub command options
+    result->code = UtoolValidateSubCommandBasicOptions(commandOption, options, usage, &(result->desc));
+    if (commandOption->flag != EXECUTABLE) {
+        goto DONE;
+    }
+
+    // validation connection options
+    result->code = UtoolValidateConnectOptions(commandOption, &(result->desc));
+    if (commandOption->flag != EXECUTABLE) {
+        goto DONE;
+    }
+
+    /* validation update firmware options */
+    ValidateUpdateFirmwareOptions(updateFirmwareOption, result);
     if (result->broken) {
         goto FAILURE;
     }
@@ -1417,147 +1813,559 @@ int UtoolCmdUpdateOutbandFirmware(UtoolCommandOption *commandOption, char **outp
         goto FAILURE;
     }
 
-    // clean
-    RetryFunc(STAGE_CREATE_SESSION, CreateSession, server, commandOption, updateFirmwareOption, result, false);
-    if (result->broken) {
-        goto FAILURE;
+    // run update firmware workflow stage by stage
+    UpdateFirmwareStage stage = UPDATE_STAGE_PREPARE;
+    while (stage != UPDATE_STAGE_DONE) {
+        stage = RunUpdateFirmwareStage(stage, server, commandOption, updateFirmwareOption, result);
+        if (result->broken) {
+            goto FAILURE;
+        }
     }
 
-    // clean
-    RetryFunc(STAGE_GET_PRODUCT_SN, GetProductSn, server, commandOption, updateFirmwareOption, result, false);
-    if (result->broken && updateFirmwareOption->productName == NULL) {
-        goto FAILURE;
+    /* if upgrade success
+    DisplayProgress(server->quiet, DISPLAY_UPGRADE_DONE);
+    WriteLogEntry(updateFirmwareOption, STAGE_UPGRADE_FIRMWARE, PROGRESS_SUCCESS, "");
+    ZF_LOGI(DISPLAY_UPGRADE_DONE);*/
+
+    /* everything finished */
+    UtoolBuildDefaultSuccessResult(&(result->desc));
+    goto DONE;
+
+FAILURE:
+    FREE_CJSON(output)
+    goto DONE;
+
+DONE:
+    FREE_CJSON(payload)
+    UtoolFreeRedfishServer(server);
+    UtoolFreeCurlResponse(response);
+    freeUpdateFirmwareOption(updateFirmwareOption);
+    *outputStr = result->desc;
+    return result->code;
+}
+
+/**
+ * A BMC to be updated by firmware rollout, and its rollout state.
+ */
+typedef struct _RolloutHost {
+    char *host;
+    char *username;
+    char *password;
+    int ipmiPort;
+    char subnet[MAX_URL_LEN];     /* hosts in the same subnet share subnet bandwidth */
+    UtoolBandwidthLimiter *uploadLimiter;   /* upload limiter of subnet, NULL if unlimited */
+
+    UpdateFirmwareStage stage;    /* last stage reached */
+    bool succeed;
+    char *message;
+    time_t startTime;
+    time_t endTime;
+} RolloutHost;
+
+typedef struct _RolloutContext {
+    UtoolCommandOption *commandOption;
+    UpdateFirmwareOption *templateOption;
+    RolloutHost *hosts;
+    int total;
+    int next;                     /* index of next host to be picked up by workers */
+    int concurrency;
+    pthread_mutex_t mutex;        /* protects next & stdout */
+    UtoolBandwidthLimiter *limiters;  /* upload limiter of each subnet */
+    int limiterCount;
+} RolloutContext;
+
+static const char *const rolloutUsage[] = {
+        "fwrollout -f host-file -u image-uri -e activate-mode [-t firmware-type] [-d dual-image] "
+        "[-c concurrency] [-b subnet-bandwidth]",
+        NULL,
+};
+
+static void RolloutDisplayProgress(RolloutContext *context, RolloutHost *host, const char *progress)
+{
+    char message[MAX_OUTPUT_LEN] = {0};
+    UtoolWrapSecFmt(message, MAX_OUTPUT_LEN, MAX_OUTPUT_LEN - 1, "[%s] %s", host->host, progress);
+    pthread_mutex_lock(&(context->mutex));
+    DisplayProgress(context->commandOption->quiet, message);
+    pthread_mutex_unlock(&(context->mutex));
+}
+
+/**
+ * get subnet of host, IPv4 address will be grouped by /24, other host is a subnet itself.
+ *
+ * @param host
+ * @param subnet
+ */
+static void RolloutGetSubnet(const char *host, char *subnet)
+{
+    unsigned int a, b, c, d;
+    char tail;
+    if (sscanf(host, "%u.%u.%u.%u%c", &a, &b, &c, &d, &tail) == 4 && a < 256 && b < 256 && c < 256 && d < 256) {
+        UtoolWrapSecFmt(subnet, MAX_URL_LEN, MAX_URL_LEN - 1, "%u.%u.%u.0/24", a, b, c);
     } else {
-        // even we can not get product SN, we just create log file without sn, the upgrade progress should continue.
-        result->broken = 0;
-        result->code = UTOOLE_OK;
+        UtoolWrapSecFmt(subnet, MAX_URL_LEN, MAX_URL_LEN - 1, "%s", host);
     }
+}
 
-    // clean
-    RetryFunc(STAGE_CREATE_LOG_FILE, CreateLogFile, server, commandOption, updateFirmwareOption, result, false);
-    if (result->broken) {
-        result->code = UtoolBuildOutputResult(STATE_FAILURE, result->data, &(result->desc));
-        goto FAILURE;
+/**
+ * build rollout result message from workflow result.
+ *
+ * @param result
+ * @return
+ */
+static char *RolloutGetResultMessage(UtoolResult *result)
+{
+    if (result->code != UTOOLE_OK) {
+        const char *errorString = (result->code > UTOOLE_OK && result->code < CURL_LAST) ?
+                                  curl_easy_strerror(result->code) : UtoolGetStringError(result->code);
+        return UtoolStringNDup(errorString, MAX_FAILURE_MSG_LEN);
     }
 
-    // parse current BMC version.
-    ParseActiveBmcVersion(updateFirmwareOption, server, result);
-    if (result->broken) {
-        goto FAILURE;
+    char *message = NULL;
+    cJSON *output = cJSON_Parse(result->desc);
+    if (output != NULL) {
+        cJSON *node = cJSONUtils_GetPointer(output, "/Message/0");
+        if (cJSON_IsString(node)) {
+            message = UtoolStringNDup(node->valuestring, MAX_FAILURE_MSG_LEN);
+        }
     }
+    FREE_CJSON(output)
+    return message;
+}
 
-    ValidateUpdateFirmwareOptionFor258(server, updateFirmwareOption, result);
-    if (result->broken) {
+/**
+ * run the update firmware workflow against one host.
+ *
+ * @param context
+ * @param host
+ */
+static void RolloutUpdateFirmware(RolloutContext *context, RolloutHost *host)
+{
+    cJSON *payload = NULL;
+    UtoolResult *result = &(UtoolResult) {0};
+    UtoolRedfishServer *server = &(UtoolRedfishServer) {0};
+    UtoolCommandOption *commandOption = &(UtoolCommandOption) {0};
+    UpdateFirmwareOption *updateFirmwareOption = &(UpdateFirmwareOption) {0};
+    UpdateFirmwareOption *templateOption = context->templateOption;
+
+    host->startTime = time(NULL);
+    host->stage = UPDATE_STAGE_PREPARE;
+    RolloutDisplayProgress(context, host, "Rollout start.");
+
+    commandOption->host = host->host;
+    commandOption->ipmiPort = host->ipmiPort;
+    commandOption->username = host->username;
+    commandOption->password = host->password;
+    commandOption->quiet = 1;
+
+    result->code = UtoolValidateConnectOptions(commandOption, &(result->desc));
+    if (result->code != UTOOLE_OK || commandOption->flag != EXECUTABLE) {
         goto FAILURE;
     }
 
-    // BMC 2.58 will be filter out in transition firmware upgrade condition check.
-    // because only 6.32, 6.38 is allowed to upgraded to version after 6.39
-    // upgrade transition firmware if necessary.
-    UpgradeTransitionFirmwareIfNecessary(server, commandOption, updateFirmwareOption, result);
+    updateFirmwareOption->imageURI = templateOption->imageURI;
+    updateFirmwareOption->activateMode = templateOption->activateMode;
+    updateFirmwareOption->firmwareType = templateOption->firmwareType;
+    updateFirmwareOption->dualImage = templateOption->dualImage;
+    updateFirmwareOption->isLocalFile = templateOption->isLocalFile;
+    if (templateOption->imageFile != NULL) {
+        updateFirmwareOption->imageFile = UtoolMappedFileOpen(templateOption->imageFile->path);
+    }
+    updateFirmwareOption->disableLogEntry = false;
+    updateFirmwareOption->logFolderWithHost = true;
+    updateFirmwareOption->commandOption = commandOption;
+
+    server->quiet = commandOption->quiet;
+    server->uploadLimiter = host->uploadLimiter;
+
+    payload = BuildPayload(server, updateFirmwareOption, result);
+    updateFirmwareOption->payload = payload;
     if (result->broken) {
-        FREE_CJSON(result->data)
         goto FAILURE;
     }
 
-    // upgrade firmware workflow starts,
-    // if workflow runs normally, result->data will carry the latest task instance.
-    StartUpgradeTargetFirmwareWorkflow(server, commandOption, updateFirmwareOption, result);
+    while (host->stage != UPDATE_STAGE_DONE) {
+        char progress[MAX_OUTPUT_LEN] = {0};
+        UtoolWrapSecFmt(progress, MAX_OUTPUT_LEN, MAX_OUTPUT_LEN - 1, "Stage `%s` start.",
+                        UPDATE_STAGE_NAMES[host->stage]);
+        RolloutDisplayProgress(context, host, progress);
+        UpdateFirmwareStage next = RunUpdateFirmwareStage(host->stage, server, commandOption, updateFirmwareOption,
+                                                          result);
+        if (result->broken) {
+            goto FAILURE;
+        }
+        host->stage = next;
+    }
+
+    host->succeed = true;
+    host->message = UtoolStringNDup(DISPLAY_UPGRADE_DONE, MAX_FAILURE_MSG_LEN);
+    goto DONE;
 
-    // if it still fails when reaching the maximum retries
-    if (result->broken) {
-        FREE_CJSON(result->data)
+FAILURE:
+    host->succeed = false;
+    host->message = RolloutGetResultMessage(result);
+    goto DONE;
+
+DONE:
+    host->endTime = time(NULL);
+    RolloutDisplayProgress(context, host, host->succeed ? DISPLAY_UPGRADE_DONE : DISPLAY_UPGRADE_FAILED);
+
+    FREE_CJSON(result->data)
+    FREE_OBJ(result->desc)
+    FREE_CJSON(payload)
+    UtoolFreeRedfishServer(server);
+    freeUpdateFirmwareOption(updateFirmwareOption);
+}
+
+/**
+ * rollout worker, keeps picking up next host until all hosts are processed.
+ *
+ * @param arg   rollout context
+ * @return
+ */
+static void *RolloutWorker(void *arg)
+{
+    RolloutContext *context = (RolloutContext *) arg;
+    while (true) {
+        pthread_mutex_lock(&(context->mutex));
+        int index = context->next < context->total ? context->next++ : -1;
+        pthread_mutex_unlock(&(context->mutex));
+
+        if (index < 0) {
+            break;
+        }
+        RolloutUpdateFirmware(context, context->hosts + index);
+    }
+    return NULL;
+}
+
+/**
+ * load rollout hosts from host file, host file is a JSON array like:
+ *
+ *  [{"Host": "192.168.1.10", "Port": 623, "Username": "Administrator", "Password": "***"}]
+ *
+ * Port, Username, Password is optional, global connect options is used if absent.
+ *
+ * @param commandOption
+ * @param hostFile
+ * @param context
+ * @param result
+ */
+static void LoadRolloutHosts(UtoolCommandOption *commandOption, const char *hostFile, RolloutContext *context,
+                             UtoolResult *result)
+{
+    FILE *infile = NULL;
+    char *fileContent = NULL;
+    cJSON *hosts = NULL;
+
+    char realFilePath[PATH_MAX] = {0};
+    const char *ok = UtoolFileRealpath(hostFile, realFilePath, PATH_MAX);
+    if (ok == NULL) {
+        result->code = UTOOLE_ILLEGAL_LOCAL_FILE_PATH;
         goto FAILURE;
     }
 
-    // if dual image update required
-    if (updateFirmwareOption->dualImage != NULL && UtoolStringEquals(updateFirmwareOption->dualImage, "Dual")) {
-        FREE_CJSON(result->data)
+    infile = fopen(realFilePath, "rb");
+    if (!infile) {
+        result->code = UTOOLE_ILLEGAL_LOCAL_FILE_PATH;
+        goto FAILURE;
+    }
+
+    struct stat fileInfo;
+    if (fstat(fileno(infile), &fileInfo) != 0) {
+        result->code = UTOOLE_ILLEGAL_LOCAL_FILE_SIZE;
+        goto FAILURE;
+    }
 
-        ZF_LOGI("Dual plane update is required, start now.");
+    fileContent = (char *) calloc(fileInfo.st_size + 1, sizeof(char));
+    result->code = UtoolAssetMallocNotNull(fileContent);
+    if (result->code != UTOOLE_OK) {
+        goto FAILURE;
+    }
 
-        DisplayProgress(server->quiet, DISPLAY_UPGRADE_CURRENT_PLANE_DONE);
-        WriteLogEntry(updateFirmwareOption, STAGE_UPGRADE_FIRMWARE, PROGRESS_RUN,
-                      DISPLAY_UPGRADE_CURRENT_PLANE_DONE);
-        ZF_LOGI(DISPLAY_UPGRADE_CURRENT_PLANE_DONE);
+    size_t size = fread(fileContent, sizeof(char), fileInfo.st_size, infile);
+    hosts = cJSON_Parse(fileContent);
+    if (size != (size_t) fileInfo.st_size || !cJSON_IsArray(hosts) || cJSON_GetArraySize(hosts) == 0) {
+        ZF_LOGI("Host file format is illegal, position: %s.", cJSON_GetErrorPtr());
+        result->code = UtoolBuildOutputResult(STATE_FAILURE, cJSON_CreateString(OPTION_HOST_FILE_ILLEGAL),
+                                              &(result->desc));
+        goto FAILURE;
+    }
 
-        DisplayProgress(server->quiet, DISPLAY_UPGRADE_BACKUP_PLANE_START);
-        WriteLogEntry(updateFirmwareOption, STAGE_UPGRADE_FIRMWARE, PROGRESS_RUN,
-                      DISPLAY_UPGRADE_BACKUP_PLANE_START);
-        ZF_LOGI(DISPLAY_UPGRADE_BACKUP_PLANE_START);
+    context->total = cJSON_GetArraySize(hosts);
+    context->hosts = (RolloutHost *) calloc(context->total, sizeof(RolloutHost));
+    result->code = UtoolAssetMallocNotNull(context->hosts);
+    if (result->code != UTOOLE_OK) {
+        goto FAILURE;
+    }
 
-        // we need to reboot BMC to update another plane
-        RebootBMC(STAGE_UPGRADE_BACKUP_PLANE, server, updateFirmwareOption, result);
-        if (result->broken) {
+    int idx = 0;
+    cJSON *item = NULL;
+    cJSON_ArrayForEach(item, hosts) {
+        RolloutHost *host = context->hosts + idx++;
+        cJSON *hostNode = cJSON_GetObjectItem(item, "Host");
+        cJSON *portNode = cJSON_GetObjectItem(item, "Port");
+        cJSON *usernameNode = cJSON_GetObjectItem(item, "Username");
+        cJSON *passwordNode = cJSON_GetObjectItem(item, "Password");
+        if (!cJSON_IsString(hostNode) || UtoolStringIsEmpty(hostNode->valuestring)) {
+            result->code = UtoolBuildOutputResult(STATE_FAILURE, cJSON_CreateString(OPTION_HOST_FILE_ILLEGAL),
+                                                  &(result->desc));
             goto FAILURE;
         }
 
-        // parse current BMC version.
-        ParseActiveBmcVersion(updateFirmwareOption, server, result);
-        if (result->broken) {
-            goto FAILURE;
+        host->host = UtoolStringNDup(hostNode->valuestring, MAX_URL_LEN);
+        const char *username = cJSON_IsString(usernameNode) ? usernameNode->valuestring : commandOption->username;
+        const char *password = cJSON_IsString(passwordNode) ? passwordNode->valuestring : commandOption->password;
+        host->username = username != NULL ? UtoolStringNDup(username, MAX_PAYLOAD_LEN) : NULL;
+        host->password = password != NULL ? UtoolStringNDup(password, MAX_PAYLOAD_LEN) : NULL;
+        host->ipmiPort = cJSON_IsNumber(portNode) ? portNode->valueint : commandOption->ipmiPort;
+        RolloutGetSubnet(host->host, host->subnet);
+    }
+    goto DONE;
+
+FAILURE:
+    result->broken = 1;
+    goto DONE;
+
+DONE:
+    if (infile != NULL) {
+        fclose(infile);
+    }
+    FREE_OBJ(fileContent)
+    FREE_CJSON(hosts)
+}
+
+/**
+ * create an upload limiter for each subnet, shared by all hosts of the subnet. Total upload throughput of a subnet
+ * never exceeds its bandwidth, and bandwidth released by finished hosts is taken by the uploading ones.
+ *
+ * @param context
+ * @param subnetBandwidth   bandwidth of each subnet in KiB/s, unlimited if 0
+ * @param result
+ */
+static void AssignRolloutBandwidth(RolloutContext *context, int subnetBandwidth, UtoolResult *result)
+{
+    if (subnetBandwidth == 0) {
+        return;
+    }
+
+    context->limiters = (UtoolBandwidthLimiter *) calloc(context->total, sizeof(UtoolBandwidthLimiter));
+    result->code = UtoolAssetMallocNotNull(context->limiters);
+    if (result->code != UTOOLE_OK) {
+        result->broken = 1;
+        return;
+    }
+
+    for (int idx = 0; idx < context->total; idx++) {
+        RolloutHost *host = context->hosts + idx;
+        for (int other = 0; other < idx; other++) {
+            if (UtoolStringEquals(host->subnet, context->hosts[other].subnet)) {
+                host->uploadLimiter = context->hosts[other].uploadLimiter;
+                break;
+            }
         }
 
-        // update bakup plane now
-        StartUpgradeTargetFirmwareWorkflow(server, commandOption, updateFirmwareOption, result);
+        if (host->uploadLimiter == NULL) {
+            host->uploadLimiter = context->limiters + context->limiterCount++;
+            UtoolBandwidthLimiterInit(host->uploadLimiter, (long) subnetBandwidth * 1024);
+            ZF_LOGI("Rollout subnet %s, max upload speed %d KiB/s.", host->subnet, subnetBandwidth);
+        }
+    }
+}
 
-        if (result->broken) {
-            FREE_CJSON(result->data)
-            DisplayProgress(server->quiet, DISPLAY_UPGRADE_BACKUP_PLANE_FAILED);
-            WriteLogEntry(updateFirmwareOption, STAGE_UPGRADE_FIRMWARE, PROGRESS_FAILED,
-                          DISPLAY_UPGRADE_BACKUP_PLANE_FAILED);
-            ZF_LOGI(DISPLAY_UPGRADE_BACKUP_PLANE_FAILED);
-            goto FAILURE;
+static cJSON *BuildRolloutReport(RolloutContext *context, int *failed)
+{
+    cJSON *report = cJSON_CreateObject();
+    cJSON *hosts = cJSON_AddArrayToObject(report, "Hosts");
+    if (hosts == NULL) {
+        FREE_CJSON(report)
+        return NULL;
+    }
+
+    *failed = 0;
+    for (int idx = 0; idx < context->total; idx++) {
+        RolloutHost *host = context->hosts + idx;
+        cJSON *item = cJSON_CreateObject();
+        if (item == NULL) {
+            FREE_CJSON(report)
+            return NULL;
+        }
+        cJSON_AddItemToArray(hosts, item);
+        cJSON_AddStringToObject(item, "Host", host->host);
+        cJSON_AddStringToObject(item, "State", host->succeed ? STATE_SUCCESS : STATE_FAILURE);
+        cJSON_AddStringToObject(item, "Stage", UPDATE_STAGE_NAMES[host->stage]);
+        cJSON_AddNumberToObject(item, "Duration", (double) (host->endTime - host->startTime));
+        if (host->message != NULL) {
+            cJSON_AddStringToObject(item, "Message", host->message);
+        } else {
+            cJSON_AddNullToObject(item, "Message");
+        }
+        if (!host->succeed) {
+            (*failed)++;
         }
+    }
 
-        DisplayProgress(server->quiet, DISPLAY_UPGRADE_BACKUP_PLANE_DONE);
-        WriteLogEntry(updateFirmwareOption, STAGE_UPGRADE_FIRMWARE, PROGRESS_RUN,
-                      DISPLAY_UPGRADE_BACKUP_PLANE_DONE);
-        ZF_LOGI(DISPLAY_UPGRADE_BACKUP_PLANE_DONE);
+    cJSON_AddNumberToObject(report, "Total", context->total);
+    cJSON_AddNumberToObject(report, "Succeed", context->total - *failed);
+    cJSON_AddNumberToObject(report, "Failed", *failed);
+    return report;
+}
+
+/**
+ * Update firmware of many BMCs with one firmware image.
+ *
+ * Each host runs the same update workflow as `fwupdate` stage by stage, at most `concurrency` hosts are updated at
+ * the same time, local image is mapped once and shared by all uploads.
+ *
+ * @param commandOption
+ * @param outputStr
+ * @return
+ */
+int UtoolCmdRolloutOutbandFirmware(UtoolCommandOption *commandOption, char **outputStr)
+{
+    char *hostFile = NULL;
+    int concurrency = ROLLOUT_DEFAULT_CONCURRENCY;
+    int subnetBandwidth = 0;
+    pthread_t *workers = NULL;
+    int workerCount = 0;
+    bool mutexInitialized = false;
+    cJSON *payload = NULL;
+
+    UtoolResult *result = &(UtoolResult) {0};
+    UpdateFirmwareOption *updateFirmwareOption = &(UpdateFirmwareOption) {0};
+    RolloutContext *context = &(RolloutContext) {0};
+
+    struct argparse_option options[] = {
+            OPT_BOOLEAN('h', "help", &(commandOption->flag), HELP_SUB_COMMAND_DESC, UtoolGetHelpOptionCallback,
+                        0, 0),
+            OPT_STRING ('f', "host-file", &hostFile, "JSON file of hosts to be updated", NULL, 0, 0),
+            OPT_STRING ('u', "image-uri", &(updateFirmwareOption->imageURI), "firmware image file URI", NULL, 0,
+                        0),
+            OPT_STRING ('e', "activate-mode", &(updateFirmwareOption->activateMode),
+                        "firmware active mode, choices: {Auto, Manual}", NULL, 0, 0),
+            OPT_STRING ('t', "firmware-type", &(updateFirmwareOption->firmwareType),
+                        "firmware type, available choices: {BMC, BIOS, CPLD, PSUFW}",
+                        NULL, 0, 0),
+            OPT_STRING ('d', "dual-image", &(updateFirmwareOption->dualImage),
+                        "indicates whether should update firmware for both plane, "
+                        "available choices: {Single, Dual}",
+                        NULL, 0, 0),
+            OPT_INTEGER('c', "concurrency", &concurrency, "max count of hosts updated at the same time, 8 by default",
+                        NULL, 0, 0),
+            OPT_INTEGER('b', "subnet-bandwidth", &subnetBandwidth,
+                        "max upload bandwidth shared by hosts of each /24 subnet in KiB/s, unlimited by default",
+                        NULL, 0, 0),
+            OPT_END(),
+    };
+
+    // validation sub command options
+    result->code = UtoolValidateSubCommandBasicOptions(commandOption, options, rolloutUsage, &(result->desc));
+    if (commandOption->flag != EXECUTABLE) {
+        goto DONE;
     }
 
+    if (hostFile == NULL) {
+        result->code = UtoolBuildOutputResult(STATE_FAILURE, cJSON_CreateString(OPTION_HOST_FILE_REQUIRED),
+                                              &(result->desc));
+        goto FAILURE;
+    }
 
-    /* step4: wait util firmware updating effect */
-    cJSON *firmwareType = NULL;
-    if (updateFirmwareOption->activeBmcVersionEq258) {
-        firmwareType = cJSON_CreateString(updateFirmwareOption->firmwareType);
-        result->code = UtoolAssetCreatedJsonNotNull(firmwareType);
-        if (result->code != UTOOLE_OK) {
-            goto FAILURE;
+    if (concurrency < 1 || concurrency > ROLLOUT_MAX_CONCURRENCY) {
+        result->code = UtoolBuildOutputResult(STATE_FAILURE, cJSON_CreateString(OPTION_CONCURRENCY_ILLEGAL),
+                                              &(result->desc));
+        goto FAILURE;
+    }
+
+    if (subnetBandwidth < 0) {
+        result->code = UtoolBuildOutputResult(STATE_FAILURE, cJSON_CreateString(OPTION_BANDWIDTH_ILLEGAL),
+                                              &(result->desc));
+        goto FAILURE;
+    }
+
+    /* validation update firmware options, local image is mapped here and shared by all hosts */
+    ValidateUpdateFirmwareOptions(updateFirmwareOption, result);
+    if (result->broken) {
+        goto FAILURE;
+    }
+
+    // validate image uri once before touching any host
+    UtoolRedfishServer *server = &(UtoolRedfishServer) {0};
+    payload = BuildPayload(server, updateFirmwareOption, result);
+    FREE_OBJ(updateFirmwareOption->targetBmcVersion)
+    if (result->broken) {
+        goto FAILURE;
+    }
+
+    LoadRolloutHosts(commandOption, hostFile, context, result);
+    if (result->broken) {
+        goto FAILURE;
+    }
+
+    context->commandOption = commandOption;
+    context->templateOption = updateFirmwareOption;
+    context->concurrency = concurrency;
+    pthread_mutex_init(&(context->mutex), NULL);
+    mutexInitialized = true;
+    AssignRolloutBandwidth(context, subnetBandwidth, result);
+    if (result->broken) {
+        goto FAILURE;
+    }
+
+    workers = (pthread_t *) calloc(concurrency, sizeof(pthread_t));
+    result->code = UtoolAssetMallocNotNull(workers);
+    if (result->code != UTOOLE_OK) {
+        goto FAILURE;
+    }
+
+    for (int idx = 0; idx < concurrency && idx < context->total; idx++) {
+        if (pthread_create(workers + idx, NULL, RolloutWorker, context) != 0) {
+            ZF_LOGE("Failed to create rollout worker thread.");
+            break;
         }
-    } else {
-        firmwareType = cJSON_Duplicate(cJSONUtils_GetPointer(result->data, "/Messages/MessageArgs/0"),
-                                       false);
-        ZF_LOGI("Detected firmware type from `/Messages/MessageArgs/0`, value is: %s", firmwareType);
-        // Free task cJSON object carried by result->data;
-        FREE_CJSON(result->data)
+        workerCount++;
     }
 
-    if (cJSON_IsString(firmwareType)) {
-        PrintFirmwareVersion(server, updateFirmwareOption, firmwareType, result);
-        FREE_CJSON(result->data)
+    // if no worker could be started, process all hosts in current thread
+    if (workerCount == 0) {
+        RolloutWorker(context);
     }
-    FREE_CJSON(firmwareType)
 
+    for (int idx = 0; idx < workerCount; idx++) {
+        pthread_join(workers[idx], NULL);
+    }
 
-    /* if upgrade success
-    DisplayProgress(server->quiet, DISPLAY_UPGRADE_DONE);
-    WriteLogEntry(updateFirmwareOption, STAGE_UPGRADE_FIRMWARE, PROGRESS_SUCCESS, "");
-    ZF_LOGI(DISPLAY_UPGRADE_DONE);*/
+    int failed = 0;
+    cJSON *report = BuildRolloutReport(context, &failed);
+    result->code = UtoolAssetCreatedJsonNotNull(report);
+    if (result->code != UTOOLE_OK) {
+        goto FAILURE;
+    }
 
-    /* everything finished */
-    UtoolBuildDefaultSuccessResult(&(result->desc));
+    result->code = UtoolBuildOutputResult(failed == 0 ? STATE_SUCCESS : STATE_FAILURE, report, &(result->desc));
     goto DONE;
 
 FAILURE:
-    FREE_CJSON(output)
     goto DONE;
 
 DONE:
+    if (mutexInitialized) {
+        pthread_mutex_destroy(&(context->mutex));
+    }
+    if (context->hosts != NULL) {
+        for (int idx = 0; idx < context->total; idx++) {
+            FREE_OBJ(context->hosts[idx].host)
+            FREE_OBJ(context->hosts[idx].username)
+            FREE_OBJ(context->hosts[idx].password)
+            FREE_OBJ(context->hosts[idx].message)
+        }
+        FREE_OBJ(context->hosts)
+    }
+    for (int idx = 0; idx < context->limiterCount; idx++) {
+        UtoolBandwidthLimiterDestroy(context->limiters + idx);
+    }
+    FREE_OBJ(context->limiters)
+    FREE_OBJ(workers)
     FREE_CJSON(payload)
-    UtoolFreeRedfishServer(server);
-    UtoolFreeCurlResponse(response);
-    freeUpdateFirmwareOption(updateFirmwareOption);
+    UtoolMappedFileRelease(updateFirmwareOption->imageFile);
     *outputStr = result->desc;
     return result->code;
 }
@@ -1590,7 +2398,9 @@ ParseActiveBmcVersion(UpdateFirmwareOption *updateFirmwareOption, UtoolRedfishSe
     char *activeBmcVersion = NULL;
     RetryFunc(STAGE_GET_BMC_VERSION, GetBmcVersion, server, NULL, updateFirmwareOption, result, true);
     if (result->broken) {
+        // failure reason is freed with output
         result->code = UtoolBuildOutputResult(STATE_FAILURE, result->data, &(result->desc));
+        result->data = NULL;
         goto FAILURE;
     }
 
@@ -1753,21 +2563,13 @@ void freeUpdateFirmwareOption(UpdateFirmwareOption *updateFirmwareOption)
         FREE_OBJ(updateFirmwareOption->productName)
         FREE_OBJ(updateFirmwareOption->activeBmcVersion)
         FREE_OBJ(updateFirmwareOption->targetBmcVersion)
+        FREE_CJSON(updateFirmwareOption->firmwareSnapshot)
+        UtoolMappedFileRelease(updateFirmwareOption->imageFile);
+        updateFirmwareOption->imageFile = NULL;
 
-        if (updateFirmwareOption->logFileFP != NULL) {
-            fseeko(updateFirmwareOption->logFileFP, -3, SEEK_END);
-            _off_t position = ftello(updateFirmwareOption->logFileFP);
-            if (position != -1) {
-                int ret = ftruncate(fileno(updateFirmwareOption->logFileFP), position); /* delete last dot */
-                if (ret != 0) {
-                    ZF_LOGE("Failed to truncate update firmware log file");
-                }
-            } else {
-                ZF_LOGE("Failed to run ftello method against update firmware log file");
-            }
-            fprintf(updateFirmwareOption->logFileFP, LOG_TAIL); /* write log file head content*/
-            fclose(updateFirmwareOption->logFileFP);            /* close log file FP */
-        }
+        /* write all pending log entries and close log file */
+        UtoolUpdateLogClose(updateFirmwareOption->updateLog);
+        updateFirmwareOption->updateLog = NULL;
     }
 }
 
@@ -1922,10 +2724,9 @@ void PrintFirmwareVersion(UtoolRedfishServer *server, UpdateFirmwareOption *upda
     ZF_LOGI("Activate firmware %s now.", mapping->firmwareName);
 
     if (mapping) {
-        /* get current firmware version */
-        ZF_LOGI("Try to get current firmware version now.");
-        UtoolRedfishGet(server, mapping->firmwareURL, NULL, NULL, result);
-        if (result->broken) {
+        /* current firmware version is read from the snapshot captured before activation */
+        const char *currentVersion = GetSnapshotFirmwareVersion(updateFirmwareOption, mapping->firmwareURL);
+        if (currentVersion == NULL) {
             UtoolWrapSecFmt(displayMessage, MAX_OUTPUT_LEN, MAX_OUTPUT_LEN - 1,
                             DISPLAY_GET_FIRMWARE_VERSION_FAILED,
                             mapping->firmwareName);
@@ -1936,19 +2737,11 @@ void PrintFirmwareVersion(UtoolRedfishServer *server, UpdateFirmwareOption *upda
             goto FAILURE;
         }
 
-        cJSON *versionNode = cJSON_GetObjectItem(result->data, "Version");
-        result->code = UtoolAssetParseJsonNotNull(versionNode);
-        if (result->code != UTOOLE_OK) {
-            DisplayProgress(server->quiet, DISPLAY_GET_FIRMWARE_VERSION_FAILED);
-            goto FAILURE;
-        }
-
         UtoolWrapSecFmt(displayMessage, MAX_OUTPUT_LEN, MAX_OUTPUT_LEN - 1,
                         "Firmware(%s)'s current version is %s",
-                        mapping->firmwareName, versionNode->valuestring);
+                        mapping->firmwareName, currentVersion);
         DisplayProgress(server->quiet, displayMessage);
         WriteLogEntry(updateFirmwareOption, STAGE_ACTIVATE, PROGRESS_GET_CURRENT_VERSION, displayMessage);
-        FREE_CJSON(result->data)
 
         // 2021-12-09(turnbig): we just keep the old logics here.
         /* we need to get new firmware version if auto restart */
@@ -1961,10 +2754,8 @@ void PrintFirmwareVersion(UtoolRedfishServer *server, UpdateFirmwareOption *upda
                 goto FAILURE;
             }
 
-            // even BMC reboot succeed, may not all service is ready, wait 10s in case.
-            sleep(10);
-
-            UtoolRedfishGet(server, mapping->firmwareURL, NULL, NULL, result);
+            // even BMC reboot succeed, may not all service is ready, poll the inventory until it is ready.
+            CaptureFirmwareSnapshotUntilReady(server, updateFirmwareOption, result);
             if (result->broken) {
                 DisplayProgress(server->quiet, MSG_FAILED_TO_GET_NEW_VERSION);
                 WriteLogEntry(updateFirmwareOption, STAGE_ACTIVATE, PROGRESS_GET_NEW_VERSION,
@@ -1974,18 +2765,12 @@ void PrintFirmwareVersion(UtoolRedfishServer *server, UpdateFirmwareOption *upda
                 goto FAILURE;
             }
 
-            cJSON *versionNode = cJSON_GetObjectItem(result->data, "Version");
-            result->code = UtoolAssetParseJsonNotNull(versionNode);
-            if (result->code != UTOOLE_OK) {
-                goto FAILURE;
-            }
-
             char message[MAX_OUTPUT_LEN];
             UtoolWrapSecFmt(message, MAX_OUTPUT_LEN, MAX_OUTPUT_LEN - 1, "%s firmware's new version is %s",
-                            mapping->firmwareName, versionNode->valuestring);
+                            mapping->firmwareName,
+                            GetSnapshotFirmwareVersion(updateFirmwareOption, mapping->firmwareURL));
             DisplayProgress(server->quiet, message);
             WriteLogEntry(updateFirmwareOption, STAGE_ACTIVATE, PROGRESS_GET_NEW_VERSION, message);
-            FREE_CJSON(result->data)
         }
     }
 
@@ -2031,24 +2816,13 @@ static void createUpdateLogFile(UtoolRedfishServer *server, UpdateFirmwareOption
     }
 
     char folderName[PATH_MAX];
-    struct tm *tm_now = localtime(&updateFirmwareOption->startTime);
-    if (tm_now == NULL) {
+    if (!BuildUpdateLogFolderName(server, updateFirmwareOption, folderName, PATH_MAX)) {
         result->code = UTOOLE_INTERNAL;
         goto FAILURE;
     }
-    UtoolWrapSecFmt(folderName, PATH_MAX, PATH_MAX - 1, "%d%02d%02d%02d%02d%02d_%s", tm_now->tm_year + 1900,
-                    tm_now->tm_mon + 1,
-                    tm_now->tm_mday, tm_now->tm_hour, tm_now->tm_min, tm_now->tm_sec,
-                    updateFirmwareOption->psn);
 
     ZF_LOGE("Try to create folder for current updating, folder: %s.", folderName);
-#if defined(__MINGW32__)
-    int ret = mkdir(folderName);
-#else
-    int old = umask(S_IWGRP | S_IXGRP | S_IROTH | S_IWOTH | S_IXOTH);
-    int ret = mkdir(folderName, 0750);
-    umask(old);
-#endif
+    int ret = CreateUpdateLogFolder(folderName);
     if (ret != 0) {
         result->code = UtoolBuildOutputResult(STATE_FAILURE, cJSON_CreateString(FAILED_TO_CREATE_FOLDER),
                                               &(result->desc));
@@ -2061,8 +2835,8 @@ static void createUpdateLogFile(UtoolRedfishServer *server, UpdateFirmwareOption
     UtoolWrapSecFmt(filepath, PATH_MAX, PATH_MAX - 1, "%s/update-firmware.log", folderName);
 
     UtoolFileRealpath(filepath, realFilepath, PATH_MAX);
-    updateFirmwareOption->logFileFP = fopen(realFilepath, "a");
-    if (!updateFirmwareOption->logFileFP) {
+    updateFirmwareOption->updateLog = UtoolUpdateLogOpen(realFilepath);
+    if (updateFirmwareOption->updateLog == NULL) {
         ZF_LOGW("Failed to create log file %s.", filepath);
         result->code = UtoolBuildOutputResult(STATE_FAILURE, cJSON_CreateString(FAILED_TO_CREATE_FILE),
                                               &(result->desc));
@@ -2071,9 +2845,6 @@ static void createUpdateLogFile(UtoolRedfishServer *server, UpdateFirmwareOption
 
     DisplayProgress(server->quiet, DISPLAY_CREATE_LOG_FILE_DONE);
 
-    /* write log file head content*/
-    fprintf(updateFirmwareOption->logFileFP, LOG_HEAD);
-
     goto DONE;
 
 FAILURE:
@@ -2085,11 +2856,57 @@ DONE:
     FREE_CJSON(result->data)
 }
 
+/**
+ * display reboot progress of BMC.
+ *
+ * @param probe
+ * @param stateChanged
+ */
+static void RebootBMCProbeCallback(UtoolRebootProbe *probe, bool stateChanged)
+{
+    int quiet = probe->server->quiet;
+    RebootProbeContext *context = (RebootProbeContext *) probe->context;
+    if (!stateChanged) {
+        UtoolPrintf(quiet, stdout, ".");
+        return;
+    }
+
+    UtoolPrintf(quiet, stdout, "\n");
+    switch (probe->state) {
+        case REBOOT_PROBE_WAIT_ALIVE:
+            DisplayProgress(quiet, DISPLAY_BMC_HAS_BEEN_SHUTDOWN);
+            WriteLogEntry(context->updateFirmwareOption, context->stage, PROGRESS_SHUTDOWN_SUCCEED, "");
+            ZF_LOGI(DISPLAY_BMC_HAS_BEEN_SHUTDOWN);
+
+            // waiting BMC power on
+            DisplayRunningProgress(quiet, DISPLAY_WAIT_BMC_POWER_ON);
+            WriteLogEntry(context->updateFirmwareOption, context->stage, PROGRESS_WAITING_ALIVE, "");
+            ZF_LOGI(DISPLAY_WAIT_BMC_POWER_ON);
+            break;
+        case REBOOT_PROBE_ALIVE:
+            DisplayProgress(quiet, DISPLAY_BMC_REBOOT_DONE);
+            WriteLogEntry(context->updateFirmwareOption, context->stage, PROGRESS_REBOOT_DONE, "");
+            ZF_LOGI(DISPLAY_BMC_REBOOT_DONE);
+            break;
+        case REBOOT_PROBE_SHUTDOWN_TIMEOUT:
+            DisplayProgress(quiet, MSG_SHUTDOWN_TO_EXCEED);
+            WriteLogEntry(context->updateFirmwareOption, context->stage, PROGRESS_FAILED, MSG_SHUTDOWN_TO_EXCEED);
+            ZF_LOGI(MSG_SHUTDOWN_TO_EXCEED);
+            break;
+        case REBOOT_PROBE_ALIVE_TIMEOUT:
+            DisplayProgress(quiet, MSG_STARTUP_TO_EXCEED);
+            WriteLogEntry(context->updateFirmwareOption, context->stage, PROGRESS_FAILED, MSG_STARTUP_TO_EXCEED);
+            ZF_LOGI(MSG_STARTUP_TO_EXCEED);
+            break;
+        default:
+            break;
+    }
+}
+
 static int RebootBMC(char *stage, UtoolRedfishServer *server, UpdateFirmwareOption *updateFirmwareOption,
                      UtoolResult *result)
 {
     int ret;
-    time_t begin, now;
     cJSON *payload = NULL;
     UtoolCurlResponse *resetManagerResp = &(UtoolCurlResponse) {0};
 
@@ -2121,87 +2938,31 @@ static int RebootBMC(char *stage, UtoolRedfishServer *server, UpdateFirmwareOpti
     WriteLogEntry(updateFirmwareOption, stage, PROGRESS_WAITING_SHUTDOWN, "");
     ZF_LOGI(DISPLAY_WAIT_BMC_SHUTDOWN);
 
-    // waiting BMC shutdown, total wait time is 120s = 40*3
-    bool hasShutdown = false;
-    time(&begin);
-    time(&now);
-    while (difftime(now, begin) <= TIME_LIMIT_SHUTDOWN) {
-        UtoolPrintf(server->quiet, stdout, ".");
-        UtoolCurlResponse *getRedfishResp = &(UtoolCurlResponse) {0};
-        ret = UtoolMakeCurlRequest(server, "/", HTTP_GET, NULL, NULL, getRedfishResp);
-        if (ret != CURLE_OK || getRedfishResp->httpStatusCode > 300) {
-            UtoolFreeCurlResponse(getRedfishResp);
-            hasShutdown = true;
-            // shutdown progress finished
-            UtoolPrintf(server->quiet, stdout, "\n");
-
-            DisplayProgress(server->quiet, DISPLAY_BMC_HAS_BEEN_SHUTDOWN);
-            WriteLogEntry(updateFirmwareOption, stage, PROGRESS_SHUTDOWN_SUCCEED, "");
-            ZF_LOGI(DISPLAY_BMC_HAS_BEEN_SHUTDOWN);
-
-            // waiting BMC power on
-            DisplayRunningProgress(server->quiet, DISPLAY_WAIT_BMC_POWER_ON);
-            WriteLogEntry(updateFirmwareOption, stage, PROGRESS_WAITING_ALIVE, "");
-            ZF_LOGI(DISPLAY_WAIT_BMC_POWER_ON);
-            break;
-        }
-
-        ZF_LOGI("BMC is still alive now. Next shutdown checking will be %d seconds later.",
-                REBOOT_CHECK_INTERVAL);
-        sleep(REBOOT_CHECK_INTERVAL);
-        UtoolFreeCurlResponse(getRedfishResp);
-        time(&now);
-    }
+    // waiting BMC shutdown in 120s and alive in 420s
+    RebootProbeContext *context = &(RebootProbeContext) {.stage = stage, .updateFirmwareOption = updateFirmwareOption};
+    UtoolRebootProbe *probe = &(UtoolRebootProbe) {
+            .server = server,
+            .state = REBOOT_PROBE_WAIT_SHUTDOWN,
+            .shutdownTimeLimit = TIME_LIMIT_SHUTDOWN,
+            .aliveTimeLimit = TIME_LIMIT_POWER_ON,
+            .callback = RebootBMCProbeCallback,
+            .context = context,
+    };
+    UtoolRedfishWaitBMCReboot(probe, 1);
 
-    if (!hasShutdown) {
-        UtoolPrintf(server->quiet, stdout, "\n");
-        DisplayProgress(server->quiet, MSG_SHUTDOWN_TO_EXCEED);
-        WriteLogEntry(updateFirmwareOption, stage, PROGRESS_FAILED, MSG_SHUTDOWN_TO_EXCEED);
+    if (probe->state == REBOOT_PROBE_SHUTDOWN_TIMEOUT) {
         UtoolBuildStringOutputResult(STATE_FAILURE, MSG_SHUTDOWN_TO_EXCEED, &(result->desc));
         goto FAILURE;
     }
 
-    // waiting BMC alive, total wait time is 420s = 120 * 3
-    time(&begin);
-    time(&now);
-    bool isAlive = false;
-    while (difftime(now, begin) <= TIME_LIMIT_POWER_ON) {
-        UtoolPrintf(server->quiet, stdout, ".");
-        UtoolCurlResponse *getRedfishResp = &(UtoolCurlResponse) {0};
-        ret = UtoolMakeCurlRequest(server, "/redfish/v1/UpdateService/FirmwareInventory/ActiveBMC", HTTP_GET, NULL,
-                                   NULL, getRedfishResp);
-        if (ret == UTOOLE_OK && getRedfishResp->httpStatusCode < 300) {
-            UtoolFreeCurlResponse(getRedfishResp);
-            isAlive = true;
-            // sleep 15s to make sure BMC has startup completely.
-            sleep(15);
-
-            // power on progress finished
-            UtoolPrintf(server->quiet, stdout, "\n");
-            // reboot progress finished
-            DisplayProgress(server->quiet, DISPLAY_BMC_REBOOT_DONE);
-            WriteLogEntry(updateFirmwareOption, stage, PROGRESS_REBOOT_DONE, "");
-            ZF_LOGI(DISPLAY_BMC_REBOOT_DONE);
-            break;
-        }
-
-        ZF_LOGI("BMC is still down now. Next alive check will be %d seconds later.", REBOOT_CHECK_INTERVAL);
-        sleep(REBOOT_CHECK_INTERVAL);
-        UtoolFreeCurlResponse(getRedfishResp);
-        time(&now);
-    }
-
-    if (!isAlive) {
-        UtoolPrintf(server->quiet, stdout, "\n");
-
-        DisplayProgress(server->quiet, MSG_STARTUP_TO_EXCEED);
-        WriteLogEntry(updateFirmwareOption, stage, PROGRESS_FAILED, MSG_STARTUP_TO_EXCEED);
-        ZF_LOGI(MSG_STARTUP_TO_EXCEED);
-
+    if (probe->state != REBOOT_PROBE_ALIVE) {
         UtoolBuildStringOutputResult(STATE_FAILURE, MSG_STARTUP_TO_EXCEED, &(result->desc));
         goto FAILURE;
     }
 
+    // reboot done is a durability point of update log
+    SyncLogEntries(updateFirmwareOption);
+    ret = UTOOLE_OK;
     goto DONE;
 
 FAILURE:
@@ -2271,6 +3032,7 @@ static void ValidateUpdateFirmwareOptions(UpdateFirmwareOption *updateFirmwareOp
         if (imageFileFP) {
             if (fstat(fileno(imageFileFP), &fileInfo) == 0) {
                 updateFirmwareOption->isLocalFile = true;
+                updateFirmwareOption->imageFile = UtoolMappedFileOpen(realFilepath);
             }
         }
 
@@ -2427,6 +3189,58 @@ static void parseTargetBmcVersionFromFilepath(UpdateFirmwareOption *option, char
 }
 
 
+/**
+ * locate the first message of utool output JSON, e.g. {"State": "Failure", "Message": ["..."]}
+ *
+ * @param output    utool output JSON string
+ * @param message   start of message string body, still escaped as in output
+ * @param len       length of message string body
+ * @return whether message string is found
+ */
+static bool FindFirstOutputMessage(const char *output, const char **message, size_t *len)
+{
+    const char *cursor = output == NULL ? NULL : strstr(output, "\"" RESULT_KEY_MESSAGES "\"");
+    if (cursor == NULL) {
+        return false;
+    }
+
+    cursor += strlen("\"" RESULT_KEY_MESSAGES "\"");
+    while (*cursor == ' ' || *cursor == '\t' || *cursor == '\n' || *cursor == '\r' || *cursor == ':' ||
+           *cursor == '[') {
+        cursor++;
+    }
+
+    if (*cursor != '"') {
+        return false;
+    }
+
+    const char *start = ++cursor;
+    while (*cursor != '\0' && *cursor != '"') {
+        // skip escaped char
+        if (*cursor == '\\' && *(cursor + 1) != '\0') {
+            cursor++;
+        }
+        cursor++;
+    }
+
+    if (*cursor != '"') {
+        return false;
+    }
+
+    *message = start;
+    *len = (size_t) (cursor - start);
+    return true;
+}
+
+/**
+ * write log entry with failure reason carried by result.
+ * message of output JSON is copied into log entry as is, output JSON does not need to be parsed again.
+ *
+ * @param option
+ * @param stage
+ * @param state
+ * @param result
+ */
 static void
 WriteFailedLogEntry(UpdateFirmwareOption *option, const char *stage, const char *state, UtoolResult *result)
 {
@@ -2437,12 +3251,11 @@ WriteFailedLogEntry(UpdateFirmwareOption *option, const char *stage, const char
             WriteLogEntry(option, stage, state, errorString);
             return;
         } else {
-            cJSON *output = cJSON_Parse(result->desc);
-            if (output != NULL) {
-                cJSON *message = cJSONUtils_GetPointer(output, "/Message/0");
-                WriteLogEntry(option, stage, state, message == NULL ? "" : message->valuestring);
+            const char *message = NULL;
+            size_t len = 0;
+            if (FindFirstOutputMessage(result->desc, &message, &len)) {
+                UtoolUpdateLogAppendJsonNote(option->updateLog, stage, state, message, len);
             }
-            FREE_CJSON(output)
         }
     }
 }
@@ -2451,16 +3264,13 @@ WriteFailedLogEntry(UpdateFirmwareOption *option, const char *stage, const char
 static void WriteLogEntry(UpdateFirmwareOption *option, const char *stage, const char *state, const char *note)
 {
     if (option->disableLogEntry != true) {
-        /* get current timestamp */
-        char nowStr[100] = {0};
-        time_t now = time(NULL);
-        struct tm *tm_now = localtime(&now);
-        if (tm_now != NULL) {
-            strftime(nowStr, sizeof(nowStr), "%Y-%m-%dT%H%M%S%z", tm_now);
-        }
+        UtoolUpdateLogAppend(option->updateLog, stage, state, note);
+    }
+}
 
-        /* write log file head content*/
-        fprintf(option->logFileFP, LOG_ENTRY_FORMAT, nowStr, stage, state, note);
-        fflush(option->logFileFP);
+static void SyncLogEntries(UpdateFirmwareOption *option)
+{
+    if (option->disableLogEntry != true) {
+        UtoolUpdateLogSync(option->updateLog);
     }
 }
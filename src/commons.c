@@ -453,12 +453,18 @@ const char *UtoolGetStringError(UtoolCode code)
             return "Failed to open local download file.";
         case UTOOLE_SSH_PROTOCOL_DISABLED:
             return "Failed to transfer file to bmc, because SSH protocol is disabled.";
+        case UTOOLE_FAILED_TO_WRITE_FILE:
+            return "Failed to write local file, please make sure the disk is not full.";
         case UTOOLE_UNEXPECT_IPMITOOL_RESULT:
             return "ipmitool returns unexpect format result, failed to parse the result.";
         case UTOOLE_INSECURE_INPUT_CHARS:
             return "Your input contains insecure chars like ""|;&$><`\\!\\n""";
         case UTOOLE_CURL_SCP_UPLOAD_FILE:
             return "Failed to upload local file with curl command.";
+        case UTOOLE_ILLEGAL_REPLAY_FILE:
+            return "Failed to load replay file, please make sure it is recorded by utool.";
+        case UTOOLE_NOT_RECORDED:
+            return "Request is not recorded in replay file.";
         default:
             return "Unknown error";
     }
@@ -517,6 +523,22 @@ const bool UtoolIsParentPathExists(const char *path)
     }
 }
 
+/**
+ * thread safe localtime, converts timestamp to local time into caller's buffer.
+ *
+ * @param timestamp
+ * @param tm        local time output
+ * @return true if succeed
+ */
+bool UtoolLocalTime(time_t timestamp, struct tm *tm)
+{
+#if defined(__MINGW32__)
+    return localtime_s(tm, &timestamp) == 0;
+#else
+    return localtime_r(&timestamp, tm) != NULL;
+#endif
+}
+
 /**
  * get cJSON node in oem node with relative xpath
  *
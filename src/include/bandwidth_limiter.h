@@ -0,0 +1,92 @@
+/*
+* Copyright © xFusion Digital Technologies Co., Ltd. 2012-2018. All rights reserved.
+* Description: shared upload bandwidth limiter header
+* Author:
+* Create: 2019-06-16
+* Notes:
+*/
+#ifndef UTOOL_BANDWIDTH_LIMITER_H
+#define UTOOL_BANDWIDTH_LIMITER_H
+/* For c++ compatibility */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <pthread.h>
+#include <curl/curl.h>
+
+/**
+ * A token bucket shared by uploads of many threads, total throughput of all uploads is capped at its rate.
+ *
+ * Tokens are refilled continuously at rate bytes per second and capped at burst. An upload takes tokens for every
+ * chunk it sends, and sleeps when the bucket is in debt. Bandwidth released by finished uploads is taken by the
+ * remaining ones automatically.
+ */
+typedef struct _UtoolBandwidthLimiter {
+    pthread_mutex_t mutex;
+    double rate;                /** bytes per second */
+    double burst;               /** max tokens could be saved */
+    double tokens;              /** available tokens, negative if bucket is in debt */
+    double updated;             /** monotonic time of last refill in seconds */
+    size_t chunk;               /** max bytes taken at once, keeps uploads smooth */
+} UtoolBandwidthLimiter;
+
+/**
+ * A CURL read/seek callback wrapper which takes tokens from limiter for every chunk read.
+ */
+typedef struct _UtoolLimitedReader {
+    curl_read_callback read;
+    curl_seek_callback seek;
+    void *data;                             /** callback data of wrapped read & seek callback */
+    UtoolBandwidthLimiter *limiter;
+} UtoolLimitedReader;
+
+/**
+ * Initialize a limiter.
+ *
+ * @param limiter
+ * @param bytesPerSecond    rate of limiter, should be greater than 0
+ */
+void UtoolBandwidthLimiterInit(UtoolBandwidthLimiter *limiter, long bytesPerSecond);
+
+/**
+ * Destroy a limiter, no upload should be using it.
+ *
+ * @param limiter
+ */
+void UtoolBandwidthLimiterDestroy(UtoolBandwidthLimiter *limiter);
+
+/**
+ * Take tokens for bytes to be sent, block current thread until the bucket is out of debt.
+ *
+ * @param limiter
+ * @param bytes
+ */
+void UtoolBandwidthLimiterAcquire(UtoolBandwidthLimiter *limiter, size_t bytes);
+
+/**
+ * CURL read function, reads from wrapped read function in small chunks and takes tokens for them.
+ *
+ * @param buffer
+ * @param size
+ * @param nitems
+ * @param reader    UtoolLimitedReader
+ * @return
+ */
+size_t UtoolLimitedReadCallback(char *buffer, size_t size, size_t nitems, void *reader);
+
+/**
+ * CURL seek function, delegates to wrapped seek function.
+ *
+ * @param reader    UtoolLimitedReader
+ * @param offset
+ * @param origin
+ * @return
+ */
+int UtoolLimitedSeekCallback(void *reader, curl_off_t offset, int origin);
+
+#ifdef __cplusplus
+}
+#endif //UTOOL_BANDWIDTH_LIMITER_H
+#endif
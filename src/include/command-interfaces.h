@@ -72,6 +72,8 @@ int UtoolCmdGetEventLog(UtoolCommandOption *commandOption, char **outputStr);
 
 int UtoolCmdGetPCIe(UtoolCommandOption *commandOption, char **outputStr);
 
+int UtoolCmdGetInventory(UtoolCommandOption *commandOption, char **outputStr);
+
 int UtoolCmdGetTasks(UtoolCommandOption *commandOption, char **outputStr);
 
 int UtoolCmdGetTime(UtoolCommandOption *commandOption, char **outputStr);
@@ -142,6 +144,10 @@ int UtoolCmdGetIpmiWhitelist(UtoolCommandOption *commandOption, char **outputStr
 
 int UtoolCmdSetIpmiWhitelist(UtoolCommandOption *commandOption, char **outputStr);
 
+int UtoolCmdRolloutOutbandFirmware(UtoolCommandOption *commandOption, char **outputStr);
+
+int UtoolCmdExporter(UtoolCommandOption *commandOption, char **outputStr);
+
 /** Test purpose **/
 int UtoolCmdUploadFileToBMC(UtoolCommandOption *commandOption, char **outputStr);
 
@@ -98,6 +98,7 @@ static inline int UtoolFreeRedfishServer(UtoolRedfishServer *server)
         FREE_OBJ(server->systemId)
         FREE_OBJ(server->oemName)
         FREE_OBJ(server->psn)
+        FREE_CJSON(server->accounts)
     }
 }
 
@@ -114,6 +115,9 @@ static inline int UtoolFreeCurlResponse(UtoolCurlResponse *response)
         FREE_OBJ(response->content)
         FREE_OBJ(response->etag)
         FREE_OBJ(response->contentType)
+        FREE_OBJ(response->cacheControl)
+        response->size = 0;
+        response->length = 0;
     }
 }
 
@@ -297,6 +301,15 @@ const char *UtoolFileRealpath(const char *path, char *resolved, size_t pathLen);
  */
 const bool UtoolIsParentPathExists(const char *path);
 
+/**
+ * thread safe localtime, converts timestamp to local time into caller's buffer.
+ *
+ * @param timestamp
+ * @param tm        local time output
+ * @return true if succeed
+ */
+bool UtoolLocalTime(time_t timestamp, struct tm *tm);
+
 /**
  * get cJSON node in oem node with relative xpath
  *
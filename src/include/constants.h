@@ -19,6 +19,7 @@ extern "C" {
 #endif
 
 #define ENABLE_DEBUG 1
+#define LOG_DEBUG_SAMPLE_RATE 1     /* write one of every N debug log lines, 1 means all */
 #define UTOOL_VENDOR "XFUSION"
 #define LOG_FILE_NAME "utool.log.txt"
 #define BAK_LOG_FILE_NAME "utool.log.txt."
@@ -46,8 +47,23 @@ extern "C" {
 
 #define CURL_TIMEOUT 120
 #define CURL_UPLOAD_TIMEOUT 300
+#define CURL_UPLOAD_LOW_SPEED_LIMIT 1L
+#define CURL_UPLOAD_LOW_SPEED_TIME 60L
 #define CURL_CONN_TIMEOUT 60
 
+#define REDFISH_ASYNC_MAX_IN_FLIGHT 8
+#define REDFISH_CACHE_MAX_ENTRIES 256
+#define REDFISH_EXPAND_MEMBERS "$expand=.($levels=1)"
+
+#define REBOOT_PROBE_INTERVAL 3
+#define REBOOT_PROBE_CONN_TIMEOUT 5
+#define REBOOT_PROBE_TIMEOUT 10
+#define REBOOT_ALIVE_CONFIRM_TIMES 3
+#define FIRMWARE_READY_TIME_LIMIT 60
+
+#define UPLOAD_CHUNK_SIZE (1024 * 1024)
+#define UPLOAD_RESUME_RETRY_TIMES 3
+
 #define PROGRESS_NOT_START 0
 #define PROGRESS_FINISHED 1
 #define PROGRESS_PROCESSING 2
@@ -58,6 +74,8 @@ extern "C" {
 #define HEADER_CONTENT_LENGTH "CONTENT-LENGTH: "
 #define HEADER_CONTENT_TYPE "CONTENT-TYPE: "
 #define HEADER_IF_MATCH "If-Match"
+#define HEADER_CACHE_CONTROL "CACHE-CONTROL: "
+#define HEADER_IF_NONE_MATCH "If-None-Match"
 
 #define VAR_OEM "${Oem}"
 
@@ -200,6 +218,8 @@ typedef enum _Code
     UTOOLE_UNEXPECT_IPMITOOL_RESULT = 146,
     UTOOLE_INSECURE_INPUT_CHARS = 147,
     UTOOLE_CURL_SCP_UPLOAD_FILE = 148,
+    UTOOLE_ILLEGAL_REPLAY_FILE = 149,           /** replay archive could not be loaded */
+    UTOOLE_NOT_RECORDED = 150,                  /** request is not found in replay archive */
 } UtoolCode;
 
 #ifdef __cplusplus
@@ -14,15 +14,33 @@ extern "C" {
 #endif
 
 #include <string.h>
+#include <stdint.h>
 #include <typedefs.h>
 
 #define MAX_IPMI_CMD_LEN 2048
+#define MAX_IPMI_CMD_OUTPUT_LEN 5012
+/* every byte takes two hex digits and a separator in ipmitool output */
+#define MAX_IPMI_RESPONSE_LEN (MAX_IPMI_CMD_OUTPUT_LEN / 3)
 #define IPMI_GET_HTTPS_PORT_NETFUN "0x30"
 #define IPMI_GET_HTTPS_PORT_CMD "0x93"
 #define IPMI_GET_HTTPS_PORT_DATA "0xdb 0x07 0x00 0x38 0x06 0x00 0x03 0xff 0x00 0x00 0x1 0x00 0x02 0x00 0x03 0x00"
 #define IPMI_GET_HTTPS_PORT_DATA_XFUSION "0x14 0xe3 0x00 0x38 0x06 0x00 0x03 0xff 0x00 0x00 0x1 0x00 0x02 0x00 0x03 0x00"
 #define IPMI_GET_VENDOR_ID "0x06 0x01"
 
+/* IANA manufacturer id in IPMI responses, little endian */
+#define IPMI_MANUFACTURER_ID_LEN 3
+#define IPMI_MANUFACTURER_ID_HUAWEI ((const uint8_t *) "\xdb\x07\x00")
+#define IPMI_MANUFACTURER_ID_XFUSION ((const uint8_t *) "\x14\xe3\x00")
+
+/**
+ * response bytes of an IPMI raw command, decoded from ipmitool output
+ */
+typedef struct _IPMIResponse
+{
+    uint8_t bytes[MAX_IPMI_RESPONSE_LEN];
+    size_t length;
+} UtoolIPMIResponse;
+
 /**
 * execute a ipmi command
 *
@@ -53,6 +71,38 @@ int UtoolIPMIGetHttpsPort(UtoolCommandOption *option, UtoolResult *result);
 */
 bool UtoolIPMIGetVendorId(UtoolCommandOption *option, UtoolResult *result);
 
+/**
+* Decode ipmitool raw output like " db 07 00 1a\n 20" into response bytes in a single pass, nothing is allocated.
+*
+* @param output     output of UtoolIPMIExecRawCommand
+* @param response
+* @return UTOOLE_OK if succeed, UTOOLE_UNEXPECT_IPMITOOL_RESULT if output is not hex bytes
+*/
+int UtoolIPMIDecodeResponse(const char *output, UtoolIPMIResponse *response);
+
+/**
+* whether response bytes at offset equal to expected bytes
+*
+* @param response
+* @param offset
+* @param expected
+* @param length     length of expected bytes
+* @return
+*/
+bool UtoolIPMIResponseMatches(const UtoolIPMIResponse *response, size_t offset, const uint8_t *expected,
+                              size_t length);
+
+/**
+* Format bytes as lower case hex separated by space like "db 07 00", the way ipmitool prints them.
+*
+* @param bytes
+* @param length
+* @param buffer     formatted string, at least length * 3 + 1 chars
+* @param size       size of buffer
+* @return UTOOLE_OK if succeed, UTOOLE_INTERNAL if buffer is too small
+*/
+int UtoolIPMIFormatBytes(const uint8_t *bytes, size_t length, char *buffer, size_t size);
+
 #ifdef __cplusplus
 }
 #endif //UTOOL_IPMI_H
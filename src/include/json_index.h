@@ -0,0 +1,69 @@
+/*
+* Copyright © xFusion Digital Technologies Co., Ltd. 2012-2018. All rights reserved.
+* Description: string keyed hash index over cJSON object items header
+* Author:
+* Create: 2019-06-16
+* Notes:
+*/
+#ifndef UTOOL_JSON_INDEX_H
+#define UTOOL_JSON_INDEX_H
+/* For c++ compatibility */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include "cJSON.h"
+
+/**
+ * An index entry, key points into the indexed item.
+ */
+typedef struct _JsonIndexEntry
+{
+    const char *key;
+    cJSON *item;
+} UtoolJsonIndexEntry;
+
+/**
+ * Open addressing hash index of cJSON object items, so looking up many keys in a large object does not have to scan
+ * it linearly per key like cJSON_GetObjectItem does. Keys are case sensitive.
+ */
+typedef struct _JsonIndex
+{
+    UtoolJsonIndexEntry *entries;
+    size_t capacity;        /** slot count, power of 2 */
+    size_t count;           /** indexed item count */
+} UtoolJsonIndex;
+
+/**
+ * Build index for all items of a cJSON object, items are indexed by their key in object and the first item wins if
+ * keys duplicate.
+ *
+ * Container should not be changed while index is used. A NULL container builds an empty index.
+ *
+ * @param index
+ * @param container
+ * @return UTOOLE_OK if succeed
+ */
+int UtoolJsonIndexBuild(UtoolJsonIndex *index, const cJSON *container);
+
+/**
+ * Get indexed item by key.
+ *
+ * @param index
+ * @param key
+ * @return NULL if not found
+ */
+cJSON *UtoolJsonIndexGet(const UtoolJsonIndex *index, const char *key);
+
+/**
+ * Free index, indexed items are not freed.
+ *
+ * @param index
+ */
+void UtoolJsonIndexFree(UtoolJsonIndex *index);
+
+#ifdef __cplusplus
+}
+#endif //UTOOL_JSON_INDEX_H
+#endif
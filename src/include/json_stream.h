@@ -0,0 +1,31 @@
+/*
+* Copyright © xFusion Digital Technologies Co., Ltd. 2012-2018. All rights reserved.
+* Description: stream cJSON node into file header
+* Author:
+* Create: 2019-06-16
+* Notes:
+*/
+#ifndef UTOOL_JSON_STREAM_H
+#define UTOOL_JSON_STREAM_H
+/* For c++ compatibility */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdio.h>
+#include "cJSON.h"
+
+/**
+ * Serialize cJSON node into file in the same format as cJSON_Print does, without building the whole text in memory.
+ * Text is written in JSON_STREAM_CHUNK_SIZE chunks.
+ *
+ * @param item
+ * @param fp
+ * @return UTOOLE_OK if succeed, UTOOLE_FAILED_TO_WRITE_FILE if failed to write file or node is invalid
+ */
+int UtoolJsonPrintToFile(const cJSON *item, FILE *fp);
+
+#ifdef __cplusplus
+}
+#endif //UTOOL_JSON_STREAM_H
+#endif
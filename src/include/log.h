@@ -12,6 +12,26 @@
 extern "C" {
 #endif
 
+#include "zf_log.h"
+
+#define LOG_BODY_HEAD_LEN 384
+#define LOG_BODY_TAIL_LEN 128
+
+/**
+* log a http body, only head and tail of the body are kept if it is too long.
+* body expression is not evaluated when the level is filtered out, no matter at compile time or runtime.
+*
+* @param lvl    zf-log level
+* @param label
+* @param body
+*/
+#define UTOOL_LOG_BODY(lvl, label, body) \
+    do { \
+        if (ZF_LOG_ON(lvl)) { \
+            UtoolLogBody((lvl), (label), (body)); \
+        } \
+    } while (0)
+
 
 /**
 * setting log to file path
@@ -21,6 +41,23 @@ extern "C" {
 */
 int UtoolSetLogFilePath(const char *log_file_path);
 
+/**
+* sample log lines of a level, only one of every `rate` lines is written to log file.
+*
+* @param level  zf-log level, ZF_LOG_DEBUG etc.
+* @param rate   0 or 1 means all lines are written
+*/
+void UtoolSetLogSampleRate(int level, unsigned int rate);
+
+/**
+* write a http body log line, use UTOOL_LOG_BODY instead of calling it directly.
+*
+* @param level
+* @param label
+* @param body
+*/
+void UtoolLogBody(int level, const char *label, const char *body);
+
 #ifdef __cplusplus
 }
 #endif //UTOOL_LOG_H
@@ -0,0 +1,80 @@
+/*
+* Copyright © xFusion Digital Technologies Co., Ltd. 2012-2018. All rights reserved.
+* Description: read-only memory mapped local file header
+* Author:
+* Create: 2019-06-16
+* Notes:
+*/
+#ifndef UTOOL_MAPPED_FILE_H
+#define UTOOL_MAPPED_FILE_H
+/* For c++ compatibility */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <curl/curl.h>
+
+/**
+ * A read-only memory mapped local file.
+ *
+ * Mapped files are registered by their real path and reference counted, so uploading the same image many times
+ * (retries, or fleet updates to many BMCs) shares one mapping and reads the file through page cache once.
+ */
+typedef struct _UtoolMappedFile {
+    char *path;
+    const unsigned char *data;
+    size_t size;
+    int refCount;
+    struct _UtoolMappedFile *next;
+} UtoolMappedFile;
+
+/**
+ * A read cursor over a mapped file, used as CURL read/seek callback data.
+ */
+typedef struct _UtoolMappedFileReader {
+    const UtoolMappedFile *file;
+    size_t offset;
+} UtoolMappedFileReader;
+
+/**
+ * Map a local file into memory, or take another reference on the existing mapping of the same file.
+ *
+ * @param realPath  real path of the local file
+ * @return mapped file, NULL if the file could not be mapped (or mmap is not available on this platform), caller
+ *         should fallback to stdio in that case.
+ */
+UtoolMappedFile *UtoolMappedFileOpen(const char *realPath);
+
+/**
+ * Release a reference of the mapped file, the mapping is removed when the last reference is released.
+ *
+ * @param file
+ */
+void UtoolMappedFileRelease(UtoolMappedFile *file);
+
+/**
+ * CURL read function copying mapped file content into CURL's buffer directly.
+ *
+ * @param buffer
+ * @param size
+ * @param nitems
+ * @param reader    UtoolMappedFileReader
+ * @return
+ */
+size_t UtoolMappedFileReadCallback(char *buffer, size_t size, size_t nitems, void *reader);
+
+/**
+ * CURL seek function for mapped file.
+ *
+ * @param reader    UtoolMappedFileReader
+ * @param offset
+ * @param origin
+ * @return
+ */
+int UtoolMappedFileSeekCallback(void *reader, curl_off_t offset, int origin);
+
+#ifdef __cplusplus
+}
+#endif //UTOOL_MAPPED_FILE_H
+#endif
@@ -0,0 +1,23 @@
+/*
+* Copyright © xFusion Digital Technologies Co., Ltd. 2012-2018. All rights reserved.
+* Description: memory output mappings shared by `getmemory` and mapping micro benchmark
+* Author:
+* Create: 2019-06-16
+* Notes:
+*/
+#ifndef UTOOL_MEMORY_MAPPINGS_H
+#define UTOOL_MEMORY_MAPPINGS_H
+/* For c++ compatibility */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "typedefs.h"
+
+/** `getmemory`, member of /Systems/%s/Memory */
+extern const UtoolOutputMapping getMemoryMappings[];
+
+#ifdef __cplusplus
+}
+#endif //UTOOL_MEMORY_MAPPINGS_H
+#endif
@@ -78,6 +78,8 @@ void UtoolDownloadFileFromBMC(UtoolRedfishServer *server, const char *bmcFileUri
  *
  * Be caution that to enable this feature, the CURL lib must be configured with `--with-libssh2`
  *
+ * Interrupted transfer will be resumed from the last acknowledged offset after its chunk checksum is verified.
+ *
  * @param server            redfish server meta information
  * @param uploadFilePath    local file path to upload
  * @param targetFileName    target filename to upload as, if NULL, use local file name
@@ -97,6 +99,15 @@ void UtoolSftpUploadFileToBMC(UtoolRedfishServer *server, char *uploadFilePath,
 void UtoolCurlCmdUploadFileToBMC(UtoolRedfishServer *server, char *uploadFilePath, char *targetFileName,
                                  UtoolResult *result);
 
+/**
+* Resolve full URL of resource, redfish-system-id and oem name are replaced.
+*
+* @param server
+* @param resourceURL
+* @param fullURL   empty buffer of MAX_URL_LEN
+*/
+void UtoolResolveResourceURL(const UtoolRedfishServer *server, const char *resourceURL, char *fullURL);
+
 /**
  * Make a new redfish request through CURL lib
  *
@@ -212,7 +223,7 @@ void UtoolRedfishDelete(UtoolRedfishServer *server, char *url, cJSON *output, co
                         UtoolResult *result);
 
 /**
-* Get All Redfish member resources
+* Get All Redfish member resources, members already loaded by UtoolRedfishGetCollection are mapped directly.
 *
 * @param server
 * @param owner
@@ -223,6 +234,46 @@ void UtoolRedfishDelete(UtoolRedfishServer *server, char *url, cJSON *output, co
 void UtoolRedfishGetMemberResources(UtoolRedfishServer *server, cJSON *owner, cJSON *memberArray,
                                     const UtoolOutputMapping *memberMapping, UtoolResult *result);
 
+/**
+* Get a resource collection with all its members loaded, result->data carries the collection whose Members are
+* member resources rather than links.
+*
+* Members are expanded in one `$expand=.($levels=1)` request when server supports it, with `$select` limited to
+* the top level properties referenced by member mapping. Otherwise, or if expanding fails, members are loaded one
+* by one.
+*
+* @param server
+* @param url
+* @param memberMapping     members are only read through this mapping, NULL if all properties are required
+* @param result
+*/
+void UtoolRedfishGetCollection(UtoolRedfishServer *server, const char *url, const UtoolOutputMapping *memberMapping,
+                               UtoolResult *result);
+
+/**
+* Find account by user name.
+*
+* Accounts are looked up through the account index of server, which maps user name to account URL & ETag. The index
+* is built on first lookup, from one `$expand` request when server supports it, otherwise by getting all accounts
+* concurrently, then it is kept in server until server is freed.
+*
+* @param server
+* @param username
+* @param result    broken if failed to build account index
+* @return index entry {"@odata.id", "@odata.etag"} owned by server, NULL if no account has the user name. ETag is
+*         absent if expanded account does not carry it, PATCH without If-Match header loads it then.
+*/
+const cJSON *UtoolRedfishFindAccount(UtoolRedfishServer *server, const char *username, UtoolResult *result);
+
+/**
+* Drop account from account index of server, should be called after the account is changed or deleted since its
+* ETag is outdated.
+*
+* @param server
+* @param username
+*/
+void UtoolRedfishForgetAccount(UtoolRedfishServer *server, const char *username);
+
 /**
 * mapping a json format task to struct task
 *
@@ -233,6 +284,84 @@ void UtoolRedfishGetMemberResources(UtoolRedfishServer *server, cJSON *owner, cJ
 */
 UtoolRedfishTask *UtoolRedfishMapTaskFromJson(UtoolRedfishServer *server, cJSON *cJSONTask, UtoolResult *result);
 
+/**
+* Initialize an async request group.
+*
+* @param group
+* @param server
+* @param maxInFlight   max requests in flight at the same time, REDFISH_ASYNC_MAX_IN_FLIGHT if not positive
+*/
+void UtoolRedfishAsyncGroupInit(UtoolRedfishAsyncGroup *group, UtoolRedfishServer *server, int maxInFlight);
+
+/**
+* Submit a redfish request to async group, request will be sent when group runs.
+* Could be called in request callback to chain dependent requests.
+*
+* @param group
+* @param url
+* @param httpMethod
+* @param payload
+* @param headers
+* @param output
+* @param outputMapping
+* @param callback      optional, see UtoolRedfishAsyncRequest
+* @param context
+* @return submitted request, NULL if failed to submit and group will be broken.
+*/
+UtoolRedfishAsyncRequest *UtoolRedfishAsyncSubmit(UtoolRedfishAsyncGroup *group, const char *url,
+                                                  const char *httpMethod, const cJSON *payload,
+                                                  const UtoolCurlHeader *headers, cJSON *output,
+                                                  const UtoolOutputMapping *outputMapping,
+                                                  void (*callback)(UtoolRedfishAsyncGroup *group,
+                                                                   UtoolRedfishAsyncRequest *request,
+                                                                   UtoolResult *result),
+                                                  void *context);
+
+/**
+* Submit an async get redfish resource request.
+*
+* @param group
+* @param url
+* @param output
+* @param outputMapping
+* @param callback
+* @param context
+* @return
+*/
+UtoolRedfishAsyncRequest *UtoolRedfishAsyncGet(UtoolRedfishAsyncGroup *group, const char *url, cJSON *output,
+                                               const UtoolOutputMapping *outputMapping,
+                                               void (*callback)(UtoolRedfishAsyncGroup *group,
+                                                                UtoolRedfishAsyncRequest *request,
+                                                                UtoolResult *result),
+                                               void *context);
+
+/**
+* Run all requests of the group until all of them (including chained requests) finished or group is broken.
+*
+*   - result carries the first failure of the group, result->broken is marked if any request fails.
+*   - requests not sent yet are dropped when group is broken.
+*   - if group->multi is set, it is used and kept after run, so next run reuses the connections.
+*   - plain GET requests (no payload nor headers) go through resource cache like UtoolMakeCurlRequest does.
+*
+* @param group
+* @param result
+*/
+void UtoolRedfishAsyncGroupRun(UtoolRedfishAsyncGroup *group, UtoolResult *result);
+
+/**
+* Wait BMCs reboot, all probes are driven by current thread concurrently.
+*
+*   - BMC is treated as down if TCP connection is refused or redfish service is unavailable.
+*   - BMC is treated as alive after ActiveBMC firmware inventory is available for several consecutive probes.
+*
+* Probe starts from the state set by caller, normally REBOOT_PROBE_WAIT_SHUTDOWN, and finishes with
+* REBOOT_PROBE_ALIVE or a timeout state.
+*
+* @param probes
+* @param count
+*/
+void UtoolRedfishWaitBMCReboot(UtoolRebootProbe *probes, int count);
+
 /**
 * Wait a redfish task finished (completed or exception/failed)
 *
@@ -0,0 +1,93 @@
+/*
+* Copyright © xFusion Digital Technologies Co., Ltd. 2012-2018. All rights reserved.
+* Description: redfish resource cache header
+* Author:
+* Create: 2019-06-16
+* Notes:
+*/
+#ifndef UTOOL_RESOURCE_CACHE_H
+#define UTOOL_RESOURCE_CACHE_H
+/* For c++ compatibility */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include "typedefs.h"
+
+/**
+ * Enable or disable resource cache for following commands.
+ *
+ * Cache is process wide and keyed by resolved resource URL (which carries server host & port) and a hash of the
+ * credential, so the same resource is only fetched once by all commands run against a server with the same account
+ * while it is fresh. It should only be enabled for read only commands, disabling it drops all cached resources.
+ *
+ * @param enabled
+ */
+void UtoolResourceCacheEnable(bool enabled);
+
+/**
+ * Hold or release resource cache, calls could be nested.
+ *
+ * While cache is held, every stored resource is served without revalidation and is never evicted, even if it has no
+ * max-age or cache grows beyond REDFISH_CACHE_MAX_ENTRIES. It is used by commands which fetch a resource graph once
+ * and read it many times, e.g. `getinventory`. When released, held resources follow their own freshness again.
+ * `no-store` responses, tasks and task monitors are never held.
+ *
+ * @param hold
+ */
+void UtoolResourceCacheHold(bool hold);
+
+/**
+ * Get cached resource.
+ *
+ * @param server
+ * @param url       resolved resource URL
+ * @param response  filled with cached content if resource is fresh
+ * @param etag      ETag of stale resource which could be revalidated by `If-None-Match`, should be freed by caller
+ * @return whether response is served from cache
+ */
+bool UtoolResourceCacheGet(const UtoolRedfishServer *server, const char *url, UtoolCurlResponse *response,
+                           char **etag);
+
+/**
+ * Whether a fresh resource is cached.
+ *
+ * @param server
+ * @param url       resolved resource URL
+ * @return
+ */
+bool UtoolResourceCacheIsFresh(const UtoolRedfishServer *server, const char *url);
+
+/**
+ * Store a successful GET response, freshness follows its Cache-Control max-age. A response without max-age is only
+ * stored if it carries an ETag, and is revalidated before every reuse, unless cache is held. `no-store` responses,
+ * tasks and task monitors are never stored.
+ *
+ * @param server
+ * @param url
+ * @param response
+ */
+void UtoolResourceCacheStore(const UtoolRedfishServer *server, const char *url, const UtoolCurlResponse *response);
+
+/**
+ * Resource is not modified (304), refresh its freshness and fill response with cached content.
+ *
+ * @param server
+ * @param url
+ * @param response
+ * @return false if resource is not cached any more
+ */
+bool UtoolResourceCacheRevalidate(const UtoolRedfishServer *server, const char *url, UtoolCurlResponse *response);
+
+/**
+ * Drop all cached resources of a server, called when resources of server may be changed.
+ *
+ * @param baseUrl   base URL of server, e.g. https://host:port
+ */
+void UtoolResourceCacheInvalidate(const char *baseUrl);
+
+#ifdef __cplusplus
+}
+#endif //UTOOL_RESOURCE_CACHE_H
+#endif
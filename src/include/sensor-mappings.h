@@ -0,0 +1,44 @@
+/*
+* Copyright © xFusion Digital Technologies Co., Ltd. 2012-2018. All rights reserved.
+* Description: sensor output mappings shared by sensor commands and metrics exporter
+* Author:
+* Create: 2019-06-16
+* Notes:
+*/
+#ifndef UTOOL_SENSOR_MAPPINGS_H
+#define UTOOL_SENSOR_MAPPINGS_H
+/* For c++ compatibility */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "typedefs.h"
+
+/** `gettemp`, member of /Chassis/%s/Thermal Temperatures */
+extern const UtoolOutputMapping getTemperatureMappings[];
+
+/** `getfan`, /Chassis/%s/Thermal */
+extern const UtoolOutputMapping getFanSummaryMapping[];
+
+/** `getfan`, member of /Chassis/%s/Thermal Fans */
+extern const UtoolOutputMapping getFanMappings[];
+
+/** `getpsu`, /Chassis/%s */
+extern const UtoolOutputMapping getPowerSummaryMapping[];
+
+/** `getpsu`, member of /Chassis/%s/Power PowerSupplies */
+extern const UtoolOutputMapping getPowerSupplyMapping[];
+
+/** `getvolt`, member of /Chassis/%s/Power Voltages */
+extern const UtoolOutputMapping getVoltageMappings[];
+
+/** `getsensor`, member of /Chassis/%s/ThresholdSensors Sensors */
+extern const UtoolOutputMapping getThresholdSensorNestMappings[];
+
+/** `getsensor`, /Chassis/%s/ThresholdSensors */
+extern const UtoolOutputMapping getThresholdSensorMappings[];
+
+#ifdef __cplusplus
+}
+#endif //UTOOL_SENSOR_MAPPINGS_H
+#endif
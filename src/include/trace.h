@@ -0,0 +1,76 @@
+/*
+* Copyright © xFusion Digital Technologies Co., Ltd. 2012-2018. All rights reserved.
+* Description: HTTP trace file & request timings header
+* Author:
+* Create: 2019-06-16
+* Notes:
+*/
+#ifndef UTOOL_TRACE_H
+#define UTOOL_TRACE_H
+/* For c++ compatibility */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <curl/curl.h>
+#include "typedefs.h"
+
+/**
+ * Open trace file, all redfish requests & responses of current command are recorded into it in HAR format, so
+ * bodies do not have to be written into utool log file.
+ *
+ * @param path
+ * @return UTOOLE_OK if succeed
+ */
+int UtoolTraceOpen(const char *path);
+
+/**
+ * whether trace file is open
+ *
+ * @return
+ */
+bool UtoolTraceEnabled(void);
+
+/**
+ * Record a finished request as a HAR entry, password properties of request body are masked.
+ *
+ * @param curl          finished curl handle, url & timings are read from it
+ * @param httpMethod
+ * @param requestBody   could be NULL
+ * @param response      could be NULL if request failed before response
+ */
+void UtoolTraceRecord(CURL *curl, const char *httpMethod, const char *requestBody, const UtoolCurlResponse *response);
+
+/**
+ * Mask password properties of a request body recursively.
+ *
+ * @param node
+ */
+void UtoolTraceMaskPassword(cJSON *node);
+
+/**
+ * Finish HAR document and close trace file.
+ */
+void UtoolTraceClose(void);
+
+/**
+ * Start collecting timings of all requests recorded by UtoolTraceRecord for current command.
+ */
+void UtoolTimingsStart(void);
+
+/**
+ * Stop collecting timings and append the aggregated `Timings` object to command output JSON.
+ *
+ *  - DNS/Connect/TLS/Wait/Receive are sums of request phases, so they may exceed Elapsed for concurrent requests.
+ *  - BytesReceived counts response bodies as transferred, BytesDecoded counts them after gzip/deflate decoding.
+ *
+ * @param output    command output JSON string, replaced with the new output. Nothing changes if timings are not
+ *                  started or output is not a JSON object.
+ */
+void UtoolTimingsFinish(char **output);
+
+#ifdef __cplusplus
+}
+#endif //UTOOL_TRACE_H
+#endif
@@ -0,0 +1,128 @@
+/*
+* Copyright © xFusion Digital Technologies Co., Ltd. 2012-2018. All rights reserved.
+* Description: record & replay transport header
+* Author:
+* Create: 2019-06-16
+* Notes:
+*/
+#ifndef UTOOL_TRANSPORT_H
+#define UTOOL_TRANSPORT_H
+/* For c++ compatibility */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <curl/curl.h>
+#include "typedefs.h"
+
+#define TRANSPORT_METHOD_IPMI "IPMI"
+
+/**
+ * Open record file, every redfish request & IPMI command of current command is recorded into it with its response
+ * and elapsed time, so the same conversation could be replayed later without network.
+ *
+ * Requests are keyed by method and URL template (resource URL before system id & OEM name are resolved), IPMI
+ * commands by their raw command arguments. Credentials are never recorded, password properties of request body are
+ * masked.
+ *
+ * @param path
+ * @return UTOOLE_OK if succeed
+ */
+int UtoolTransportRecordOpen(const char *path);
+
+/**
+ * Load a recorded file and serve all redfish requests & IPMI commands from it instead of network.
+ *
+ * Entries of the same key are replayed in recorded order, the last one is replayed again once they are exhausted,
+ * so polling loops still end.
+ *
+ * @param path
+ * @param timed     whether requests take their recorded time, otherwise replayed as fast as possible
+ * @return UTOOLE_OK if succeed, UTOOLE_ILLEGAL_REPLAY_FILE if file could not be loaded
+ */
+int UtoolTransportReplayOpen(const char *path, bool timed);
+
+/**
+ * whether requests are served from replay file
+ *
+ * @return
+ */
+bool UtoolTransportReplaying(void);
+
+/**
+ * whether replayed requests should take their recorded time
+ *
+ * @return
+ */
+bool UtoolTransportTimed(void);
+
+/**
+ * Record a finished redfish request, nothing happens if record file is not open.
+ *
+ * @param curl          finished curl handle, elapsed time is read from it
+ * @param httpMethod
+ * @param resourceURL   URL template of the request
+ * @param headers       request headers, could be NULL
+ * @param requestBody   could be NULL
+ * @param code          CURL code of the request
+ * @param response
+ */
+void UtoolTransportRecord(CURL *curl, const char *httpMethod, const char *resourceURL,
+                          const struct curl_slist *headers, const char *requestBody, int code,
+                          const UtoolCurlResponse *response);
+
+/**
+ * Replay a redfish request, response is filled with the recorded one.
+ *
+ * @param httpMethod
+ * @param resourceURL   URL template of the request
+ * @param response
+ * @param elapsed       recorded elapsed seconds of the request
+ * @return recorded CURL code, UTOOLE_NOT_RECORDED if request is not found in replay file
+ */
+int UtoolTransportReplay(const char *httpMethod, const char *resourceURL, UtoolCurlResponse *response,
+                         double *elapsed);
+
+/**
+ * Record a finished IPMI command, nothing happens if record file is not open.
+ *
+ * @param command   raw command arguments, without connection & credential arguments
+ * @param exitCode  exit code of ipmitool
+ * @param output    output of ipmitool
+ * @param elapsed   elapsed seconds
+ */
+void UtoolTransportRecordCommand(const char *command, int exitCode, const char *output, double elapsed);
+
+/**
+ * Replay an IPMI command, it takes its recorded time if replay is timed.
+ *
+ * @param command   raw command arguments
+ * @param exitCode  recorded exit code of ipmitool
+ * @return a copy of recorded output, NULL if command is not found in replay file or failed to malloc
+ */
+char *UtoolTransportReplayCommand(const char *command, int *exitCode);
+
+/**
+ * Sleep for the recorded time of a replayed request if replay is timed.
+ *
+ * @param elapsed   seconds
+ */
+void UtoolTransportWait(double elapsed);
+
+/**
+ * monotonic clock in seconds, used to schedule replayed requests which take their recorded time concurrently
+ *
+ * @return
+ */
+double UtoolTransportClock(void);
+
+/**
+ * Finish and close record file, release replay file.
+ */
+void UtoolTransportClose(void);
+
+#ifdef __cplusplus
+}
+#endif //UTOOL_TRANSPORT_H
+#endif
@@ -15,8 +15,10 @@ extern "C" {
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <time.h>
 #include "cJSON.h"
 
 
@@ -63,6 +65,11 @@ typedef struct _CommandOption
     int commandArgc;
     UtoolCommandOptionFlag flag;  /** whether the command should be executed, default yes(0) otherwise no */
     int quiet;
+    char *traceFile;              /** record redfish requests & responses into this file in HAR format */
+    int timings;                  /** whether append request timings to output */
+    char *recordFile;             /** record redfish requests & IPMI commands into this file for replay */
+    char *replayFile;             /** serve redfish requests & IPMI commands from this recorded file */
+    int replayTimed;              /** whether replayed requests take their recorded time */
     const char **commandArgv;
 
 } UtoolCommandOption;
@@ -98,6 +105,10 @@ typedef struct _RedfishServer
     char *oemName;
     char *psn;
     int quiet;
+    void *uploadLimiter;    /** optional UtoolBandwidthLimiter shared by uploads, unlimited if NULL */
+    bool expandSupported;   /** service supports $expand=.($levels=1) */
+    bool selectSupported;   /** service supports $select */
+    cJSON *accounts;        /** account index, user name -> {"@odata.id", "@odata.etag"} */
 } UtoolRedfishServer;
 
 
@@ -108,10 +119,12 @@ typedef struct _CurlResponse
 {
     char *content;
     size_t size;         /** max content size malloced */
+    size_t length;       /** content size received, after content decoding */
     long int httpStatusCode;
     char *etag;
     long contentLength;
     char *contentType;
+    char *cacheControl;  /** Cache-Control header, NULL if absent */
     FILE *downloadToFP;  /** used for download file request */
 } UtoolCurlResponse;
 
@@ -176,6 +189,92 @@ typedef struct _RedfishTask
     UtoolRedfishMessage *message;
 } UtoolRedfishTask;
 
+struct _RedfishAsyncGroup;
+
+/**
+ * An asynchronous redfish request, processed by async group.
+ */
+typedef struct _RedfishAsyncRequest
+{
+    char *url;
+    const char *httpMethod;
+    cJSON *output;                                  /** response will be mapped into output if mapping present */
+    const UtoolOutputMapping *outputMapping;
+
+    /**
+     * called when request is finished, result->data carries the parsed response and will be freed after callback
+     * returns unless callback takes it away. If result is still broken after callback returns, the whole group will
+     * be broken. Requests can be chained by submitting new requests in callback.
+     */
+    void (*callback)(struct _RedfishAsyncGroup *group, struct _RedfishAsyncRequest *request, UtoolResult *result);
+    void *context;                                  /** caller context for callback */
+
+    /* internal properties */
+    void *curl;
+    void *headers;
+    char *payload;
+    bool cacheable;                                 /** plain GET request, served through resource cache */
+    bool replayed;                                  /** response is served from replay file */
+    int replayCode;                                 /** recorded CURL code of replayed request */
+    double replayDue;                               /** monotonic seconds when a timed replay finishes */
+    UtoolCurlResponse response;
+    struct _RedfishAsyncRequest *next;
+} UtoolRedfishAsyncRequest;
+
+/**
+ * A group of asynchronous redfish requests against one redfish server, requests are sent concurrently through
+ * one thread and the first failure breaks the whole group.
+ */
+typedef struct _RedfishAsyncGroup
+{
+    UtoolRedfishServer *server;
+    int maxInFlight;                                /** max requests in flight at the same time */
+    void *multi;                                    /** optional CURLM handle owned by caller, connections are kept
+                                                        alive in it between runs. A new one is used per run if NULL */
+
+    /* internal properties */
+    UtoolRedfishAsyncRequest *head;                 /** requests waiting to be sent */
+    UtoolRedfishAsyncRequest *tail;
+    UtoolRedfishAsyncRequest *replaying;            /** replayed requests waiting for their recorded time */
+    int inFlight;
+    bool broken;
+} UtoolRedfishAsyncGroup;
+
+/**
+ * BMC reboot probe states
+ */
+typedef enum _RebootProbeState
+{
+    REBOOT_PROBE_WAIT_SHUTDOWN = 0,     /** waiting BMC to go down */
+    REBOOT_PROBE_WAIT_ALIVE,            /** waiting BMC to come back */
+    REBOOT_PROBE_ALIVE,                 /** BMC is confirmed alive */
+    REBOOT_PROBE_SHUTDOWN_TIMEOUT,      /** BMC does not go down in time */
+    REBOOT_PROBE_ALIVE_TIMEOUT,         /** BMC does not come back in time */
+} UtoolRebootProbeState;
+
+/**
+ * Non-blocking reboot probe of one BMC, many probes can be driven by one thread at the same time.
+ */
+typedef struct _RebootProbe
+{
+    UtoolRedfishServer *server;
+    UtoolRebootProbeState state;
+    int shutdownTimeLimit;              /** max seconds to wait BMC go down */
+    int aliveTimeLimit;                 /** max seconds to wait BMC come back */
+
+    /** called after every finished probe, stateChanged indicates whether probe state has been changed */
+    void (*callback)(struct _RebootProbe *probe, bool stateChanged);
+    void *context;                      /** caller context for callback */
+
+    /* internal properties */
+    void *curl;
+    bool tcpProbe;                      /** whether next probe is TCP connect only probe */
+    int successes;                      /** consecutive alive successes */
+    time_t stateStartTime;
+    time_t nextProbeTime;
+    UtoolCurlResponse response;
+} UtoolRebootProbe;
+
 /* IPMI option */
 typedef struct _IPMIRawCmdOption {
     char *command;
@@ -188,9 +287,10 @@ typedef struct _IPMIRawCmdOption {
 /* IPMI option */
 typedef struct _IPMICommand {
     int length;
-    char *command;
-    char *data;
-    char *netfun;
+    int command;            /** -1 if absent */
+    uint8_t *data;          /** sub function bytes, NULL if absent */
+    size_t dataLength;
+    int netfun;             /** -1 if absent */
     int total;
 } UtoolIPMICommand;
 
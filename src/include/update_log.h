@@ -0,0 +1,92 @@
+/*
+* Copyright © xFusion Digital Technologies Co., Ltd. 2012-2018. All rights reserved.
+* Description: structured firmware update log header
+* Author:
+* Create: 2019-06-16
+* Notes:
+*/
+#ifndef UTOOL_UPDATE_LOG_H
+#define UTOOL_UPDATE_LOG_H
+/* For c++ compatibility */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+/**
+ * A JSON-lines firmware update log, one entry per line:
+ *
+ *      {"Time":"2019-09-22T152502+0800","Stage":"Upload firmware to BMC","State":"Start","Note":""}
+ *
+ * Entries are formatted into a memory buffer by producers and written by a background writer thread, file is only
+ * flushed and synced to disk at explicit durability points (stage boundaries) and when the log is closed.
+ */
+typedef struct _UtoolUpdateLog {
+    FILE *fp;
+    char *pending;                  /* entries formatted by producers, not handed to writer yet */
+    size_t pendingLen;
+    size_t pendingCap;
+    char *writing;                  /* buffer owned by writer thread, swapped with pending */
+    size_t writingCap;
+    unsigned long syncRequested;    /* durability points requested so far */
+    unsigned long syncDone;         /* durability points reached so far */
+    bool closing;
+    pthread_t writer;
+    pthread_mutex_t mutex;
+    pthread_cond_t wakeup;          /* signals writer there are entries, sync request or close */
+    pthread_cond_t synced;          /* signals producers durability point is reached */
+} UtoolUpdateLog;
+
+/**
+ * Open (append) update log file and start its writer thread.
+ *
+ * @param path
+ * @return update log, NULL if file could not be opened or writer thread could not be started.
+ */
+UtoolUpdateLog *UtoolUpdateLogOpen(const char *path);
+
+/**
+ * Append a log entry, entry is written asynchronously.
+ *
+ * @param log   could be NULL, entry is dropped then
+ * @param stage
+ * @param state
+ * @param note  plain text note, escaped when formatting
+ */
+void UtoolUpdateLogAppend(UtoolUpdateLog *log, const char *stage, const char *state, const char *note);
+
+/**
+ * Append a log entry whose note is already a JSON string body (escaped, without quotes), e.g. a slice of utool
+ * output JSON, so it could be copied as is.
+ *
+ * @param log   could be NULL, entry is dropped then
+ * @param stage
+ * @param state
+ * @param note
+ * @param noteLen
+ */
+void UtoolUpdateLogAppendJsonNote(UtoolUpdateLog *log, const char *stage, const char *state, const char *note,
+                                  size_t noteLen);
+
+/**
+ * Durability point, block until all entries appended before are written and synced to disk.
+ *
+ * @param log   could be NULL
+ */
+void UtoolUpdateLogSync(UtoolUpdateLog *log);
+
+/**
+ * Write and sync all pending entries, stop writer thread and close the log.
+ *
+ * @param log   could be NULL
+ */
+void UtoolUpdateLogClose(UtoolUpdateLog *log);
+
+#ifdef __cplusplus
+}
+#endif //UTOOL_UPDATE_LOG_H
+#endif
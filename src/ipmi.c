@@ -12,8 +12,8 @@
 #include <commons.h>
 #include <securec.h>
 #include <string_utils.h>
+#include <transport.h>
 
-#define MAX_IPMI_CMD_OUTPUT_LEN 5012
 #define IPMITOOL_CMD_RUN_FAILED "Failure: failed to execute IPMI command"
 #if defined(__MINGW32__)
 #define IPMITOOL_CMD "ipmitool -I lanplus -H %s -U %s -P %s -p %d %s 2>&1"
@@ -23,6 +23,16 @@
 
 #define ESCAPE_CHARS "|;&$><`\\!\n"
 
+/* response bytes 51 & 52 of get HTTPS port command carry the port, little endian */
+#define IPMI_HTTPS_PORT_OFFSET 51
+/* response bytes 6 ~ 8 of get device id command carry the manufacturer id */
+#define IPMI_MANUFACTURER_ID_OFFSET 6
+
+/* class of chars in ipmitool output, hex digits carry their value in low 4 bits, other chars are illegal */
+#define IPMI_HEX_DIGIT 0x10
+#define IPMI_HEX_SEPARATOR 0x20
+#define IPMI_HEX_VALUE_MASK 0x0F
+
 static bool changeVendorId = false;
 
 /**
@@ -105,27 +115,40 @@ UtoolIPMIExecRawCommand(UtoolCommandOption *option, UtoolIPMIRawCmdOption *ipmiR
         return NULL;
     }
 
-    cmdOutput = (char *) malloc(MAX_IPMI_CMD_OUTPUT_LEN);
-    if (cmdOutput == NULL) {
-        result->broken = 1;
-        result->code = UTOOLE_INTERNAL;
-        return NULL;
-    }
+    int ret = 0;
+    if (UtoolTransportReplaying()) {
+        cmdOutput = UtoolTransportReplayCommand(ipmiRawCmd, &ret);
+        if (cmdOutput == NULL) {
+            result->broken = 1;
+            result->code = ret == UTOOLE_NOT_RECORDED ? UTOOLE_NOT_RECORDED : UTOOLE_INTERNAL;
+            return NULL;
+        }
+    } else {
+        cmdOutput = (char *) malloc(MAX_IPMI_CMD_OUTPUT_LEN);
+        if (cmdOutput == NULL) {
+            result->broken = 1;
+            result->code = UTOOLE_INTERNAL;
+            return NULL;
+        }
 
-    if ((fp = popen(ipmiCmd, "r")) == NULL) {
-        ZF_LOGI("Failed to execute IPMI command, command is: %s", ipmiCmd);
-        result->broken = 1;
-        result->code = UtoolBuildStringOutputResult(STATE_FAILURE, IPMITOOL_CMD_RUN_FAILED, &(result->desc));
-        free(cmdOutput);
-        return NULL;
-    }
+        double started = UtoolTransportClock();
+        if ((fp = popen(ipmiCmd, "r")) == NULL) {
+            ZF_LOGI("Failed to execute IPMI command, command is: %s", ipmiCmd);
+            result->broken = 1;
+            result->code = UtoolBuildStringOutputResult(STATE_FAILURE, IPMITOOL_CMD_RUN_FAILED, &(result->desc));
+            free(cmdOutput);
+            return NULL;
+        }
+
+        *cmdOutput = '\0';
+        while (fgets(buffer, sizeof(buffer), fp) != NULL) {
+            UtoolWrapStringNAppend(cmdOutput, MAX_IPMI_CMD_OUTPUT_LEN, buffer, sizeof(buffer));
+        }
 
-    *cmdOutput = '\0';
-    while (fgets(buffer, sizeof(buffer), fp) != NULL) {
-        UtoolWrapStringNAppend(cmdOutput, MAX_IPMI_CMD_OUTPUT_LEN, buffer, sizeof(buffer));
+        ret = pclose(fp);
+        UtoolTransportRecordCommand(ipmiRawCmd, ret, cmdOutput, UtoolTransportClock() - started);
     }
 
-    int ret = pclose(fp);
     if (ret != 0) {
         ZF_LOGE("IPMI command's return code is not zero, output: %s", cmdOutput);
         result->broken = 1;
@@ -152,43 +175,93 @@ UtoolIPMIExecRawCommand(UtoolCommandOption *option, UtoolIPMIRawCmdOption *ipmiR
 }
 
 
-unsigned char hex2uchar(unsigned char hexChar)
+static const uint8_t g_UtoolIPMIHexChars[256] = {
+        [' '] = IPMI_HEX_SEPARATOR, ['\t'] = IPMI_HEX_SEPARATOR, ['\r'] = IPMI_HEX_SEPARATOR,
+        ['\n'] = IPMI_HEX_SEPARATOR,
+        ['0'] = IPMI_HEX_DIGIT | 0x0, ['1'] = IPMI_HEX_DIGIT | 0x1, ['2'] = IPMI_HEX_DIGIT | 0x2,
+        ['3'] = IPMI_HEX_DIGIT | 0x3, ['4'] = IPMI_HEX_DIGIT | 0x4, ['5'] = IPMI_HEX_DIGIT | 0x5,
+        ['6'] = IPMI_HEX_DIGIT | 0x6, ['7'] = IPMI_HEX_DIGIT | 0x7, ['8'] = IPMI_HEX_DIGIT | 0x8,
+        ['9'] = IPMI_HEX_DIGIT | 0x9,
+        ['a'] = IPMI_HEX_DIGIT | 0xA, ['b'] = IPMI_HEX_DIGIT | 0xB, ['c'] = IPMI_HEX_DIGIT | 0xC,
+        ['d'] = IPMI_HEX_DIGIT | 0xD, ['e'] = IPMI_HEX_DIGIT | 0xE, ['f'] = IPMI_HEX_DIGIT | 0xF,
+        ['A'] = IPMI_HEX_DIGIT | 0xA, ['B'] = IPMI_HEX_DIGIT | 0xB, ['C'] = IPMI_HEX_DIGIT | 0xC,
+        ['D'] = IPMI_HEX_DIGIT | 0xD, ['E'] = IPMI_HEX_DIGIT | 0xE, ['F'] = IPMI_HEX_DIGIT | 0xF,
+};
+
+static const char g_UtoolIPMIHexDigits[] = "0123456789abcdef";
+
+int UtoolIPMIDecodeResponse(const char *output, UtoolIPMIResponse *response)
 {
-    if (hexChar >= '0' && hexChar <= '9') {
-        return (unsigned char) (hexChar - '0');
-    }
+    int digits = 0;
+    uint8_t value = 0;
+    response->length = 0;
+
+    // a byte is one or two hex digits, it ends at a separator or end of output
+    for (const unsigned char *cursor = (const unsigned char *) output;; cursor++) {
+        uint8_t charClass = g_UtoolIPMIHexChars[*cursor];
+        if (charClass & IPMI_HEX_DIGIT) {
+            if (digits == 2) {
+                goto FAILURE;
+            }
+            value = (uint8_t) ((value << 4) | (charClass & IPMI_HEX_VALUE_MASK));
+            digits++;
+            continue;
+        }
 
-    if (hexChar >= 'a' && hexChar <= 'f') {
-        return (unsigned char) (hexChar - 'a' + 10);
-    }
+        if (charClass != IPMI_HEX_SEPARATOR && *cursor != '\0') {
+            goto FAILURE;
+        }
 
-    if (hexChar >= 'A' && hexChar <= 'F') {
-        return (unsigned char) (hexChar - 'A' + 10);
+        if (digits > 0) {
+            if (response->length == MAX_IPMI_RESPONSE_LEN) {
+                goto FAILURE;
+            }
+            response->bytes[response->length++] = value;
+            digits = 0;
+            value = 0;
+        }
+
+        if (*cursor == '\0') {
+            return UTOOLE_OK;
+        }
     }
 
-    ZF_LOGE("Convert hex char %c failed", hexChar);
-    return 0x00;
+FAILURE:
+    ZF_LOGE("Failed to decode ipmitool output: %s", output);
+    response->length = 0;
+    return UTOOLE_UNEXPECT_IPMITOOL_RESULT;
 }
 
-int hexstr2uchar(unsigned char *hexstr, int hexLen, unsigned char *binstr)
+bool UtoolIPMIResponseMatches(const UtoolIPMIResponse *response, size_t offset, const uint8_t *expected,
+                              size_t length)
 {
-    int binLen = 0;
-    binLen = hexLen / 2;
-    hexLen = binLen * 2;
+    return offset <= response->length && length <= response->length - offset &&
+           memcmp(response->bytes + offset, expected, length) == 0;
+}
 
-    for (int idx = 0; idx < hexLen; idx += 2) {
-        binstr[idx / 2] = ((hex2uchar(hexstr[idx]) << 4) & 0xF0) + hex2uchar(hexstr[idx + 1]);
+int UtoolIPMIFormatBytes(const uint8_t *bytes, size_t length, char *buffer, size_t size)
+{
+    if (size < length * 3 + 1) {
+        return UTOOLE_INTERNAL;
     }
 
-    return binLen;
+    char *cursor = buffer;
+    for (size_t idx = 0; idx < length; idx++) {
+        if (idx > 0) {
+            *cursor++ = ' ';
+        }
+        *cursor++ = g_UtoolIPMIHexDigits[bytes[idx] >> 4];
+        *cursor++ = g_UtoolIPMIHexDigits[bytes[idx] & 0x0F];
+    }
+    *cursor = '\0';
+    return UTOOLE_OK;
 }
 
 int UtoolIPMIGetHttpsPort(UtoolCommandOption *option, UtoolResult *result)
 {
     int port = 0;
     char *ipmiCmdOutput = NULL;
-    unsigned char hexPortString[5] = {0};
-    unsigned char ucharPortStr[1024] = {0};
+    UtoolIPMIResponse *response = &(UtoolIPMIResponse) {0};
 
     UtoolIPMIRawCmdOption *rawCmdOption = &(UtoolIPMIRawCmdOption) {
             .netfun = IPMI_GET_HTTPS_PORT_NETFUN,
@@ -198,14 +271,10 @@ int UtoolIPMIGetHttpsPort(UtoolCommandOption *option, UtoolResult *result)
 
     ipmiCmdOutput = UtoolIPMIExecRawCommand(option, rawCmdOption, result);
     if (!result->broken && ipmiCmdOutput != NULL) {
-        hexPortString[0] = (unsigned char) ipmiCmdOutput[157];
-        hexPortString[1] = (unsigned char) ipmiCmdOutput[158];
-        hexPortString[2] = (unsigned char) ipmiCmdOutput[160];
-        hexPortString[3] = (unsigned char) ipmiCmdOutput[161];
-        hexPortString[4] = '\0';
-
-        hexstr2uchar(hexPortString, 4, ucharPortStr);
-        port = ((ucharPortStr[1] << 8) & 0x0000FF00) + (ucharPortStr[0] & 0x000000FF);
+        if (UtoolIPMIDecodeResponse(ipmiCmdOutput, response) == UTOOLE_OK &&
+            response->length > IPMI_HTTPS_PORT_OFFSET + 1) {
+            port = response->bytes[IPMI_HTTPS_PORT_OFFSET] | (response->bytes[IPMI_HTTPS_PORT_OFFSET + 1] << 8);
+        }
     } else {
         /* ignore error */
         FREE_OBJ(result->desc)
@@ -224,12 +293,15 @@ bool UtoolIPMIGetVendorId(UtoolCommandOption *option, UtoolResult *result)
 {
     bool res = false;
     char *ipmiCmdOutput = NULL;
+    UtoolIPMIResponse *response = &(UtoolIPMIResponse) {0};
     UtoolIPMIRawCmdOption *rawCmdOption = &(UtoolIPMIRawCmdOption) {
             .command = IPMI_GET_VENDOR_ID,
     };
     ipmiCmdOutput = UtoolIPMIExecRawCommand(option, rawCmdOption, result);
     if (!result->broken && ipmiCmdOutput != NULL) {
-        if (strstr(ipmiCmdOutput, "14 e3 00")) {
+        if (UtoolIPMIDecodeResponse(ipmiCmdOutput, response) == UTOOLE_OK &&
+            UtoolIPMIResponseMatches(response, IPMI_MANUFACTURER_ID_OFFSET, IPMI_MANUFACTURER_ID_XFUSION,
+                                     IPMI_MANUFACTURER_ID_LEN)) {
             res = true;
             changeVendorId = true;
         }
@@ -0,0 +1,97 @@
+/*
+* Copyright © xFusion Digital Technologies Co., Ltd. 2012-2018. All rights reserved.
+* Description: string keyed hash index over cJSON object items
+* Author:
+* Create: 2019-06-16
+* Notes:
+*/
+#include <stdlib.h>
+#include <string.h>
+#include "json_index.h"
+#include "commons.h"
+#include "constants.h"
+#include "zf_log.h"
+
+#define JSON_INDEX_MIN_CAPACITY 8
+
+static size_t UtoolJsonIndexHash(const char *key)
+{
+    // djb2
+    size_t hash = 5381;
+    for (const char *ch = key; *ch != '\0'; ch++) {
+        hash = hash * 33 + (unsigned char) *ch;
+    }
+    return hash;
+}
+
+int UtoolJsonIndexBuild(UtoolJsonIndex *index, const cJSON *container)
+{
+    index->entries = NULL;
+    index->capacity = 0;
+    index->count = 0;
+
+    // keep load factor under 0.5, so probe sequences stay short
+    size_t itemCount = container == NULL ? 0 : (size_t) cJSON_GetArraySize(container);
+    size_t capacity = JSON_INDEX_MIN_CAPACITY;
+    while (capacity < itemCount * 2) {
+        capacity <<= 1u;
+    }
+
+    index->entries = (UtoolJsonIndexEntry *) calloc(capacity, sizeof(UtoolJsonIndexEntry));
+    if (index->entries == NULL) {
+        ZF_LOGE("Failed to malloc json index with %zu slots.", capacity);
+        return UTOOLE_INTERNAL;
+    }
+    index->capacity = capacity;
+
+    const cJSON *item = NULL;
+    cJSON_ArrayForEach(item, container) {
+        const char *key = item->string;
+        if (key == NULL) {
+            continue;
+        }
+
+        size_t slot = UtoolJsonIndexHash(key) & (capacity - 1);
+        bool duplicated = false;
+        while (index->entries[slot].key != NULL) {
+            if (strcmp(index->entries[slot].key, key) == 0) {
+                duplicated = true;
+                break;
+            }
+            slot = (slot + 1) & (capacity - 1);
+        }
+
+        if (!duplicated) {
+            index->entries[slot].key = key;
+            index->entries[slot].item = (cJSON *) item;
+            index->count++;
+        }
+    }
+
+    return UTOOLE_OK;
+}
+
+cJSON *UtoolJsonIndexGet(const UtoolJsonIndex *index, const char *key)
+{
+    if (index->entries == NULL || key == NULL) {
+        return NULL;
+    }
+
+    size_t slot = UtoolJsonIndexHash(key) & (index->capacity - 1);
+    while (index->entries[slot].key != NULL) {
+        if (strcmp(index->entries[slot].key, key) == 0) {
+            return index->entries[slot].item;
+        }
+        slot = (slot + 1) & (index->capacity - 1);
+    }
+    return NULL;
+}
+
+void UtoolJsonIndexFree(UtoolJsonIndex *index)
+{
+    if (index != NULL) {
+        FREE_OBJ(index->entries)
+        index->capacity = 0;
+        index->count = 0;
+    }
+}
@@ -0,0 +1,222 @@
+/*
+* Copyright © xFusion Digital Technologies Co., Ltd. 2012-2018. All rights reserved.
+* Description: stream cJSON node into file
+* Author:
+* Create: 2019-06-16
+* Notes:
+*/
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include <math.h>
+#include <float.h>
+#include "json_stream.h"
+#include "constants.h"
+#include "zf_log.h"
+
+#define JSON_STREAM_CHUNK_SIZE 4096
+
+/**
+ * a fixed size chunk buffer in front of file
+ */
+typedef struct _JsonStream {
+    FILE *fp;
+    size_t used;
+    bool failed;
+    char chunk[JSON_STREAM_CHUNK_SIZE];
+} UtoolJsonStream;
+
+static void UtoolJsonStreamFlush(UtoolJsonStream *stream)
+{
+    if (!stream->failed && stream->used > 0 && fwrite(stream->chunk, 1, stream->used, stream->fp) != stream->used) {
+        ZF_LOGE("Failed to write JSON chunk into file.");
+        stream->failed = true;
+    }
+    stream->used = 0;
+}
+
+static void UtoolJsonStreamWrite(UtoolJsonStream *stream, const char *data, size_t len)
+{
+    while (len > 0 && !stream->failed) {
+        size_t count = JSON_STREAM_CHUNK_SIZE - stream->used;
+        count = count < len ? count : len;
+        memcpy(stream->chunk + stream->used, data, count);
+        stream->used += count;
+        data += count;
+        len -= count;
+        if (stream->used == JSON_STREAM_CHUNK_SIZE) {
+            UtoolJsonStreamFlush(stream);
+        }
+    }
+}
+
+static void UtoolJsonStreamPutChar(UtoolJsonStream *stream, char ch)
+{
+    UtoolJsonStreamWrite(stream, &ch, 1);
+}
+
+static void UtoolJsonStreamIndent(UtoolJsonStream *stream, int depth)
+{
+    for (int idx = 0; idx < depth; idx++) {
+        UtoolJsonStreamPutChar(stream, '\t');
+    }
+}
+
+/**
+ * write JSON string, characters are escaped the same as cJSON does
+ *
+ * @param stream
+ * @param str
+ */
+static void UtoolJsonStreamString(UtoolJsonStream *stream, const char *str)
+{
+    UtoolJsonStreamPutChar(stream, '"');
+    if (str != NULL) {
+        // write unescaped runs at once
+        const unsigned char *start = (const unsigned char *) str;
+        const unsigned char *cursor = start;
+        for (; *cursor != '\0'; cursor++) {
+            if (*cursor >= 32 && *cursor != '"' && *cursor != '\\') {
+                continue;
+            }
+
+            UtoolJsonStreamWrite(stream, (const char *) start, (size_t) (cursor - start));
+            start = cursor + 1;
+            switch (*cursor) {
+                case '"':
+                    UtoolJsonStreamWrite(stream, "\\\"", 2);
+                    break;
+                case '\\':
+                    UtoolJsonStreamWrite(stream, "\\\\", 2);
+                    break;
+                case '\b':
+                    UtoolJsonStreamWrite(stream, "\\b", 2);
+                    break;
+                case '\f':
+                    UtoolJsonStreamWrite(stream, "\\f", 2);
+                    break;
+                case '\n':
+                    UtoolJsonStreamWrite(stream, "\\n", 2);
+                    break;
+                case '\r':
+                    UtoolJsonStreamWrite(stream, "\\r", 2);
+                    break;
+                case '\t':
+                    UtoolJsonStreamWrite(stream, "\\t", 2);
+                    break;
+                default: {
+                    char escaped[8] = {0};
+                    int len = snprintf(escaped, sizeof(escaped), "\\u%04x", *cursor);
+                    UtoolJsonStreamWrite(stream, escaped, (size_t) len);
+                    break;
+                }
+            }
+        }
+        UtoolJsonStreamWrite(stream, (const char *) start, (size_t) (cursor - start));
+    }
+    UtoolJsonStreamPutChar(stream, '"');
+}
+
+/**
+ * write JSON number, 15 significant digits are used if it could be recovered, otherwise 17 like cJSON does
+ *
+ * @param stream
+ * @param number
+ */
+static void UtoolJsonStreamNumber(UtoolJsonStream *stream, double number)
+{
+    char buffer[32] = {0};
+    int len;
+    if (isnan(number) || isinf(number)) {
+        len = snprintf(buffer, sizeof(buffer), "null");
+    } else {
+        double test = 0.0;
+        len = snprintf(buffer, sizeof(buffer), "%1.15g", number);
+        bool recovered = sscanf(buffer, "%lg", &test) == 1;
+        double maxVal = fabs(test) > fabs(number) ? fabs(test) : fabs(number);
+        if (!recovered || fabs(test - number) > maxVal * DBL_EPSILON) {
+            len = snprintf(buffer, sizeof(buffer), "%1.17g", number);
+        }
+    }
+
+    if (len < 0 || len >= (int) sizeof(buffer)) {
+        stream->failed = true;
+        return;
+    }
+    UtoolJsonStreamWrite(stream, buffer, (size_t) len);
+}
+
+static void UtoolJsonStreamValue(UtoolJsonStream *stream, const cJSON *item, int depth)
+{
+    const cJSON *child = NULL;
+    switch (item->type & 0xFF) {
+        case cJSON_NULL:
+            UtoolJsonStreamWrite(stream, "null", 4);
+            break;
+        case cJSON_False:
+            UtoolJsonStreamWrite(stream, "false", 5);
+            break;
+        case cJSON_True:
+            UtoolJsonStreamWrite(stream, "true", 4);
+            break;
+        case cJSON_Number:
+            UtoolJsonStreamNumber(stream, item->valuedouble);
+            break;
+        case cJSON_Raw:
+            if (item->valuestring == NULL) {
+                stream->failed = true;
+                break;
+            }
+            UtoolJsonStreamWrite(stream, item->valuestring, strlen(item->valuestring));
+            break;
+        case cJSON_String:
+            UtoolJsonStreamString(stream, item->valuestring);
+            break;
+        case cJSON_Array:
+            // array items are separated by ", " in one line, nested objects are indented one more level
+            UtoolJsonStreamPutChar(stream, '[');
+            cJSON_ArrayForEach(child, item) {
+                UtoolJsonStreamValue(stream, child, depth + 1);
+                if (child->next != NULL) {
+                    UtoolJsonStreamWrite(stream, ", ", 2);
+                }
+            }
+            UtoolJsonStreamPutChar(stream, ']');
+            break;
+        case cJSON_Object:
+            UtoolJsonStreamWrite(stream, "{\n", 2);
+            cJSON_ArrayForEach(child, item) {
+                UtoolJsonStreamIndent(stream, depth + 1);
+                UtoolJsonStreamString(stream, child->string);
+                UtoolJsonStreamWrite(stream, ":\t", 2);
+                UtoolJsonStreamValue(stream, child, depth + 1);
+                if (child->next != NULL) {
+                    UtoolJsonStreamPutChar(stream, ',');
+                }
+                UtoolJsonStreamPutChar(stream, '\n');
+            }
+            UtoolJsonStreamIndent(stream, depth);
+            UtoolJsonStreamPutChar(stream, '}');
+            break;
+        default:
+            stream->failed = true;
+            break;
+    }
+}
+
+int UtoolJsonPrintToFile(const cJSON *item, FILE *fp)
+{
+    UtoolJsonStream *stream = &(UtoolJsonStream) {0};
+    stream->fp = fp;
+    if (item == NULL || fp == NULL) {
+        return UTOOLE_FAILED_TO_WRITE_FILE;
+    }
+
+    UtoolJsonStreamValue(stream, item, 0);
+    UtoolJsonStreamFlush(stream);
+    if (!stream->failed && fflush(fp) != 0) {
+        ZF_LOGE("Failed to flush JSON into file.");
+        stream->failed = true;
+    }
+    return stream->failed ? UTOOLE_FAILED_TO_WRITE_FILE : UTOOLE_OK;
+}
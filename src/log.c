@@ -23,62 +23,257 @@
 #include <string.h>
 #include <securec.h>
 #include <dirent.h>
+#include <pthread.h>
+#include <sched.h>
 #include "string_utils.h"
 
 #define MAX_ROTATION_FILE_COUNT 10
 #define MAX_ROTATION_FILE_NAME_LEN 64
+#define ROTATION_NAMES_INITIAL_CAPACITY 16
+#define LOG_ROTATION_INDEX_FILE_NAME "utool.log.index"
 #define MAX_ROTATION_FILE_SIZE 50 * 1024 * 1024
 
+#ifndef ZF_LOG_BUF_SZ
+#define ZF_LOG_BUF_SZ 512
+#endif
+
+#define LOG_RING_SLOT_COUNT 1024        /* must be power of 2 */
+#define LOG_RING_IDLE_WAIT_MS 100
+#define LOG_LEVEL_COUNT (ZF_LOG_FATAL + 1)
+
+/**
+ * A log line slot of ring buffer,
+ * slot is free for producer at position `pos` when sequence == pos, and ready for flusher when sequence == pos + 1.
+ */
+typedef struct _UtoolLogSlot {
+    unsigned long sequence;
+    size_t len;
+    char line[ZF_LOG_BUF_SZ + 1];
+} UtoolLogSlot;
+
+/**
+ * Bounded lock-free MPSC ring buffer of log lines, producers are threads calling ZF_LOG*, the only consumer is the
+ * flusher thread writing lines to log file.
+ */
+typedef struct _UtoolLogRing {
+    UtoolLogSlot *slots;
+    unsigned long enqueuePos;       /* next position to claim, shared by producers */
+    unsigned long dequeuePos;       /* next position to flush, owned by flusher */
+    unsigned long dropped;          /* lines dropped because ring is full */
+    bool flusherIdle;
+    bool stopping;
+    pthread_t flusher;
+    pthread_mutex_t mutex;
+    pthread_cond_t wakeup;
+} UtoolLogRing;
 
 FILE *g_UtoolLogFileFP = NULL;
 
+static UtoolLogRing g_UtoolLogRing = {.mutex = PTHREAD_MUTEX_INITIALIZER, .wakeup = PTHREAD_COND_INITIALIZER};
+static bool g_UtoolLogAsync = false;
+
+/* keep one of every N lines per level, 0 or 1 means keep all */
+static unsigned int g_UtoolLogSampleRates[LOG_LEVEL_COUNT] = {0};
+static unsigned long g_UtoolLogSampleCounters[LOG_LEVEL_COUNT] = {0};
+
 bool RotationLogFile(const char *log_file_path);
 
+static bool UtoolLogSampled(int level)
+{
+    if (level < 0 || level >= LOG_LEVEL_COUNT || g_UtoolLogSampleRates[level] <= 1) {
+        return true;
+    }
+    unsigned long count = __atomic_fetch_add(&(g_UtoolLogSampleCounters[level]), 1, __ATOMIC_RELAXED);
+    return count % g_UtoolLogSampleRates[level] == 0;
+}
 
-bool RemoveOldestLogFiles();
+static void UtoolLogRingWakeup(UtoolLogRing *ring)
+{
+    // flusher waits with timeout, a missed signal only delays flushing a little
+    if (__atomic_load_n(&(ring->flusherIdle), __ATOMIC_ACQUIRE)) {
+        pthread_cond_signal(&(ring->wakeup));
+    }
+}
 
-static void LogToFileOutputCallback(const zf_log_message *msg, void *arg)
+/**
+ * push a log line into ring buffer.
+ *
+ * @param ring
+ * @param line
+ * @param len
+ * @param blocking  whether wait for free slot when ring is full
+ * @return false if ring is full and the line is not pushed
+ */
+static bool UtoolLogRingPush(UtoolLogRing *ring, const char *line, size_t len, bool blocking)
 {
-    (void) arg;
-    *msg->p = '\n';
-    size_t num = fwrite(msg->buf, msg->p - msg->buf + 1, 1, g_UtoolLogFileFP);
-    if (num != 1) {
-        perror("exception occurs when write log file.");
+    unsigned long pos = __atomic_load_n(&(ring->enqueuePos), __ATOMIC_RELAXED);
+    while (true) {
+        UtoolLogSlot *slot = ring->slots + (pos & (LOG_RING_SLOT_COUNT - 1));
+        unsigned long sequence = __atomic_load_n(&(slot->sequence), __ATOMIC_ACQUIRE);
+        long diff = (long) (sequence - pos);
+        if (diff == 0) {
+            // claim the slot, pos is reloaded if other producer claims it first
+            if (__atomic_compare_exchange_n(&(ring->enqueuePos), &pos, pos + 1, true, __ATOMIC_RELAXED,
+                                            __ATOMIC_RELAXED)) {
+                memcpy(slot->line, line, len);
+                slot->len = len;
+                __atomic_store_n(&(slot->sequence), pos + 1, __ATOMIC_RELEASE);
+                return true;
+            }
+        } else if (diff < 0) {
+            // ring is full
+            if (!blocking) {
+                return false;
+            }
+            UtoolLogRingWakeup(ring);
+            sched_yield();
+            pos = __atomic_load_n(&(ring->enqueuePos), __ATOMIC_RELAXED);
+        } else {
+            pos = __atomic_load_n(&(ring->enqueuePos), __ATOMIC_RELAXED);
+        }
     }
-    fflush(g_UtoolLogFileFP);
 }
 
-static void UpdateAllLogBakFilePerm()
+/**
+ * flusher thread, writes log lines in batch and flush once per batch.
+ *
+ * @param arg
+ * @return
+ */
+static void *UtoolLogFlusher(void *arg)
 {
-    int ret;
-    DIR *d = opendir("."); // open the path
-    if (d == NULL) {
-        perror("Failed to open current workspace dir.");
+    UtoolLogRing *ring = (UtoolLogRing *) arg;
+    unsigned long reportedDropped = 0;
+    while (true) {
+        bool written = false;
+        while (true) {
+            UtoolLogSlot *slot = ring->slots + (ring->dequeuePos & (LOG_RING_SLOT_COUNT - 1));
+            if (__atomic_load_n(&(slot->sequence), __ATOMIC_ACQUIRE) != ring->dequeuePos + 1) {
+                break;
+            }
+
+            if (fwrite(slot->line, slot->len, 1, g_UtoolLogFileFP) != 1) {
+                perror("exception occurs when write log file.");
+            }
+            __atomic_store_n(&(slot->sequence), ring->dequeuePos + LOG_RING_SLOT_COUNT, __ATOMIC_RELEASE);
+            ring->dequeuePos++;
+            written = true;
+        }
+
+        unsigned long dropped = __atomic_load_n(&(ring->dropped), __ATOMIC_RELAXED);
+        if (dropped != reportedDropped) {
+            fprintf(g_UtoolLogFileFP, "%lu debug log lines dropped, log ring buffer is full.\n",
+                    dropped - reportedDropped);
+            reportedDropped = dropped;
+            written = true;
+        }
+
+        if (written) {
+            fflush(g_UtoolLogFileFP);
+            continue;
+        }
+
+        if (__atomic_load_n(&(ring->stopping), __ATOMIC_ACQUIRE)) {
+            break;
+        }
+
+        // ring is empty, wait for new lines
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_nsec += LOG_RING_IDLE_WAIT_MS * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec += 1;
+            deadline.tv_nsec -= 1000000000L;
+        }
+
+        pthread_mutex_lock(&(ring->mutex));
+        __atomic_store_n(&(ring->flusherIdle), true, __ATOMIC_RELEASE);
+        UtoolLogSlot *next = ring->slots + (ring->dequeuePos & (LOG_RING_SLOT_COUNT - 1));
+        if (__atomic_load_n(&(next->sequence), __ATOMIC_ACQUIRE) != ring->dequeuePos + 1 &&
+            !__atomic_load_n(&(ring->stopping), __ATOMIC_ACQUIRE)) {
+            pthread_cond_timedwait(&(ring->wakeup), &(ring->mutex), &deadline);
+        }
+        __atomic_store_n(&(ring->flusherIdle), false, __ATOMIC_RELEASE);
+        pthread_mutex_unlock(&(ring->mutex));
+    }
+    return NULL;
+}
+
+/**
+ * start flusher thread, log lines are written synchronously if it could not be started.
+ */
+static void UtoolStartLogFlusher(void)
+{
+    UtoolLogRing *ring = &g_UtoolLogRing;
+    ring->slots = (UtoolLogSlot *) malloc(sizeof(UtoolLogSlot) * LOG_RING_SLOT_COUNT);
+    if (ring->slots == NULL) {
         return;
     }
 
-    struct dirent *dir;
-    while ((dir = readdir(d)) != NULL) {
-        if (dir->d_type != DT_DIR && UtoolStringStartsWith(dir->d_name, BAK_LOG_FILE_NAME)) {
-            ret = chmod(dir->d_name, 0440);
-            if (ret == -1) {
-                perror("Failed to update rotation log file mod to 0400.");
-                goto DONE;
-            }
+    for (unsigned long idx = 0; idx < LOG_RING_SLOT_COUNT; idx++) {
+        ring->slots[idx].sequence = idx;
+    }
+
+    if (pthread_create(&(ring->flusher), NULL, UtoolLogFlusher, ring) != 0) {
+        perror("Failed to start log flusher thread.");
+        free(ring->slots);
+        ring->slots = NULL;
+        return;
+    }
+    g_UtoolLogAsync = true;
+}
+
+/**
+ * write all lines left in ring buffer and stop flusher thread.
+ */
+static void UtoolStopLogFlusher(void)
+{
+    UtoolLogRing *ring = &g_UtoolLogRing;
+    if (!g_UtoolLogAsync) {
+        return;
+    }
+
+    pthread_mutex_lock(&(ring->mutex));
+    __atomic_store_n(&(ring->stopping), true, __ATOMIC_RELEASE);
+    pthread_cond_signal(&(ring->wakeup));
+    pthread_mutex_unlock(&(ring->mutex));
+    pthread_join(ring->flusher, NULL);
+
+    g_UtoolLogAsync = false;
+    free(ring->slots);
+    ring->slots = NULL;
+}
+
+static void LogToFileOutputCallback(const zf_log_message *msg, void *arg)
+{
+    (void) arg;
+    if (!UtoolLogSampled(msg->lvl)) {
+        return;
+    }
+
+    *msg->p = '\n';
+    size_t len = msg->p - msg->buf + 1;
+    if (g_UtoolLogAsync) {
+        // verbose & debug lines are dropped when ring is full, others wait for a free slot
+        if (UtoolLogRingPush(&g_UtoolLogRing, msg->buf, len, msg->lvl > ZF_LOG_DEBUG)) {
+            UtoolLogRingWakeup(&g_UtoolLogRing);
+        } else {
+            __atomic_fetch_add(&(g_UtoolLogRing.dropped), 1, __ATOMIC_RELAXED);
         }
+        return;
     }
 
-DONE:
-    ret = closedir(d);
-    if (ret == -1) {
-        perror("Failed to call closedir on utool root.");
+    size_t num = fwrite(msg->buf, len, 1, g_UtoolLogFileFP);
+    if (num != 1) {
+        perror("exception occurs when write log file.");
     }
+    fflush(g_UtoolLogFileFP);
 }
 
 static void CloseLogFileOutput(void)
 {
-    UpdateAllLogBakFilePerm();
     ZF_LOGI("Application exit, close log file now.");
+    UtoolStopLogFlusher();
     fclose(g_UtoolLogFileFP);
     g_UtoolLogFileFP = NULL;
 }
@@ -111,15 +306,16 @@ int UtoolSetLogFilePath(const char *const log_file_path)
             unsigned long long logFileSize = GetFileSize(fileno(g_UtoolLogFileFP));
             if (logFileSize >= MAX_ROTATION_FILE_SIZE) {
                 fclose(g_UtoolLogFileFP);
-                bool success = RotationLogFile(log_file_path);
-                if (!success) {
-                    return 0;
-                }
-
-                RemoveOldestLogFiles();
+                // keep appending to current log file if rotation fails
+                RotationLogFile(log_file_path);
                 g_UtoolLogFileFP = fopen(realFilepath, "a");
+                if (!g_UtoolLogFileFP) {
+                    ZF_LOGW("Failed to open log file %s", log_file_path);
+                    return 1;
+                }
             }
 
+            UtoolStartLogFlusher();
             atexit(CloseLogFileOutput);
             zf_log_set_output_v(ZF_LOG_PUT_STD, 0, LogToFileOutputCallback);
             ZF_LOGI("Log to file %s initialize succeed.", log_file_path);
@@ -134,61 +330,197 @@ int UtoolSetLogFilePath(const char *const log_file_path)
 }
 
 
-bool RemoveOldestLogFiles()
+typedef char UtoolRotationFileName[MAX_ROTATION_FILE_NAME_LEN];
+
+/**
+ * append a rotated log file name, names array grows as required.
+ *
+ * @param names
+ * @param count
+ * @param capacity
+ * @param name
+ * @return false if memory could not be allocated or name is too long
+ */
+static bool AppendRotationFileName(UtoolRotationFileName **names, int *count, int *capacity, const char *name)
+{
+    if (*count == *capacity) {
+        int newCapacity = *capacity == 0 ? ROTATION_NAMES_INITIAL_CAPACITY : *capacity * 2;
+        UtoolRotationFileName *grown = (UtoolRotationFileName *) realloc(*names,
+                                                                          newCapacity * sizeof(UtoolRotationFileName));
+        if (grown == NULL) {
+            perror("Failed to load rotation log files, reason: realloc failed.");
+            return false;
+        }
+        *names = grown;
+        *capacity = newCapacity;
+    }
+
+    errno_t ok = strncpy_s((*names)[*count], MAX_ROTATION_FILE_NAME_LEN, name,
+                           strnlen(name, MAX_ROTATION_FILE_NAME_LEN - 1));
+    if (ok != EOK) {
+        return false;
+    }
+    (*count)++;
+    return true;
+}
+
+/**
+ * load rotated log file names from rotation index, oldest first.
+ *
+ * rotated files of old versions are not indexed, current dir is scanned once to seed the index when index file does
+ * not exist. All rotated files found are loaded, so that every file beyond max count is pruned.
+ *
+ * @param names     names array, should be freed by caller
+ * @param capacity  capacity of names array
+ * @return count of rotated log files
+ */
+static int LoadRotationIndex(UtoolRotationFileName **names, int *capacity)
 {
-    errno_t ok;
-    DIR *d = opendir("."); // open the path
+    int count = 0;
+    char line[MAX_ROTATION_FILE_NAME_LEN];
+    FILE *index = fopen(LOG_ROTATION_INDEX_FILE_NAME, "r");
+    if (index != NULL) {
+        while (fgets(line, MAX_ROTATION_FILE_NAME_LEN, index) != NULL) {
+            line[strcspn(line, "\r\n")] = '\0';
+            if (line[0] != '\0' && !AppendRotationFileName(names, &count, capacity, line)) {
+                break;
+            }
+        }
+        fclose(index);
+        return count;
+    }
+
+    DIR *d = opendir(".");
     if (d == NULL) {
         perror("Failed to open current workspace dir.");
-        return false;
+        return 0;
     }
 
-    char rotationFileNames[64][MAX_ROTATION_FILE_NAME_LEN];
-    int rotationFileCount = 0;
     struct dirent *dir;
     while ((dir = readdir(d)) != NULL) {
-        if (dir->d_type != DT_DIR && UtoolStringStartsWith(dir->d_name, LOG_FILE_NAME)) {
-            size_t rotationFileNameLen = strnlen(dir->d_name, MAX_ROTATION_FILE_NAME_LEN - 1);
-            ok = strncpy_s(rotationFileNames[rotationFileCount++], MAX_ROTATION_FILE_NAME_LEN, dir->d_name, rotationFileNameLen);
-            if (ok != EOK) {
-                perror("Failed to remove rotation log files, reason: strncpy_s failed.");
-                closedir(d);
-                return false;
+        if (dir->d_type != DT_DIR && UtoolStringStartsWith(dir->d_name, BAK_LOG_FILE_NAME) &&
+            strnlen(dir->d_name, MAX_ROTATION_FILE_NAME_LEN) < MAX_ROTATION_FILE_NAME_LEN) {
+            if (!AppendRotationFileName(names, &count, capacity, dir->d_name)) {
+                break;
             }
         }
     }
     closedir(d);
 
-    if (rotationFileCount > MAX_ROTATION_FILE_COUNT) {
-        qsort(rotationFileNames, rotationFileCount, sizeof rotationFileNames[0], strcmp);
-        for (int idx = 0; idx < rotationFileCount - MAX_ROTATION_FILE_COUNT; idx++) {
-            // remove oldest rotation files
-            if (remove(rotationFileNames[idx]) != 0) {
-                perror("Failed to remove rotation log files");
-                return false;
-            }
-        }
+    // rotated file names end with timestamp, sort them by name
+    if (count > 0) {
+        qsort(*names, count, sizeof(UtoolRotationFileName), (int (*)(const void *, const void *)) strcmp);
+    }
+    return count;
+}
+
+/**
+ * rewrite rotation index atomically
+ *
+ * @param names
+ * @param count
+ * @return
+ */
+static bool SaveRotationIndex(UtoolRotationFileName *names, int count)
+{
+    FILE *index = fopen(LOG_ROTATION_INDEX_FILE_NAME ".tmp", "w");
+    if (index == NULL) {
+        perror("Failed to write rotation index file");
+        return false;
+    }
+
+    for (int idx = 0; idx < count; idx++) {
+        fprintf(index, "%s\n", names[idx]);
     }
 
+    if (fclose(index) != 0 || rename(LOG_ROTATION_INDEX_FILE_NAME ".tmp", LOG_ROTATION_INDEX_FILE_NAME) != 0) {
+        perror("Failed to write rotation index file");
+        return false;
+    }
     return true;
 }
 
+/**
+ * add new rotated log file into rotation index, and remove oldest rotated files beyond max count.
+ *
+ * @param rotationFileName
+ * @return
+ */
+static bool RecordRotatedLogFile(const char *rotationFileName)
+{
+    UtoolRotationFileName *names = NULL;
+    int capacity = 0;
+    int count = LoadRotationIndex(&names, &capacity);
+
+    // seeding scan has found the new rotated file already
+    if (count == 0 || strcmp(names[count - 1], rotationFileName) != 0) {
+        if (!AppendRotationFileName(&names, &count, &capacity, rotationFileName)) {
+            perror("Failed to record rotation log file.");
+            FREE_OBJ(names)
+            return false;
+        }
+    }
+
+    int removeCount = count > MAX_ROTATION_FILE_COUNT ? count - MAX_ROTATION_FILE_COUNT : 0;
+    for (int idx = 0; idx < removeCount; idx++) {
+        // oldest rotated file may have been removed manually
+        if (remove(names[idx]) != 0 && errno != ENOENT) {
+            perror("Failed to remove rotation log files");
+        }
+    }
+
+    bool saved = SaveRotationIndex(names + removeCount, count - removeCount);
+    FREE_OBJ(names)
+    return saved;
+}
+
 bool RotationLogFile(const char *log_file_path)
 {
     char rotationFileName[PATH_MAX];
     time_t now = time(NULL);
-    struct tm *tm_now = localtime(&now);
-    if (tm_now == NULL) {
+    struct tm tm_now;
+    if (!UtoolLocalTime(now, &tm_now)) {
         perror("Can not rotation log file");
         return false;
     }
     UtoolWrapSecFmt(rotationFileName, PATH_MAX, PATH_MAX - 1, "%s.%d%02d%02d%02d%02d%02d",
-                    log_file_path, tm_now->tm_year + 1900, tm_now->tm_mon + 1,
-                    tm_now->tm_mday, tm_now->tm_hour, tm_now->tm_min, tm_now->tm_sec);
+                    log_file_path, tm_now.tm_year + 1900, tm_now.tm_mon + 1,
+                    tm_now.tm_mday, tm_now.tm_hour, tm_now.tm_min, tm_now.tm_sec);
     int ret = rename(log_file_path, rotationFileName);
-    if (!ret) {
+    if (ret != 0) {
         perror("Failed to rename rotation log file");
         return false;
     }
-    return true;
+
+    // only the new rotated file needs to be read only
+    if (chmod(rotationFileName, 0440) != 0) {
+        perror("Failed to update rotation log file mod to 0440.");
+    }
+
+    return RecordRotatedLogFile(rotationFileName);
+}
+
+void UtoolSetLogSampleRate(int level, unsigned int rate)
+{
+    if (level >= 0 && level < LOG_LEVEL_COUNT) {
+        g_UtoolLogSampleRates[level] = rate;
+    }
+}
+
+void UtoolLogBody(int level, const char *label, const char *body)
+{
+    if (body == NULL) {
+        ZF_LOG_WRITE(level, _ZF_LOG_TAG, "%s: <empty>", label);
+        return;
+    }
+
+    size_t len = strlen(body);
+    if (len <= LOG_BODY_HEAD_LEN + LOG_BODY_TAIL_LEN) {
+        ZF_LOG_WRITE(level, _ZF_LOG_TAG, "%s (%zu bytes): %s", label, len, body);
+        return;
+    }
+
+    ZF_LOG_WRITE(level, _ZF_LOG_TAG, "%s (%zu bytes): %.*s ...(%zu bytes omitted)... %s", label, len,
+                 LOG_BODY_HEAD_LEN, body, len - LOG_BODY_HEAD_LEN - LOG_BODY_TAIL_LEN,
+                 body + len - LOG_BODY_TAIL_LEN);
 }
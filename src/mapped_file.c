@@ -0,0 +1,185 @@
+/*
+* Copyright © xFusion Digital Technologies Co., Ltd. 2012-2018. All rights reserved.
+* Description: read-only memory mapped local file
+* Author:
+* Create: 2019-06-16
+* Notes:
+*/
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#if !defined(__MINGW32__)
+#include <sys/mman.h>
+#endif
+#include "mapped_file.h"
+#include "zf_log.h"
+
+#if defined(__MINGW32__)
+
+UtoolMappedFile *UtoolMappedFileOpen(const char *realPath)
+{
+    (void) realPath;
+    return NULL;
+}
+
+void UtoolMappedFileRelease(UtoolMappedFile *file)
+{
+    (void) file;
+}
+
+#else
+
+/* all mapped files of current process, protected by mutex */
+static UtoolMappedFile *g_UtoolMappedFiles = NULL;
+static pthread_mutex_t g_UtoolMappedFilesMutex = PTHREAD_MUTEX_INITIALIZER;
+
+static UtoolMappedFile *UtoolMapFile(const char *realPath)
+{
+    struct stat fileInfo;
+    void *data = NULL;
+
+    int fd = open(realPath, O_RDONLY);
+    if (fd < 0) {
+        ZF_LOGW("Failed to open file %s for mapping.", realPath);
+        return NULL;
+    }
+
+    if (fstat(fd, &fileInfo) != 0 || !S_ISREG(fileInfo.st_mode)) {
+        ZF_LOGW("Failed to stat file %s for mapping.", realPath);
+        close(fd);
+        return NULL;
+    }
+
+    if (fileInfo.st_size > 0) {
+        data = mmap(NULL, (size_t) fileInfo.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            ZF_LOGW("Failed to mmap file %s.", realPath);
+            close(fd);
+            return NULL;
+        }
+        /* uploading always reads the image from head to tail */
+        madvise(data, (size_t) fileInfo.st_size, MADV_SEQUENTIAL);
+    }
+
+    /* mapping remains valid after the descriptor is closed */
+    close(fd);
+
+    UtoolMappedFile *file = (UtoolMappedFile *) calloc(1, sizeof(UtoolMappedFile));
+    if (file != NULL) {
+        file->path = strdup(realPath);
+    }
+
+    if (file == NULL || file->path == NULL) {
+        if (data != NULL) {
+            munmap(data, (size_t) fileInfo.st_size);
+        }
+        free(file);
+        return NULL;
+    }
+
+    file->data = (const unsigned char *) data;
+    file->size = (size_t) fileInfo.st_size;
+    ZF_LOGI("File %s is mapped into memory, size %zu.", realPath, file->size);
+    return file;
+}
+
+UtoolMappedFile *UtoolMappedFileOpen(const char *realPath)
+{
+    if (realPath == NULL) {
+        return NULL;
+    }
+
+    pthread_mutex_lock(&g_UtoolMappedFilesMutex);
+
+    UtoolMappedFile *file = g_UtoolMappedFiles;
+    while (file != NULL && strcmp(file->path, realPath) != 0) {
+        file = file->next;
+    }
+
+    if (file == NULL) {
+        file = UtoolMapFile(realPath);
+        if (file != NULL) {
+            file->next = g_UtoolMappedFiles;
+            g_UtoolMappedFiles = file;
+        }
+    }
+
+    if (file != NULL) {
+        file->refCount++;
+    }
+
+    pthread_mutex_unlock(&g_UtoolMappedFilesMutex);
+    return file;
+}
+
+void UtoolMappedFileRelease(UtoolMappedFile *file)
+{
+    if (file == NULL) {
+        return;
+    }
+
+    pthread_mutex_lock(&g_UtoolMappedFilesMutex);
+
+    if (--file->refCount == 0) {
+        UtoolMappedFile **prev = &g_UtoolMappedFiles;
+        while (*prev != NULL && *prev != file) {
+            prev = &((*prev)->next);
+        }
+        if (*prev != NULL) {
+            *prev = file->next;
+        }
+
+        if (file->data != NULL) {
+            munmap((void *) file->data, file->size);
+        }
+        ZF_LOGI("File %s is unmapped.", file->path);
+        free(file->path);
+        free(file);
+    }
+
+    pthread_mutex_unlock(&g_UtoolMappedFilesMutex);
+}
+
+#endif
+
+size_t UtoolMappedFileReadCallback(char *buffer, size_t size, size_t nitems, void *reader)
+{
+    UtoolMappedFileReader *cursor = (UtoolMappedFileReader *) reader;
+    const UtoolMappedFile *file = cursor->file;
+    if (cursor->offset >= file->size) {
+        return 0;
+    }
+
+    size_t len = size * nitems;
+    size_t left = file->size - cursor->offset;
+    if (len > left) {
+        len = left;
+    }
+
+    memcpy(buffer, file->data + cursor->offset, len);
+    cursor->offset += len;
+    return len;
+}
+
+int UtoolMappedFileSeekCallback(void *reader, curl_off_t offset, int origin)
+{
+    UtoolMappedFileReader *cursor = (UtoolMappedFileReader *) reader;
+    curl_off_t base = 0;
+    if (origin == SEEK_CUR) {
+        base = (curl_off_t) cursor->offset;
+    } else if (origin == SEEK_END) {
+        base = (curl_off_t) cursor->file->size;
+    }
+
+    curl_off_t position = base + offset;
+    if (position < 0 || position > (curl_off_t) cursor->file->size) {
+        return CURL_SEEKFUNC_FAIL;
+    }
+
+    cursor->offset = (size_t) position;
+    return CURL_SEEKFUNC_OK;
+}
@@ -8,6 +8,7 @@
 #include <typedefs.h>
 #include <constants.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <string.h>
 #include <sys/stat.h>
 #include <fcntl.h>
@@ -21,6 +22,12 @@
 #include "redfish.h"
 #include "zf_log.h"
 #include "string_utils.h"
+#include "mapped_file.h"
+#include "bandwidth_limiter.h"
+#include "log.h"
+#include "trace.h"
+#include "transport.h"
+#include "resource_cache.h"
 
 /**
  * Common CURL write data function.
@@ -49,6 +56,10 @@ static int UtoolCurlGetHeaderCallback(const char *buffer, size_t size, size_t ni
 static int
 UtoolCurlPrintUploadProgressCallback(void *output, double dltotal, double dlnow, double ultotal, double ulnow);
 
+static size_t CURLReadLocalFileToStream(void *ptr, size_t size, size_t nmemb, void *stream);
+
+static int CURLSeekLocalFileStream(void *stream, curl_off_t offset, int origin);
+
 /**
 * Setup a new Curl Request with common basic config for redfish API.
 *
@@ -62,6 +73,23 @@ static CURL *UtoolSetupCurlRequest(const UtoolRedfishServer *server,
                                    const char *httpMethod,
                                    UtoolCurlResponse *response);
 
+/**
+* Whether a failed file transfer is worth resuming.
+*
+* @param code
+* @return
+*/
+static bool UtoolIsResumableCurlError(CURLcode code);
+
+/**
+* Setup timeout of file upload. A bandwidth limited upload may legally take longer than any fixed total timeout, so
+* it is only aborted when it stalls.
+*
+* @param curl
+* @param server
+*/
+static void UtoolSetupUploadTimeout(CURL *curl, const UtoolRedfishServer *server);
+
 /**
 * Upload file to BMC temp storage. Will try upload through http, then sftp if failed.
 *
@@ -77,7 +105,17 @@ void UtoolUploadFileToBMC(UtoolRedfishServer *server, const char *uploadFilePath
         ZF_LOGI("HTTP upload file is not supported by this iBMC, will try scp now.");
         result->broken = 0;
         result->code = UTOOLE_OK;
-        UtoolSftpUploadFileToBMC(server, uploadFilePath, NULL, result);
+        UtoolSftpUploadFileToBMC(server, (char *) uploadFilePath, NULL, result);
+    } else if (result->broken && UtoolIsResumableCurlError((CURLcode) result->code)) {
+        /* iBMC multipart upload API could not be resumed, try resumable sftp upload if ssh is enabled */
+        int httpErrorCode = result->code;
+        ZF_LOGI("HTTP upload file is interrupted, will try resumable sftp upload now.");
+        result->broken = 0;
+        result->code = UTOOLE_OK;
+        UtoolSftpUploadFileToBMC(server, (char *) uploadFilePath, NULL, result);
+        if (result->code == UTOOLE_SSH_PROTOCOL_DISABLED) {
+            result->code = httpErrorCode;
+        }
     }
 }
 
@@ -96,6 +134,9 @@ void UtoolHttpUploadFileToBMC(UtoolRedfishServer *server, const char *uploadFile
 
     int progress = PROGRESS_NOT_START; // 0 => not start; 1 => finished; 2 => progressing;
     FILE *uploadFileFp = NULL;
+    UtoolMappedFile *mappedFile = NULL;
+    UtoolMappedFileReader reader = {0};
+    UtoolLimitedReader limitedReader = {0};
     UtoolCurlResponse *response = &(UtoolCurlResponse) {0};
 
     CURL *curl = NULL;
@@ -110,17 +151,21 @@ void UtoolHttpUploadFileToBMC(UtoolRedfishServer *server, const char *uploadFile
         goto FAILURE;
     }
 
-    uploadFileFp = fopen(path, "rb"); /* open file to upload */
-    if (!uploadFileFp) {
-        result->code = UTOOLE_ILLEGAL_LOCAL_FILE_PATH;
-        goto FAILURE;
-    } /* can't continue */
+    /* read file through memory mapping if possible, fallback to let curl mime read the file itself */
+    mappedFile = UtoolMappedFileOpen(path);
+    if (mappedFile == NULL) {
+        uploadFileFp = fopen(path, "rb"); /* open file to upload */
+        if (!uploadFileFp) {
+            result->code = UTOOLE_ILLEGAL_LOCAL_FILE_PATH;
+            goto FAILURE;
+        } /* can't continue */
 
-    ///* get the file size */
-    if (fstat(fileno(uploadFileFp), &fileInfo) != 0) {
-        result->code = UTOOLE_ILLEGAL_LOCAL_FILE_SIZE;
-        goto FAILURE;
-    } /* can't continue */
+        ///* get the file size */
+        if (fstat(fileno(uploadFileFp), &fileInfo) != 0) {
+            result->code = UTOOLE_ILLEGAL_LOCAL_FILE_SIZE;
+            goto FAILURE;
+        } /* can't continue */
+    }
 
     curl_mimepart *field = NULL;
     curl = UtoolSetupCurlRequest(server, "/UpdateService/FirmwareInventory", HTTP_POST, response);
@@ -130,7 +175,7 @@ void UtoolHttpUploadFileToBMC(UtoolRedfishServer *server, const char *uploadFile
     }
 
     /** reset CURL timeout for uploading file */
-    curl_easy_setopt(curl, CURLOPT_TIMEOUT, CURL_UPLOAD_TIMEOUT);
+    UtoolSetupUploadTimeout(curl, server);
 
     // setup content type
     /**
@@ -144,7 +189,34 @@ void UtoolHttpUploadFileToBMC(UtoolRedfishServer *server, const char *uploadFile
     /* Fill in the file upload field */
     field = curl_mime_addpart(form);
     curl_mime_name(field, "imgfile");
-    curl_mime_filedata(field, uploadFilePath);
+    if (mappedFile != NULL || server->uploadLimiter != NULL) {
+        curl_off_t fileSize = mappedFile != NULL ? (curl_off_t) mappedFile->size : (curl_off_t) fileInfo.st_size;
+        curl_read_callback readCallback = (curl_read_callback) CURLReadLocalFileToStream;
+        curl_seek_callback seekCallback = CURLSeekLocalFileStream;
+        void *readData = uploadFileFp;
+        if (mappedFile != NULL) {
+            reader.file = mappedFile;
+            readCallback = UtoolMappedFileReadCallback;
+            seekCallback = UtoolMappedFileSeekCallback;
+            readData = &reader;
+        }
+
+        // limit upload bandwidth if required, the limiter may be shared with other uploads
+        if (server->uploadLimiter != NULL) {
+            limitedReader = (UtoolLimitedReader) {readCallback, seekCallback, readData, server->uploadLimiter};
+            readCallback = UtoolLimitedReadCallback;
+            seekCallback = UtoolLimitedSeekCallback;
+            readData = &limitedReader;
+        }
+
+        curl_mime_data_cb(field, fileSize, readCallback, seekCallback, NULL, readData);
+        /* keep the same part filename as curl_mime_filedata, which is the base name of the given path */
+        char filename[PATH_MAX] = {0};
+        UtoolWrapSecFmt(filename, PATH_MAX, PATH_MAX - 1, "%s", uploadFilePath);
+        curl_mime_filename(field, basename(filename));
+    } else {
+        curl_mime_filedata(field, uploadFilePath);
+    }
 
     // setup mime post form
     curl_easy_setopt(curl, CURLOPT_MIMEPOST, form);
@@ -164,6 +236,7 @@ void UtoolHttpUploadFileToBMC(UtoolRedfishServer *server, const char *uploadFile
     result->code = curl_easy_perform(curl);
     if (result->code == CURLE_OK) { /* Check for errors */
         curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &response->httpStatusCode);
+        UtoolTraceRecord(curl, HTTP_POST, NULL, response);
         if (response->httpStatusCode == 404 || response->httpStatusCode == 413) {
             result->not_support = 1;
         }
@@ -200,6 +273,7 @@ DONE:
     }
     curl_easy_cleanup(curl);    /* cleanup the curl */
     curl_mime_free(form);       /* cleanup the form */
+    UtoolMappedFileRelease(mappedFile);
     UtoolFreeCurlResponse(response);
 }
 
@@ -279,6 +353,7 @@ void UtoolDownloadFileFromBMC(UtoolRedfishServer *server, const char *bmcFileUri
     result->code = curl_easy_perform(curl);
     if (result->code == CURLE_OK) {
         curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &response->httpStatusCode);
+        UtoolTraceRecord(curl, HTTP_POST, payload, NULL);
         if (response->httpStatusCode >= 400) {
             result->code = UtoolResolveFailureResponse(response, &(result->desc));
             goto FAILURE;
@@ -327,11 +402,210 @@ static size_t CURLReadLocalFileToStream(void *ptr, size_t size, size_t nmemb, vo
     return n;
 }
 
+/**
+ * CURL seek function for local file, used by CURL to skip the part already uploaded when resuming.
+ *
+ * @param stream
+ * @param offset
+ * @param origin
+ * @return
+ */
+static int CURLSeekLocalFileStream(void *stream, curl_off_t offset, int origin)
+{
+    FILE *f = (FILE *) stream;
+    return fseeko(f, (off_t) offset, origin) == 0 ? CURL_SEEKFUNC_OK : CURL_SEEKFUNC_FAIL;
+}
+
+/* CRC32 (IEEE 802.3) half-byte lookup table */
+static const uint32_t CRC32_NIBBLE_TABLE[16] = {
+        0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+        0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+};
+
+/**
+ * Update a CRC32 checksum with more bytes.
+ *
+ * @param crc   previous checksum, 0 for the first block
+ * @param buffer
+ * @param len
+ * @return
+ */
+static uint32_t UtoolCrc32(uint32_t crc, const unsigned char *buffer, size_t len)
+{
+    crc = ~crc;
+    for (size_t idx = 0; idx < len; idx++) {
+        crc ^= buffer[idx];
+        crc = (crc >> 4) ^ CRC32_NIBBLE_TABLE[crc & 0x0F];
+        crc = (crc >> 4) ^ CRC32_NIBBLE_TABLE[crc & 0x0F];
+    }
+    return ~crc;
+}
+
+/**
+ * CURL write function which accumulates CRC32 checksum of the downloaded chunk.
+ */
+static size_t CURLWriteChunkChecksum(const void *buffer, size_t size, size_t nmemb, void *userdata)
+{
+    uint32_t *crc = (uint32_t *) userdata;
+    *crc = UtoolCrc32(*crc, buffer, size * nmemb);
+    return size * nmemb;
+}
+
+/**
+ * Calculate CRC32 checksum of local file range [offset, offset + len).
+ *
+ * @param mappedFile    mapped local file, NULL if file is read through fp
+ * @param fp
+ * @param offset
+ * @param len
+ * @param crc           output checksum
+ * @return true if the range is read completely
+ */
+static bool UtoolLocalFileChunkChecksum(const UtoolMappedFile *mappedFile, FILE *fp, curl_off_t offset,
+                                        curl_off_t len, uint32_t *crc)
+{
+    unsigned char buffer[BUFSIZ];
+    *crc = 0;
+
+    if (mappedFile != NULL) {
+        if (offset + len > (curl_off_t) mappedFile->size) {
+            return false;
+        }
+        *crc = UtoolCrc32(0, mappedFile->data + offset, (size_t) len);
+        return true;
+    }
+
+    if (fseeko(fp, (off_t) offset, SEEK_SET) != 0) {
+        return false;
+    }
+
+    while (len > 0) {
+        size_t want = len > (curl_off_t) sizeof(buffer) ? sizeof(buffer) : (size_t) len;
+        size_t got = fread(buffer, 1, want, fp);
+        if (got != want) {
+            return false;
+        }
+        *crc = UtoolCrc32(*crc, buffer, got);
+        len -= (curl_off_t) got;
+    }
+
+    return true;
+}
+
+/**
+ * Get the offset from where an interrupted sftp upload could be resumed.
+ *
+ * The size of remote file is treated as acknowledged offset, the last (partial) chunk before that offset is
+ * downloaded back and verified against local file's checksum before resuming. Returns 0 if the remote file does
+ * not exist, is larger than local file or its tail chunk does not match.
+ *
+ * @param sftpRemoteFileUrl
+ * @param mappedFile
+ * @param uploadFileFp
+ * @param fileSize
+ * @return
+ */
+static curl_off_t UtoolSftpGetResumeOffset(const char *sftpRemoteFileUrl, const UtoolMappedFile *mappedFile,
+                                           FILE *uploadFileFp, curl_off_t fileSize)
+{
+    curl_off_t remoteSize = -1;
+    curl_off_t offset = 0;
+    uint32_t remoteCrc = 0;
+    uint32_t localCrc = 0;
+    char range[64] = {0};
+
+    CURL *curl = curl_easy_init();
+    if (!curl) {
+        return 0;
+    }
+
+    curl_easy_setopt(curl, CURLOPT_URL, sftpRemoteFileUrl);
+    curl_easy_setopt(curl, CURLOPT_NOBODY, 1L);
+    curl_easy_setopt(curl, CURLOPT_TIMEOUT, CURL_TIMEOUT);
+    curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, CURL_CONN_TIMEOUT);
+    curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+    CURLcode code = curl_easy_perform(curl);
+    if (code != CURLE_OK) {
+        ZF_LOGI("Remote file is not accessible(CURL code %d), upload from beginning.", code);
+        goto DONE;
+    }
+
+    curl_easy_getinfo(curl, CURLINFO_CONTENT_LENGTH_DOWNLOAD_T, &remoteSize);
+    if (remoteSize <= 0 || remoteSize >= fileSize) {
+        ZF_LOGI("Remote file size is %" CURL_FORMAT_CURL_OFF_T ", upload from beginning.", remoteSize);
+        goto DONE;
+    }
+
+    /* verify the last acknowledged chunk before resuming */
+    curl_off_t chunkStart = ((remoteSize - 1) / UPLOAD_CHUNK_SIZE) * UPLOAD_CHUNK_SIZE;
+    UtoolWrapSecFmt(range, sizeof(range), sizeof(range) - 1,
+                    "%" CURL_FORMAT_CURL_OFF_T "-%" CURL_FORMAT_CURL_OFF_T, chunkStart, remoteSize - 1);
+    curl_easy_setopt(curl, CURLOPT_NOBODY, 0L);
+    curl_easy_setopt(curl, CURLOPT_RANGE, range);
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, CURLWriteChunkChecksum);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &remoteCrc);
+    code = curl_easy_perform(curl);
+    if (code != CURLE_OK) {
+        ZF_LOGI("Failed to read back remote chunk %s(CURL code %d), upload from beginning.", range, code);
+        goto DONE;
+    }
+
+    if (!UtoolLocalFileChunkChecksum(mappedFile, uploadFileFp, chunkStart, remoteSize - chunkStart, &localCrc)) {
+        ZF_LOGE("Failed to read local file chunk %s, upload from beginning.", range);
+        goto DONE;
+    }
+
+    if (localCrc != remoteCrc) {
+        ZF_LOGI("Checksum of remote chunk %s mismatch(local %08x, remote %08x), upload from beginning.",
+                range, localCrc, remoteCrc);
+        goto DONE;
+    }
+
+    ZF_LOGI("Checksum of remote chunk %s verified(%08x), resume upload from there.", range, localCrc);
+    offset = remoteSize;
+
+DONE:
+    curl_easy_cleanup(curl);
+    return offset;
+}
+
+static void UtoolSetupUploadTimeout(CURL *curl, const UtoolRedfishServer *server)
+{
+    if (server->uploadLimiter == NULL) {
+        curl_easy_setopt(curl, CURLOPT_TIMEOUT, CURL_UPLOAD_TIMEOUT);
+        return;
+    }
+
+    curl_easy_setopt(curl, CURLOPT_TIMEOUT, 0L);
+    curl_easy_setopt(curl, CURLOPT_LOW_SPEED_LIMIT, CURL_UPLOAD_LOW_SPEED_LIMIT);
+    curl_easy_setopt(curl, CURLOPT_LOW_SPEED_TIME, CURL_UPLOAD_LOW_SPEED_TIME);
+}
+
+static bool UtoolIsResumableCurlError(CURLcode code)
+{
+    switch (code) {
+        case CURLE_SEND_ERROR:
+        case CURLE_RECV_ERROR:
+        case CURLE_OPERATION_TIMEDOUT:
+        case CURLE_PARTIAL_FILE:
+        case CURLE_COULDNT_CONNECT:
+        case CURLE_GOT_NOTHING:
+        case CURLE_SSH:
+        case CURLE_UPLOAD_FAILED:
+            return true;
+        default:
+            return false;
+    }
+}
+
 /**
  * Upload file to BMC temp storage through CURL lib with sftp protocol.
  *
  * Be caution that to enable this feature, the CURL lib must be configured with `--with-libssh2`
  *
+ * An interrupted transfer (including the one left by a previous call) is resumed from the size of the remote
+ * file once the checksum of its last chunk is verified.
+ *
  * @param server            redfish server meta information
  * @param uploadFilePath    local file path to upload
  * @param targetFileName    target filename to upload as, if NULL, use local file name
@@ -343,6 +617,10 @@ UtoolSftpUploadFileToBMC(UtoolRedfishServer *server, char *uploadFilePath, char
     ZF_LOGI("Try to sftp put local file `%s` to BMC /tmp/web folder now", uploadFilePath);
 
     FILE *uploadFileFp = NULL;
+    UtoolMappedFile *mappedFile = NULL;
+    UtoolMappedFileReader reader = {0};
+    UtoolLimitedReader limitedReader = {0};
+    curl_off_t fileSize = 0;
     char sftpRemoteFileUrl[MAX_URL_LEN] = {0};
     cJSON *getNetworkProtocolRespJson = NULL;
     UtoolCurlResponse *response = &(UtoolCurlResponse) {0};
@@ -357,17 +635,25 @@ UtoolSftpUploadFileToBMC(UtoolRedfishServer *server, char *uploadFilePath, char
         goto FAILURE;
     }
 
-    uploadFileFp = fopen(path, "rb"); /* open file to upload */
-    if (!uploadFileFp) {
-        result->code = UTOOLE_ILLEGAL_LOCAL_FILE_PATH;
-        goto FAILURE;
-    } /* can't continue */
+    /* read file through memory mapping if possible, fallback to stdio */
+    mappedFile = UtoolMappedFileOpen(path);
+    if (mappedFile != NULL) {
+        reader.file = mappedFile;
+        fileSize = (curl_off_t) mappedFile->size;
+    } else {
+        uploadFileFp = fopen(path, "rb"); /* open file to upload */
+        if (!uploadFileFp) {
+            result->code = UTOOLE_ILLEGAL_LOCAL_FILE_PATH;
+            goto FAILURE;
+        } /* can't continue */
 
-    /* get the file size */
-    if (fstat(fileno(uploadFileFp), &fileInfo) != 0) {
-        result->code = UTOOLE_ILLEGAL_LOCAL_FILE_SIZE;
-        goto FAILURE;
-    } /* can't continue */
+        /* get the file size */
+        if (fstat(fileno(uploadFileFp), &fileInfo) != 0) {
+            result->code = UTOOLE_ILLEGAL_LOCAL_FILE_SIZE;
+            goto FAILURE;
+        } /* can't continue */
+        fileSize = (curl_off_t) fileInfo.st_size;
+    }
 
 
     UtoolRedfishGet(server, "/Managers/%s/NetworkProtocol", NULL, NULL, result);
@@ -393,39 +679,78 @@ UtoolSftpUploadFileToBMC(UtoolRedfishServer *server, char *uploadFilePath, char
         goto FAILURE;
     }
 
+    curl_off_t offset = UtoolSftpGetResumeOffset(sftpRemoteFileUrl, mappedFile, uploadFileFp, fileSize);
+    int attempts = 0;
+    while (true) {
+        curl = curl_easy_init();
+        if (!curl) {
+            result->code = UTOOLE_CURL_INIT_FAILED;
+            goto FAILURE;
+        }
 
-    curl = curl_easy_init();
-    if (!curl) {
-        result->code = UTOOLE_CURL_INIT_FAILED;
-        goto FAILURE;
-    }
+        /** reset CURL timeout for uploading file */
+        UtoolSetupUploadTimeout(curl, server);
+        curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+
+        /** setup CURL upload options */
+        curl_easy_setopt(curl, CURLOPT_UPLOAD, 1L);
+        curl_easy_setopt(curl, CURLOPT_URL, sftpRemoteFileUrl);
+        curl_read_callback readCallback = (curl_read_callback) CURLReadLocalFileToStream;
+        curl_seek_callback seekCallback = CURLSeekLocalFileStream;
+        void *readData = uploadFileFp;
+        if (mappedFile != NULL) {
+            reader.offset = 0;
+            readCallback = UtoolMappedFileReadCallback;
+            seekCallback = UtoolMappedFileSeekCallback;
+            readData = &reader;
+        } else {
+            rewind(uploadFileFp);
+        }
 
-    /** reset CURL timeout for uploading file */
-    curl_easy_setopt(curl, CURLOPT_TIMEOUT, CURL_UPLOAD_TIMEOUT);
+        // limit upload bandwidth if required, the limiter may be shared with other uploads
+        if (server->uploadLimiter != NULL) {
+            limitedReader = (UtoolLimitedReader) {readCallback, seekCallback, readData, server->uploadLimiter};
+            readCallback = UtoolLimitedReadCallback;
+            seekCallback = UtoolLimitedSeekCallback;
+            readData = &limitedReader;
+        }
+        curl_easy_setopt(curl, CURLOPT_READFUNCTION, readCallback);
+        curl_easy_setopt(curl, CURLOPT_READDATA, readData);
+        curl_easy_setopt(curl, CURLOPT_SEEKFUNCTION, seekCallback);
+        curl_easy_setopt(curl, CURLOPT_SEEKDATA, readData);
+        curl_easy_setopt(curl, CURLOPT_INFILESIZE_LARGE, fileSize);
+        if (offset > 0) {
+            ZF_LOGI("Resume uploading from offset %" CURL_FORMAT_CURL_OFF_T "/%" CURL_FORMAT_CURL_OFF_T ".",
+                    offset, fileSize);
+            curl_easy_setopt(curl, CURLOPT_RESUME_FROM_LARGE, offset);
+        }
 
-    /** setup CURL upload options */
-    curl_easy_setopt(curl, CURLOPT_UPLOAD, 1L);
-    curl_easy_setopt(curl, CURLOPT_URL, sftpRemoteFileUrl);
-    curl_easy_setopt(curl, CURLOPT_READFUNCTION, CURLReadLocalFileToStream);
-    curl_easy_setopt(curl, CURLOPT_READDATA, uploadFileFp);
-    curl_easy_setopt(curl, CURLOPT_INFILESIZE, (long) fileInfo.st_size);
+        if (!server->quiet) {
+            bool finished = false;
+            curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0L);
+            curl_easy_setopt(curl, CURLOPT_PROGRESSFUNCTION, UtoolCurlPrintUploadProgressCallback);
+            curl_easy_setopt(curl, CURLOPT_PROGRESSDATA, &finished);
+        }
 
-    if (!server->quiet) {
-        bool finished = false;
-        curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0L);
-        curl_easy_setopt(curl, CURLOPT_PROGRESSFUNCTION, UtoolCurlPrintUploadProgressCallback);
-        curl_easy_setopt(curl, CURLOPT_PROGRESSDATA, &finished);
-    }
+        /* enable verbose for easier tracing */
+        /* curl_easy_setopt(curl, CURLOPT_VERBOSE, 1L); */
 
-    /* enable verbose for easier tracing */
-    /* curl_easy_setopt(curl, CURLOPT_VERBOSE, 1L); */
+        /* Perform the request, res will get the return code */
+        result->code = curl_easy_perform(curl);
+        UtoolTraceRecord(curl, "PUT", NULL, NULL);
+        curl_easy_cleanup(curl);
+        curl = NULL;
+        if (result->code == CURLE_OK) {
+            break;
+        }
 
-    /* Perform the request, res will get the return code */
-    result->code = curl_easy_perform(curl);
-    if (result->code != CURLE_OK) { /* Check for errors */
         const char *error = curl_easy_strerror((CURLcode) result->code);
         ZF_LOGE("Failed upload file to BMC, CURL code is %d, error is %s.", result->code, error);
-        goto FAILURE;
+        if (++attempts >= UPLOAD_RESUME_RETRY_TIMES || !UtoolIsResumableCurlError((CURLcode) result->code)) {
+            goto FAILURE;
+        }
+
+        offset = UtoolSftpGetResumeOffset(sftpRemoteFileUrl, mappedFile, uploadFileFp, fileSize);
     }
 
     goto DONE;
@@ -441,6 +766,7 @@ DONE:
     }
     FREE_CJSON(result->data);
     curl_easy_cleanup(curl);    /* cleanup the curl */
+    UtoolMappedFileRelease(mappedFile);
     UtoolFreeCurlResponse(response);
 }
 
@@ -503,9 +829,9 @@ void UtoolCurlCmdUploadFileToBMC(UtoolRedfishServer *server, char *uploadFilePat
 
         char nowStr[100] = {0};
         time_t now = time(NULL);
-        struct tm *tm_now = localtime(&now);
-        if (tm_now != NULL) {
-            strftime(nowStr, sizeof(nowStr), "%Y-%m-%d %H:%M:%S", tm_now);
+        struct tm tm_now;
+        if (UtoolLocalTime(now, &tm_now)) {
+            strftime(nowStr, sizeof(nowStr), "%Y-%m-%d %H:%M:%S", &tm_now);
         }
         fprintf(stdout, "%s Upload file now...\n", nowStr);
         fflush(stdout);
@@ -557,8 +883,32 @@ int UtoolMakeCurlRequest(UtoolRedfishServer *server,
     int ret = UTOOLE_INTERNAL;
     CURL *curl = NULL;
     char *payloadContent = NULL;
+    char *cachedEtag = NULL;
+    bool refetch = false;
     struct curl_slist *curlHeaderList = NULL;
 
+    // plain GET requests are served by resource cache if possible, stale resource is revalidated with its ETag
+    char fullURL[MAX_URL_LEN] = {0};
+    bool cacheable = UtoolStringEquals(httpMethod, HTTP_GET) && payload == NULL &&
+                     (headers == NULL || headers->name == NULL);
+    if (cacheable) {
+        UtoolResolveResourceURL(server, resourceURL, fullURL);
+        if (UtoolResourceCacheGet(server, fullURL, response, &cachedEtag)) {
+            ret = UTOOLE_OK;
+            goto DONE;
+        }
+
+        if (cachedEtag != NULL) {
+            char ifNoneMatch[MAX_HEADER_LEN] = {0};
+            UtoolWrapSecFmt(ifNoneMatch, MAX_HEADER_LEN, MAX_HEADER_LEN - 1, "%s: %s", HEADER_IF_NONE_MATCH,
+                            cachedEtag);
+            curlHeaderList = curl_slist_append(curlHeaderList, ifNoneMatch);
+        }
+    } else if (!UtoolStringEquals(httpMethod, HTTP_GET)) {
+        // resources may be changed by this request
+        UtoolResourceCacheInvalidate(server->baseUrl);
+    }
+
     const UtoolCurlHeader *ifMatchHeader = NULL;
     for (int idx = 0;; idx++) {
         const UtoolCurlHeader *header = headers + idx;
@@ -591,15 +941,6 @@ int UtoolMakeCurlRequest(UtoolRedfishServer *server,
         }
     }
 
-    curl = UtoolSetupCurlRequest(server, resourceURL, httpMethod, response);
-    if (!curl) {
-        return UTOOLE_CURL_INIT_FAILED;
-    }
-
-    // setup headers
-    curlHeaderList = curl_slist_append(curlHeaderList, CONTENT_TYPE_JSON);
-    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, curlHeaderList);
-
     // setup payload, payload should be freed by caller
     if (payload != NULL) {
         /** https://github.com/bagder/everything-curl/blob/master/libcurl-http-requests.md */
@@ -608,65 +949,105 @@ int UtoolMakeCurlRequest(UtoolRedfishServer *server,
         if (ret != UTOOLE_OK) {
             goto DONE;
         }
-        ZF_LOGD("Sending payload: %s", payloadContent);
-        curl_easy_setopt(curl, CURLOPT_POSTFIELDS, payloadContent);
-        curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, strlen(payloadContent));
+        UTOOL_LOG_BODY(ZF_LOG_DEBUG, "Sending payload", payloadContent);
     }
 
-    // perform request
-    ret = curl_easy_perform(curl);
-    if (ret == CURLE_OK) {
-        curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &response->httpStatusCode);
-        ZF_LOGD("Response: %s", response->content);
+    if (UtoolTransportReplaying()) {
+        double elapsed = 0;
+        ret = UtoolTransportReplay(httpMethod, resourceURL, response, &elapsed);
+        UtoolTransportWait(elapsed);
     } else {
+        curl = UtoolSetupCurlRequest(server, resourceURL, httpMethod, response);
+        if (!curl) {
+            ret = UTOOLE_CURL_INIT_FAILED;
+            goto DONE;
+        }
+
+        // setup headers
+        curlHeaderList = curl_slist_append(curlHeaderList, CONTENT_TYPE_JSON);
+        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, curlHeaderList);
+        if (payloadContent != NULL) {
+            curl_easy_setopt(curl, CURLOPT_POSTFIELDS, payloadContent);
+            curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, strlen(payloadContent));
+        }
+
+        // perform request, response is recorded before resource cache fills a not modified response
+        ret = curl_easy_perform(curl);
+        if (ret == CURLE_OK) {
+            curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &response->httpStatusCode);
+        }
+        UtoolTransportRecord(curl, httpMethod, resourceURL, curlHeaderList, payloadContent, ret, response);
+    }
+
+    if (ret == CURLE_OK) {
+        UTOOL_LOG_BODY(ZF_LOG_DEBUG, "Response", response->content);
+        if (cacheable && response->httpStatusCode == 304) {
+            // resource may be dropped from cache meanwhile, fetch it again without condition then
+            refetch = !UtoolResourceCacheRevalidate(server, fullURL, response);
+        } else if (cacheable && response->httpStatusCode >= 200 && response->httpStatusCode < 300) {
+            UtoolResourceCacheStore(server, fullURL, response);
+        }
+    } else if (ret < CURL_LAST) {
         const char *error = curl_easy_strerror((CURLcode) ret);
         ZF_LOGE("Failed to perform http request, CURL code is %d, error is %s", ret, error);
     }
+    UtoolTraceRecord(curl, httpMethod, payloadContent, response);
 
     goto DONE;
 
 DONE:
     FREE_OBJ(payloadContent)
+    FREE_OBJ(cachedEtag)
     if (curl) {
         curl_easy_cleanup(curl);
     }
     curl_slist_free_all(curlHeaderList);
+    if (refetch) {
+        UtoolFreeCurlResponse(response);
+        return UtoolMakeCurlRequest(server, resourceURL, httpMethod, payload, headers, response);
+    }
     return ret;
 }
 
+void UtoolResolveResourceURL(const UtoolRedfishServer *server, const char *resourceURL, char *fullURL)
+{
+    // replace %s with redfish-system-id if necessary
+    UtoolWrapStringNAppend(fullURL, MAX_URL_LEN, server->baseUrl, strnlen(server->baseUrl, MAX_URL_LEN));
+    if (strstr(resourceURL, "/redfish/v1") == NULL) {
+        UtoolWrapStringAppend(fullURL, MAX_URL_LEN, "/redfish/v1");
+    }
+
+    if (strstr(resourceURL, "%s") != NULL) {
+        char _resourceURL[MAX_URL_LEN] = {0};
+        UtoolWrapSecFmt(_resourceURL, MAX_URL_LEN, MAX_URL_LEN - 1, resourceURL, server->systemId);
+        UtoolWrapStringNAppend(fullURL, MAX_URL_LEN, _resourceURL, strnlen(_resourceURL, MAX_URL_LEN));
+    } else {
+        UtoolWrapStringNAppend(fullURL, MAX_URL_LEN, resourceURL, strnlen(resourceURL, MAX_URL_LEN));
+    }
+
+    if (strstr(resourceURL, VAR_OEM) != NULL) {
+        char *url = UtoolStringReplace(fullURL, VAR_OEM, server->oemName);
+        if (url != NULL) {
+            fullURL[0] = '\0';
+            UtoolWrapStringNAppend(fullURL, MAX_URL_LEN, url, strnlen(url, MAX_URL_LEN));
+            free(url);
+        }
+    }
+}
+
 static CURL *UtoolSetupCurlRequest(const UtoolRedfishServer *server, const char *resourceURL,
                                    const char *httpMethod, UtoolCurlResponse *response)
 {
-    char *url = NULL;
     CURL *curl = curl_easy_init();
     if (curl) {
-        // replace %s with redfish-system-id if necessary
         char fullURL[MAX_URL_LEN] = {0};
-        UtoolWrapStringNAppend(fullURL, MAX_URL_LEN, server->baseUrl, strnlen(server->baseUrl, MAX_URL_LEN));
-        if (strstr(resourceURL, "/redfish/v1") == NULL) {
-            UtoolWrapStringAppend(fullURL, MAX_URL_LEN, "/redfish/v1");
-        }
-
-        if (strstr(resourceURL, "%s") != NULL) {
-            char _resourceURL[MAX_URL_LEN] = {0};
-            UtoolWrapSecFmt(_resourceURL, MAX_URL_LEN, MAX_URL_LEN - 1, resourceURL, server->systemId);
-            UtoolWrapStringNAppend(fullURL, MAX_URL_LEN, _resourceURL, strnlen(_resourceURL, MAX_URL_LEN));
-        } else {
-            UtoolWrapStringNAppend(fullURL, MAX_URL_LEN, resourceURL, strnlen(resourceURL, MAX_URL_LEN));
-        }
+        UtoolResolveResourceURL(server, resourceURL, fullURL);
 
         /* enable verbose for easier tracing */
         /*curl_easy_setopt(curl, CURLOPT_VERBOSE, 1L);*/
 
-        if (strstr(resourceURL, VAR_OEM) != NULL) {
-            char *url = UtoolStringReplace(fullURL, VAR_OEM, server->oemName);
-            curl_easy_setopt(curl, CURLOPT_URL, url);
-            ZF_LOGI("[%s] %s", httpMethod, url);
-            free(url);
-        } else {
-            curl_easy_setopt(curl, CURLOPT_URL, fullURL);
-            ZF_LOGI("[%s] %s", httpMethod, fullURL);
-        }
+        curl_easy_setopt(curl, CURLOPT_URL, fullURL);
+        ZF_LOGI("[%s] %s", httpMethod, fullURL);
 
         // setup basic http meta
         curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, httpMethod);
@@ -683,6 +1064,12 @@ static CURL *UtoolSetupCurlRequest(const UtoolRedfishServer *server, const char
         curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, CURL_CONN_TIMEOUT);
         curl_easy_setopt(curl, CURLOPT_TIMEOUT, CURL_TIMEOUT);
 
+        // negotiate all content encodings (gzip, deflate...) built in libcurl, response is decoded while received
+        curl_easy_setopt(curl, CURLOPT_ACCEPT_ENCODING, "");
+
+        // requests may be issued from worker threads, avoid signal based DNS timeout
+        curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+
         // setup basic auth
         curl_easy_setopt(curl, CURLOPT_HTTPAUTH, (long) CURLAUTH_BASIC);
         curl_easy_setopt(curl, CURLOPT_USERNAME, server->username);
@@ -729,7 +1116,7 @@ int UtoolResolveFailureResponse(UtoolCurlResponse *response, char **result)
     }
 
     // if status code not in the list above, read detail from response content
-    ZF_LOGE("Failed to execute request, error response -> %s", response->content);
+    UTOOL_LOG_BODY(ZF_LOG_ERROR, "Failed to execute request, error response", response->content);
     cJSON *failures = cJSON_CreateArray();
     int ret = UtoolGetFailuresFromResponse(response, failures);
     if (ret != UTOOLE_OK) {
@@ -754,7 +1141,7 @@ bool UtoolResolvePartialFailureResponse(UtoolCurlResponse *response, UtoolResult
 {
     long int code = response->httpStatusCode;
     ZF_LOGI("Try to resolve partial failure, http code -> %ld", code);
-    ZF_LOGI("Try to resolve partial failure, http response -> %s", response->content);
+    UTOOL_LOG_BODY(ZF_LOG_INFO, "Try to resolve partial failure, http response", response->content);
 
     // handle standard internet errors
     if (403 == code) {
@@ -872,6 +1259,8 @@ void UtoolGetRedfishServer2(UtoolCommandOption *option, UtoolRedfishServer *serv
 
     errno_t ok;
     cJSON *getSystemJson = NULL, *getRedfishJson = NULL;
+    char *oem = NULL;
+    bool isOemMalloc = false;
 
     server->quiet = option->quiet;
 
@@ -965,10 +1354,18 @@ void UtoolGetRedfishServer2(UtoolCommandOption *option, UtoolRedfishServer *serv
         goto FAILURE;
     }
 
+    // root resource is only used here, take it away from result
     getRedfishJson = result->data;
+    result->data = NULL;
+
+    // members of collection could be expanded in one request, see UtoolRedfishGetCollection
+    cJSON *noLinksNode = cJSONUtils_GetPointer(getRedfishJson, "/ProtocolFeaturesSupported/ExpandQuery/NoLinks");
+    cJSON *levelsNode = cJSONUtils_GetPointer(getRedfishJson, "/ProtocolFeaturesSupported/ExpandQuery/Levels");
+    cJSON *selectNode = cJSONUtils_GetPointer(getRedfishJson, "/ProtocolFeaturesSupported/SelectQuery");
+    server->expandSupported = cJSON_IsTrue(noLinksNode) && cJSON_IsTrue(levelsNode);
+    server->selectSupported = cJSON_IsTrue(selectNode);
+    ZF_LOGI("Redfish service supports $expand: %d, $select: %d.", server->expandSupported, server->selectSupported);
     cJSON *oemNode = cJSONUtils_GetPointer(getRedfishJson, "/Oem");
-    char *oem = NULL;
-    bool isOemMalloc = false;
     if (oemNode == NULL || oemNode->valuestring == NULL) {
         oem = (char *) malloc(strlen(DEFAULT_OEM) + 1);
         if (oem == NULL) {
@@ -1052,6 +1449,19 @@ static int UtoolCurlGetHeaderCallback(const char *buffer, size_t size, size_t ni
             }
         }
 
+        size_t cacheControlPrefixLen = strlen(HEADER_CACHE_CONTROL);
+        if (size * nitems > cacheControlPrefixLen &&
+            strncasecmp(buffer, HEADER_CACHE_CONTROL, cacheControlPrefixLen) == 0) {
+            // header buffer is not null terminated, strip tailing CRLF
+            size_t len = size * nitems - cacheControlPrefixLen;
+            const char *value = buffer + cacheControlPrefixLen;
+            while (len > 0 && (value[len - 1] == '\r' || value[len - 1] == '\n')) {
+                len--;
+            }
+            FREE_OBJ(response->cacheControl)
+            response->cacheControl = len > 0 ? UtoolStringNDup(value, len) : NULL;
+        }
+
         if (UtoolStringCaseStartsWith((const char *) buffer, (const char *) HEADER_CONTENT_TYPE)) {
             // get response content
             unsigned long fullSize = size * nitems;
@@ -1089,9 +1499,9 @@ UtoolCurlPrintUploadProgressCallback(void *output, double dltotal, double dlnow,
         if (*finished != PROGRESS_FINISHED) {
             char nowStr[100] = {0};
             time_t now = time(NULL);
-            struct tm *tm_now = localtime(&now);
-            if (tm_now != NULL) {
-                strftime(nowStr, sizeof(nowStr), "%Y-%m-%d %H:%M:%S", tm_now);
+            struct tm tm_now;
+            if (UtoolLocalTime(now, &tm_now)) {
+                strftime(nowStr, sizeof(nowStr), "%Y-%m-%d %H:%M:%S", &tm_now);
             }
 
             fprintf(stdout, "\r%s Upload file inprogress, process: %.0f%%.", nowStr, (ulnow * 100) / ultotal);
@@ -1112,41 +1522,55 @@ static int UtoolCurlGetRespCallback(const void *buffer, size_t size, size_t nmem
 {
     // realloc method is forbidden in XFUSION developing documents.
     // because CURL may response multiple times to write response content
-    // so we malloc enough memory according to content length header directly
-    unsigned long fullSize = size * nmemb;
-    unsigned long length = response->contentLength > 0 ? response->contentLength : fullSize * 10;
-    if (response->content == NULL) {
-        response->content = (char *) malloc(length + 1);
-        if (response->content != NULL) {
-            response->content[0] = '\0';
-            response->size = length;
-        } else {
+    // so we malloc enough memory according to content length header directly.
+    // content length header is the encoded size of a compressed response, decoded content may exceed it, then
+    // content is moved into a new buffer twice as large.
+    size_t fullSize = size * nmemb;
+    size_t received = response->content == NULL ? 0 : response->length;
+    if (response->content == NULL || received + fullSize > response->size) {
+        size_t capacity = response->contentLength > 0 ? (size_t) response->contentLength : fullSize * 10;
+        if (capacity < response->size * 2) {
+            capacity = response->size * 2;
+        }
+        if (capacity < received + fullSize) {
+            capacity = received + fullSize;
+        }
+
+        char *content = (char *) malloc(capacity + 1);
+        if (content == NULL) {
             return 0;
         }
+        if (received > 0 && memcpy_s(content, capacity, response->content, received) != EOK) {
+            FREE_OBJ(content)
+            return 0;
+        }
+        FREE_OBJ(response->content)
+        response->content = content;
+        response->size = capacity;
     }
 
-    UtoolWrapStringNAppend(response->content, response->size + 1, (char *) buffer, fullSize);
+    if (memcpy_s(response->content + received, response->size - received, buffer, fullSize) != EOK) {
+        return 0;
+    }
+    response->length = received + fullSize;
+    response->content[response->length] = '\0';
 
     // return content size
-    return fullSize;
+    return (int) fullSize;
 }
 
-void UtoolRedfishProcessRequest(UtoolRedfishServer *server,
-                                char *url,
-                                const char *httpMethod,
-                                const cJSON *payload,
-                                const UtoolCurlHeader *headers,
-                                cJSON *output,
-                                const UtoolOutputMapping *outputMapping,
-                                UtoolResult *result)
+/**
+* Resolve failures of a finished redfish request, then parse response and map it into output.
+*
+* @param server
+* @param response
+* @param output
+* @param outputMapping
+* @param result
+*/
+static void UtoolRedfishProcessResponse(UtoolRedfishServer *server, UtoolCurlResponse *response, cJSON *output,
+                                        const UtoolOutputMapping *outputMapping, UtoolResult *result)
 {
-    UtoolCurlResponse *response = &(UtoolCurlResponse) {0};
-
-    result->code = UtoolMakeCurlRequest(server, url, httpMethod, payload, headers, response);
-    if (result->code != UTOOLE_OK) {
-        goto FAILURE;
-    }
-
     bool resolved = UtoolResolvePartialFailureResponse(response, result);
     if (resolved || result->broken) {
         goto FAILURE;
@@ -1166,24 +1590,44 @@ void UtoolRedfishProcessRequest(UtoolRedfishServer *server,
         }
     }
 
-    goto DONE;
+    return;
 
 FAILURE:
     result->broken = 1;
-    goto DONE;
-
-DONE:
-    UtoolFreeCurlResponse(response);
 }
 
-
-/**
-* Get Redfish resource and parse content to JSON.
-*
-* if success, result->data will carry the (cJSON *) format response content.
-* if interrupt, result->data will be safe freed. Caller do not need to care about the data.
-*
-* @param server
+void UtoolRedfishProcessRequest(UtoolRedfishServer *server,
+                                char *url,
+                                const char *httpMethod,
+                                const cJSON *payload,
+                                const UtoolCurlHeader *headers,
+                                cJSON *output,
+                                const UtoolOutputMapping *outputMapping,
+                                UtoolResult *result)
+{
+    UtoolCurlResponse *response = &(UtoolCurlResponse) {0};
+
+    result->code = UtoolMakeCurlRequest(server, url, httpMethod, payload, headers, response);
+    if (result->code != UTOOLE_OK) {
+        result->broken = 1;
+        goto DONE;
+    }
+
+    UtoolRedfishProcessResponse(server, response, output, outputMapping, result);
+    goto DONE;
+
+DONE:
+    UtoolFreeCurlResponse(response);
+}
+
+
+/**
+* Get Redfish resource and parse content to JSON.
+*
+* if success, result->data will carry the (cJSON *) format response content.
+* if interrupt, result->data will be safe freed. Caller do not need to care about the data.
+*
+* @param server
 * @param url
 * @param result
 */
@@ -1221,6 +1665,287 @@ void UtoolRedfishDelete(UtoolRedfishServer *server, char *url, cJSON *output, co
     UtoolRedfishProcessRequest(server, url, HTTP_DELETE, NULL, NULL, output, outputMapping, result);
 }
 
+/**
+* Whether a member of collection is a resource rather than a link, i.e. it carries properties besides annotations.
+*
+* @param member
+* @return
+*/
+static bool UtoolRedfishIsExpandedMember(const cJSON *member)
+{
+    const cJSON *property = NULL;
+    cJSON_ArrayForEach(property, member) {
+        if (property->string != NULL && !UtoolStringStartsWith(property->string, "@odata.")) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+* Build URL which expands members of collection, $select is limited to top level properties referenced by member
+* mapping when server supports it and the URL is not too long.
+*
+* @param server
+* @param url
+* @param memberMapping
+* @param expandUrl     buffer of MAX_URL_LEN
+* @return false if expanded URL is too long
+*/
+static bool UtoolRedfishBuildExpandURL(const UtoolRedfishServer *server, const char *url,
+                                       const UtoolOutputMapping *memberMapping, char *expandUrl)
+{
+    char fullURL[MAX_URL_LEN] = {0};
+    UtoolResolveResourceURL(server, url, fullURL);
+    size_t fullLen = strnlen(fullURL, MAX_URL_LEN);
+    size_t expandLen = strnlen(url, MAX_URL_LEN) + strlen("?" REDFISH_EXPAND_MEMBERS);
+    if (fullLen + strlen("?" REDFISH_EXPAND_MEMBERS) >= MAX_URL_LEN || expandLen >= MAX_URL_LEN) {
+        return false;
+    }
+    UtoolWrapSecFmt(expandUrl, MAX_URL_LEN, MAX_URL_LEN - 1, "%s?%s", url, REDFISH_EXPAND_MEMBERS);
+    if (!server->selectSupported || memberMapping == NULL) {
+        return true;
+    }
+
+    // comma delimited property list, "Members" itself is always selected
+    char properties[MAX_URL_LEN] = ",Members,";
+    size_t propertiesLen = strlen(properties);
+    for (const UtoolOutputMapping *mapping = memberMapping; mapping->sourceXpath != NULL; mapping++) {
+        // "/Oem/${Oem}/Position" selects "Oem", root node handlers may read any property
+        const char *property = mapping->sourceXpath + 1;
+        size_t len = strcspn(property, "/");
+        if (mapping->useRootNode || mapping->sourceXpath[0] != '/' || len == 0 ||
+            propertiesLen + len + 1 >= MAX_URL_LEN) {
+            return true;
+        }
+        // "/Null" is a placeholder for properties the resource does not have
+        if (strcmp(mapping->sourceXpath, "/Null") == 0) {
+            continue;
+        }
+
+        char needle[MAX_URL_LEN] = {0};
+        UtoolWrapSecFmt(needle, MAX_URL_LEN, MAX_URL_LEN - 1, ",%.*s,", (int) len, property);
+        if (strstr(properties, needle) == NULL) {
+            UtoolWrapStringAppend(properties, MAX_URL_LEN, needle + 1);
+            propertiesLen += len + 1;
+        }
+    }
+    properties[propertiesLen - 1] = '\0';
+
+    // select list is left out when the URL would be too long, members are still expanded
+    size_t selectLen = strlen("&$select=") + propertiesLen - 2;
+    if (fullLen + strlen("?" REDFISH_EXPAND_MEMBERS) + selectLen < MAX_URL_LEN && expandLen + selectLen < MAX_URL_LEN) {
+        UtoolWrapStringAppend(expandUrl, MAX_URL_LEN, "&$select=");
+        UtoolWrapStringAppend(expandUrl, MAX_URL_LEN, properties + 1);
+    }
+    return true;
+}
+
+void UtoolRedfishGetCollection(UtoolRedfishServer *server, const char *url, const UtoolOutputMapping *memberMapping,
+                               UtoolResult *result)
+{
+    cJSON *collection = NULL;
+    UtoolCurlResponse *response = &(UtoolCurlResponse) {0};
+
+    // a collection prefetched into resource cache (e.g. by getinventory) is most likely followed by its members
+    char fullURL[MAX_URL_LEN] = {0};
+    UtoolResolveResourceURL(server, url, fullURL);
+    if (server->expandSupported && !UtoolResourceCacheIsFresh(server, fullURL)) {
+        char expandUrl[MAX_URL_LEN] = {0};
+        bool expandable = UtoolRedfishBuildExpandURL(server, url, memberMapping, expandUrl);
+        result->code = expandable ? UtoolMakeCurlRequest(server, expandUrl, HTTP_GET, NULL, NULL, response)
+                                  : UTOOLE_OK;
+        if (result->code != UTOOLE_OK) {
+            goto FAILURE;
+        }
+
+        if (!expandable) {
+            ZF_LOGW("URL of %s is too long to expand members.", url);
+        } else if (response->httpStatusCode >= 200 && response->httpStatusCode < 300) {
+            collection = cJSON_Parse(response->content);
+        } else {
+            ZF_LOGW("Failed to expand members of %s, status code is %ld, load them one by one.", url,
+                    response->httpStatusCode);
+        }
+    }
+
+    if (collection == NULL) {
+        UtoolRedfishGet(server, (char *) url, NULL, NULL, result);
+        if (result->broken) {
+            goto DONE;
+        }
+        collection = result->data;
+        result->data = NULL;
+    }
+
+    // load members which are not expanded
+    cJSON *members = cJSON_GetObjectItem(collection, "Members");
+    int memberCount = cJSON_GetArraySize(members);
+    for (int idx = 0; idx < memberCount; idx++) {
+        cJSON *member = cJSON_GetArrayItem(members, idx);
+        if (UtoolRedfishIsExpandedMember(member)) {
+            continue;
+        }
+
+        cJSON *linkNode = cJSON_GetObjectItem(member, "@odata.id");
+        result->code = UtoolAssetJsonNodeNotNull(linkNode, "/Members/*/@odata.id");
+        if (result->code != UTOOLE_OK) {
+            goto FAILURE;
+        }
+
+        UtoolRedfishGet(server, linkNode->valuestring, NULL, NULL, result);
+        if (result->broken) {
+            goto DONE;
+        }
+        cJSON_ReplaceItemInArray(members, idx, result->data);
+        result->data = NULL;
+    }
+
+    result->data = collection;
+    collection = NULL;
+    goto DONE;
+
+FAILURE:
+    result->broken = 1;
+    goto DONE;
+
+DONE:
+    FREE_CJSON(collection)
+    UtoolFreeCurlResponse(response);
+}
+
+/**
+* Add an account into account index, accounts without user name (empty slots) are skipped.
+*
+* @param accounts
+* @param account
+* @param url
+* @param etag      could be NULL
+* @return false if failed to create index entry
+*/
+static bool UtoolRedfishIndexAccount(cJSON *accounts, const cJSON *account, const char *url, const char *etag)
+{
+    cJSON *username = cJSON_GetObjectItem(account, "UserName");
+    if (!cJSON_IsString(username) || UtoolStringIsEmpty(username->valuestring) || url == NULL ||
+        cJSON_GetObjectItemCaseSensitive(accounts, username->valuestring) != NULL) {
+        return true;
+    }
+
+    cJSON *entry = cJSON_AddObjectToObject(accounts, username->valuestring);
+    if (entry == NULL || cJSON_AddStringToObject(entry, "@odata.id", url) == NULL) {
+        return false;
+    }
+    return etag == NULL || cJSON_AddStringToObject(entry, "@odata.etag", etag) != NULL;
+}
+
+static void UtoolRedfishIndexAccountCallback(UtoolRedfishAsyncGroup *group, UtoolRedfishAsyncRequest *request,
+                                             UtoolResult *result)
+{
+    (void) group;
+    if (!result->broken &&
+        !UtoolRedfishIndexAccount((cJSON *) request->context, result->data, request->url, request->response.etag)) {
+        result->code = UTOOLE_CREATE_JSON_NULL;
+        result->broken = 1;
+    }
+}
+
+/**
+* Build account index of server.
+*
+* @param server
+* @param result
+*/
+static void UtoolRedfishBuildAccountIndex(UtoolRedfishServer *server, UtoolResult *result)
+{
+    cJSON *collection = NULL;
+    cJSON *accounts = cJSON_CreateObject();
+    result->code = UtoolAssetCreatedJsonNotNull(accounts);
+    if (result->code != UTOOLE_OK) {
+        goto FAILURE;
+    }
+
+    cJSON *member = NULL;
+    if (server->expandSupported) {
+        // members are loaded in one request, ETag of member is carried by its @odata.etag property
+        UtoolRedfishGetCollection(server, "/AccountService/Accounts", NULL, result);
+        if (result->broken) {
+            goto FAILURE;
+        }
+        collection = result->data;
+        result->data = NULL;
+
+        cJSON_ArrayForEach(member, cJSON_GetObjectItem(collection, "Members")) {
+            cJSON *url = cJSON_GetObjectItem(member, "@odata.id");
+            cJSON *etag = cJSON_GetObjectItem(member, "@odata.etag");
+            if (!UtoolRedfishIndexAccount(accounts, member, cJSON_IsString(url) ? url->valuestring : NULL,
+                                          cJSON_IsString(etag) ? etag->valuestring : NULL)) {
+                result->code = UTOOLE_CREATE_JSON_NULL;
+                goto FAILURE;
+            }
+        }
+    } else {
+        UtoolRedfishGet(server, "/AccountService/Accounts", NULL, NULL, result);
+        if (result->broken) {
+            goto FAILURE;
+        }
+        collection = result->data;
+        result->data = NULL;
+
+        // get all accounts concurrently, ETag of account is taken from its response header
+        UtoolRedfishAsyncGroup *group = &(UtoolRedfishAsyncGroup) {0};
+        UtoolRedfishAsyncGroupInit(group, server, 0);
+        cJSON_ArrayForEach(member, cJSON_GetObjectItem(collection, "Members")) {
+            cJSON *link = cJSON_GetObjectItem(member, "@odata.id");
+            result->code = UtoolAssetJsonNodeNotNull(link, "/Members/*/@odata.id");
+            if (result->code != UTOOLE_OK) {
+                // submitted requests will be dropped by broken group
+                group->broken = true;
+                break;
+            }
+            UtoolRedfishAsyncGet(group, link->valuestring, NULL, NULL, UtoolRedfishIndexAccountCallback, accounts);
+        }
+
+        UtoolRedfishAsyncGroupRun(group, result);
+        if (result->broken) {
+            goto FAILURE;
+        }
+    }
+
+    ZF_LOGI("Account index is built, %d accounts found.", cJSON_GetArraySize(accounts));
+    server->accounts = accounts;
+    accounts = NULL;
+    goto DONE;
+
+FAILURE:
+    result->broken = 1;
+    goto DONE;
+
+DONE:
+    FREE_CJSON(accounts)
+    FREE_CJSON(collection)
+}
+
+const cJSON *UtoolRedfishFindAccount(UtoolRedfishServer *server, const char *username, UtoolResult *result)
+{
+    if (server->accounts == NULL) {
+        UtoolRedfishBuildAccountIndex(server, result);
+        if (result->broken) {
+            return NULL;
+        }
+    }
+
+    const cJSON *account = cJSON_GetObjectItemCaseSensitive(server->accounts, username);
+    ZF_LOGI("Account with user name %s is %s.", username, account != NULL ? "found" : "not found");
+    return account;
+}
+
+void UtoolRedfishForgetAccount(UtoolRedfishServer *server, const char *username)
+{
+    if (server->accounts != NULL) {
+        cJSON_DeleteItemFromObjectCaseSensitive(server->accounts, username);
+    }
+}
+
 /**
 * Get All Redfish member resources
 *
@@ -1246,6 +1971,16 @@ void UtoolRedfishGetMemberResources(UtoolRedfishServer *server, cJSON *owner, cJ
             goto FAILURE;
         }
 
+        // members of collection loaded by UtoolRedfishGetCollection are resources already
+        if (UtoolRedfishIsExpandedMember(memberLink)) {
+            result->code = UtoolMappingCJSONItems(server, memberLink, outputMember, memberMapping);
+            if (result->code != UTOOLE_OK) {
+                goto FAILURE;
+            }
+            cJSON_AddItemToArray(memberArray, outputMember);
+            continue;
+        }
+
         cJSON *linkNode = cJSON_GetObjectItem(memberLink, "@odata.id");
         char *url = linkNode->valuestring;
         UtoolRedfishGet(server, url, outputMember, memberMapping, result);
@@ -1493,9 +2228,9 @@ void UtoolRedfishWaitUtilTaskFinished(UtoolRedfishServer *server, cJSON *cJSONTa
 
         char nowStr[100] = {0};
         time_t now = time(NULL);
-        struct tm *tm_now = localtime(&now);
-        if (tm_now != NULL) {
-            strftime(nowStr, sizeof(nowStr), "%Y-%m-%d %H:%M:%S", tm_now);
+        struct tm tm_now;
+        if (UtoolLocalTime(now, &tm_now)) {
+            strftime(nowStr, sizeof(nowStr), "%Y-%m-%d %H:%M:%S", &tm_now);
         }
 
         // print task progress to stdout
@@ -1580,9 +2315,9 @@ void UtoolRedfishWaitUtilTaskStart(UtoolRedfishServer *server, cJSON *cJSONTask,
 
         char logTimestamp[100] = {0};
         time_t now = time(NULL);
-        struct tm *tm_now = localtime(&now);
-        if (tm_now != NULL) {
-            strftime(logTimestamp, sizeof(logTimestamp), "%Y-%m-%d %H:%M:%S", tm_now);
+        struct tm tm_now;
+        if (UtoolLocalTime(now, &tm_now)) {
+            strftime(logTimestamp, sizeof(logTimestamp), "%Y-%m-%d %H:%M:%S", &tm_now);
         }
 
         // print task progress to stdout
@@ -1664,3 +2399,584 @@ bool UtoolIsRedfishTaskInArray(cJSON *task, const char *states[])
     return UtoolStringInArray(status->valuestring, states);
 }
 
+
+
+/**
+* Setup next probe request of a BMC reboot probe.
+*
+*   - TCP probe only connects to redfish port, it is cheap and fails fast when BMC is down.
+*   - HTTP probe gets redfish root when waiting shutdown and ActiveBMC firmware inventory when waiting alive.
+*
+* @param probe
+* @return
+*/
+static CURL *UtoolSetupRebootProbeRequest(UtoolRebootProbe *probe)
+{
+    CURL *curl = NULL;
+    if (probe->tcpProbe) {
+        curl = curl_easy_init();
+        if (curl) {
+            // connect to the same host:port as redfish service, but stop right after TCP connection is established
+            char url[MAX_URL_LEN] = {0};
+            const char *hostPort = strstr(probe->server->baseUrl, "://");
+            UtoolWrapSecFmt(url, MAX_URL_LEN, MAX_URL_LEN - 1, "http%s",
+                            hostPort != NULL ? hostPort : probe->server->baseUrl);
+            curl_easy_setopt(curl, CURLOPT_URL, url);
+            curl_easy_setopt(curl, CURLOPT_CONNECT_ONLY, 1L);
+            curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+        }
+    } else {
+        const char *resourceURL = probe->state == REBOOT_PROBE_WAIT_SHUTDOWN ? "/" :
+                                  "/UpdateService/FirmwareInventory/ActiveBMC";
+        curl = UtoolSetupCurlRequest(probe->server, resourceURL, HTTP_GET, &(probe->response));
+        if (curl) {
+            curl_easy_setopt(curl, CURLOPT_TIMEOUT, REBOOT_PROBE_TIMEOUT);
+        }
+    }
+
+    if (curl) {
+        curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, REBOOT_PROBE_CONN_TIMEOUT);
+        curl_easy_setopt(curl, CURLOPT_PRIVATE, probe);
+    }
+    return curl;
+}
+
+/**
+* Advance reboot probe state with the result of finished probe.
+*
+* @param probe
+* @param curl
+* @param code
+* @param now
+*/
+static void UtoolHandleRebootProbeResult(UtoolRebootProbe *probe, CURL *curl, CURLcode code, time_t now)
+{
+    UtoolRebootProbeState previous = probe->state;
+
+    long httpStatusCode = 0;
+    if (code == CURLE_OK && !probe->tcpProbe) {
+        curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &httpStatusCode);
+    }
+    bool up = code == CURLE_OK && (probe->tcpProbe || httpStatusCode < 300);
+    ZF_LOGD("Reboot probe(%s) of %s result: CURL code %d, http status %ld.",
+            probe->tcpProbe ? "TCP" : "HTTP", probe->server->host, code, httpStatusCode);
+
+    UtoolFreeCurlResponse(&(probe->response));
+    probe->response = (UtoolCurlResponse) {0};
+
+    // TCP connection is alive, confirm with redfish service right now
+    if (probe->tcpProbe && up) {
+        probe->tcpProbe = false;
+        probe->nextProbeTime = now;
+        return;
+    }
+
+    if (probe->state == REBOOT_PROBE_WAIT_SHUTDOWN) {
+        if (!up) {
+            probe->state = REBOOT_PROBE_WAIT_ALIVE;
+            probe->stateStartTime = now;
+            probe->successes = 0;
+        }
+    } else if (probe->state == REBOOT_PROBE_WAIT_ALIVE) {
+        probe->successes = up ? probe->successes + 1 : 0;
+        if (probe->successes >= REBOOT_ALIVE_CONFIRM_TIMES) {
+            probe->state = REBOOT_PROBE_ALIVE;
+        }
+    }
+
+    // redfish connection is kept in multi handle's cache, so only go back to TCP probe once BMC is down
+    probe->tcpProbe = !up;
+    probe->nextProbeTime = now + REBOOT_PROBE_INTERVAL;
+    if (probe->callback != NULL) {
+        probe->callback(probe, probe->state != previous);
+    }
+}
+
+void UtoolRedfishWaitBMCReboot(UtoolRebootProbe *probes, int count)
+{
+    time_t now = time(NULL);
+    for (int idx = 0; idx < count; idx++) {
+        UtoolRebootProbe *probe = probes + idx;
+        probe->curl = NULL;
+        probe->tcpProbe = true;
+        probe->successes = 0;
+        probe->stateStartTime = now;
+        probe->nextProbeTime = now;
+        probe->response = (UtoolCurlResponse) {0};
+    }
+
+    CURLM *multi = curl_multi_init();
+    if (multi == NULL) {
+        ZF_LOGE("Failed to init curl multi handle, aboard reboot probes.");
+        return;
+    }
+
+    while (true) {
+        int unfinished = 0;
+        int inFlight = 0;
+        time_t nextProbeTime = 0;
+        now = time(NULL);
+        for (int idx = 0; idx < count; idx++) {
+            UtoolRebootProbe *probe = probes + idx;
+            if (probe->state != REBOOT_PROBE_WAIT_SHUTDOWN && probe->state != REBOOT_PROBE_WAIT_ALIVE) {
+                continue;
+            }
+
+            unfinished++;
+            if (probe->curl != NULL) {
+                inFlight++;
+                continue;
+            }
+
+            bool waitShutdown = probe->state == REBOOT_PROBE_WAIT_SHUTDOWN;
+            int timeLimit = waitShutdown ? probe->shutdownTimeLimit : probe->aliveTimeLimit;
+            if (difftime(now, probe->stateStartTime) > timeLimit) {
+                ZF_LOGI("Reboot probe of %s exceeds time limit %d seconds.", probe->server->host, timeLimit);
+                probe->state = waitShutdown ? REBOOT_PROBE_SHUTDOWN_TIMEOUT : REBOOT_PROBE_ALIVE_TIMEOUT;
+                if (probe->callback != NULL) {
+                    probe->callback(probe, true);
+                }
+                unfinished--;
+                continue;
+            }
+
+            if (now < probe->nextProbeTime) {
+                if (nextProbeTime == 0 || probe->nextProbeTime < nextProbeTime) {
+                    nextProbeTime = probe->nextProbeTime;
+                }
+                continue;
+            }
+
+            CURL *curl = UtoolSetupRebootProbeRequest(probe);
+            if (curl == NULL) {
+                probe->nextProbeTime = now + REBOOT_PROBE_INTERVAL;
+                continue;
+            }
+            curl_multi_add_handle(multi, curl);
+            probe->curl = curl;
+            inFlight++;
+        }
+
+        if (unfinished == 0) {
+            break;
+        }
+
+        int running = 0;
+        curl_multi_perform(multi, &running);
+
+        int left = 0;
+        CURLMsg *msg = NULL;
+        while ((msg = curl_multi_info_read(multi, &left)) != NULL) {
+            if (msg->msg != CURLMSG_DONE) {
+                continue;
+            }
+
+            CURL *curl = msg->easy_handle;
+            CURLcode code = msg->data.result;
+            UtoolRebootProbe *probe = NULL;
+            curl_easy_getinfo(curl, CURLINFO_PRIVATE, (char **) &probe);
+            curl_multi_remove_handle(multi, curl);
+            UtoolHandleRebootProbeResult(probe, curl, code, time(NULL));
+            curl_easy_cleanup(curl);
+            probe->curl = NULL;
+        }
+
+        if (inFlight > 0) {
+            // wake up when any probe makes progress or every second to schedule next probes
+            curl_multi_wait(multi, NULL, 0, 1000, NULL);
+        } else {
+            // curl_multi_wait returns at once without handles, sleep until the earliest probe is due
+            time_t wait = nextProbeTime > now ? nextProbeTime - now : 1;
+            sleep((unsigned int) (wait < REBOOT_PROBE_INTERVAL ? wait : REBOOT_PROBE_INTERVAL));
+        }
+    }
+
+    curl_multi_cleanup(multi);
+}
+
+void UtoolRedfishAsyncGroupInit(UtoolRedfishAsyncGroup *group, UtoolRedfishServer *server, int maxInFlight)
+{
+    group->server = server;
+    group->maxInFlight = maxInFlight > 0 ? maxInFlight : REDFISH_ASYNC_MAX_IN_FLIGHT;
+    group->head = NULL;
+    group->tail = NULL;
+    group->multi = NULL;
+    group->replaying = NULL;
+    group->inFlight = 0;
+    group->broken = false;
+}
+
+static void UtoolFreeRedfishAsyncRequest(UtoolRedfishAsyncRequest *request)
+{
+    if (request != NULL) {
+        if (request->curl != NULL) {
+            curl_easy_cleanup(request->curl);
+        }
+        curl_slist_free_all((struct curl_slist *) request->headers);
+        UtoolFreeCurlResponse(&(request->response));
+        FREE_OBJ(request->payload)
+        FREE_OBJ(request->url)
+        FREE_OBJ(request)
+    }
+}
+
+UtoolRedfishAsyncRequest *UtoolRedfishAsyncSubmit(UtoolRedfishAsyncGroup *group, const char *url,
+                                                  const char *httpMethod, const cJSON *payload,
+                                                  const UtoolCurlHeader *headers, cJSON *output,
+                                                  const UtoolOutputMapping *outputMapping,
+                                                  void (*callback)(UtoolRedfishAsyncGroup *group,
+                                                                   UtoolRedfishAsyncRequest *request,
+                                                                   UtoolResult *result),
+                                                  void *context)
+{
+    UtoolRedfishAsyncRequest *request = (UtoolRedfishAsyncRequest *) calloc(1, sizeof(UtoolRedfishAsyncRequest));
+    if (request == NULL) {
+        goto FAILURE;
+    }
+
+    request->url = UtoolStringNDup(url, MAX_URL_LEN);
+    if (request->url == NULL) {
+        goto FAILURE;
+    }
+
+    if (payload != NULL) {
+        request->payload = cJSON_PrintUnformatted(payload);
+        if (request->payload == NULL) {
+            goto FAILURE;
+        }
+    }
+
+    struct curl_slist *curlHeaderList = NULL;
+    for (int idx = 0; headers != NULL && headers[idx].name != NULL; idx++) {
+        char buffer[MAX_HEADER_LEN] = {0};
+        UtoolWrapSecFmt(buffer, MAX_HEADER_LEN, MAX_HEADER_LEN - 1, "%s: %s", headers[idx].name,
+                        headers[idx].value);
+        curlHeaderList = curl_slist_append(curlHeaderList, buffer);
+    }
+    curlHeaderList = curl_slist_append(curlHeaderList, CONTENT_TYPE_JSON);
+    request->headers = curlHeaderList;
+
+    request->httpMethod = httpMethod;
+    request->cacheable = UtoolStringEquals(httpMethod, HTTP_GET) && payload == NULL && headers == NULL;
+    request->output = output;
+    request->outputMapping = outputMapping;
+    request->callback = callback;
+    request->context = context;
+
+    if (group->tail == NULL) {
+        group->head = request;
+    } else {
+        group->tail->next = request;
+    }
+    group->tail = request;
+    return request;
+
+FAILURE:
+    ZF_LOGE("Failed to submit async request %s.", url);
+    UtoolFreeRedfishAsyncRequest(request);
+    group->broken = true;
+    return NULL;
+}
+
+UtoolRedfishAsyncRequest *UtoolRedfishAsyncGet(UtoolRedfishAsyncGroup *group, const char *url, cJSON *output,
+                                               const UtoolOutputMapping *outputMapping,
+                                               void (*callback)(UtoolRedfishAsyncGroup *group,
+                                                                UtoolRedfishAsyncRequest *request,
+                                                                UtoolResult *result),
+                                               void *context)
+{
+    return UtoolRedfishAsyncSubmit(group, url, HTTP_GET, NULL, NULL, output, outputMapping, callback, context);
+}
+
+/**
+* Serve a cacheable async request from resource cache if it is fresh, otherwise make it a conditional request when
+* the cached resource carries an ETag.
+*
+* @param group
+* @param request
+* @return whether request is served from cache
+*/
+static bool UtoolRedfishAsyncServeFromCache(UtoolRedfishAsyncGroup *group, UtoolRedfishAsyncRequest *request)
+{
+    char fullURL[MAX_URL_LEN] = {0};
+    char *etag = NULL;
+    UtoolResolveResourceURL(group->server, request->url, fullURL);
+    if (UtoolResourceCacheGet(group->server, fullURL, &(request->response), &etag)) {
+        return true;
+    }
+
+    if (etag != NULL) {
+        char header[MAX_HEADER_LEN] = {0};
+        UtoolWrapSecFmt(header, MAX_HEADER_LEN, MAX_HEADER_LEN - 1, "%s: %s", HEADER_IF_NONE_MATCH, etag);
+        request->headers = curl_slist_append((struct curl_slist *) request->headers, header);
+        free(etag);
+    }
+    return false;
+}
+
+/**
+* Update resource cache with response of a cacheable async request.
+*
+* @param group
+* @param request
+* @return false if resource is dropped from cache while revalidating, request is submitted again then.
+*/
+static bool UtoolRedfishAsyncCacheResponse(UtoolRedfishAsyncGroup *group, UtoolRedfishAsyncRequest *request)
+{
+    char fullURL[MAX_URL_LEN] = {0};
+    UtoolCurlResponse *response = &(request->response);
+    UtoolResolveResourceURL(group->server, request->url, fullURL);
+    if (response->httpStatusCode == 304) {
+        if (!UtoolResourceCacheRevalidate(group->server, fullURL, response)) {
+            UtoolRedfishAsyncSubmit(group, request->url, HTTP_GET, NULL, NULL, request->output,
+                                    request->outputMapping, request->callback, request->context);
+            return false;
+        }
+    } else if (response->httpStatusCode >= 200 && response->httpStatusCode < 300) {
+        UtoolResourceCacheStore(group->server, fullURL, response);
+    }
+    return true;
+}
+
+/**
+* Process a finished async request, the first failure of group is moved into group result.
+*
+* @param group
+* @param request
+* @param code
+* @param result  group result
+*/
+static void UtoolRedfishAsyncComplete(UtoolRedfishAsyncGroup *group, UtoolRedfishAsyncRequest *request,
+                                      CURLcode code, UtoolResult *result)
+{
+    UtoolResult *requestResult = &(UtoolResult) {0};
+    if (request->curl != NULL) {
+        if (code == CURLE_OK) {
+            curl_easy_getinfo(request->curl, CURLINFO_RESPONSE_CODE, &(request->response.httpStatusCode));
+        }
+        // response is recorded before resource cache fills a not modified response
+        UtoolTransportRecord(request->curl, request->httpMethod, request->url,
+                             (const struct curl_slist *) request->headers, request->payload, code,
+                             &(request->response));
+    }
+
+    if (code != CURLE_OK) {
+        ZF_LOGE("Failed to perform async request %s, CURL code is %d, error is %s", request->url, code,
+                curl_easy_strerror(code));
+        requestResult->code = code;
+        requestResult->broken = 1;
+    } else {
+        // request->curl is NULL when response is served from resource cache or replay file
+        if (request->curl != NULL || request->replayed) {
+            UTOOL_LOG_BODY(ZF_LOG_DEBUG, "Response", request->response.content);
+            if (request->cacheable && !UtoolRedfishAsyncCacheResponse(group, request)) {
+                UtoolTraceRecord(request->curl, request->httpMethod, request->payload, &(request->response));
+                return;
+            }
+        }
+        UtoolRedfishProcessResponse(group->server, &(request->response), request->output, request->outputMapping,
+                                    requestResult);
+    }
+    if (request->curl != NULL) {
+        UtoolTraceRecord(request->curl, request->httpMethod, request->payload, &(request->response));
+    }
+
+    if (request->callback != NULL && !group->broken) {
+        request->callback(group, request, requestResult);
+    }
+    FREE_CJSON(requestResult->data)
+
+    if (requestResult->broken && !group->broken) {
+        group->broken = true;
+        result->broken = 1;
+        result->code = requestResult->code;
+        result->desc = requestResult->desc;
+        requestResult->desc = NULL;
+    }
+    FREE_OBJ(requestResult->desc)
+}
+
+/**
+* Serve an async request from replay file. A timed replay stays in flight until its recorded time passes, so
+* concurrent requests overlap like they did while recorded.
+*
+* @param group
+* @param request
+* @param result  group result
+*/
+static void UtoolRedfishAsyncReplay(UtoolRedfishAsyncGroup *group, UtoolRedfishAsyncRequest *request,
+                                    UtoolResult *result)
+{
+    double elapsed = 0;
+    request->replayed = true;
+    request->replayCode = UtoolTransportReplay(request->httpMethod, request->url, &(request->response), &elapsed);
+    if (!UtoolTransportTimed()) {
+        UtoolRedfishAsyncComplete(group, request, (CURLcode) request->replayCode, result);
+        UtoolFreeRedfishAsyncRequest(request);
+        return;
+    }
+
+    request->replayDue = UtoolTransportClock() + elapsed;
+    request->next = group->replaying;
+    group->replaying = request;
+    group->inFlight++;
+}
+
+/**
+* Wait until the earliest timed replay of group finishes, then complete all finished ones.
+*
+* @param group
+* @param result  group result
+*/
+static void UtoolRedfishAsyncReplayWait(UtoolRedfishAsyncGroup *group, UtoolResult *result)
+{
+    double due = group->replaying->replayDue;
+    for (UtoolRedfishAsyncRequest *request = group->replaying->next; request != NULL; request = request->next) {
+        if (request->replayDue < due) {
+            due = request->replayDue;
+        }
+    }
+    UtoolTransportWait(due - UtoolTransportClock());
+
+    double now = UtoolTransportClock();
+    UtoolRedfishAsyncRequest **link = &(group->replaying);
+    while (*link != NULL) {
+        UtoolRedfishAsyncRequest *request = *link;
+        if (request->replayDue > now) {
+            link = &(request->next);
+            continue;
+        }
+
+        *link = request->next;
+        request->next = NULL;
+        group->inFlight--;
+        UtoolRedfishAsyncComplete(group, request, (CURLcode) request->replayCode, result);
+        UtoolFreeRedfishAsyncRequest(request);
+    }
+}
+
+void UtoolRedfishAsyncGroupRun(UtoolRedfishAsyncGroup *group, UtoolResult *result)
+{
+    CURLM *multi = group->multi != NULL ? (CURLM *) group->multi : curl_multi_init();
+    if (multi == NULL) {
+        result->code = UTOOLE_CURL_INIT_FAILED;
+        result->broken = 1;
+        group->broken = true;
+        goto DONE;
+    }
+
+    // group is broken before running, e.g. failed to submit request, only drop the submitted requests
+    if (group->broken) {
+        ZF_LOGE("Async group is broken before running.");
+        if (result->code == UTOOLE_OK) {
+            result->code = UTOOLE_INTERNAL;
+        }
+        result->broken = 1;
+        goto DONE;
+    }
+
+    while (true) {
+        // send waiting requests while there is room
+        while (!group->broken && group->head != NULL && group->inFlight < group->maxInFlight) {
+            UtoolRedfishAsyncRequest *request = group->head;
+            group->head = request->next;
+            if (group->head == NULL) {
+                group->tail = NULL;
+            }
+            request->next = NULL;
+
+            if (request->cacheable) {
+                if (UtoolRedfishAsyncServeFromCache(group, request)) {
+                    UtoolRedfishAsyncComplete(group, request, CURLE_OK, result);
+                    UtoolFreeRedfishAsyncRequest(request);
+                    continue;
+                }
+            } else if (!UtoolStringEquals(request->httpMethod, HTTP_GET)) {
+                // resources may be changed by this request
+                UtoolResourceCacheInvalidate(group->server->baseUrl);
+            }
+
+            if (UtoolTransportReplaying()) {
+                UtoolRedfishAsyncReplay(group, request, result);
+                continue;
+            }
+
+            CURL *curl = UtoolSetupCurlRequest(group->server, request->url, request->httpMethod,
+                                               &(request->response));
+            if (curl == NULL) {
+                UtoolFreeRedfishAsyncRequest(request);
+                group->broken = true;
+                result->code = UTOOLE_CURL_INIT_FAILED;
+                result->broken = 1;
+                break;
+            }
+
+            curl_easy_setopt(curl, CURLOPT_HTTPHEADER, (struct curl_slist *) request->headers);
+            if (request->payload != NULL) {
+                UTOOL_LOG_BODY(ZF_LOG_DEBUG, "Sending payload", request->payload);
+                curl_easy_setopt(curl, CURLOPT_POSTFIELDS, request->payload);
+                curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, strlen(request->payload));
+            }
+            curl_easy_setopt(curl, CURLOPT_PRIVATE, request);
+            request->curl = curl;
+            curl_multi_add_handle(multi, curl);
+            group->inFlight++;
+        }
+
+        if (group->inFlight == 0) {
+            break;
+        }
+
+        // requests are either replayed or sent through network in a run
+        if (group->replaying != NULL) {
+            UtoolRedfishAsyncReplayWait(group, result);
+            continue;
+        }
+
+        int running = 0;
+        curl_multi_perform(multi, &running);
+
+        int left = 0;
+        CURLMsg *msg = NULL;
+        while ((msg = curl_multi_info_read(multi, &left)) != NULL) {
+            if (msg->msg != CURLMSG_DONE) {
+                continue;
+            }
+
+            CURL *curl = msg->easy_handle;
+            CURLcode code = msg->data.result;
+            UtoolRedfishAsyncRequest *request = NULL;
+            curl_easy_getinfo(curl, CURLINFO_PRIVATE, (char **) &request);
+            curl_multi_remove_handle(multi, curl);
+            group->inFlight--;
+
+            UtoolRedfishAsyncComplete(group, request, code, result);
+            UtoolFreeRedfishAsyncRequest(request);
+        }
+
+        if (group->inFlight > 0) {
+            curl_multi_wait(multi, NULL, 0, 1000, NULL);
+        }
+    }
+
+    goto DONE;
+
+DONE:
+    // drop requests which are not sent
+    while (group->head != NULL) {
+        UtoolRedfishAsyncRequest *request = group->head;
+        group->head = request->next;
+        UtoolFreeRedfishAsyncRequest(request);
+    }
+    group->tail = NULL;
+    while (group->replaying != NULL) {
+        UtoolRedfishAsyncRequest *request = group->replaying;
+        group->replaying = request->next;
+        group->inFlight--;
+        UtoolFreeRedfishAsyncRequest(request);
+    }
+
+    if (multi != NULL && multi != group->multi) {
+        curl_multi_cleanup(multi);
+    }
+}
@@ -0,0 +1,405 @@
+/*
+* Copyright © xFusion Digital Technologies Co., Ltd. 2012-2018. All rights reserved.
+* Description: process wide redfish resource cache, honoring ETag & Cache-Control max-age
+* Author:
+* Create: 2019-06-16
+* Notes:
+*/
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include "resource_cache.h"
+#include "commons.h"
+#include "constants.h"
+#include "string_utils.h"
+#include "zf_log.h"
+
+#define RESOURCE_CACHE_BUCKET_COUNT 64
+#define RESOURCE_CACHE_FNV_OFFSET 0xcbf29ce484222325ULL
+#define RESOURCE_CACHE_FNV_PRIME 0x100000001b3ULL
+
+/* task state changes while it is polled, task resources & task monitors are never cached */
+static const char *const g_UtoolResourceCacheVolatilePaths[] = {"/TaskService", "/TaskMonitor", "/taskmonitor", NULL};
+
+/**
+ * A cached GET response
+ */
+typedef struct _CachedResource {
+    unsigned long long credential;  /* hash of username & password, a resource is only served to the same account */
+    char *url;
+    char *content;
+    char *etag;
+    char *contentType;
+    long httpStatusCode;
+    time_t storedAt;
+    time_t expiresAt;           /* resource should be revalidated after this time */
+    bool held;                  /* stored while cache is held, fresh & never evicted until cache is released */
+    struct _CachedResource *next;
+} UtoolCachedResource;
+
+static bool g_UtoolResourceCacheEnabled = false;
+static UtoolCachedResource *g_UtoolResourceCache[RESOURCE_CACHE_BUCKET_COUNT] = {0};
+static int g_UtoolResourceCacheCount = 0;
+static int g_UtoolResourceCacheHeld = 0;
+static pthread_mutex_t g_UtoolResourceCacheMutex = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * hash credential of server, so that a resource fetched by an account is never served to a request with a wrong
+ * password without BMC checking it.
+ *
+ * @param server
+ * @return
+ */
+static unsigned long long UtoolResourceCacheCredential(const UtoolRedfishServer *server)
+{
+    // FNV-1a over "username\0password"
+    unsigned long long hash = RESOURCE_CACHE_FNV_OFFSET;
+    const char *parts[] = {server->username, server->password};
+    for (int idx = 0; idx < 2; idx++) {
+        for (const char *ch = parts[idx] != NULL ? parts[idx] : ""; *ch != '\0'; ch++) {
+            hash = (hash ^ (unsigned char) *ch) * RESOURCE_CACHE_FNV_PRIME;
+        }
+        hash = hash * RESOURCE_CACHE_FNV_PRIME;
+    }
+    return hash;
+}
+
+static unsigned long UtoolResourceCacheHash(unsigned long long credential, const char *url)
+{
+    // djb2
+    unsigned long hash = 5381 + (unsigned long) credential;
+    for (const char *ch = url; *ch != '\0'; ch++) {
+        hash = hash * 33 + (unsigned char) *ch;
+    }
+    return hash % RESOURCE_CACHE_BUCKET_COUNT;
+}
+
+static bool UtoolResourceCacheIsVolatile(const char *url)
+{
+    for (int idx = 0; g_UtoolResourceCacheVolatilePaths[idx] != NULL; idx++) {
+        if (strstr(url, g_UtoolResourceCacheVolatilePaths[idx]) != NULL) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * whether url is a resource of server, base URL must be followed by a path or end of url, so that
+ * https://h:443 does not match https://h:4430 and https://10.0.0.1 does not match https://10.0.0.12.
+ *
+ * @param url
+ * @param baseUrl
+ * @return
+ */
+static bool UtoolResourceCacheIsOfServer(const char *url, const char *baseUrl)
+{
+    if (!UtoolStringStartsWith(url, baseUrl)) {
+        return false;
+    }
+    char next = url[strlen(baseUrl)];
+    return next == '/' || next == '\0';
+}
+
+static void UtoolFreeCachedResource(UtoolCachedResource *resource)
+{
+    FREE_OBJ(resource->url)
+    FREE_OBJ(resource->content)
+    FREE_OBJ(resource->etag)
+    FREE_OBJ(resource->contentType)
+    free(resource);
+}
+
+/**
+ * find cached resource, caller should hold the mutex.
+ *
+ * @param credential
+ * @param url
+ * @return
+ */
+static UtoolCachedResource *UtoolResourceCacheFind(unsigned long long credential, const char *url)
+{
+    UtoolCachedResource *resource = g_UtoolResourceCache[UtoolResourceCacheHash(credential, url)];
+    for (; resource != NULL; resource = resource->next) {
+        if (resource->credential == credential && strcmp(resource->url, url) == 0) {
+            return resource;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * remove resources matched by filter, caller should hold the mutex.
+ *
+ * @param baseUrl   remove resources of this server, NULL to remove all
+ * @param oldest    remove this resource only if not NULL
+ */
+static void UtoolResourceCacheRemove(const char *baseUrl, const UtoolCachedResource *oldest)
+{
+    for (int idx = 0; idx < RESOURCE_CACHE_BUCKET_COUNT; idx++) {
+        UtoolCachedResource **link = g_UtoolResourceCache + idx;
+        while (*link != NULL) {
+            UtoolCachedResource *resource = *link;
+            bool matched = oldest != NULL ? resource == oldest :
+                           (baseUrl == NULL || UtoolResourceCacheIsOfServer(resource->url, baseUrl));
+            if (matched) {
+                *link = resource->next;
+                UtoolFreeCachedResource(resource);
+                g_UtoolResourceCacheCount--;
+            } else {
+                link = &(resource->next);
+            }
+        }
+    }
+}
+
+/**
+ * evict the oldest resource which is not held, caller should hold the mutex. Cache may grow beyond
+ * REDFISH_CACHE_MAX_ENTRIES while it is held.
+ */
+static void UtoolResourceCacheEvictOldest(void)
+{
+    UtoolCachedResource *oldest = NULL;
+    for (int idx = 0; idx < RESOURCE_CACHE_BUCKET_COUNT; idx++) {
+        for (UtoolCachedResource *resource = g_UtoolResourceCache[idx]; resource != NULL; resource = resource->next) {
+            if (resource->held) {
+                continue;
+            }
+            if (oldest == NULL || resource->storedAt < oldest->storedAt) {
+                oldest = resource;
+            }
+        }
+    }
+    if (oldest != NULL) {
+        UtoolResourceCacheRemove(NULL, oldest);
+    }
+}
+
+/**
+ * get freshness lifetime from Cache-Control header, a resource without explicit max-age is stale at once and could
+ * only be reused after being revalidated by its ETag.
+ *
+ * @param cacheControl
+ * @return lifetime in seconds, -1 if response should not be stored
+ */
+static long UtoolResourceCacheGetMaxAge(const char *cacheControl)
+{
+    if (cacheControl == NULL) {
+        return 0;
+    }
+    if (strstr(cacheControl, "no-store") != NULL) {
+        return -1;
+    }
+    if (strstr(cacheControl, "no-cache") != NULL) {
+        return 0;
+    }
+
+    const char *maxAge = strstr(cacheControl, "max-age=");
+    if (maxAge != NULL) {
+        long seconds = strtol(maxAge + strlen("max-age="), NULL, 10);
+        return seconds > 0 ? seconds : 0;
+    }
+    return 0;
+}
+
+/**
+ * whether resource could be served without revalidation, caller should hold the mutex.
+ *
+ * @param resource
+ * @return
+ */
+static bool UtoolResourceCacheIsServable(const UtoolCachedResource *resource)
+{
+    return resource->held || time(NULL) < resource->expiresAt;
+}
+
+/**
+ * fill response with cached resource, caller should hold the mutex.
+ *
+ * @param resource
+ * @param response
+ * @return
+ */
+static bool UtoolResourceCacheFill(const UtoolCachedResource *resource, UtoolCurlResponse *response)
+{
+    size_t len = strlen(resource->content);
+    char *content = (char *) malloc(len + 1);
+    if (content == NULL) {
+        return false;
+    }
+    memcpy(content, resource->content, len + 1);
+
+    FREE_OBJ(response->content)
+    response->content = content;
+    response->size = len;
+    response->length = len;
+    response->contentLength = (long) len;
+    response->httpStatusCode = resource->httpStatusCode;
+    if (response->etag == NULL && resource->etag != NULL) {
+        response->etag = UtoolStringNDup(resource->etag, MAX_HEADER_LEN);
+    }
+    if (response->contentType == NULL && resource->contentType != NULL) {
+        response->contentType = UtoolStringNDup(resource->contentType, MAX_HEADER_LEN);
+    }
+    return true;
+}
+
+void UtoolResourceCacheEnable(bool enabled)
+{
+    pthread_mutex_lock(&g_UtoolResourceCacheMutex);
+    g_UtoolResourceCacheEnabled = enabled;
+    if (!enabled) {
+        UtoolResourceCacheRemove(NULL, NULL);
+    }
+    pthread_mutex_unlock(&g_UtoolResourceCacheMutex);
+}
+
+void UtoolResourceCacheHold(bool hold)
+{
+    pthread_mutex_lock(&g_UtoolResourceCacheMutex);
+    g_UtoolResourceCacheHeld += hold ? 1 : -1;
+    if (!hold && g_UtoolResourceCacheHeld <= 0) {
+        g_UtoolResourceCacheHeld = 0;
+
+        // held resources fall back to normal freshness, those could neither be reused nor revalidated are dropped
+        time_t now = time(NULL);
+        for (int idx = 0; idx < RESOURCE_CACHE_BUCKET_COUNT; idx++) {
+            UtoolCachedResource **link = g_UtoolResourceCache + idx;
+            while (*link != NULL) {
+                UtoolCachedResource *resource = *link;
+                resource->held = false;
+                if (now >= resource->expiresAt && resource->etag == NULL) {
+                    *link = resource->next;
+                    UtoolFreeCachedResource(resource);
+                    g_UtoolResourceCacheCount--;
+                } else {
+                    link = &(resource->next);
+                }
+            }
+        }
+        while (g_UtoolResourceCacheCount > REDFISH_CACHE_MAX_ENTRIES) {
+            UtoolResourceCacheEvictOldest();
+        }
+    }
+    pthread_mutex_unlock(&g_UtoolResourceCacheMutex);
+}
+
+bool UtoolResourceCacheGet(const UtoolRedfishServer *server, const char *url, UtoolCurlResponse *response,
+                           char **etag)
+{
+    bool served = false;
+    unsigned long long credential = UtoolResourceCacheCredential(server);
+    pthread_mutex_lock(&g_UtoolResourceCacheMutex);
+    UtoolCachedResource *resource = g_UtoolResourceCacheEnabled ? UtoolResourceCacheFind(credential, url) : NULL;
+    if (resource != NULL) {
+        if (UtoolResourceCacheIsServable(resource)) {
+            served = UtoolResourceCacheFill(resource, response);
+        } else if (resource->etag != NULL) {
+            *etag = UtoolStringNDup(resource->etag, MAX_HEADER_LEN);
+        }
+    }
+    pthread_mutex_unlock(&g_UtoolResourceCacheMutex);
+
+    if (served) {
+        ZF_LOGI("[GET] %s is served from resource cache.", url);
+    }
+    return served;
+}
+
+bool UtoolResourceCacheIsFresh(const UtoolRedfishServer *server, const char *url)
+{
+    unsigned long long credential = UtoolResourceCacheCredential(server);
+    pthread_mutex_lock(&g_UtoolResourceCacheMutex);
+    UtoolCachedResource *resource = g_UtoolResourceCacheEnabled ? UtoolResourceCacheFind(credential, url) : NULL;
+    bool fresh = resource != NULL && UtoolResourceCacheIsServable(resource);
+    pthread_mutex_unlock(&g_UtoolResourceCacheMutex);
+    return fresh;
+}
+
+void UtoolResourceCacheStore(const UtoolRedfishServer *server, const char *url, const UtoolCurlResponse *response)
+{
+    // a resource which is neither fresh nor could be revalidated is useless, unless cache is held
+    long maxAge = UtoolResourceCacheGetMaxAge(response->cacheControl);
+    if (maxAge < 0 || response->content == NULL || UtoolResourceCacheIsVolatile(url)) {
+        return;
+    }
+    pthread_mutex_lock(&g_UtoolResourceCacheMutex);
+    bool held = g_UtoolResourceCacheHeld > 0;
+    pthread_mutex_unlock(&g_UtoolResourceCacheMutex);
+    if (maxAge == 0 && response->etag == NULL && !held) {
+        return;
+    }
+
+    UtoolCachedResource *resource = (UtoolCachedResource *) calloc(1, sizeof(UtoolCachedResource));
+    if (resource == NULL) {
+        return;
+    }
+    unsigned long long credential = UtoolResourceCacheCredential(server);
+    resource->credential = credential;
+    resource->url = UtoolStringNDup(url, MAX_URL_LEN);
+    resource->content = UtoolStringNDup(response->content, strlen(response->content) + 1);
+    resource->etag = response->etag != NULL ? UtoolStringNDup(response->etag, MAX_HEADER_LEN) : NULL;
+    resource->contentType = response->contentType != NULL ? UtoolStringNDup(response->contentType, MAX_HEADER_LEN)
+                                                          : NULL;
+    resource->httpStatusCode = response->httpStatusCode;
+    resource->storedAt = time(NULL);
+    resource->expiresAt = resource->storedAt + maxAge;
+    if (resource->url == NULL || resource->content == NULL) {
+        UtoolFreeCachedResource(resource);
+        return;
+    }
+
+    pthread_mutex_lock(&g_UtoolResourceCacheMutex);
+    if (g_UtoolResourceCacheEnabled) {
+        resource->held = g_UtoolResourceCacheHeld > 0;
+        UtoolCachedResource *stale = UtoolResourceCacheFind(credential, url);
+        if (stale != NULL) {
+            UtoolResourceCacheRemove(NULL, stale);
+        }
+        if (g_UtoolResourceCacheCount >= REDFISH_CACHE_MAX_ENTRIES) {
+            UtoolResourceCacheEvictOldest();
+        }
+
+        unsigned long bucket = UtoolResourceCacheHash(credential, url);
+        resource->next = g_UtoolResourceCache[bucket];
+        g_UtoolResourceCache[bucket] = resource;
+        g_UtoolResourceCacheCount++;
+        resource = NULL;
+    }
+    pthread_mutex_unlock(&g_UtoolResourceCacheMutex);
+
+    if (resource != NULL) {
+        UtoolFreeCachedResource(resource);
+    }
+}
+
+bool UtoolResourceCacheRevalidate(const UtoolRedfishServer *server, const char *url, UtoolCurlResponse *response)
+{
+    bool served = false;
+    unsigned long long credential = UtoolResourceCacheCredential(server);
+    pthread_mutex_lock(&g_UtoolResourceCacheMutex);
+    UtoolCachedResource *resource = g_UtoolResourceCacheEnabled ? UtoolResourceCacheFind(credential, url) : NULL;
+    if (resource != NULL) {
+        long maxAge = UtoolResourceCacheGetMaxAge(response->cacheControl);
+        resource->expiresAt = time(NULL) + (maxAge > 0 ? maxAge : 0);
+        served = UtoolResourceCacheFill(resource, response);
+    }
+    pthread_mutex_unlock(&g_UtoolResourceCacheMutex);
+
+    if (served) {
+        ZF_LOGI("[GET] %s is not modified, served from resource cache.", url);
+    }
+    return served;
+}
+
+void UtoolResourceCacheInvalidate(const char *baseUrl)
+{
+    if (baseUrl == NULL) {
+        return;
+    }
+
+    pthread_mutex_lock(&g_UtoolResourceCacheMutex);
+    UtoolResourceCacheRemove(baseUrl, NULL);
+    pthread_mutex_unlock(&g_UtoolResourceCacheMutex);
+}
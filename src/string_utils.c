@@ -456,7 +456,7 @@ char *UtoolStringTokens(char *source, const char *delimiters, char **nextToken)
 
     size_t head = strspn(source, delimiters);
     /** if all chars are contained in delimiters */
-    if (strlen(source) == head) {
+    if (source[head] == '\0') {
         return NULL;
     }
 
@@ -464,7 +464,8 @@ char *UtoolStringTokens(char *source, const char *delimiters, char **nextToken)
     size_t tokenLen = strcspn(token, delimiters);
     size_t nextTokenOffset = tokenLen;
 
-    if (strlen(token) > tokenLen) {
+    /** token is followed by a delimiter, no need to scan the rest of source */
+    if (token[tokenLen] != '\0') {
         *(token + tokenLen) = '\0';
         nextTokenOffset++;
     }
@@ -0,0 +1,410 @@
+/*
+* Copyright © xFusion Digital Technologies Co., Ltd. 2012-2018. All rights reserved.
+* Description: HTTP trace file in HAR format & request timings
+* Author:
+* Create: 2019-06-16
+* Notes:
+*/
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+#include <pthread.h>
+#include "trace.h"
+#include "cJSON.h"
+#include "commons.h"
+#include "constants.h"
+#include "string_utils.h"
+#include "utool.h"
+#include "zf_log.h"
+
+#define TRACE_HAR_VERSION "1.2"
+#define TRACE_MASKED_VALUE "******"
+#define TRACE_HAR_HEAD "{\"log\":{\"version\":\"" TRACE_HAR_VERSION "\",\"creator\":{\"name\":\"utool\",\"version\":\"" \
+                       UTOOL_VERSION "\"},\"entries\":[\n"
+#define TRACE_HAR_TAIL "\n]}}\n"
+
+/**
+ * timing phases of a finished request in seconds, all phases are 0 for a reused connection's DNS/Connect/TLS.
+ */
+typedef struct _UtoolRequestTimings {
+    double dns;
+    double connect;
+    double tls;
+    double send;
+    double wait;
+    double receive;
+    double total;
+    double uploaded;
+    double downloaded;  /* response body bytes on the wire, compressed if content is encoded */
+    double decoded;     /* response body bytes after content decoding */
+    bool reused;
+} UtoolRequestTimings;
+
+/**
+ * timings aggregated for all requests of current command
+ */
+typedef struct _UtoolCommandTimings {
+    bool started;
+    struct timespec startTime;
+    int requests;
+    int reusedConnections;
+    UtoolRequestTimings sum;
+    double maxTotal;
+} UtoolCommandTimings;
+
+static FILE *g_UtoolTraceFP = NULL;
+static bool g_UtoolTraceHasEntry = false;
+static UtoolCommandTimings g_UtoolTimings = {0};
+static pthread_mutex_t g_UtoolTraceMutex = PTHREAD_MUTEX_INITIALIZER;
+
+int UtoolTraceOpen(const char *path)
+{
+    int ret = UTOOLE_OK;
+    pthread_mutex_lock(&g_UtoolTraceMutex);
+    if (g_UtoolTraceFP == NULL) {
+        g_UtoolTraceFP = fopen(path, "w");
+        if (g_UtoolTraceFP == NULL) {
+            ZF_LOGE("Failed to open trace file %s.", path);
+            ret = UTOOLE_FAILED_TO_WRITE_FILE;
+        } else {
+            g_UtoolTraceHasEntry = false;
+            fputs(TRACE_HAR_HEAD, g_UtoolTraceFP);
+            ZF_LOGI("Trace redfish requests to file %s.", path);
+        }
+    }
+    pthread_mutex_unlock(&g_UtoolTraceMutex);
+    return ret;
+}
+
+bool UtoolTraceEnabled(void)
+{
+    pthread_mutex_lock(&g_UtoolTraceMutex);
+    bool enabled = g_UtoolTraceFP != NULL;
+    pthread_mutex_unlock(&g_UtoolTraceMutex);
+    return enabled;
+}
+
+static bool UtoolTraceOrTimingsEnabled(void)
+{
+    pthread_mutex_lock(&g_UtoolTraceMutex);
+    bool enabled = g_UtoolTraceFP != NULL || g_UtoolTimings.started;
+    pthread_mutex_unlock(&g_UtoolTraceMutex);
+    return enabled;
+}
+
+void UtoolTraceMaskPassword(cJSON *node)
+{
+    cJSON *child = NULL;
+    cJSON_ArrayForEach(child, node) {
+        if (child->string != NULL && cJSON_IsString(child) && strstr(child->string, "Password") != NULL) {
+            cJSON_SetValuestring(child, TRACE_MASKED_VALUE);
+        } else if (cJSON_IsObject(child) || cJSON_IsArray(child)) {
+            UtoolTraceMaskPassword(child);
+        }
+    }
+}
+
+/**
+ * build HAR content (postData/content) object, JSON body is masked before recorded.
+ *
+ * @param text
+ * @param mimeType
+ * @param masked    whether password properties should be masked
+ * @return
+ */
+static cJSON *UtoolTraceBuildContent(const char *text, const char *mimeType, bool masked)
+{
+    cJSON *content = cJSON_CreateObject();
+    if (content == NULL) {
+        return NULL;
+    }
+
+    cJSON_AddNumberToObject(content, "size", text == NULL ? 0 : (double) strlen(text));
+    cJSON_AddStringToObject(content, "mimeType", mimeType == NULL ? "" : mimeType);
+    if (text == NULL) {
+        return content;
+    }
+
+    if (masked) {
+        cJSON *json = cJSON_Parse(text);
+        if (json != NULL) {
+            UtoolTraceMaskPassword(json);
+            char *maskedText = cJSON_PrintUnformatted(json);
+            cJSON_AddStringToObject(content, "text", maskedText == NULL ? "" : maskedText);
+            FREE_OBJ(maskedText)
+            FREE_CJSON(json)
+            return content;
+        }
+    }
+
+    cJSON_AddStringToObject(content, "text", text);
+    return content;
+}
+
+static double UtoolTraceGetInfo(CURL *curl, CURLINFO info)
+{
+    double value = 0;
+    if (curl_easy_getinfo(curl, info, &value) != CURLE_OK || value < 0) {
+        return 0;
+    }
+    return value;
+}
+
+static double UtoolTraceGetPhase(double end, double start)
+{
+    return end > start ? end - start : 0;
+}
+
+/**
+ * split curl accumulated timestamps into request phases
+ *
+ * @param curl
+ * @param response  could be NULL if request failed before response
+ * @param timings
+ */
+static void UtoolTraceGetTimings(CURL *curl, const UtoolCurlResponse *response, UtoolRequestTimings *timings)
+{
+    double nameLookup = UtoolTraceGetInfo(curl, CURLINFO_NAMELOOKUP_TIME);
+    double connect = UtoolTraceGetInfo(curl, CURLINFO_CONNECT_TIME);
+    double appConnect = UtoolTraceGetInfo(curl, CURLINFO_APPCONNECT_TIME);
+    double preTransfer = UtoolTraceGetInfo(curl, CURLINFO_PRETRANSFER_TIME);
+    double startTransfer = UtoolTraceGetInfo(curl, CURLINFO_STARTTRANSFER_TIME);
+    double connected = appConnect > connect ? appConnect : connect;
+
+    timings->total = UtoolTraceGetInfo(curl, CURLINFO_TOTAL_TIME);
+    timings->dns = nameLookup;
+    timings->connect = UtoolTraceGetPhase(connect, nameLookup);
+    timings->tls = UtoolTraceGetPhase(appConnect, connect);
+    timings->send = UtoolTraceGetPhase(preTransfer, connected);
+    timings->wait = UtoolTraceGetPhase(startTransfer, preTransfer);
+    timings->receive = UtoolTraceGetPhase(timings->total, startTransfer);
+    timings->uploaded = UtoolTraceGetInfo(curl, CURLINFO_SIZE_UPLOAD);
+    timings->downloaded = UtoolTraceGetInfo(curl, CURLINFO_SIZE_DOWNLOAD);
+    // downloaded file is written to disk directly, its decoded size is not counted
+    timings->decoded = response != NULL && response->content != NULL ? (double) response->length
+                                                                      : timings->downloaded;
+
+    // no new connection is made if connection is reused
+    long connects = 0;
+    curl_easy_getinfo(curl, CURLINFO_NUM_CONNECTS, &connects);
+    timings->reused = connects == 0;
+}
+
+static void UtoolTimingsAccumulate(const UtoolRequestTimings *timings)
+{
+    pthread_mutex_lock(&g_UtoolTraceMutex);
+    if (g_UtoolTimings.started) {
+        UtoolRequestTimings *sum = &(g_UtoolTimings.sum);
+        g_UtoolTimings.requests++;
+        g_UtoolTimings.reusedConnections += timings->reused ? 1 : 0;
+        sum->dns += timings->dns;
+        sum->connect += timings->connect;
+        sum->tls += timings->tls;
+        sum->send += timings->send;
+        sum->wait += timings->wait;
+        sum->receive += timings->receive;
+        sum->total += timings->total;
+        sum->uploaded += timings->uploaded;
+        sum->downloaded += timings->downloaded;
+        sum->decoded += timings->decoded;
+        if (timings->total > g_UtoolTimings.maxTotal) {
+            g_UtoolTimings.maxTotal = timings->total;
+        }
+    }
+    pthread_mutex_unlock(&g_UtoolTraceMutex);
+}
+
+void UtoolTraceRecord(CURL *curl, const char *httpMethod, const char *requestBody, const UtoolCurlResponse *response)
+{
+    if (curl == NULL || !UtoolTraceOrTimingsEnabled()) {
+        return;
+    }
+
+    UtoolRequestTimings *requestTimings = &(UtoolRequestTimings) {0};
+    UtoolTraceGetTimings(curl, response, requestTimings);
+    UtoolTimingsAccumulate(requestTimings);
+    if (!UtoolTraceEnabled()) {
+        return;
+    }
+
+    char *url = NULL;
+    curl_easy_getinfo(curl, CURLINFO_EFFECTIVE_URL, &url);
+    double total = requestTimings->total;
+
+    // started time is estimated from total time since request finished just now
+    char started[64] = {0};
+    time_t now = time(NULL) - (time_t) total;
+    struct tm tmStarted;
+#if defined(__MINGW32__)
+    if (gmtime_s(&tmStarted, &now) == 0) {
+#else
+    if (gmtime_r(&now, &tmStarted) != NULL) {
+#endif
+        strftime(started, sizeof(started), "%Y-%m-%dT%H:%M:%SZ", &tmStarted);
+    }
+
+    cJSON *entry = cJSON_CreateObject();
+    cJSON *request = cJSON_AddObjectToObject(entry, "request");
+    cJSON *resp = cJSON_AddObjectToObject(entry, "response");
+    cJSON *timings = cJSON_AddObjectToObject(entry, "timings");
+    if (entry == NULL || request == NULL || resp == NULL || timings == NULL) {
+        FREE_CJSON(entry)
+        return;
+    }
+
+    cJSON_AddStringToObject(entry, "startedDateTime", started);
+    cJSON_AddNumberToObject(entry, "time", total * 1000);
+
+    cJSON_AddStringToObject(request, "method", httpMethod);
+    cJSON_AddStringToObject(request, "url", url == NULL ? "" : url);
+    cJSON_AddStringToObject(request, "httpVersion", "HTTP/1.1");
+    cJSON_AddArrayToObject(request, "headers");
+    cJSON_AddArrayToObject(request, "queryString");
+    cJSON_AddNumberToObject(request, "headersSize", -1);
+    cJSON_AddNumberToObject(request, "bodySize", requestBody == NULL ? 0 : (double) strlen(requestBody));
+    if (requestBody != NULL) {
+        cJSON_AddItemToObject(request, "postData", UtoolTraceBuildContent(requestBody, "application/json", true));
+    }
+
+    const char *responseBody = response == NULL ? NULL : response->content;
+    cJSON_AddNumberToObject(resp, "status", response == NULL ? 0 : response->httpStatusCode);
+    cJSON_AddStringToObject(resp, "statusText", "");
+    cJSON_AddStringToObject(resp, "httpVersion", "HTTP/1.1");
+    cJSON_AddArrayToObject(resp, "headers");
+    cJSON *content = UtoolTraceBuildContent(responseBody, response == NULL ? NULL : response->contentType, false);
+    cJSON_AddItemToObject(resp, "content", content);
+    cJSON_AddStringToObject(resp, "redirectURL", "");
+    cJSON_AddNumberToObject(resp, "headersSize", -1);
+
+    // HAR bodySize is the received (maybe compressed) size, content compression is the bytes saved by encoding
+    cJSON_AddNumberToObject(resp, "bodySize", requestTimings->downloaded);
+    if (content != NULL && requestTimings->decoded > requestTimings->downloaded) {
+        cJSON_AddNumberToObject(content, "compression", requestTimings->decoded - requestTimings->downloaded);
+    }
+
+    // HAR connect time includes ssl time, -1 means not applicable
+    cJSON_AddNumberToObject(timings, "blocked", -1);
+    cJSON_AddNumberToObject(timings, "dns", requestTimings->reused ? -1 : requestTimings->dns * 1000);
+    cJSON_AddNumberToObject(timings, "connect", requestTimings->reused ? -1 :
+                                                (requestTimings->connect + requestTimings->tls) * 1000);
+    cJSON_AddNumberToObject(timings, "ssl", requestTimings->reused ? -1 : requestTimings->tls * 1000);
+    cJSON_AddNumberToObject(timings, "send", requestTimings->send * 1000);
+    cJSON_AddNumberToObject(timings, "wait", requestTimings->wait * 1000);
+    cJSON_AddNumberToObject(timings, "receive", requestTimings->receive * 1000);
+    cJSON_AddStringToObject(entry, "connection", requestTimings->reused ? "reused" : "new");
+
+    char *text = cJSON_PrintUnformatted(entry);
+    FREE_CJSON(entry)
+    if (text == NULL) {
+        return;
+    }
+
+    pthread_mutex_lock(&g_UtoolTraceMutex);
+    if (g_UtoolTraceFP != NULL) {
+        if (g_UtoolTraceHasEntry) {
+            fputs(",\n", g_UtoolTraceFP);
+        }
+        fputs(text, g_UtoolTraceFP);
+        g_UtoolTraceHasEntry = true;
+    }
+    pthread_mutex_unlock(&g_UtoolTraceMutex);
+    FREE_OBJ(text)
+}
+
+void UtoolTraceClose(void)
+{
+    pthread_mutex_lock(&g_UtoolTraceMutex);
+    if (g_UtoolTraceFP != NULL) {
+        fputs(TRACE_HAR_TAIL, g_UtoolTraceFP);
+        fclose(g_UtoolTraceFP);
+        g_UtoolTraceFP = NULL;
+    }
+    pthread_mutex_unlock(&g_UtoolTraceMutex);
+}
+
+void UtoolTimingsStart(void)
+{
+    pthread_mutex_lock(&g_UtoolTraceMutex);
+    memset(&g_UtoolTimings, 0, sizeof(g_UtoolTimings));
+    g_UtoolTimings.started = true;
+    clock_gettime(CLOCK_MONOTONIC, &(g_UtoolTimings.startTime));
+    pthread_mutex_unlock(&g_UtoolTraceMutex);
+}
+
+static double UtoolTimingsMillis(double seconds)
+{
+    // keep 3 decimals of milliseconds
+    return (double) ((long long) (seconds * 1000000 + 0.5)) / 1000;
+}
+
+/**
+ * build `Timings` output object from aggregated timings, caller should hold the mutex.
+ *
+ * @param elapsed   command elapsed seconds
+ * @return
+ */
+static cJSON *UtoolTimingsBuildOutput(double elapsed)
+{
+    cJSON *output = cJSON_CreateObject();
+    if (output == NULL) {
+        return NULL;
+    }
+
+    const UtoolRequestTimings *sum = &(g_UtoolTimings.sum);
+    int requests = g_UtoolTimings.requests;
+    cJSON_AddNumberToObject(output, "Requests", requests);
+    cJSON_AddNumberToObject(output, "ReusedConnections", g_UtoolTimings.reusedConnections);
+    cJSON_AddNumberToObject(output, "ElapsedMs", UtoolTimingsMillis(elapsed));
+    cJSON_AddNumberToObject(output, "DNSMs", UtoolTimingsMillis(sum->dns));
+    cJSON_AddNumberToObject(output, "ConnectMs", UtoolTimingsMillis(sum->connect));
+    cJSON_AddNumberToObject(output, "TLSMs", UtoolTimingsMillis(sum->tls));
+    cJSON_AddNumberToObject(output, "TTFBMs", UtoolTimingsMillis(sum->wait));
+    cJSON_AddNumberToObject(output, "ReceiveMs", UtoolTimingsMillis(sum->receive));
+    cJSON_AddNumberToObject(output, "TotalMs", UtoolTimingsMillis(sum->total));
+    cJSON_AddNumberToObject(output, "AvgTotalMs", UtoolTimingsMillis(requests > 0 ? sum->total / requests : 0));
+    cJSON_AddNumberToObject(output, "MaxTotalMs", UtoolTimingsMillis(g_UtoolTimings.maxTotal));
+    cJSON_AddNumberToObject(output, "BytesSent", sum->uploaded);
+    cJSON_AddNumberToObject(output, "BytesReceived", sum->downloaded);
+    cJSON_AddNumberToObject(output, "BytesDecoded", sum->decoded);
+    return output;
+}
+
+void UtoolTimingsFinish(char **output)
+{
+    cJSON *json = NULL;
+    cJSON *timings = NULL;
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    pthread_mutex_lock(&g_UtoolTraceMutex);
+    if (g_UtoolTimings.started) {
+        double elapsed = (double) (now.tv_sec - g_UtoolTimings.startTime.tv_sec) +
+                         (double) (now.tv_nsec - g_UtoolTimings.startTime.tv_nsec) / 1000000000;
+        timings = UtoolTimingsBuildOutput(elapsed);
+        g_UtoolTimings.started = false;
+    }
+    pthread_mutex_unlock(&g_UtoolTraceMutex);
+
+    if (timings == NULL || output == NULL || *output == NULL) {
+        goto DONE;
+    }
+
+    json = cJSON_Parse(*output);
+    if (!cJSON_IsObject(json)) {
+        goto DONE;
+    }
+
+    cJSON_AddItemToObject(json, "Timings", timings);
+    timings = NULL;
+
+    char *pretty = cJSON_Print(json);
+    if (pretty != NULL) {
+        FREE_OBJ(*output)
+        *output = pretty;
+    }
+
+DONE:
+    FREE_CJSON(timings)
+    FREE_CJSON(json)
+}
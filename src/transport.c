@@ -0,0 +1,442 @@
+/*
+* Copyright © xFusion Digital Technologies Co., Ltd. 2012-2018. All rights reserved.
+* Description: record & replay transport of redfish requests and IPMI commands
+* Author:
+* Create: 2019-06-16
+* Notes: record file is a JSON document, its entries are appended while requests finish like trace file.
+*/
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <limits.h>
+#include <time.h>
+#include <pthread.h>
+#include "transport.h"
+#include "trace.h"
+#include "cJSON.h"
+#include "commons.h"
+#include "constants.h"
+#include "string_utils.h"
+#include "utool.h"
+#include "zf_log.h"
+
+#define TRANSPORT_VERSION "1"
+#define TRANSPORT_HEAD "{\"Version\":\"" TRANSPORT_VERSION "\",\"Creator\":\"utool " UTOOL_VERSION "\",\"Entries\":[\n"
+#define TRANSPORT_TAIL "\n]}\n"
+#define TRANSPORT_ETAG "ETag"
+#define TRANSPORT_CONTENT_TYPE "Content-Type"
+#define TRANSPORT_CACHE_CONTROL "Cache-Control"
+
+/**
+ * a recorded request of replay file, strings are borrowed from the parsed replay file.
+ */
+typedef struct _UtoolTransportEntry {
+    const char *method;
+    const char *url;
+    int code;
+    long status;
+    const char *body;
+    const char *etag;
+    const char *contentType;
+    const char *cacheControl;
+    double elapsed;     /* seconds */
+    bool replayed;
+} UtoolTransportEntry;
+
+static FILE *g_UtoolTransportRecordFP = NULL;
+static bool g_UtoolTransportHasEntry = false;
+static cJSON *g_UtoolTransportReplayJson = NULL;
+static UtoolTransportEntry *g_UtoolTransportEntries = NULL;
+static int g_UtoolTransportEntryCount = 0;
+static bool g_UtoolTransportTimed = false;
+static pthread_mutex_t g_UtoolTransportMutex = PTHREAD_MUTEX_INITIALIZER;
+
+int UtoolTransportRecordOpen(const char *path)
+{
+    int ret = UTOOLE_OK;
+    pthread_mutex_lock(&g_UtoolTransportMutex);
+    if (g_UtoolTransportRecordFP == NULL) {
+        g_UtoolTransportRecordFP = fopen(path, "w");
+        if (g_UtoolTransportRecordFP == NULL) {
+            ZF_LOGE("Failed to open record file %s.", path);
+            ret = UTOOLE_FAILED_TO_WRITE_FILE;
+        } else {
+            g_UtoolTransportHasEntry = false;
+            fputs(TRANSPORT_HEAD, g_UtoolTransportRecordFP);
+            ZF_LOGI("Record requests to file %s.", path);
+        }
+    }
+    pthread_mutex_unlock(&g_UtoolTransportMutex);
+    return ret;
+}
+
+static bool UtoolTransportRecording(void)
+{
+    pthread_mutex_lock(&g_UtoolTransportMutex);
+    bool recording = g_UtoolTransportRecordFP != NULL;
+    pthread_mutex_unlock(&g_UtoolTransportMutex);
+    return recording;
+}
+
+/**
+ * read whole file into a NULL terminated string
+ *
+ * @param path
+ * @return file content, NULL if failed
+ */
+static char *UtoolTransportReadFile(const char *path)
+{
+    char *content = NULL;
+    char realFilePath[PATH_MAX] = {0};
+    if (UtoolFileRealpath(path, realFilePath, PATH_MAX) == NULL) {
+        return NULL;
+    }
+
+    FILE *fp = fopen(realFilePath, "rb");
+    if (fp == NULL) {
+        return NULL;
+    }
+
+    if (fseek(fp, 0L, SEEK_END) != 0) {
+        goto DONE;
+    }
+    long size = ftell(fp);
+    if (size < 0 || fseek(fp, 0L, SEEK_SET) != 0) {
+        goto DONE;
+    }
+
+    content = (char *) calloc((size_t) size + 1, sizeof(char));
+    if (content != NULL && fread(content, sizeof(char), (size_t) size, fp) != (size_t) size) {
+        FREE_OBJ(content)
+    }
+
+DONE:
+    fclose(fp);
+    return content;
+}
+
+static const char *UtoolTransportGetString(const cJSON *node, const char *name)
+{
+    cJSON *child = cJSON_GetObjectItem(node, name);
+    return cJSON_IsString(child) ? child->valuestring : NULL;
+}
+
+static double UtoolTransportGetNumber(const cJSON *node, const char *name)
+{
+    cJSON *child = cJSON_GetObjectItem(node, name);
+    return cJSON_IsNumber(child) ? child->valuedouble : 0;
+}
+
+int UtoolTransportReplayOpen(const char *path, bool timed)
+{
+    int ret = UTOOLE_OK;
+    cJSON *json = NULL;
+    UtoolTransportEntry *entries = NULL;
+
+    char *content = UtoolTransportReadFile(path);
+    if (content == NULL) {
+        ZF_LOGE("Failed to read replay file %s.", path);
+        ret = UTOOLE_ILLEGAL_REPLAY_FILE;
+        goto DONE;
+    }
+
+    json = cJSON_Parse(content);
+    cJSON *entriesNode = cJSON_GetObjectItem(json, "Entries");
+    if (!cJSON_IsArray(entriesNode)) {
+        ZF_LOGE("Replay file %s is not well formed.", path);
+        ret = UTOOLE_ILLEGAL_REPLAY_FILE;
+        goto DONE;
+    }
+
+    int count = cJSON_GetArraySize(entriesNode);
+    entries = (UtoolTransportEntry *) calloc(count > 0 ? count : 1, sizeof(UtoolTransportEntry));
+    if (entries == NULL) {
+        ret = UTOOLE_INTERNAL;
+        goto DONE;
+    }
+
+    int idx = 0;
+    cJSON *node = NULL;
+    cJSON_ArrayForEach(node, entriesNode) {
+        UtoolTransportEntry *entry = entries + idx;
+        cJSON *headers = cJSON_GetObjectItem(node, "ResponseHeaders");
+        entry->method = UtoolTransportGetString(node, "Method");
+        entry->url = UtoolTransportGetString(node, "URL");
+        if (entry->method == NULL || entry->url == NULL) {
+            ZF_LOGE("Entry %d of replay file %s has no method or URL.", idx, path);
+            ret = UTOOLE_ILLEGAL_REPLAY_FILE;
+            goto DONE;
+        }
+        entry->code = (int) UtoolTransportGetNumber(node, "Code");
+        entry->status = (long) UtoolTransportGetNumber(node, "Status");
+        entry->body = UtoolTransportGetString(node, "ResponseBody");
+        entry->etag = UtoolTransportGetString(headers, TRANSPORT_ETAG);
+        entry->contentType = UtoolTransportGetString(headers, TRANSPORT_CONTENT_TYPE);
+        entry->cacheControl = UtoolTransportGetString(headers, TRANSPORT_CACHE_CONTROL);
+        entry->elapsed = UtoolTransportGetNumber(node, "TimeMs") / 1000;
+        idx++;
+    }
+
+    pthread_mutex_lock(&g_UtoolTransportMutex);
+    FREE_CJSON(g_UtoolTransportReplayJson)
+    FREE_OBJ(g_UtoolTransportEntries)
+    g_UtoolTransportReplayJson = json;
+    g_UtoolTransportEntries = entries;
+    g_UtoolTransportEntryCount = count;
+    g_UtoolTransportTimed = timed;
+    pthread_mutex_unlock(&g_UtoolTransportMutex);
+    json = NULL;
+    entries = NULL;
+    ZF_LOGI("Replay %d requests from file %s%s.", count, path, timed ? " with recorded timings" : "");
+
+DONE:
+    FREE_OBJ(entries)
+    FREE_CJSON(json)
+    FREE_OBJ(content)
+    return ret;
+}
+
+bool UtoolTransportReplaying(void)
+{
+    pthread_mutex_lock(&g_UtoolTransportMutex);
+    bool replaying = g_UtoolTransportEntries != NULL;
+    pthread_mutex_unlock(&g_UtoolTransportMutex);
+    return replaying;
+}
+
+bool UtoolTransportTimed(void)
+{
+    pthread_mutex_lock(&g_UtoolTransportMutex);
+    bool timed = g_UtoolTransportEntries != NULL && g_UtoolTransportTimed;
+    pthread_mutex_unlock(&g_UtoolTransportMutex);
+    return timed;
+}
+
+/**
+ * append an entry to record file
+ *
+ * @param entry
+ */
+static void UtoolTransportWriteEntry(cJSON *entry)
+{
+    char *text = cJSON_PrintUnformatted(entry);
+    if (text == NULL) {
+        return;
+    }
+
+    pthread_mutex_lock(&g_UtoolTransportMutex);
+    if (g_UtoolTransportRecordFP != NULL) {
+        if (g_UtoolTransportHasEntry) {
+            fputs(",\n", g_UtoolTransportRecordFP);
+        }
+        fputs(text, g_UtoolTransportRecordFP);
+        g_UtoolTransportHasEntry = true;
+    }
+    pthread_mutex_unlock(&g_UtoolTransportMutex);
+    FREE_OBJ(text)
+}
+
+static void UtoolTransportAddString(cJSON *node, const char *name, const char *value)
+{
+    if (value != NULL) {
+        cJSON_AddStringToObject(node, name, value);
+    }
+}
+
+void UtoolTransportRecord(CURL *curl, const char *httpMethod, const char *resourceURL,
+                          const struct curl_slist *headers, const char *requestBody, int code,
+                          const UtoolCurlResponse *response)
+{
+    if (!UtoolTransportRecording()) {
+        return;
+    }
+
+    double total = 0;
+    if (curl == NULL || curl_easy_getinfo(curl, CURLINFO_TOTAL_TIME, &total) != CURLE_OK || total < 0) {
+        total = 0;
+    }
+
+    cJSON *entry = cJSON_CreateObject();
+    cJSON *requestHeaders = cJSON_AddArrayToObject(entry, "RequestHeaders");
+    cJSON *responseHeaders = cJSON_CreateObject();
+    if (entry == NULL || requestHeaders == NULL || responseHeaders == NULL) {
+        FREE_CJSON(responseHeaders)
+        goto DONE;
+    }
+
+    cJSON_AddStringToObject(entry, "Method", httpMethod);
+    cJSON_AddStringToObject(entry, "URL", resourceURL);
+    for (const struct curl_slist *header = headers; header != NULL; header = header->next) {
+        cJSON_AddItemToArray(requestHeaders, cJSON_CreateString(header->data));
+    }
+
+    if (requestBody != NULL) {
+        cJSON *body = cJSON_Parse(requestBody);
+        if (body != NULL) {
+            UtoolTraceMaskPassword(body);
+            cJSON_AddItemToObject(entry, "RequestBody", body);
+        }
+    }
+
+    cJSON_AddNumberToObject(entry, "Code", code);
+    cJSON_AddNumberToObject(entry, "Status", response == NULL ? 0 : response->httpStatusCode);
+    if (response != NULL) {
+        UtoolTransportAddString(responseHeaders, TRANSPORT_ETAG, response->etag);
+        UtoolTransportAddString(responseHeaders, TRANSPORT_CONTENT_TYPE, response->contentType);
+        UtoolTransportAddString(responseHeaders, TRANSPORT_CACHE_CONTROL, response->cacheControl);
+        // downloaded file is written to disk directly, its content is not recorded
+        UtoolTransportAddString(entry, "ResponseBody", response->content);
+    }
+    cJSON_AddItemToObject(entry, "ResponseHeaders", responseHeaders);
+    cJSON_AddNumberToObject(entry, "TimeMs", total * 1000);
+
+    UtoolTransportWriteEntry(entry);
+
+DONE:
+    FREE_CJSON(entry)
+}
+
+void UtoolTransportRecordCommand(const char *command, int exitCode, const char *output, double elapsed)
+{
+    if (!UtoolTransportRecording()) {
+        return;
+    }
+
+    cJSON *entry = cJSON_CreateObject();
+    if (entry == NULL) {
+        return;
+    }
+
+    cJSON_AddStringToObject(entry, "Method", TRANSPORT_METHOD_IPMI);
+    cJSON_AddStringToObject(entry, "URL", command);
+    cJSON_AddNumberToObject(entry, "Code", exitCode);
+    UtoolTransportAddString(entry, "ResponseBody", output);
+    cJSON_AddNumberToObject(entry, "TimeMs", elapsed * 1000);
+
+    UtoolTransportWriteEntry(entry);
+    FREE_CJSON(entry)
+}
+
+/**
+ * take next entry of the key, the last one is taken again once all entries of the key are replayed.
+ * caller should hold the mutex.
+ *
+ * @param method
+ * @param url
+ * @return NULL if key is not recorded
+ */
+static UtoolTransportEntry *UtoolTransportTake(const char *method, const char *url)
+{
+    UtoolTransportEntry *last = NULL;
+    for (int idx = 0; idx < g_UtoolTransportEntryCount; idx++) {
+        UtoolTransportEntry *entry = g_UtoolTransportEntries + idx;
+        if (UtoolStringEquals(entry->method, method) && UtoolStringEquals(entry->url, url)) {
+            if (!entry->replayed) {
+                entry->replayed = true;
+                return entry;
+            }
+            last = entry;
+        }
+    }
+
+    if (last == NULL) {
+        ZF_LOGE("[%s] %s is not recorded in replay file.", method, url);
+    }
+    return last;
+}
+
+static char *UtoolTransportDup(const char *value)
+{
+    return value == NULL ? NULL : UtoolStringNDup(value, strlen(value));
+}
+
+int UtoolTransportReplay(const char *httpMethod, const char *resourceURL, UtoolCurlResponse *response,
+                         double *elapsed)
+{
+    int ret = UTOOLE_NOT_RECORDED;
+    *elapsed = 0;
+
+    pthread_mutex_lock(&g_UtoolTransportMutex);
+    const UtoolTransportEntry *entry = UtoolTransportTake(httpMethod, resourceURL);
+    if (entry == NULL) {
+        goto DONE;
+    }
+
+    UtoolFreeCurlResponse(response);
+    response->httpStatusCode = entry->status;
+    response->etag = UtoolTransportDup(entry->etag);
+    response->contentType = UtoolTransportDup(entry->contentType);
+    response->cacheControl = UtoolTransportDup(entry->cacheControl);
+    if (entry->body != NULL) {
+        response->content = UtoolTransportDup(entry->body);
+        if (response->content == NULL) {
+            ret = UTOOLE_INTERNAL;
+            goto DONE;
+        }
+        response->length = strlen(response->content);
+        response->size = response->length;
+        response->contentLength = (long) response->length;
+    }
+
+    ZF_LOGI("[%s] %s is replayed.", httpMethod, resourceURL);
+    *elapsed = entry->elapsed;
+    ret = entry->code;
+
+DONE:
+    pthread_mutex_unlock(&g_UtoolTransportMutex);
+    return ret;
+}
+
+char *UtoolTransportReplayCommand(const char *command, int *exitCode)
+{
+    char *output = NULL;
+    double elapsed = 0;
+    *exitCode = UTOOLE_NOT_RECORDED;
+
+    pthread_mutex_lock(&g_UtoolTransportMutex);
+    const UtoolTransportEntry *entry = UtoolTransportTake(TRANSPORT_METHOD_IPMI, command);
+    if (entry != NULL) {
+        output = UtoolTransportDup(entry->body == NULL ? "" : entry->body);
+        *exitCode = entry->code;
+        elapsed = entry->elapsed;
+    }
+    pthread_mutex_unlock(&g_UtoolTransportMutex);
+
+    UtoolTransportWait(elapsed);
+    return output;
+}
+
+void UtoolTransportWait(double elapsed)
+{
+    if (elapsed <= 0 || !UtoolTransportTimed()) {
+        return;
+    }
+
+    struct timespec duration = {
+            .tv_sec = (time_t) elapsed,
+            .tv_nsec = (long) ((elapsed - (double) (time_t) elapsed) * 1000000000),
+    };
+    nanosleep(&duration, NULL);
+}
+
+double UtoolTransportClock(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double) now.tv_sec + (double) now.tv_nsec / 1000000000;
+}
+
+void UtoolTransportClose(void)
+{
+    pthread_mutex_lock(&g_UtoolTransportMutex);
+    if (g_UtoolTransportRecordFP != NULL) {
+        fputs(TRANSPORT_TAIL, g_UtoolTransportRecordFP);
+        fclose(g_UtoolTransportRecordFP);
+        g_UtoolTransportRecordFP = NULL;
+    }
+    FREE_CJSON(g_UtoolTransportReplayJson)
+    FREE_OBJ(g_UtoolTransportEntries)
+    g_UtoolTransportEntryCount = 0;
+    g_UtoolTransportTimed = false;
+    pthread_mutex_unlock(&g_UtoolTransportMutex);
+}
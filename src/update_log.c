@@ -0,0 +1,287 @@
+/*
+* Copyright © xFusion Digital Technologies Co., Ltd. 2012-2018. All rights reserved.
+* Description: structured firmware update log written by a background writer thread
+* Author:
+* Create: 2019-06-16
+* Notes:
+*/
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+#if defined(__MINGW32__)
+#include <io.h>
+#endif
+#include "update_log.h"
+#include "commons.h"
+#include "zf_log.h"
+
+#define UPDATE_LOG_TIME_FORMAT "%Y-%m-%dT%H%M%S%z"
+#define UPDATE_LOG_INIT_BUFFER_SIZE 4096
+#define UPDATE_LOG_ENTRY_OVERHEAD 128
+
+/**
+ * make sure there is room for size more bytes in pending buffer, caller should hold the mutex.
+ *
+ * @param log
+ * @param size
+ * @return
+ */
+static bool UtoolUpdateLogReserve(UtoolUpdateLog *log, size_t size)
+{
+    if (log->pendingLen + size <= log->pendingCap) {
+        return true;
+    }
+
+    size_t capacity = log->pendingCap > 0 ? log->pendingCap : UPDATE_LOG_INIT_BUFFER_SIZE;
+    while (capacity < log->pendingLen + size) {
+        capacity *= 2;
+    }
+
+    char *buffer = (char *) realloc(log->pending, capacity);
+    if (buffer == NULL) {
+        return false;
+    }
+    log->pending = buffer;
+    log->pendingCap = capacity;
+    return true;
+}
+
+/**
+ * append a JSON string body of text to buffer, worst case takes 6 bytes per char.
+ *
+ * @param cursor
+ * @param text
+ * @param len
+ * @return cursor after the appended content
+ */
+static char *UtoolUpdateLogEscape(char *cursor, const char *text, size_t len)
+{
+    static const char hex[] = "0123456789abcdef";
+    for (size_t idx = 0; idx < len; idx++) {
+        unsigned char ch = (unsigned char) text[idx];
+        if (ch == '"' || ch == '\\') {
+            *cursor++ = '\\';
+            *cursor++ = (char) ch;
+        } else if (ch == '\n') {
+            *cursor++ = '\\';
+            *cursor++ = 'n';
+        } else if (ch == '\r') {
+            *cursor++ = '\\';
+            *cursor++ = 'r';
+        } else if (ch == '\t') {
+            *cursor++ = '\\';
+            *cursor++ = 't';
+        } else if (ch < 0x20) {
+            memcpy(cursor, "\\u00", 4);
+            cursor += 4;
+            *cursor++ = hex[ch >> 4];
+            *cursor++ = hex[ch & 0x0F];
+        } else {
+            *cursor++ = (char) ch;
+        }
+    }
+    return cursor;
+}
+
+static char *UtoolUpdateLogCopy(char *cursor, const char *text)
+{
+    size_t len = strlen(text);
+    memcpy(cursor, text, len);
+    return cursor + len;
+}
+
+static void UtoolUpdateLogAppendEntry(UtoolUpdateLog *log, const char *stage, const char *state, const char *note,
+                                      size_t noteLen, bool noteEscaped)
+{
+    if (log == NULL) {
+        return;
+    }
+
+    stage = stage == NULL ? "" : stage;
+    state = state == NULL ? "" : state;
+    if (note == NULL) {
+        note = "";
+        noteLen = 0;
+    }
+
+    char now[64] = {0};
+    time_t timestamp = time(NULL);
+    struct tm tmNow;
+    if (UtoolLocalTime(timestamp, &tmNow)) {
+        strftime(now, sizeof(now), UPDATE_LOG_TIME_FORMAT, &tmNow);
+    }
+
+    size_t stageLen = strlen(stage);
+    size_t stateLen = strlen(state);
+    size_t worst = UPDATE_LOG_ENTRY_OVERHEAD + strlen(now) + (stageLen + stateLen + noteLen) * 6;
+
+    pthread_mutex_lock(&(log->mutex));
+    if (!UtoolUpdateLogReserve(log, worst)) {
+        pthread_mutex_unlock(&(log->mutex));
+        ZF_LOGW("Failed to allocate memory for update log entry, entry is dropped.");
+        return;
+    }
+
+    char *cursor = log->pending + log->pendingLen;
+    cursor = UtoolUpdateLogCopy(cursor, "{\"Time\":\"");
+    cursor = UtoolUpdateLogCopy(cursor, now);
+    cursor = UtoolUpdateLogCopy(cursor, "\",\"Stage\":\"");
+    cursor = UtoolUpdateLogEscape(cursor, stage, stageLen);
+    cursor = UtoolUpdateLogCopy(cursor, "\",\"State\":\"");
+    cursor = UtoolUpdateLogEscape(cursor, state, stateLen);
+    cursor = UtoolUpdateLogCopy(cursor, "\",\"Note\":\"");
+    if (noteEscaped) {
+        memcpy(cursor, note, noteLen);
+        cursor += noteLen;
+    } else {
+        cursor = UtoolUpdateLogEscape(cursor, note, noteLen);
+    }
+    cursor = UtoolUpdateLogCopy(cursor, "\"}\n");
+    log->pendingLen = (size_t) (cursor - log->pending);
+
+    pthread_cond_signal(&(log->wakeup));
+    pthread_mutex_unlock(&(log->mutex));
+}
+
+static void UtoolUpdateLogFlushToDisk(FILE *fp)
+{
+    if (fflush(fp) != 0) {
+        ZF_LOGW("Failed to flush update log file.");
+        return;
+    }
+#if defined(__MINGW32__)
+    if (_commit(fileno(fp)) != 0) {
+#else
+    if (fsync(fileno(fp)) != 0) {
+#endif
+        ZF_LOGW("Failed to sync update log file to disk.");
+    }
+}
+
+/**
+ * writer thread, takes over pending buffer and writes it outside the mutex, so producers never wait for disk.
+ *
+ * @param arg   update log
+ * @return
+ */
+static void *UtoolUpdateLogWriter(void *arg)
+{
+    UtoolUpdateLog *log = (UtoolUpdateLog *) arg;
+
+    pthread_mutex_lock(&(log->mutex));
+    while (true) {
+        while (log->pendingLen == 0 && log->syncDone == log->syncRequested && !log->closing) {
+            pthread_cond_wait(&(log->wakeup), &(log->mutex));
+        }
+
+        char *entries = log->pending;
+        size_t entriesLen = log->pendingLen;
+        size_t entriesCap = log->pendingCap;
+        log->pending = log->writing;
+        log->pendingCap = log->writingCap;
+        log->pendingLen = 0;
+        log->writing = entries;
+        log->writingCap = entriesCap;
+
+        unsigned long syncTarget = log->syncRequested;
+        bool closing = log->closing;
+        pthread_mutex_unlock(&(log->mutex));
+
+        if (entriesLen > 0 && fwrite(entries, 1, entriesLen, log->fp) != entriesLen) {
+            ZF_LOGW("Failed to write update log file.");
+        }
+
+        // only writer thread updates syncDone, it is safe to read it without lock
+        if (syncTarget != log->syncDone || closing) {
+            UtoolUpdateLogFlushToDisk(log->fp);
+        }
+
+        pthread_mutex_lock(&(log->mutex));
+        log->syncDone = syncTarget;
+        pthread_cond_broadcast(&(log->synced));
+        if (closing && log->pendingLen == 0) {
+            break;
+        }
+    }
+    pthread_mutex_unlock(&(log->mutex));
+    return NULL;
+}
+
+UtoolUpdateLog *UtoolUpdateLogOpen(const char *path)
+{
+    UtoolUpdateLog *log = (UtoolUpdateLog *) calloc(1, sizeof(UtoolUpdateLog));
+    if (log == NULL) {
+        return NULL;
+    }
+
+    log->fp = fopen(path, "a");
+    if (log->fp == NULL) {
+        ZF_LOGW("Failed to open update log file %s.", path);
+        free(log);
+        return NULL;
+    }
+
+    pthread_mutex_init(&(log->mutex), NULL);
+    pthread_cond_init(&(log->wakeup), NULL);
+    pthread_cond_init(&(log->synced), NULL);
+    if (pthread_create(&(log->writer), NULL, UtoolUpdateLogWriter, log) != 0) {
+        ZF_LOGW("Failed to start update log writer thread.");
+        pthread_cond_destroy(&(log->synced));
+        pthread_cond_destroy(&(log->wakeup));
+        pthread_mutex_destroy(&(log->mutex));
+        fclose(log->fp);
+        free(log);
+        return NULL;
+    }
+
+    return log;
+}
+
+void UtoolUpdateLogAppend(UtoolUpdateLog *log, const char *stage, const char *state, const char *note)
+{
+    UtoolUpdateLogAppendEntry(log, stage, state, note, note == NULL ? 0 : strlen(note), false);
+}
+
+void UtoolUpdateLogAppendJsonNote(UtoolUpdateLog *log, const char *stage, const char *state, const char *note,
+                                  size_t noteLen)
+{
+    UtoolUpdateLogAppendEntry(log, stage, state, note, noteLen, true);
+}
+
+void UtoolUpdateLogSync(UtoolUpdateLog *log)
+{
+    if (log == NULL) {
+        return;
+    }
+
+    pthread_mutex_lock(&(log->mutex));
+    unsigned long ticket = ++log->syncRequested;
+    pthread_cond_signal(&(log->wakeup));
+    while (log->syncDone < ticket) {
+        pthread_cond_wait(&(log->synced), &(log->mutex));
+    }
+    pthread_mutex_unlock(&(log->mutex));
+}
+
+void UtoolUpdateLogClose(UtoolUpdateLog *log)
+{
+    if (log == NULL) {
+        return;
+    }
+
+    pthread_mutex_lock(&(log->mutex));
+    log->closing = true;
+    pthread_cond_signal(&(log->wakeup));
+    pthread_mutex_unlock(&(log->mutex));
+    pthread_join(log->writer, NULL);
+
+    fclose(log->fp);
+    pthread_cond_destroy(&(log->synced));
+    pthread_cond_destroy(&(log->wakeup));
+    pthread_mutex_destroy(&(log->mutex));
+    free(log->pending);
+    free(log->writing);
+    free(log);
+}
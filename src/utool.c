@@ -19,6 +19,9 @@
 #include "command-helps.h"
 #include "command-interfaces.h"
 #include "log.h"
+#include "trace.h"
+#include "transport.h"
+#include "resource_cache.h"
 #include "zf_log.h"
 #include <pthread.h>
 #include <stdbool.h>
@@ -65,6 +68,7 @@ UtoolCommand g_UtoolCommands[] = {
         {.name = "gethealthevent", .pFuncExecute = UtoolCmdGetHealthEvent, .type = GET},
         {.name = "geteventlog", .pFuncExecute = UtoolCmdGetEventLog, .type = GET},
         {.name = "getpcie", .pFuncExecute = UtoolCmdGetPCIe, .type = GET},
+        {.name = "getinventory", .pFuncExecute = UtoolCmdGetInventory, .type = GET},
         {.name = "gettime", .pFuncExecute = UtoolCmdGetTime, .type = GET},
 
         {.name = "adduser", .pFuncExecute = UtoolCmdAddUser, .type = SET},
@@ -84,6 +88,7 @@ UtoolCommand g_UtoolCommands[] = {
         {.name = "settrapcom", .pFuncExecute = UtoolCmdSetSNMPTrapNotification, .type = SET},
         {.name = "settrapdest", .pFuncExecute = UtoolCmdSetSNMPTrapNotificationDest, .type = SET},
         {.name = "fwupdate", .pFuncExecute = UtoolCmdUpdateOutbandFirmware, .type = SET},
+        {.name = "fwrollout", .pFuncExecute = UtoolCmdRolloutOutbandFirmware, .type = SET},
         {.name = "collect", .pFuncExecute = UtoolCmdCollectAllBoardInfo, .type = SET},
         {.name = "locateserver", .pFuncExecute = UtoolCmdSetIndicatorLED, .type = SET},
         {.name = "setvnc", .pFuncExecute = UtoolCmdSetVNCSettings, .type = SET},
@@ -99,6 +104,7 @@ UtoolCommand g_UtoolCommands[] = {
         {.name = "getipmiwhitelist", .pFuncExecute = UtoolCmdGetIpmiWhitelist, .type = GET},
         {.name = "setipmiwhitelist", .pFuncExecute = UtoolCmdSetIpmiWhitelist, .type = SET},
         {.name = "getoverallpowerstatus", .pFuncExecute = UtoolCmdGetOverallPowerStatus, .type = GET},
+        {.name = "exporter", .pFuncExecute = UtoolCmdExporter, .type = GET},
 
 
         // Test purpose start
@@ -139,6 +145,19 @@ static int utool_parse_command_option(UtoolCommandOption *commandOption, int arg
                         UtoolShowVendorOptionCallback, 0, 0),
             OPT_BOOLEAN('q', "quiet", &(commandOption->quiet),
                         "do not output Non-json content."),
+            OPT_STRING (0, "trace-file", &(commandOption->traceFile),
+                        "record redfish requests & responses into file in HAR format.",
+                        NULL, 0, 0),
+            OPT_BOOLEAN(0, "timings", &(commandOption->timings),
+                        "append timings of redfish requests to output."),
+            OPT_STRING (0, "record", &(commandOption->recordFile),
+                        "record redfish requests & IPMI commands into file for replay.",
+                        NULL, 0, 0),
+            OPT_STRING (0, "replay", &(commandOption->replayFile),
+                        "serve redfish requests & IPMI commands from recorded file, no network is accessed.",
+                        NULL, 0, 0),
+            OPT_BOOLEAN(0, "replay-timed", &(commandOption->replayTimed),
+                        "replayed requests take their recorded time, as fast as possible by default."),
             OPT_GROUP  ("Server Authentication Options:"),
             OPT_STRING ('H', "host", &(commandOption->host),
                         "domain name, IPv4 address, or [IPv6 address].",
@@ -220,6 +239,7 @@ static int initialize(char **result)
             // init log file
             if (ENABLE_DEBUG == 1) {
                 zf_log_set_output_level(ZF_LOG_DEBUG);
+                UtoolSetLogSampleRate(ZF_LOG_DEBUG, LOG_DEBUG_SAMPLE_RATE);
             } else {
                 zf_log_set_output_level(ZF_LOG_INFO);
             }
@@ -302,6 +322,31 @@ int utool_main(int argc, char *argv[], char **result)
     }
     ZF_LOGI("Parse command option done.");
 
+    if (commandOption->traceFile != NULL) {
+        ret = UtoolTraceOpen(commandOption->traceFile);
+        if (ret != UTOOLE_OK) {
+            goto FAILURE;
+        }
+    }
+
+    if (commandOption->timings) {
+        UtoolTimingsStart();
+    }
+
+    if (commandOption->recordFile != NULL) {
+        ret = UtoolTransportRecordOpen(commandOption->recordFile);
+        if (ret != UTOOLE_OK) {
+            goto FAILURE;
+        }
+    }
+
+    if (commandOption->replayFile != NULL) {
+        ret = UtoolTransportReplayOpen(commandOption->replayFile, commandOption->replayTimed);
+        if (ret != UTOOLE_OK) {
+            goto FAILURE;
+        }
+    }
+
     /**
      * 2. try to find command function
      */
@@ -323,6 +368,9 @@ int utool_main(int argc, char *argv[], char **result)
     }
 
     if (targetCommand) {
+        // resources are only cached for read only commands, they are changed by other commands
+        UtoolResourceCacheEnable(targetCommand->type == GET);
+
         ZF_LOGI("A command handler matched for %s found, try to execute now.", commandName);
         ret = targetCommand->pFuncExecute(commandOption, result);
         if (ret != UTOOLE_OK) {
@@ -357,8 +405,14 @@ FAILURE:
     goto DONE;
 
 DONE:
+    if (ret == UTOOLE_OK) {
+        UtoolTimingsFinish(result);
+    }
+    UtoolTraceClose();
+    UtoolTransportClose();
     if (ret != UTOOLE_CREATE_LOG_FILE) {
-        ZF_LOGI("Command processed, return code is: %d, result is: %s", ret, *result);
+        ZF_LOGI("Command processed, return code is: %d.", ret);
+        UTOOL_LOG_BODY(ZF_LOG_DEBUG, "Command result", *result);
     }
     return ret;
 }
@@ -0,0 +1,588 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+#
+# Copyright © xFusion Digital Technologies Co., Ltd. 2012-2018. All rights reserved.
+# Description: mock iBMC redfish service for offline benchmarking & regression testing
+# Author:
+# Create: 2019-06-16
+# Notes: python3 standard library only, TLS certificate is generated through openssl command if not provided
+#
+"""
+Mock iBMC redfish service.
+
+Resources are loaded from fixture files, each fixture is a JSON object which maps resource path to resource, e.g.
+{"/redfish/v1/Systems/1": {...}}. Resources could be changed through PATCH/POST/DELETE while the service runs, and are
+restored when fixtures are reloaded.
+
+Besides redfish resources, the service exposes:
+
+    GET    /mock/stats      counters since start or last reset
+    DELETE /mock/stats      reset counters
+    POST   /mock/reload     reload fixtures, all changes are dropped
+"""
+import argparse
+import base64
+import gzip
+import json
+import os
+import random
+import socket
+import socketserver
+import ssl
+import subprocess
+import sys
+import threading
+import time
+import zlib
+from http.server import BaseHTTPRequestHandler, HTTPServer
+from urllib.parse import parse_qs, unquote, urlsplit
+
+ROOT = "/redfish/v1"
+MOCK_ROOT = "/mock"
+SUCCESS_MESSAGE = {
+    "@Message.ExtendedInfo": [{
+        "@odata.type": "#Message.v1_0_0.Message",
+        "MessageId": "Base.1.0.Success",
+        "RelatedProperties": [],
+        "Message": "Successfully Completed Request",
+        "MessageArgs": [],
+        "Severity": "OK",
+        "Resolution": "None"
+    }]
+}
+
+
+def build_error(status, message_id, message, resolution="None"):
+    """Build redfish error response body the same way iBMC does."""
+    return {
+        "error": {
+            "code": "Base.1.0.GeneralError",
+            "message": "A general error has occurred. See ExtendedInfo for more information.",
+            "@Message.ExtendedInfo": [{
+                "@odata.type": "#Message.v1_0_0.Message",
+                "MessageId": message_id,
+                "RelatedProperties": [],
+                "Message": message,
+                "MessageArgs": [],
+                "Severity": "Warning" if status < 500 else "Critical",
+                "Resolution": resolution
+            }]
+        }
+    }
+
+
+def merge_patch(target, patch):
+    """Apply JSON merge patch (RFC 7386) onto target in place."""
+    for key, value in patch.items():
+        if value is None:
+            target.pop(key, None)
+        elif isinstance(value, dict) and isinstance(target.get(key), dict):
+            merge_patch(target[key], value)
+        else:
+            target[key] = value
+
+
+class Stats(object):
+    """Counters shared by all handler threads."""
+
+    def __init__(self):
+        self.lock = threading.Lock()
+        self.reset()
+
+    def reset(self):
+        with self.lock:
+            self.requests = 0
+            self.methods = {}
+            self.connections = 0
+            self.handshakes = 0
+            self.bytes_received = 0
+            self.bytes_sent = 0
+
+    def count(self, **kwargs):
+        with self.lock:
+            for key, value in kwargs.items():
+                setattr(self, key, getattr(self, key) + value)
+
+    def count_request(self, method):
+        with self.lock:
+            self.requests += 1
+            self.methods[method] = self.methods.get(method, 0) + 1
+
+    def snapshot(self):
+        with self.lock:
+            return {
+                "Requests": self.requests,
+                "Methods": dict(self.methods),
+                "Connections": self.connections,
+                "Handshakes": self.handshakes,
+                "BytesReceived": self.bytes_received,
+                "BytesSent": self.bytes_sent,
+            }
+
+
+class ResourceStore(object):
+    """Redfish resources keyed by path, with a weak ETag per resource.
+
+    iBMC matches URI case-insensitively (e.g. VncService & VNCService), so does the store.
+    """
+
+    def __init__(self, fixtures_dir):
+        self.fixtures_dir = fixtures_dir
+        self.lock = threading.Lock()
+        self.resources = {}
+        self.etags = {}
+        self.paths = {}
+        self.reload()
+
+    def reload(self):
+        resources = {}
+        for name in sorted(os.listdir(self.fixtures_dir)):
+            if name.endswith(".json"):
+                with open(os.path.join(self.fixtures_dir, name), encoding="utf-8") as fixture:
+                    resources.update(json.load(fixture))
+        with self.lock:
+            self.resources = resources
+            self.etags = {}
+            self.paths = {path.lower(): path for path in resources}
+            for path in resources:
+                self._touch(path)
+
+    def resolve(self, path):
+        """Return the path a resource is stored with, path itself if not found."""
+        with self.lock:
+            return self.paths.get(path.lower(), path)
+
+    def _touch(self, path):
+        content = json.dumps(self.resources[path], sort_keys=True).encode("utf-8")
+        self.etags[path] = 'W/"%08x"' % (zlib.crc32(content) & 0xFFFFFFFF)
+
+    def get(self, path):
+        """Return a copy of resource & its ETag, (None, None) if not found."""
+        with self.lock:
+            resource = self.resources.get(path)
+            if resource is None:
+                return None, None
+            return json.loads(json.dumps(resource)), self.etags[path]
+
+    def patch(self, path, payload, if_match):
+        """Return (status, resource, etag)."""
+        with self.lock:
+            resource = self.resources.get(path)
+            if resource is None:
+                return 404, None, None
+            if if_match is not None and if_match != "*" and if_match != self.etags[path]:
+                return 412, None, None
+            merge_patch(resource, payload)
+            self._touch(path)
+            return 200, json.loads(json.dumps(resource)), self.etags[path]
+
+    def create(self, collection_path, payload):
+        """Create a member in collection, return (status, resource, etag)."""
+        with self.lock:
+            collection = self.resources.get(collection_path)
+            if collection is None or "Members" not in collection:
+                return 405, None, None
+            ids = [m["@odata.id"].rsplit("/", 1)[-1] for m in collection["Members"]]
+            numbers = [int(i) for i in ids if i.isdigit()]
+            member_id = str(max(numbers) + 1 if numbers else len(ids) + 1)
+            path = collection_path + "/" + member_id
+            resource = dict(payload)
+            resource.update({"@odata.id": path, "Id": member_id})
+            self.resources[path] = resource
+            self.paths[path.lower()] = path
+            collection["Members"].append({"@odata.id": path})
+            collection["Members@odata.count"] = len(collection["Members"])
+            self._touch(path)
+            self._touch(collection_path)
+            return 201, json.loads(json.dumps(resource)), self.etags[path]
+
+    def delete(self, path, if_match):
+        """Delete resource & its link in parent collection, return status."""
+        with self.lock:
+            if path not in self.resources:
+                return 404
+            if if_match is not None and if_match != "*" and if_match != self.etags[path]:
+                return 412
+            del self.resources[path]
+            del self.etags[path]
+            self.paths.pop(path.lower(), None)
+            parent = path.rsplit("/", 1)[0]
+            collection = self.resources.get(parent)
+            if collection is not None and "Members" in collection:
+                collection["Members"] = [m for m in collection["Members"] if m.get("@odata.id") != path]
+                collection["Members@odata.count"] = len(collection["Members"])
+                self._touch(parent)
+            return 200
+
+
+class CountingReader(object):
+    """Wrap handler rfile to count received bytes.
+
+    Bytes are held until the request path is known, so that control requests under /mock are not counted.
+    """
+
+    def __init__(self, stream, stats):
+        self.stream = stream
+        self.stats = stats
+        self.pending = 0
+        self.counted = None
+
+    def begin_request(self):
+        self.pending = 0
+        self.counted = None
+
+    def decide(self, counted):
+        self.counted = counted
+        if counted:
+            self.stats.count(bytes_received=self.pending)
+        self.pending = 0
+
+    def _count(self, size):
+        if self.counted is None:
+            self.pending += size
+        elif self.counted:
+            self.stats.count(bytes_received=size)
+
+    def read(self, *args):
+        data = self.stream.read(*args)
+        self._count(len(data))
+        return data
+
+    def readline(self, *args):
+        data = self.stream.readline(*args)
+        self._count(len(data))
+        return data
+
+    def __getattr__(self, name):
+        return getattr(self.stream, name)
+
+
+class CountingWriter(object):
+    """Wrap handler wfile to count sent bytes."""
+
+    def __init__(self, stream, stats):
+        self.stream = stream
+        self.stats = stats
+        self.counted = True
+
+    def write(self, data):
+        if self.counted:
+            self.stats.count(bytes_sent=len(data))
+        return self.stream.write(data)
+
+    def __getattr__(self, name):
+        return getattr(self.stream, name)
+
+
+class MockBMCServer(socketserver.ThreadingMixIn, HTTPServer):
+    daemon_threads = True
+    request_queue_size = 128
+    allow_reuse_address = True
+
+    def __init__(self, options, store, ssl_context):
+        self.options = options
+        self.store = store
+        self.ssl_context = ssl_context
+        self.stats = Stats()
+        self.random = random.Random(options.seed)
+        self.random_lock = threading.Lock()
+        HTTPServer.__init__(self, (options.bind, options.port), MockBMCHandler)
+
+    def delay(self, base_ms):
+        """Sleep base_ms with uniform jitter, jitter sequence is deterministic for the same seed."""
+        if base_ms <= 0 and self.options.jitter <= 0:
+            return
+        with self.random_lock:
+            jitter = self.random.uniform(-self.options.jitter, self.options.jitter)
+        time.sleep(max(0.0, base_ms + jitter) / 1000.0)
+
+
+class MockBMCHandler(BaseHTTPRequestHandler):
+    protocol_version = "HTTP/1.1"
+    server_version = "MockiBMC/1.0"
+    sys_version = ""
+
+    def setup(self):
+        # TLS handshake is done in handler thread, so that connect latency of connections does not add up
+        stats = self.server.stats
+        stats.count(connections=1)
+        self.server.delay(self.server.options.connect_latency)
+        self.request = self.server.ssl_context.wrap_socket(self.request, server_side=True)
+        if not self.request.session_reused:
+            stats.count(handshakes=1)
+        BaseHTTPRequestHandler.setup(self)
+        self.rfile = CountingReader(self.rfile, stats)
+        self.wfile = CountingWriter(self.wfile, stats)
+
+    def handle_one_request(self):
+        self.rfile.begin_request()
+        self.wfile.counted = True
+        BaseHTTPRequestHandler.handle_one_request(self)
+
+    def handle(self):
+        try:
+            BaseHTTPRequestHandler.handle(self)
+        except (ConnectionError, ssl.SSLError, socket.timeout):
+            pass
+
+    def log_message(self, fmt, *args):
+        if self.server.options.verbose:
+            sys.stderr.write("%s - %s\n" % (self.address_string(), fmt % args))
+
+    # ---------------------------------------------------------------------------------------------------------------
+    # helpers
+    # ---------------------------------------------------------------------------------------------------------------
+    def read_payload(self):
+        length = int(self.headers.get("Content-Length") or 0)
+        if length <= 0:
+            return {}
+        body = self.rfile.read(length)
+        try:
+            payload = json.loads(body.decode("utf-8"))
+        except ValueError:
+            return None
+        return payload if isinstance(payload, dict) else None
+
+    def send_json(self, status, body, etag=None, extra_headers=None):
+        content = json.dumps(body, indent=4).encode("utf-8") if body is not None else b""
+        encoding = None
+        accept_encoding = self.headers.get("Accept-Encoding") or ""
+        if self.server.options.gzip and content and "gzip" in accept_encoding:
+            content = gzip.compress(content)
+            encoding = "gzip"
+
+        self.send_response(status)
+        self.send_header("Content-Type", "application/json;charset=utf-8")
+        self.send_header("OData-Version", "4.0")
+        if etag is not None:
+            self.send_header("ETag", etag)
+        if encoding is not None:
+            self.send_header("Content-Encoding", encoding)
+        for key, value in (extra_headers or {}).items():
+            self.send_header(key, value)
+        self.send_header("Content-Length", str(len(content)))
+        self.end_headers()
+        if content and self.command != "HEAD":
+            self.wfile.write(content)
+
+    def send_error_json(self, status, message_id, message):
+        self.send_json(status, build_error(status, message_id, message))
+
+    def authorized(self):
+        options = self.server.options
+        if options.username is None:
+            return True
+
+        expected = "Basic " + base64.b64encode(
+            ("%s:%s" % (options.username, options.password)).encode("utf-8")).decode("ascii")
+        if self.headers.get("Authorization") == expected:
+            return True
+        self.send_error_json(401, "Base.1.0.NoValidSession",
+                             "There is no valid session established with the implementation.")
+        return False
+
+    def begin(self):
+        """Count request, apply latency & authenticate, return (path, query) or None if request is answered.
+
+        Control requests under /mock are neither counted nor delayed.
+        """
+        url = urlsplit(self.path)
+        path = unquote(url.path).rstrip("/") or "/"
+        control = path == MOCK_ROOT or path.startswith(MOCK_ROOT + "/")
+        self.rfile.decide(not control)
+        self.wfile.counted = not control
+        if control:
+            return path, parse_qs(url.query)
+        self.server.stats.count_request(self.command)
+        self.server.delay(self.server.options.latency)
+        if not self.authorized():
+            return None
+        return self.server.store.resolve(path), parse_qs(url.query)
+
+    def expand(self, resource, query):
+        """Handle $expand=.($levels=1) & $select on collection, only when service advertises support."""
+        if not self.server.options.expand or "$expand" not in query or "Members" not in resource:
+            return resource
+
+        select = None
+        if "$select" in query:
+            select = set(query["$select"][0].split(","))
+        members = []
+        for link in resource["Members"]:
+            member, etag = self.server.store.get(link.get("@odata.id"))
+            if member is None:
+                continue
+            member["@odata.etag"] = etag
+            if select is not None:
+                member = dict((k, v) for k, v in member.items() if k in select or k.startswith("@odata."))
+            members.append(member)
+        resource["Members"] = members
+        return resource
+
+    # ---------------------------------------------------------------------------------------------------------------
+    # HTTP methods
+    # ---------------------------------------------------------------------------------------------------------------
+    def do_GET(self):
+        request = self.begin()
+        if request is None:
+            return
+        path, query = request
+
+        if path == MOCK_ROOT + "/stats":
+            self.send_json(200, self.server.stats.snapshot())
+            return
+
+        resource, etag = self.server.store.get(path)
+        if resource is None:
+            self.send_error_json(404, "Base.1.0.ResourceMissingAtURI",
+                                 "The resource at the URI %s was not found." % path)
+            return
+
+        if path == ROOT and self.server.options.expand:
+            resource["ProtocolFeaturesSupported"] = {
+                "ExpandQuery": {"ExpandAll": False, "Levels": True, "Links": False, "NoLinks": True,
+                                "MaxLevels": 1},
+                "SelectQuery": True
+            }
+
+        if not query and self.headers.get("If-None-Match") == etag:
+            self.send_response(304)
+            self.send_header("ETag", etag)
+            self.send_header("Content-Length", "0")
+            self.end_headers()
+            return
+
+        self.send_json(200, self.expand(resource, query), etag=etag)
+
+    do_HEAD = do_GET
+
+    def do_PATCH(self):
+        request = self.begin()
+        if request is None:
+            return
+        path, _ = request
+
+        payload = self.read_payload()
+        if payload is None:
+            self.send_error_json(400, "Base.1.0.MalformedJSON", "The request body submitted was malformed JSON.")
+            return
+
+        status, resource, etag = self.server.store.patch(path, payload, self.headers.get("If-Match"))
+        if status == 404:
+            self.send_error_json(404, "Base.1.0.ResourceMissingAtURI",
+                                 "The resource at the URI %s was not found." % path)
+        elif status == 412:
+            self.send_error_json(412, "Base.1.0.PreconditionFailed",
+                                 "The ETag supplied did not match the ETag required to change this resource.")
+        else:
+            self.send_json(status, resource, etag=etag)
+
+    def do_POST(self):
+        request = self.begin()
+        if request is None:
+            return
+        path, _ = request
+
+        payload = self.read_payload()
+        if path == MOCK_ROOT + "/reload":
+            self.server.store.reload()
+            self.send_json(200, SUCCESS_MESSAGE)
+            return
+
+        if payload is None:
+            self.send_error_json(400, "Base.1.0.MalformedJSON", "The request body submitted was malformed JSON.")
+            return
+
+        # actions are accepted without any side effect
+        if "/Actions/" in path:
+            self.send_json(200, SUCCESS_MESSAGE)
+            return
+
+        status, resource, etag = self.server.store.create(path, payload)
+        if status != 201:
+            self.send_error_json(405, "Base.1.0.ActionNotSupported",
+                                 "The action POST is not supported by the resource %s." % path)
+            return
+        self.send_json(status, resource, etag=etag, extra_headers={"Location": resource["@odata.id"]})
+
+    def do_DELETE(self):
+        request = self.begin()
+        if request is None:
+            return
+        path, _ = request
+
+        if path == MOCK_ROOT + "/stats":
+            self.server.stats.reset()
+            self.send_json(200, SUCCESS_MESSAGE)
+            return
+
+        status = self.server.store.delete(path, self.headers.get("If-Match"))
+        if status == 404:
+            self.send_error_json(404, "Base.1.0.ResourceMissingAtURI",
+                                 "The resource at the URI %s was not found." % path)
+        elif status == 412:
+            self.send_error_json(412, "Base.1.0.PreconditionFailed",
+                                 "The ETag supplied did not match the ETag required to change this resource.")
+        else:
+            self.send_json(200, SUCCESS_MESSAGE)
+
+
+def load_ssl_context(options):
+    """Load TLS certificate, a self-signed one is generated into state directory if not provided."""
+    cert, key = options.cert, options.key
+    if cert is None or key is None:
+        cert = os.path.join(options.state_dir, "mock-bmc-cert.pem")
+        key = os.path.join(options.state_dir, "mock-bmc-key.pem")
+        if not (os.path.exists(cert) and os.path.exists(key)):
+            os.makedirs(options.state_dir, exist_ok=True)
+            subprocess.check_call(["openssl", "req", "-x509", "-newkey", "rsa:2048", "-nodes", "-days", "3650",
+                                   "-subj", "/CN=localhost", "-keyout", key, "-out", cert],
+                                  stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+
+    context = ssl.SSLContext(ssl.PROTOCOL_TLS_SERVER)
+    context.load_cert_chain(cert, key)
+    return context
+
+
+def parse_args(argv):
+    here = os.path.dirname(os.path.abspath(__file__))
+    parser = argparse.ArgumentParser(description="Mock iBMC redfish service.")
+    parser.add_argument("--bind", default="127.0.0.1", help="listen address, 127.0.0.1 by default")
+    parser.add_argument("--port", type=int, default=int(os.environ.get("UTOOL_MOCK_BMC_PORT", "8443")),
+                        help="HTTPS port, $UTOOL_MOCK_BMC_PORT or 8443 by default")
+    parser.add_argument("--fixtures", default=os.path.join(here, "fixtures"), help="fixtures directory")
+    parser.add_argument("--latency", type=float, default=0.0, help="latency of every request in milliseconds")
+    parser.add_argument("--jitter", type=float, default=0.0,
+                        help="uniform jitter in milliseconds added to latency, within [-jitter, +jitter]")
+    parser.add_argument("--connect-latency", type=float, default=0.0,
+                        help="extra latency of every new connection in milliseconds, e.g. 2 RTTs for TCP & TLS")
+    parser.add_argument("--seed", type=int, default=0, help="seed of jitter sequence")
+    parser.add_argument("--expand", action="store_true", help="advertise and serve $expand & $select queries")
+    parser.add_argument("--gzip", action="store_true", help="gzip response if client accepts")
+    parser.add_argument("--username", help="required basic auth user name, any credential is accepted if absent")
+    parser.add_argument("--password", default="", help="required basic auth password")
+    parser.add_argument("--cert", help="TLS certificate file")
+    parser.add_argument("--key", help="TLS private key file")
+    parser.add_argument("--state-dir", default=os.getcwd(), help="directory of generated TLS certificate")
+    parser.add_argument("--verbose", action="store_true", help="log every request to stderr")
+    return parser.parse_args(argv)
+
+
+def main(argv):
+    options = parse_args(argv)
+    store = ResourceStore(options.fixtures)
+    server = MockBMCServer(options, store, load_ssl_context(options))
+    sys.stdout.write("Mock iBMC serves %d resources on https://%s:%d\n" % (len(store.resources), options.bind,
+                                                                          server.server_address[1]))
+    sys.stdout.flush()
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+    finally:
+        server.server_close()
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv[1:]))